@@ -72,6 +72,11 @@ public class AmazonPollyMetaHuman : ModuleRules
             "JsonUtilities"
         });
 
+        if (Target.bBuildEditor) {
+            // The multiplayer replication tests start play-in-editor sessions
+            PrivateDependencyModuleNames.Add("UnrealEd");
+        }
+
         // Dynamically linking to the SDK requires us to define the
         // USE_IMPORT_EXPORT symbol for all build targets using the
         // SDK. Source: https://github.com/aws/aws-sdk-cpp/blob/main/Docs/SDK_usage_guide.md#build-defines
@@ -109,6 +114,18 @@ public class AmazonPollyMetaHuman : ModuleRules
                 "$(BinaryOutputDir)/lib" + LibraryName + ".dylib",
                 Path.Combine(LibraryPath, "lib", "lib" + LibraryName + ".dylib")
             );
+        } else if (Target.Platform == UnrealTargetPlatform.Linux) {
+            // Add the library with symbols required by the linker (.so for dynamic libraries on linux).
+            string LibraryDirectory = Path.Combine(LibraryPath, "lib");
+            PublicAdditionalLibraries.Add(Path.Combine(LibraryDirectory, "lib" + LibraryName + ".so"));
+
+            // Stage the library along with the target, so it can be loaded at runtime. The loader looks for the
+            // name the library was linked with, which may carry a version suffix, so every name of it is staged.
+            if (Directory.Exists(LibraryDirectory)) {
+                foreach (string LibraryFile in Directory.GetFiles(LibraryDirectory, "lib" + LibraryName + ".so*")) {
+                    RuntimeDependencies.Add("$(BinaryOutputDir)/" + Path.GetFileName(LibraryFile), LibraryFile);
+                }
+            }
         } else {
             throw new PlatformNotSupportedException(
                 "Platform " + Platform + " is not supported by the AwsSdk Module."
@@ -19,12 +19,18 @@
 #include "AmazonPollyMetaHuman.h"
 #include "Core.h"
 #include "Interfaces/IPluginManager.h"
+#include "PollySynthesisScheduler.h"
+#include "SpeechDiskCache.h"
+#include "SpeechMemoryTracker.h"
+#include "SpeechMetrics.h"
 
 #define LOCTEXT_NAMESPACE "FAmazonPollyMetaHumanModule"
 DEFINE_LOG_CATEGORY(LogAmazonPollyMetaHuman);
 
 void* MemoryManagerWrapper::AllocateMemory(std::size_t blockSize, std::size_t /*alignment*/, const char* /*allocationTag*/)
 {
+    // The SDK is only used for Polly, its memory holds the requests and responses in flight
+    LLM_SCOPE_POLLY_SPEECH();
     return ::operator new(blockSize);
 }
 
@@ -48,6 +54,8 @@ FAmazonPollyMetaHumanModule::~FAmazonPollyMetaHumanModule()
 
 void FAmazonPollyMetaHumanModule::StartupModule()
 {
+    FSpeechMemoryTracker::Get().Start();
+    FSpeechMetrics::Get().Start();
     Aws::SDKOptions* awsSDKOptions = static_cast<Aws::SDKOptions*>(m_sdkOptions);
     awsSDKOptions->memoryManagementOptions.memoryManager = &m_memoryManager;
     Aws::InitAPI(*awsSDKOptions);
@@ -56,10 +64,15 @@ void FAmazonPollyMetaHumanModule::StartupModule()
 
 void FAmazonPollyMetaHumanModule::ShutdownModule()
 {
+    FSpeechMemoryTracker::Get().Stop();
+    FSpeechMetrics::Get().Stop();
     if (!m_apiInitialized) {
         return;
     }
     m_apiInitialized = false;
+    // The scheduler's workers may still be sending requests through the SDK
+    FPollySynthesisScheduler::Shutdown();
+    FSpeechDiskCache::Get().Flush();
     Aws::ShutdownAPI(*static_cast<Aws::SDKOptions *>(m_sdkOptions));
 }
 
@@ -17,6 +17,8 @@
  */
 
 #include "GenerateSpeechAction.h"
+#include "Async/Async.h"
+#include "SpeechTrace.h"
 
 FGenerateSpeechAction::FGenerateSpeechAction(
     const struct FLatentActionInfo& LatentActionInfo,
@@ -28,23 +30,106 @@ FGenerateSpeechAction::FGenerateSpeechAction(
     ExecutionFunction(LatentActionInfo.ExecutionFunction),
     Linkage(LatentActionInfo.Linkage),
     CallbackTarget(LatentActionInfo.CallbackTarget),
-    SpeechComponent(SpeechComponent),
     GenerateSpeechExecPins(GenerateSpeechExecPins),
-    bIsDone(false)
+    SpeechComponent(SpeechComponent),
+    State(MakeShared<FGenerateSpeechState, ESPMode::ThreadSafe>()),
+    UtteranceId(SpeechTrace::NewUtteranceId())
 {
+    POLLY_TRACE_SCOPE(FGenerateSpeechAction::FGenerateSpeechAction);
     this->GenerateSpeechExecPins = EGenerateSpeechExecPins::Failure;
-    AsyncTask(ENamedThreads::AnyHiPriThreadNormalTask, [this, Text, VoiceId] ()
+    SpeechTrace::BeginSpan(UtteranceId, ESpeechTraceSpan::Utterance);
+    // The pending call holds back the destruction of the component (see USpeechComponent::IsReadyForFinishDestroy),
+    // so the raw pointer stays valid until the call is done with it
+    SpeechComponent->PendingGenerateSpeechCalls.Increment();
+    TSharedRef<FGenerateSpeechState, ESPMode::ThreadSafe> SharedState = State;
+    // A text held in the memory of the FSpeechCache is generated without waiting for anything, so it is not worth a
+    // thread. Texts cached on disk only are read on the GThreadPool below.
+    if (SpeechComponent->AreSegmentsCached(Text, VoiceId, true)) {
+        TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech = SpeechComponent->BeginGenerateSpeech(Text, VoiceId, UtteranceId);
+        SharedState->Speech = Speech;
+        // An entry evicted meanwhile is synthesized instead, and its requests are polled by UpdateOperation
+        if (Speech->IsReady()) {
+            const bool bSucceeded = SpeechComponent->FinishGenerateSpeech(*Speech, false);
+            if (Speech->bFinished) {
+                SharedState->bFinishing = true;
+                SharedState->bSucceeded = bSucceeded;
+                SpeechComponent->PendingGenerateSpeechCalls.Decrement();
+                SpeechTrace::BeginSpan(UtteranceId, ESpeechTraceSpan::Handoff);
+                SharedState->bIsDone = true;
+            }
+        }
+        return;
+    }
+    // Putting the requests in flight may read the disk cache, so it runs on the bounded GThreadPool like the other
+    // speech work. The worker returns as soon as the requests are issued: UpdateOperation polls them from then on.
+    SpeechTrace::BeginSpan(UtteranceId, ESpeechTraceSpan::LatentAction);
+    const uint32 ThreadUtteranceId = UtteranceId;
+    Async(EAsyncExecution::ThreadPool, [SharedState, SpeechComponent, Text, VoiceId, ThreadUtteranceId] ()
     {
-        this->SpeechComponent->GenerateSpeechSync(Text, VoiceId);
-        AsyncTask(ENamedThreads::GameThread, [this] ()
-        {
-            this->GenerateSpeechExecPins = EGenerateSpeechExecPins::Success;
-            this->bIsDone = true;
-        });
+        SpeechTrace::EndSpan(ThreadUtteranceId, ESpeechTraceSpan::LatentAction);
+        TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech = SpeechComponent->BeginGenerateSpeech(Text, VoiceId, ThreadUtteranceId);
+        FScopeLock lock(&SharedState->Mutex);
+        SharedState->Speech = Speech;
+        if (SharedState->bAbandoned) {
+            SharedState->bFinishing = true;
+            FinishSpeech(SharedState, SpeechComponent);
+        }
     });
 }
 
+FGenerateSpeechAction::~FGenerateSpeechAction()
+{
+    // The speech of a deleted action is still generated, its requests are then waited for on the GThreadPool
+    FScopeLock lock(&State->Mutex);
+    State->bAbandoned = true;
+    if (State->Speech.IsValid() && !State->bFinishing) {
+        State->bFinishing = true;
+        FinishSpeech(State, SpeechComponent);
+    }
+}
+
 void FGenerateSpeechAction::UpdateOperation(FLatentResponse& Response)
 {
-    Response.FinishAndTriggerIf(bIsDone, ExecutionFunction, Linkage, CallbackTarget);
-}
\ No newline at end of file
+    {
+        FScopeLock lock(&State->Mutex);
+        if (State->Speech.IsValid() && !State->bFinishing && State->Speech->IsReady()) {
+            State->bFinishing = true;
+            FinishSpeech(State, SpeechComponent);
+        }
+    }
+    if (State->bIsDone) {
+        SpeechTrace::EndSpan(UtteranceId, ESpeechTraceSpan::Handoff);
+        GenerateSpeechExecPins = State->bSucceeded ? EGenerateSpeechExecPins::Success : EGenerateSpeechExecPins::Failure;
+    }
+    Response.FinishAndTriggerIf(State->bIsDone, ExecutionFunction, Linkage, CallbackTarget);
+}
+
+void FGenerateSpeechAction::FinishSpeech(TSharedRef<FGenerateSpeechState, ESPMode::ThreadSafe> State, USpeechComponent* SpeechComponent)
+{
+    Async(EAsyncExecution::ThreadPool, [State, SpeechComponent] ()
+    {
+        TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech = State->Speech.ToSharedRef();
+        bool bSucceeded = false;
+        while (true) {
+            bool bWaitForRetry = false;
+            {
+                FScopeLock lock(&State->Mutex);
+                bWaitForRetry = State->bAbandoned;
+            }
+            bSucceeded = SpeechComponent->FinishGenerateSpeech(*Speech, bWaitForRetry);
+            if (Speech->bFinished) {
+                break;
+            }
+            // A failed prefetch was synthesized again, whose requests are polled like the first ones
+            FScopeLock lock(&State->Mutex);
+            if (!State->bAbandoned) {
+                State->bFinishing = false;
+                return;
+            }
+        }
+        State->bSucceeded = bSucceeded;
+        SpeechComponent->PendingGenerateSpeechCalls.Decrement();
+        SpeechTrace::BeginSpan(Speech->UtteranceId, ESpeechTraceSpan::Handoff);
+        State->bIsDone = true;
+    });
+}
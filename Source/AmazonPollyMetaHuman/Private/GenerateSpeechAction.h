@@ -20,10 +20,15 @@
 
 #include "Runtime/Engine/Public/LatentActions.h"
 #include "SpeechComponent.h"
+#include "HAL/ThreadSafeBool.h"
 
 /**
  * Latent action corresponding to the latent USpeechComponent::GenerateSpeech function, which
- * is required to avoid blocking the game thread.
+ * is required to avoid blocking the game thread. The latent action manager may delete the action
+ * while the speech is still being generated (e.g. when its callback target is destroyed), so the
+ * background work only shares FGenerateSpeechState with it and never references the action itself.
+ * No thread waits for the Polly requests of the speech: they are put in flight on the GThreadPool,
+ * UpdateOperation polls them, and the speech is finished on the GThreadPool once they have returned.
  */
 class FGenerateSpeechAction : public FPendingLatentAction {
 public:
@@ -43,6 +48,7 @@ public:
         const EVoiceId& VoiceId,
         EGenerateSpeechExecPins& GenerateSpeechExecPins
     );
+    virtual ~FGenerateSpeechAction();
     void UpdateOperation(FLatentResponse& Response) override;
 
 private:
@@ -55,12 +61,36 @@ private:
     /** Information required to update latent response and inform completion */
     UObject* const CallbackTarget;
 
-    /** SpeechComponent instance generating speech */
-    USpeechComponent* SpeechComponent;
-
     /** Execution pin reference to be updated on completion */
     EGenerateSpeechExecPins& GenerateSpeechExecPins;
 
-    /** Flag to signal completion */
-    bool bIsDone;
+    /** SpeechComponent instance generating speech */
+    USpeechComponent* const SpeechComponent;
+
+    /** State shared with the background work generating the speech */
+    struct FGenerateSpeechState {
+        /** Guards Speech, bFinishing and bAbandoned */
+        FCriticalSection Mutex;
+        /** The speech, once its requests are in flight */
+        TSharedPtr<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech;
+        /** Set while the speech is being finished */
+        bool bFinishing = false;
+        /** Set once the action was deleted, after which the speech is finished without being polled */
+        bool bAbandoned = false;
+        /** Flag to signal completion */
+        FThreadSafeBool bIsDone;
+        /** Flag to signal that the speech was generated */
+        FThreadSafeBool bSucceeded;
+    };
+    TSharedRef<FGenerateSpeechState, ESPMode::ThreadSafe> State;
+
+    /**
+     * Finishes the speech on the GThreadPool. Must be called with the Mutex of the state held.
+     * @param State - the state of the call, whose speech is ready unless the call was abandoned
+     * @param SpeechComponent - SpeechComponent instance generating speech
+     */
+    static void FinishSpeech(TSharedRef<FGenerateSpeechState, ESPMode::ThreadSafe> State, USpeechComponent* SpeechComponent);
+
+    /** Utterance of the call in traces, see SpeechTrace */
+    const uint32 UtteranceId;
 };
\ No newline at end of file
@@ -0,0 +1,59 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyAudioBuffer.h"
+
+FPollyAudioData::FPollyAudioData(TArray<uint8>&& InData) :
+    Data(MoveTemp(InData))
+{
+    View = Data;
+}
+
+FPollyAudioData::FPollyAudioData(TArrayView<const uint8> InView, TSharedPtr<const void, ESPMode::ThreadSafe> InOwner) :
+    View(InView),
+    Owner(InOwner)
+{
+}
+
+FPollyAudioBuffer PollyAudioBuffer::Make(TArray<uint8>&& Data) {
+    return MakeShared<FPollyAudioData, ESPMode::ThreadSafe>(MoveTemp(Data));
+}
+
+FPollyAudioBuffer PollyAudioBuffer::MakeView(TArrayView<const uint8> View, TSharedPtr<const void, ESPMode::ThreadSafe> Owner) {
+    return MakeShared<FPollyAudioData, ESPMode::ThreadSafe>(View, Owner);
+}
+
+const FPollyAudioBuffer& PollyAudioBuffer::GetEmpty() {
+    static const FPollyAudioBuffer EmptyBuffer = Make(TArray<uint8>());
+    return EmptyBuffer;
+}
+
+int64 PollyAudioBuffer::NumBytes(const TArray<FPollyAudioBuffer>& Buffers) {
+    int64 Bytes = 0;
+    for (const FPollyAudioBuffer& Buffer : Buffers) {
+        Bytes += Buffer->Num();
+    }
+    return Bytes;
+}
+
+void PollyAudioBuffer::Flatten(const TArray<FPollyAudioBuffer>& Buffers, TArray<uint8>& OutData) {
+    OutData.Reserve(OutData.Num() + NumBytes(Buffers));
+    for (const FPollyAudioBuffer& Buffer : Buffers) {
+        OutData.Append(Buffer->GetData(), Buffer->Num());
+    }
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+
+/**
+* Immutable bytes of a Polly response, pcm audio or speech marks. The bytes are either held in an allocation of
+* their own, or viewed in memory owned by another object that is kept alive along with them, e.g. a memory mapped
+* entry of the FSpeechDiskCache.
+*/
+class FPollyAudioData {
+public:
+    /**
+    * @param InData - the bytes, whose allocation is taken over
+    */
+    explicit FPollyAudioData(TArray<uint8>&& InData);
+    /**
+    * @param InView - the bytes, in memory owned by InOwner
+    * @param InOwner - the owner of the memory, kept alive for as long as the bytes are. Must not be null.
+    */
+    FPollyAudioData(TArrayView<const uint8> InView, TSharedPtr<const void, ESPMode::ThreadSafe> InOwner);
+    /**
+    * Not copyable, the view of an owned allocation points into it
+    */
+    FPollyAudioData(const FPollyAudioData&) = delete;
+    FPollyAudioData& operator=(const FPollyAudioData&) = delete;
+
+    const uint8* GetData() const {
+        return View.GetData();
+    }
+
+    int32 Num() const {
+        return View.Num();
+    }
+
+    TArrayView<const uint8> GetView() const {
+        return View;
+    }
+
+    /**
+    * Returns true if the bytes are viewed in memory owned by another object rather than held by the buffer
+    */
+    bool IsView() const {
+        return Owner.IsValid();
+    }
+
+    /**
+    * Returns the heap memory held by the buffer, none for a view
+    */
+    SIZE_T GetAllocatedSize() const {
+        return Data.GetAllocatedSize();
+    }
+
+private:
+    TArray<uint8> Data;
+    TArrayView<const uint8> View;
+    TSharedPtr<const void, ESPMode::ThreadSafe> Owner;
+};
+
+/**
+* Body of a Polly response, reference counted and shared rather than copied by the outcome of the request, the
+* FSpeechCache, the speech component and the sound playing the speech
+*/
+using FPollyAudioBuffer = TSharedRef<const FPollyAudioData, ESPMode::ThreadSafe>;
+
+namespace PollyAudioBuffer {
+    /**
+    * Returns a buffer taking over the allocation of Data, without copying it
+    * @param Data - the bytes of the buffer
+    * @return FPollyAudioBuffer - the buffer
+    */
+    FPollyAudioBuffer Make(TArray<uint8>&& Data);
+    /**
+    * Returns a buffer viewing memory owned by another object, without copying it
+    * @param View - the bytes of the buffer
+    * @param Owner - the owner of the memory, kept alive by the buffer
+    * @return FPollyAudioBuffer - the buffer
+    */
+    FPollyAudioBuffer MakeView(TArrayView<const uint8> View, TSharedPtr<const void, ESPMode::ThreadSafe> Owner);
+    /**
+    * Returns the empty buffer shared by the outcomes without a body
+    */
+    const FPollyAudioBuffer& GetEmpty();
+    /**
+    * Returns the total size of the buffers of a speech
+    * @param Buffers - the buffers, in playback order
+    * @return int64 - the size in bytes
+    */
+    int64 NumBytes(const TArray<FPollyAudioBuffer>& Buffers);
+    /**
+    * Appends the buffers of a speech to a single array, for consumers that need the audio in one piece
+    * @param Buffers - the buffers, in playback order
+    * @param OutData - receives the bytes of the buffers
+    */
+    void Flatten(const TArray<FPollyAudioBuffer>& Buffers, TArray<uint8>& OutData);
+}
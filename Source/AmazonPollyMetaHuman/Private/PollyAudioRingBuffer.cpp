@@ -0,0 +1,171 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyAudioRingBuffer.h"
+
+FPollyAudioRingBuffer::FPollyAudioRingBuffer(int32 MinCapacityBytes) :
+    WritePosition(0),
+    ReadPosition(0),
+    OverflowChunkOffset(0),
+    OverflowWritePosition(0),
+    OverflowReadPosition(0),
+    bFinished(false),
+    bFailed(false),
+    WaitedBytes(MAX_int32),
+    bStopWaiting(false),
+    BytesEvent(FPlatformProcess::GetSynchEventFromPool(false))
+{
+    const int32 Capacity = FMath::RoundUpToPowerOfTwo(FMath::Max(MinCapacityBytes, 2));
+    Buffer.SetNumUninitialized(Capacity);
+    IndexMask = Capacity - 1;
+}
+
+FPollyAudioRingBuffer::~FPollyAudioRingBuffer() {
+    FPlatformProcess::ReturnSynchEventToPool(BytesEvent);
+}
+
+int32 FPollyAudioRingBuffer::Write(const uint8* Data, int32 NumBytes) {
+    const uint64 Write = WritePosition.load(std::memory_order_relaxed);
+    const uint64 Read = ReadPosition.load(std::memory_order_acquire);
+    const int32 FreeBytes = GetCapacity() - static_cast<int32>(Write - Read);
+    const int32 BytesToWrite = FMath::Min(NumBytes, FreeBytes);
+    if (BytesToWrite <= 0) {
+        return 0;
+    }
+    const int32 StartIndex = static_cast<int32>(Write & IndexMask);
+    const int32 FirstSpan = FMath::Min(BytesToWrite, GetCapacity() - StartIndex);
+    FMemory::Memcpy(Buffer.GetData() + StartIndex, Data, FirstSpan);
+    FMemory::Memcpy(Buffer.GetData(), Data + FirstSpan, BytesToWrite - FirstSpan);
+    WritePosition.store(Write + BytesToWrite, std::memory_order_release);
+    NotifyWaiter();
+    return BytesToWrite;
+}
+
+void FPollyAudioRingBuffer::WriteAll(const uint8* Data, int32 NumBytes) {
+    const uint64 OverflowWrite = OverflowWritePosition.load(std::memory_order_relaxed);
+    // Once bytes are waiting in Overflow, later bytes must queue up behind them to keep the order
+    const int32 BytesWritten = OverflowWrite == OverflowReadPosition.load(std::memory_order_acquire) ? Write(Data, NumBytes) : 0;
+    if (BytesWritten < NumBytes) {
+        Overflow.Enqueue(TArray<uint8>(Data + BytesWritten, NumBytes - BytesWritten));
+        OverflowWritePosition.store(OverflowWrite + NumBytes - BytesWritten, std::memory_order_release);
+        NotifyWaiter();
+    }
+}
+
+int32 FPollyAudioRingBuffer::Read(uint8* Dest, int32 NumBytes) {
+    int32 BytesRead = ReadRing(Dest, NumBytes);
+    while (BytesRead < NumBytes) {
+        TArray<uint8>* Chunk = Overflow.Peek();
+        if (Chunk == nullptr) {
+            break;
+        }
+        // The producer may have filled the ring just before it started to overflow, those bytes come first
+        const int32 RingBytesRead = ReadRing(Dest + BytesRead, NumBytes - BytesRead);
+        if (RingBytesRead > 0) {
+            BytesRead += RingBytesRead;
+            continue;
+        }
+        const int32 ChunkBytesRead = FMath::Min(NumBytes - BytesRead, Chunk->Num() - OverflowChunkOffset);
+        FMemory::Memcpy(Dest + BytesRead, Chunk->GetData() + OverflowChunkOffset, ChunkBytesRead);
+        BytesRead += ChunkBytesRead;
+        OverflowChunkOffset += ChunkBytesRead;
+        if (OverflowChunkOffset == Chunk->Num()) {
+            Overflow.Pop();
+            OverflowChunkOffset = 0;
+        }
+        OverflowReadPosition.fetch_add(ChunkBytesRead, std::memory_order_release);
+    }
+    return BytesRead;
+}
+
+int32 FPollyAudioRingBuffer::ReadRing(uint8* Dest, int32 NumBytes) {
+    const uint64 Read = ReadPosition.load(std::memory_order_relaxed);
+    const uint64 Write = WritePosition.load(std::memory_order_acquire);
+    const int32 BytesToRead = FMath::Min(NumBytes, static_cast<int32>(Write - Read));
+    if (BytesToRead <= 0) {
+        return 0;
+    }
+    const int32 StartIndex = static_cast<int32>(Read & IndexMask);
+    const int32 FirstSpan = FMath::Min(BytesToRead, GetCapacity() - StartIndex);
+    FMemory::Memcpy(Dest, Buffer.GetData() + StartIndex, FirstSpan);
+    FMemory::Memcpy(Dest + FirstSpan, Buffer.GetData(), BytesToRead - FirstSpan);
+    ReadPosition.store(Read + BytesToRead, std::memory_order_release);
+    return BytesToRead;
+}
+
+void FPollyAudioRingBuffer::Discard() {
+    ReadPosition.store(WritePosition.load(std::memory_order_acquire), std::memory_order_release);
+    while (TArray<uint8>* Chunk = Overflow.Peek()) {
+        const int32 ChunkBytes = Chunk->Num() - OverflowChunkOffset;
+        Overflow.Pop();
+        OverflowChunkOffset = 0;
+        OverflowReadPosition.fetch_add(ChunkBytes, std::memory_order_release);
+    }
+}
+
+int32 FPollyAudioRingBuffer::Num() const {
+    const uint64 OverflowBytes = OverflowWritePosition.load(std::memory_order_acquire) - OverflowReadPosition.load(std::memory_order_acquire);
+    return static_cast<int32>(WritePosition.load(std::memory_order_acquire) - ReadPosition.load(std::memory_order_acquire) + OverflowBytes);
+}
+
+int32 FPollyAudioRingBuffer::GetCapacity() const {
+    return Buffer.Num();
+}
+
+int64 FPollyAudioRingBuffer::GetAllocatedSize() const {
+    const uint64 OverflowBytes = OverflowWritePosition.load(std::memory_order_acquire) - OverflowReadPosition.load(std::memory_order_acquire);
+    return GetCapacity() + static_cast<int64>(OverflowBytes);
+}
+
+int64 FPollyAudioRingBuffer::GetTotalBytesWritten() const {
+    return static_cast<int64>(WritePosition.load(std::memory_order_acquire) + OverflowWritePosition.load(std::memory_order_acquire));
+}
+
+void FPollyAudioRingBuffer::WaitForBytes(int32 NumBytes) {
+    // Published before the checks, so that bytes written in between always trigger the event
+    WaitedBytes.store(NumBytes);
+    while (Num() < NumBytes && !IsFinished() && !bStopWaiting.load()) {
+        BytesEvent->Wait();
+    }
+    WaitedBytes.store(MAX_int32);
+}
+
+void FPollyAudioRingBuffer::StopWaiting() {
+    bStopWaiting.store(true);
+    BytesEvent->Trigger();
+}
+
+void FPollyAudioRingBuffer::NotifyWaiter() {
+    if (Num() >= WaitedBytes.load()) {
+        BytesEvent->Trigger();
+    }
+}
+
+void FPollyAudioRingBuffer::Finish(bool bSucceeded) {
+    bFailed.store(!bSucceeded, std::memory_order_relaxed);
+    bFinished.store(true, std::memory_order_release);
+    BytesEvent->Trigger();
+}
+
+bool FPollyAudioRingBuffer::IsFinished() const {
+    return bFinished.load(std::memory_order_acquire);
+}
+
+bool FPollyAudioRingBuffer::HasFailed() const {
+    return IsFinished() && bFailed.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Event.h"
+#include "Containers/Queue.h"
+#include <atomic>
+
+/**
+* Lock-free single-producer/single-consumer byte ring buffer used to stream PCM audio from the
+* thread receiving the Polly response to the audio render thread. Exactly one thread may write
+* and exactly one thread may read at any time; neither side ever takes a lock. Bytes written by
+* WriteAll that do not fit are staged in overflow chunks, which the consumer reads after the ring.
+*/
+class FPollyAudioRingBuffer {
+public:
+    /**
+    * Creates the ring buffer
+    * @param MinCapacityBytes - the minimum capacity, rounded up to the next power of two
+    */
+    explicit FPollyAudioRingBuffer(int32 MinCapacityBytes);
+    ~FPollyAudioRingBuffer();
+    /**
+    * Copies as many bytes as currently fit into the ring buffer (producer side)
+    * @param Data - the bytes to write
+    * @param NumBytes - the number of bytes to write
+    * @return int32 - the number of bytes actually written
+    */
+    int32 Write(const uint8* Data, int32 NumBytes);
+    /**
+    * Writes all bytes without ever waiting for the consumer: whatever does not fit into the ring
+    * buffer is copied into an overflow chunk instead (producer side)
+    * @param Data - the bytes to write
+    * @param NumBytes - the number of bytes to write
+    */
+    void WriteAll(const uint8* Data, int32 NumBytes);
+    /**
+    * Copies up to NumBytes buffered bytes out of the ring buffer (consumer side)
+    * @param Dest - the destination of the bytes
+    * @param NumBytes - the maximum number of bytes to read
+    * @return int32 - the number of bytes actually read
+    */
+    int32 Read(uint8* Dest, int32 NumBytes);
+    /**
+    * Drops every buffered byte (consumer side)
+    */
+    void Discard();
+    /**
+    * Returns the number of bytes that can currently be read, including the overflow chunks
+    */
+    int32 Num() const;
+    /**
+    * Returns the capacity of the ring buffer in bytes
+    */
+    int32 GetCapacity() const;
+    /**
+    * Returns the bytes held by the ring buffer and its overflow chunks
+    */
+    int64 GetAllocatedSize() const;
+    /**
+    * Returns the total number of bytes written since creation
+    */
+    int64 GetTotalBytesWritten() const;
+    /**
+    * Waits until NumBytes can be read, the producer finished, or StopWaiting was called. The producer
+    * signals the wait as soon as it writes the last of those bytes, so nothing is polled meanwhile.
+    * Only one thread may wait at a time.
+    * @param NumBytes - the number of bytes to wait for
+    */
+    void WaitForBytes(int32 NumBytes);
+    /**
+    * Releases WaitForBytes for good, for instance once the request writing into the ring buffer completed
+    */
+    void StopWaiting();
+    /**
+    * Signals that the producer will not write any more bytes
+    * @param bSucceeded - false if the stream ended because of an error
+    */
+    void Finish(bool bSucceeded);
+    /**
+    * Returns true once the producer has finished writing
+    */
+    bool IsFinished() const;
+    /**
+    * Returns true if the producer finished because of an error
+    */
+    bool HasFailed() const;
+
+private:
+    /**
+    * Copies the buffered bytes of the ring out, without looking at the overflow chunks
+    */
+    int32 ReadRing(uint8* Dest, int32 NumBytes);
+    /**
+    * Wakes up WaitForBytes once the bytes it waits for have been written (producer side)
+    */
+    void NotifyWaiter();
+
+    /**
+    * Storage of the ring buffer, its size is a power of two
+    */
+    TArray<uint8> Buffer;
+    /**
+    * Mask mapping a monotonic position to an index in Buffer
+    */
+    uint64 IndexMask;
+    /**
+    * Monotonic count of bytes written, only advanced by the producer
+    */
+    std::atomic<uint64> WritePosition;
+    /**
+    * Monotonic count of bytes read, only advanced by the consumer
+    */
+    std::atomic<uint64> ReadPosition;
+    /**
+    * Bytes that did not fit into the ring buffer, in the order they were written
+    */
+    TQueue<TArray<uint8>, EQueueMode::Spsc> Overflow;
+    /**
+    * Offset of the next byte to read in the chunk at the head of Overflow, only used by the consumer
+    */
+    int32 OverflowChunkOffset;
+    /**
+    * Monotonic count of bytes put into Overflow, only advanced by the producer
+    */
+    std::atomic<uint64> OverflowWritePosition;
+    /**
+    * Monotonic count of bytes taken out of Overflow, only advanced by the consumer
+    */
+    std::atomic<uint64> OverflowReadPosition;
+    /**
+    * Set by the producer once the stream is complete
+    */
+    std::atomic<bool> bFinished;
+    /**
+    * Set by the producer if the stream ended because of an error
+    */
+    std::atomic<bool> bFailed;
+    /**
+    * Number of bytes WaitForBytes is waiting for, MAX_int32 while nobody waits
+    */
+    std::atomic<int32> WaitedBytes;
+    /**
+    * Set by StopWaiting
+    */
+    std::atomic<bool> bStopWaiting;
+    /**
+    * Triggered when WaitForBytes has to check the ring buffer again
+    */
+    FEvent* BytesEvent;
+};
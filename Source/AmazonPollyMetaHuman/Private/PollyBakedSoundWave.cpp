@@ -0,0 +1,214 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyBakedSoundWave.h"
+#include "PollySpeechAsset.h"
+#include "SpeechMemoryTracker.h"
+
+namespace {
+    const int32 SampleBytes = sizeof(int16);
+    const int32 PollyBytesPerSecond = 16000 * SampleBytes;
+}
+
+UPollyBakedSoundWave::UPollyBakedSoundWave(const FObjectInitializer& ObjectInitializer) :
+    Super(ObjectInitializer),
+    SpeechAsset(nullptr),
+    PlayCursor(0),
+    bPrimed(false),
+    PendingSeekBytes(INDEX_NONE),
+    UnderflowCount(0),
+    bStopped(false)
+{
+}
+
+void UPollyBakedSoundWave::SetSpeechAsset(UPollySpeechAsset* InSpeechAsset, int32 ReadAheadChunks) {
+    LLM_SCOPE_POLLY_SPEECH();
+    SpeechAsset = InSpeechAsset;
+    Slots.Reset();
+    for (int32 SlotIndex = 0; SlotIndex < FMath::Max(ReadAheadChunks, 1); SlotIndex++) {
+        TUniquePtr<FChunkSlot> Slot = MakeUnique<FChunkSlot>();
+        Slot->Data.SetNumUninitialized(UPollySpeechAsset::AudioChunkBytes);
+        FChunkSlot* SlotPtr = Slot.Get();
+        Slot->Callback = [SlotPtr](bool bWasCancelled, IBulkDataIORequest* Request) {
+            SlotPtr->State.store(bWasCancelled ? FChunkSlot::Failed : FChunkSlot::Ready, std::memory_order_release);
+        };
+        Slots.Add(MoveTemp(Slot));
+    }
+    PlayCursor = 0;
+    bPrimed = false;
+    // The first chunks are read before playback starts, so that the speech can start without silence
+    UpdateReadAhead();
+}
+
+void UPollyBakedSoundWave::Seek(float Seconds) {
+    const int64 SeekBytes = FMath::Max<int64>(static_cast<int64>(Seconds * PollyBytesPerSecond), 0);
+    PendingSeekBytes.store(SeekBytes - SeekBytes % SampleBytes, std::memory_order_release);
+}
+
+void UPollyBakedSoundWave::StopStream() {
+    bStopped.store(true, std::memory_order_release);
+}
+
+int32 UPollyBakedSoundWave::GetUnderflowCount() const {
+    return UnderflowCount.load(std::memory_order_relaxed);
+}
+
+int32 UPollyBakedSoundWave::GetResidentAudioBytes() const {
+    int32 ResidentBytes = 0;
+    for (const TUniquePtr<FChunkSlot>& Slot : Slots) {
+        ResidentBytes += Slot->Data.Num();
+    }
+    return ResidentBytes;
+}
+
+int32 UPollyBakedSoundWave::OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) {
+    OutAudio.Reset();
+    if (SpeechAsset == nullptr || Slots.Num() == 0) {
+        return 0;
+    }
+    if (bStopped.load(std::memory_order_acquire)) {
+        CancelReads();
+        return 0;
+    }
+    const int64 SeekBytes = PendingSeekBytes.exchange(INDEX_NONE, std::memory_order_acq_rel);
+    if (SeekBytes != INDEX_NONE) {
+        PlayCursor = SeekBytes;
+        bPrimed = false;
+    }
+    const int64 NumAudioBytes = SpeechAsset->GetNumAudioBytes();
+    if (PlayCursor >= NumAudioBytes) {
+        return 0;
+    }
+    UpdateReadAhead();
+    const int32 BytesNeeded = NumSamples * SampleBytes;
+    OutAudio.AddZeroed(BytesNeeded);
+    int32 BytesWritten = 0;
+    bool bUnderflow = false;
+    while (BytesWritten < BytesNeeded && PlayCursor < NumAudioBytes) {
+        const int32 ChunkIndex = static_cast<int32>(PlayCursor / UPollySpeechAsset::AudioChunkBytes);
+        FChunkSlot* Slot = FindSlot(ChunkIndex);
+        const int32 State = Slot != nullptr ? Slot->State.load(std::memory_order_acquire) : FChunkSlot::Free;
+        if (State != FChunkSlot::Ready && State != FChunkSlot::Failed) {
+            bUnderflow = true;
+            break;
+        }
+        const int32 ChunkOffset = static_cast<int32>(PlayCursor - ChunkIndex * static_cast<int64>(UPollySpeechAsset::AudioChunkBytes));
+        const int32 ChunkSize = SpeechAsset->GetAudioChunkSize(ChunkIndex);
+        const int32 BytesToCopy = FMath::Min(BytesNeeded - BytesWritten, ChunkSize - ChunkOffset);
+        if (State == FChunkSlot::Ready) {
+            FMemory::Memcpy(OutAudio.GetData() + BytesWritten, Slot->Data.GetData() + ChunkOffset, BytesToCopy);
+        }
+        // A chunk that failed to read plays as silence rather than stalling the speech
+        BytesWritten += BytesToCopy;
+        PlayCursor += BytesToCopy;
+        if (ChunkOffset + BytesToCopy == ChunkSize) {
+            ReleaseSlot(*Slot);
+        }
+    }
+    if (bUnderflow && bPrimed) {
+        UnderflowCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    bPrimed |= BytesWritten > 0;
+    // The freed slots are refilled right away, so that reads stay ahead of the cursor by the whole window
+    UpdateReadAhead();
+    if (PlayCursor >= NumAudioBytes) {
+        // The last callback only returns what is left of the speech
+        const int32 SamplesWritten = (BytesWritten + SampleBytes - 1) / SampleBytes;
+        OutAudio.SetNum(SamplesWritten * SampleBytes, false);
+        return SamplesWritten;
+    }
+    return NumSamples;
+}
+
+bool UPollyBakedSoundWave::IsReadyForFinishDestroy() {
+    if (!Super::IsReadyForFinishDestroy()) {
+        return false;
+    }
+    // The audio render thread is done with the sound, the reads can be cancelled from here
+    CancelReads();
+    for (const TUniquePtr<FChunkSlot>& Slot : Slots) {
+        if (Slot->Request.IsValid() && !Slot->Request->PollCompletion()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UPollyBakedSoundWave::UpdateReadAhead() {
+    const int32 FirstChunkIndex = static_cast<int32>(PlayCursor / UPollySpeechAsset::AudioChunkBytes);
+    const int32 EndChunkIndex = FMath::Min(FirstChunkIndex + Slots.Num(), SpeechAsset->GetNumAudioChunks());
+    for (const TUniquePtr<FChunkSlot>& Slot : Slots) {
+        const bool bInWindow = Slot->ChunkIndex >= FirstChunkIndex && Slot->ChunkIndex < EndChunkIndex;
+        if (Slot->ChunkIndex != INDEX_NONE && !bInWindow && Slot->State.load(std::memory_order_acquire) != FChunkSlot::Reading) {
+            // Left behind by a seek
+            ReleaseSlot(*Slot);
+        }
+    }
+    for (int32 ChunkIndex = FirstChunkIndex; ChunkIndex < EndChunkIndex; ChunkIndex++) {
+        if (FindSlot(ChunkIndex) != nullptr) {
+            continue;
+        }
+        FChunkSlot* FreeSlot = FindSlot(INDEX_NONE);
+        if (FreeSlot == nullptr) {
+            // Stale reads are still in flight, the chunk is read once one of them completes
+            return;
+        }
+        StartRead(*FreeSlot, ChunkIndex);
+    }
+}
+
+void UPollyBakedSoundWave::StartRead(FChunkSlot& Slot, int32 ChunkIndex) {
+    Slot.ChunkIndex = ChunkIndex;
+    if (SpeechAsset->CopyResidentAudioChunk(ChunkIndex, Slot.Data.GetData())) {
+        Slot.State.store(FChunkSlot::Ready, std::memory_order_release);
+        return;
+    }
+    // Set before the read starts, since the callback may run before ReadAudioChunkAsync returns
+    Slot.State.store(FChunkSlot::Reading, std::memory_order_release);
+    Slot.Request.Reset(SpeechAsset->ReadAudioChunkAsync(ChunkIndex, Slot.Data.GetData(), &Slot.Callback));
+    if (!Slot.Request.IsValid()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to stream chunk %d of %s."), ChunkIndex, *SpeechAsset->GetPathName());
+        Slot.State.store(FChunkSlot::Failed, std::memory_order_release);
+    }
+}
+
+void UPollyBakedSoundWave::ReleaseSlot(FChunkSlot& Slot) {
+    if (Slot.Request.IsValid()) {
+        Slot.Request->WaitCompletion();
+        Slot.Request.Reset();
+    }
+    Slot.ChunkIndex = INDEX_NONE;
+    Slot.State.store(FChunkSlot::Free, std::memory_order_release);
+}
+
+void UPollyBakedSoundWave::CancelReads() {
+    for (const TUniquePtr<FChunkSlot>& Slot : Slots) {
+        if (Slot->Request.IsValid() && !Slot->Request->PollCompletion()) {
+            Slot->Request->Cancel();
+        }
+    }
+}
+
+UPollyBakedSoundWave::FChunkSlot* UPollyBakedSoundWave::FindSlot(int32 ChunkIndex) const {
+    for (const TUniquePtr<FChunkSlot>& Slot : Slots) {
+        if (Slot->ChunkIndex == ChunkIndex) {
+            return Slot.Get();
+        }
+    }
+    return nullptr;
+}
@@ -0,0 +1,161 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "Serialization/BulkData.h"
+#include <atomic>
+#include "PollyBakedSoundWave.generated.h"
+
+class UPollySpeechAsset;
+
+/**
+* Procedural sound wave that streams the audio of a UPollySpeechAsset on the audio render thread. Only a small
+* read-ahead window of chunks following the play cursor is kept in memory, whatever the length of the speech, and
+* the chunks are read from the package, pak file or container of the asset as the cursor advances. A chunk that
+* has not arrived in time is replaced by silence and counted as an underflow.
+*/
+UCLASS()
+class UPollyBakedSoundWave : public USoundWaveProcedural {
+
+    GENERATED_BODY()
+
+public:
+    /**
+    * Default constructor.
+    */
+    UPollyBakedSoundWave(const FObjectInitializer& ObjectInitializer);
+    /**
+    * Attaches the asset the audio is streamed from and starts reading its first chunks
+    * @param InSpeechAsset - the baked speech to play
+    * @param ReadAheadChunks - the number of chunks kept in memory, including the one being played
+    */
+    void SetSpeechAsset(UPollySpeechAsset* InSpeechAsset, int32 ReadAheadChunks);
+    /**
+    * Moves the play cursor at the next audio callback. Can be called from any thread.
+    * @param Seconds - the playback time to continue from
+    */
+    void Seek(float Seconds);
+    /**
+    * Stops the sound at the next audio callback and cancels the reads in flight. Can be called from any thread.
+    */
+    void StopStream();
+    /**
+    * Returns the number of audio callbacks that found the chunk under the play cursor still being read
+    */
+    int32 GetUnderflowCount() const;
+    /**
+    * Returns the memory held for the audio of the speech, which is bounded by the read-ahead window
+    */
+    int32 GetResidentAudioBytes() const;
+    /**
+    * Fills OutAudio with the next NumSamples samples of the speech. Called on the audio render thread.
+    * See USoundWaveProcedural::OnGeneratePCMAudio for details.
+    */
+    virtual int32 OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) override;
+    /**
+    * Waits for the reads in flight, which write into the chunks of the sound, before it is destroyed
+    */
+    virtual bool IsReadyForFinishDestroy() override;
+
+private:
+    /**
+    * A chunk of the read-ahead window
+    */
+    struct FChunkSlot {
+        enum EState : int32 {
+            Free,
+            Reading,
+            Ready,
+            Failed
+        };
+        /**
+        * The audio of the chunk, UPollySpeechAsset::AudioChunkBytes allocated once
+        */
+        TArray<uint8> Data;
+        /**
+        * Index of the chunk held, INDEX_NONE if the slot is free
+        */
+        int32 ChunkIndex = INDEX_NONE;
+        /**
+        * EState of the slot, set by the IO thread completing the read
+        */
+        std::atomic<int32> State{ Free };
+        /**
+        * The read in flight or completed
+        */
+        TUniquePtr<IBulkDataIORequest> Request;
+        /**
+        * Completion callback of Request, which must outlive it
+        */
+        FBulkDataIORequestCallBack Callback;
+    };
+
+    /**
+    * Frees the slots that fell out of the read-ahead window and starts reading the chunks missing from it
+    */
+    void UpdateReadAhead();
+    /**
+    * Starts reading a chunk into a free slot
+    */
+    void StartRead(FChunkSlot& Slot, int32 ChunkIndex);
+    /**
+    * Frees a slot whose read is not in flight
+    */
+    void ReleaseSlot(FChunkSlot& Slot);
+    /**
+    * Cancels the reads in flight
+    */
+    void CancelReads();
+    /**
+    * Returns the slot holding a chunk, nullptr if the chunk is not being read
+    */
+    FChunkSlot* FindSlot(int32 ChunkIndex) const;
+
+    /**
+    * The baked speech the audio is streamed from
+    */
+    UPROPERTY()
+    UPollySpeechAsset* SpeechAsset;
+    /**
+    * The read-ahead window, only accessed by the audio render thread once playback started
+    */
+    TArray<TUniquePtr<FChunkSlot>> Slots;
+    /**
+    * Position of the next byte to play
+    */
+    int64 PlayCursor;
+    /**
+    * Set once audio has been played since the start or the last seek
+    */
+    bool bPrimed;
+    /**
+    * Position set by Seek, INDEX_NONE if there is no seek to apply
+    */
+    std::atomic<int64> PendingSeekBytes;
+    /**
+    * Number of audio callbacks that found the chunk under the play cursor still being read
+    */
+    std::atomic<int32> UnderflowCount;
+    /**
+    * Set by StopStream
+    */
+    std::atomic<bool> bStopped;
+};
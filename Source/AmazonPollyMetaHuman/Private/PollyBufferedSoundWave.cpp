@@ -0,0 +1,94 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyBufferedSoundWave.h"
+
+UPollyBufferedSoundWave::UPollyBufferedSoundWave(const FObjectInitializer& ObjectInitializer) :
+    Super(ObjectInitializer),
+    ReadOffset(0),
+    bStopped(false)
+{
+}
+
+void UPollyBufferedSoundWave::SetAudio(const TArray<FPollyAudioBuffer>& InBuffers, int64 StartByte) {
+    FScopeLock lock(&Mutex);
+    Buffers.Reset();
+    ReadOffset = 0;
+    for (const FPollyAudioBuffer& Buffer : InBuffers) {
+        if (StartByte >= Buffer->Num()) {
+            StartByte -= Buffer->Num();
+            continue;
+        }
+        if (Buffers.Num() == 0) {
+            ReadOffset = static_cast<int32>(StartByte);
+        }
+        Buffers.Add(Buffer);
+    }
+}
+
+void UPollyBufferedSoundWave::AppendAudio(const TArray<FPollyAudioBuffer>& InBuffers) {
+    if (bStopped.load(std::memory_order_acquire)) {
+        return;
+    }
+    FScopeLock lock(&Mutex);
+    for (const FPollyAudioBuffer& Buffer : InBuffers) {
+        if (Buffer->Num() > 0) {
+            Buffers.Add(Buffer);
+        }
+    }
+}
+
+void UPollyBufferedSoundWave::StopStream() {
+    bStopped.store(true, std::memory_order_release);
+    FScopeLock lock(&Mutex);
+    Buffers.Empty();
+    ReadOffset = 0;
+}
+
+int64 UPollyBufferedSoundWave::GetRemainingAudioBytes() const {
+    FScopeLock lock(&Mutex);
+    return PollyAudioBuffer::NumBytes(Buffers) - ReadOffset;
+}
+
+int32 UPollyBufferedSoundWave::OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) {
+    OutAudio.Reset();
+    if (bStopped.load(std::memory_order_acquire)) {
+        return 0;
+    }
+    const int32 BytesNeeded = NumSamples * sizeof(int16);
+    OutAudio.SetNumUninitialized(BytesNeeded);
+    int32 BytesRead = 0;
+    {
+        FScopeLock lock(&Mutex);
+        while (BytesRead < BytesNeeded && Buffers.Num() > 0) {
+            const FPollyAudioData& Buffer = *Buffers[0];
+            const int32 NumBytes = FMath::Min(BytesNeeded - BytesRead, Buffer.Num() - ReadOffset);
+            FMemory::Memcpy(OutAudio.GetData() + BytesRead, Buffer.GetData() + ReadOffset, NumBytes);
+            BytesRead += NumBytes;
+            ReadOffset += NumBytes;
+            if (ReadOffset == Buffer.Num()) {
+                // Releases the buffer unless the speech component still holds it
+                Buffers.RemoveAt(0, 1, false);
+                ReadOffset = 0;
+            }
+        }
+    }
+    // Silence keeps the sound alive until more audio is appended
+    FMemory::Memzero(OutAudio.GetData() + BytesRead, BytesNeeded - BytesRead);
+    return NumSamples;
+}
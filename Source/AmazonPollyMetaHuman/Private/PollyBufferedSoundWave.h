@@ -0,0 +1,83 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "PollyAudioBuffer.h"
+#include <atomic>
+#include "PollyBufferedSoundWave.generated.h"
+
+/**
+* Procedural sound wave that plays the buffers of a speech where they are, instead of copying them into the audio
+* queue of USoundWaveProcedural first. The buffers are shared with the speech component, so the only copy of the
+* audio is the one into the output of each audio callback. While no audio is left, the sound is kept alive with
+* silence, so that the audio of a segment arriving later still plays.
+*/
+UCLASS()
+class UPollyBufferedSoundWave : public USoundWaveProcedural {
+
+    GENERATED_BODY()
+
+public:
+    /**
+    * Default constructor.
+    */
+    UPollyBufferedSoundWave(const FObjectInitializer& ObjectInitializer);
+    /**
+    * Sets the audio to play, replacing any audio that has not been played yet
+    * @param InBuffers - the buffers of the speech, in playback order
+    * @param StartByte - where in the buffers playback starts
+    */
+    void SetAudio(const TArray<FPollyAudioBuffer>& InBuffers, int64 StartByte);
+    /**
+    * Appends audio to the audio that has not been played yet. Can be called from any thread.
+    * @param InBuffers - the buffers, in playback order
+    */
+    void AppendAudio(const TArray<FPollyAudioBuffer>& InBuffers);
+    /**
+    * Stops the sound at the next audio callback, releasing the audio that has not been played yet.
+    * Can be called from any thread.
+    */
+    void StopStream();
+    /**
+    * Returns the number of bytes of audio that have not been played yet
+    */
+    int64 GetRemainingAudioBytes() const;
+    /**
+    * Fills OutAudio with the next NumSamples samples of the buffers. Called on the audio render thread.
+    * See USoundWaveProcedural::OnGeneratePCMAudio for details.
+    */
+    virtual int32 OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) override;
+
+private:
+    /**
+    * The buffers that have not been played completely, the first one from ReadOffset on
+    */
+    TArray<FPollyAudioBuffer> Buffers;
+    int32 ReadOffset;
+    /**
+    * Guards Buffers and ReadOffset, which are read on the audio render thread
+    */
+    mutable FCriticalSection Mutex;
+    /**
+    * Set by StopStream
+    */
+    std::atomic<bool> bStopped;
+};
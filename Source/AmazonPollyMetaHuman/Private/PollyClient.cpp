@@ -20,26 +20,249 @@
 #include <aws/polly/model/SynthesizeSpeechResult.h>
 #include <aws/polly/PollyRequest.h>
 #include <aws/core/utils/Outcome.h>
+#include <aws/core/http/HttpRequest.h>
+#include <aws/core/http/HttpResponse.h>
+#include <aws/polly/PollyErrors.h>
 #include <iostream>
+#include "PollySynthesisScheduler.h"
+#include "PollyResponseStream.h"
+#include "SpeechMetrics.h"
+#include "SpeechTextUtils.h"
+#include "SpeechTrace.h"
 
-PollyClient::PollyClient() {
+namespace {
+    const char* const StreamAllocationTag = "AmazonPollyMetaHuman";
+    /**
+    * Size of 1 ms of the 16 kHz, 16-bit mono pcm audio returned by Polly
+    */
+    const int32 PcmBytesPerMillisecond = 32;
+    /**
+    * Rough size of the speech marks Polly returns per character of text
+    */
+    const int32 SpeechMarkBytesPerCharacter = 48;
+
+    /**
+    * Returns true if Polly rejected a request for exceeding the request rate of the account
+    */
+    bool IsThrottlingError(const Aws::Client::AWSError<Aws::Polly::PollyErrors>& Error) {
+        return Error.GetErrorType() == Aws::Polly::PollyErrors::THROTTLING;
+    }
+
+    /**
+    * Estimates the size of the response to a request, so that its body is allocated once in most cases. The
+    * estimate of the audio is padded by a quarter, since speaking rates vary between voices.
+    * @param SpeechRequest - the request
+    * @return int32 - the expected size in bytes
+    */
+    int32 EstimateResponseBytes(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
+        const FString Text = UnrealAWSUtils::AwsStringToFString(SpeechRequest.GetText());
+        if (SpeechRequest.GetOutputFormat() == Aws::Polly::Model::OutputFormat::json) {
+            return Text.Len() * SpeechMarkBytesPerCharacter;
+        }
+        const int64 AudioBytes = static_cast<int64>(SpeechTextUtils::EstimateSpeechMilliseconds(Text)) * PcmBytesPerMillisecond * 5 / 4;
+        return static_cast<int32>(FMath::Min<int64>(AudioBytes, MAX_int32));
+    }
+
+    /**
+    * Collects the bytes of a streamed Polly response and forwards them to a ring buffer. Bytes are
+    * staged until the SDK reports the chunk as received, so that an error body returned by Polly
+    * (which is written to the same stream) never ends up in the audio. The error body is kept instead,
+    * for the SDK to read the type and message of the error from. Forwarding never waits for the
+    * consumer, so the worker is released as soon as the whole body has arrived.
+    */
+    class FPollyStreamSink {
+    public:
+        explicit FPollyStreamSink(TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> InRingBuffer) :
+            RingBuffer(InRingBuffer),
+            ErrorBody(MakeShared<FPollyResponseBody, ESPMode::ThreadSafe>(0))
+        {
+        }
+
+        /**
+        * Starts an attempt of the request over, the SDK creates a new stream for each of them
+        */
+        void BeginAttempt() {
+            StagedBytes.Reset();
+            ErrorBody->Reset();
+        }
+
+        TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> GetErrorBody() const {
+            return ErrorBody;
+        }
+
+        void Stage(const char* Data, std::streamsize NumBytes) {
+            StagedBytes.Append(reinterpret_cast<const uint8*>(Data), static_cast<int32>(NumBytes));
+        }
+
+        void Commit(bool bIsAudio) {
+            if (bIsAudio && StagedBytes.Num() > 0) {
+                FSpeechMetrics::Get().RecordBytesReceived(StagedBytes.Num());
+                RingBuffer->WriteAll(StagedBytes.GetData(), StagedBytes.Num());
+            }
+            else if (!bIsAudio && StagedBytes.Num() > 0) {
+                ErrorBody->Write(reinterpret_cast<const char*>(StagedBytes.GetData()), StagedBytes.Num());
+            }
+            StagedBytes.Reset();
+        }
+
+    private:
+        TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer;
+        TArray<uint8> StagedBytes;
+        TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> ErrorBody;
+    };
+
+    /**
+    * Stream buffer handing every write to a FPollyStreamSink. Reads and seeks go to the error body of the sink, and
+    * tellp reports every byte written, as the response stream buffer does.
+    */
+    class FPollyStreamSinkBuf : public FPollyResponseStreamBuf {
+    public:
+        explicit FPollyStreamSinkBuf(TSharedRef<FPollyStreamSink, ESPMode::ThreadSafe> InSink) :
+            FPollyResponseStreamBuf(InSink->GetErrorBody()),
+            Sink(InSink),
+            NumBytesWritten(0)
+        {
+        }
+
+    protected:
+        std::streamsize xsputn(const char* Data, std::streamsize NumBytes) override {
+            Sink->Stage(Data, NumBytes);
+            NumBytesWritten += NumBytes;
+            return NumBytes;
+        }
+
+        int_type overflow(int_type Character) override {
+            if (!traits_type::eq_int_type(Character, traits_type::eof())) {
+                const char Byte = traits_type::to_char_type(Character);
+                Sink->Stage(&Byte, 1);
+                NumBytesWritten++;
+            }
+            return traits_type::not_eof(Character);
+        }
+
+        int64 GetNumBytesWritten() const override {
+            return NumBytesWritten;
+        }
+
+    private:
+        TSharedRef<FPollyStreamSink, ESPMode::ThreadSafe> Sink;
+        int64 NumBytesWritten;
+    };
+
+    /**
+    * Response stream handed to the SDK in place of the default string stream
+    */
+    class FPollyStreamSinkStream : public Aws::IOStream {
+    public:
+        explicit FPollyStreamSinkStream(TSharedRef<FPollyStreamSink, ESPMode::ThreadSafe> Sink) :
+            Aws::IOStream(nullptr),
+            StreamBuf(Sink)
+        {
+            rdbuf(&StreamBuf);
+        }
+
+    private:
+        FPollyStreamSinkBuf StreamBuf;
+    };
+}
+
+PollyCancellationFlag MakePollyCancellationFlag() {
+    return MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+}
+
+PollyClient::PollyClient(const FString& EndpointOverride) {
     Aws::Client::ClientConfiguration configuration;
     configuration.userAgent = "request-source/AmazonPollyMetaHuman";
+    if (!EndpointOverride.IsEmpty()) {
+        configuration.endpointOverride = UnrealAWSUtils::FStringToAwsString(EndpointOverride);
+        if (EndpointOverride.StartsWith(TEXT("http://"))) {
+            configuration.scheme = Aws::Http::Scheme::HTTP;
+        }
+    }
     AwsPollyClient = MakeUnique<Aws::Polly::PollyClient>(configuration);
 }
 
 PollyClient::~PollyClient() {};
 
 PollyOutcome PollyClient::SynthesizeSpeech(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
+    POLLY_TRACE_SCOPE(PollyClient::SynthesizeSpeech);
     PollyOutcome Outcome;
-    Aws::Polly::Model::SynthesizeSpeechOutcome SpeechOutcome = AwsPollyClient->SynthesizeSpeech(SpeechRequest);
+    // The response is written straight into the body that becomes the StreamBuffer of the outcome. The SDK creates
+    // a new stream for every attempt of the request, each of which starts the body over.
+    TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body = MakeShared<FPollyResponseBody, ESPMode::ThreadSafe>(EstimateResponseBytes(SpeechRequest));
+    Aws::Polly::Model::SynthesizeSpeechRequest BufferedRequest(SpeechRequest);
+    BufferedRequest.SetResponseStreamFactory([Body]() -> Aws::IOStream* {
+        Body->Reset();
+        return Aws::New<FPollyResponseStream>(StreamAllocationTag, Body);
+    });
+    Aws::Polly::Model::SynthesizeSpeechOutcome SpeechOutcome = AwsPollyClient->SynthesizeSpeech(BufferedRequest);
     if (SpeechOutcome.IsSuccess()) {
-        Outcome.StreamBuffer = UnrealAWSUtils::PreparePollyData(SpeechOutcome.GetResult().GetAudioStream());
+        Outcome.StreamBuffer = Body->Take();
         Outcome.IsSuccess = true;
     }
     else {
         Outcome.IsSuccess = false;
+        Outcome.IsThrottled = IsThrottlingError(SpeechOutcome.GetError());
         Outcome.PollyErrorMsg = SpeechOutcome.GetError().GetMessage();
     }
     return Outcome;
-}
\ No newline at end of file
+}
+
+TFuture<PollyOutcome> PollyClient::SynthesizeSpeechAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) {
+    Aws::Polly::Model::SynthesizeSpeechRequest CancellableRequest(SpeechRequest);
+    // The SDK polls the continue handler while the request is being transferred, so raising
+    // the flag aborts the HTTP call instead of waiting for Polly to finish the response.
+    CancellableRequest.SetContinueRequestHandler([CancellationFlag](const Aws::Http::HttpRequest*) {
+        return !*CancellationFlag;
+    });
+    return FPollySynthesisScheduler::Get().Schedule(Scheduling, CancellationFlag, [this, CancellableRequest, CancellationFlag]() {
+        return SynthesizeCancellable(CancellableRequest, [this, &CancellableRequest]() { return SynthesizeSpeech(CancellableRequest); }, CancellationFlag);
+    });
+}
+
+TFuture<PollyOutcome> PollyClient::SynthesizeSpeechStreamAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) {
+    TSharedRef<FPollyStreamSink, ESPMode::ThreadSafe> Sink = MakeShared<FPollyStreamSink, ESPMode::ThreadSafe>(RingBuffer);
+    Aws::Polly::Model::SynthesizeSpeechRequest StreamingRequest(SpeechRequest);
+    StreamingRequest.SetContinueRequestHandler([CancellationFlag](const Aws::Http::HttpRequest*) {
+        return !*CancellationFlag;
+    });
+    StreamingRequest.SetResponseStreamFactory([Sink]() -> Aws::IOStream* {
+        Sink->BeginAttempt();
+        return Aws::New<FPollyStreamSinkStream>(StreamAllocationTag, Sink);
+    });
+    // Invoked by the HTTP client right after each chunk of the body has been written to the stream
+    StreamingRequest.SetDataReceivedEventHandler([Sink](const Aws::Http::HttpRequest*, Aws::Http::HttpResponse* Response, long long) {
+        Sink->Commit(Response->GetResponseCode() == Aws::Http::HttpResponseCode::OK);
+    });
+    return FPollySynthesisScheduler::Get().Schedule(Scheduling, CancellationFlag, [this, StreamingRequest, CancellationFlag]() {
+        return SynthesizeCancellable(StreamingRequest, [this, &StreamingRequest]() {
+            PollyOutcome StreamOutcome;
+            Aws::Polly::Model::SynthesizeSpeechOutcome SpeechOutcome = AwsPollyClient->SynthesizeSpeech(StreamingRequest);
+            StreamOutcome.IsSuccess = SpeechOutcome.IsSuccess();
+            if (!StreamOutcome.IsSuccess) {
+                StreamOutcome.IsThrottled = IsThrottlingError(SpeechOutcome.GetError());
+                StreamOutcome.PollyErrorMsg = SpeechOutcome.GetError().GetMessage();
+            }
+            return StreamOutcome;
+        }, CancellationFlag);
+    });
+}
+
+PollyOutcome PollyClient::SynthesizeCancellable(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const TFunction<PollyOutcome()>& Synthesize, const PollyCancellationFlag& CancellationFlag) {
+    PollyOutcome Outcome;
+    if (!*CancellationFlag) {
+        const double StartSeconds = FPlatformTime::Seconds();
+        Outcome = Synthesize();
+        // A failure seen after the flag went up is the abort itself rather than an error of its own
+        if (Outcome.IsSuccess || !CancellationFlag->AtomicSet(true)) {
+            FSpeechMetrics::Get().RecordRequest(SpeechRequest, FPlatformTime::Seconds() - StartSeconds, Outcome);
+            return Outcome;
+        }
+    }
+    FSpeechMetrics::Get().RecordCancelledRequest();
+    Outcome.IsSuccess = false;
+    Outcome.IsCancelled = true;
+    Outcome.StreamBuffer = PollyAudioBuffer::GetEmpty();
+    Outcome.PollyErrorMsg = "Request cancelled";
+    return Outcome;
+}
@@ -21,7 +21,13 @@
 #include <aws/core/Aws.h>
 #include <aws/polly/model/SynthesizeSpeechRequest.h>
 #include "UnrealAWSUtils.h"
+#include "PollyAudioRingBuffer.h"
+#include "PollyAudioBuffer.h"
 #include <aws/polly/PollyClient.h>
+#include "Async/Future.h"
+#include "HAL/ThreadSafeBool.h"
+#include "Templates/SharedPointer.h"
+#include "SpeechPriority.h"
 
 /**
 * Struct containing Polly data, to be used in SynthesizeSpeech 
@@ -32,10 +38,49 @@
 */
 struct PollyOutcome {
     bool IsSuccess;
-    TArray<uint8> StreamBuffer;
+    /**
+    * Body of the response, shared rather than copied by the consumers of the outcome
+    */
+    FPollyAudioBuffer StreamBuffer = PollyAudioBuffer::GetEmpty();
     Aws::String PollyErrorMsg; 
+    /**
+    * True if the request was aborted through its cancellation flag rather than failing on its own
+    */
+    bool IsCancelled = false;
+    /**
+    * True if Polly rejected the request for exceeding the request rate of the account
+    */
+    bool IsThrottled = false;
+};
+
+/**
+* Flag shared by a group of Polly requests. Raising it aborts every request in the group that is
+* still in flight, and a request that fails raises it so that its siblings are aborted as well.
+*/
+using PollyCancellationFlag = TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe>;
+
+/**
+* How a single Polly request is scheduled
+*/
+struct FPollyRequestScheduling {
+    ESpeechPriority Priority = ESpeechPriority::Normal;
+    /**
+    * FPlatformTime::Seconds() by which the request must have been sent, or 0 for no deadline. A request that is
+    * still waiting at its deadline fails without being sent.
+    */
+    double DeadlineSeconds = 0.0;
+    /**
+    * Utterance the request is traced as part of, see SpeechTrace. 0 for requests of no utterance, e.g. of the warmup.
+    */
+    uint32 TraceUtteranceId = 0;
 };
 
+/**
+* Creates a new, lowered PollyCancellationFlag
+* @return PollyCancellationFlag - the flag
+*/
+PollyCancellationFlag MakePollyCancellationFlag();
+
 /**
 * Wrapper for PollyClient that calls on Polly API, encapsulates AWS Polly SDK  
 */
@@ -50,8 +95,10 @@ private:
 public:
     /*
     * Creates the PollyClient
+    * @param EndpointOverride - the endpoint to send requests to instead of Polly, e.g. "http://localhost:4566" for a
+    * local stand-in, or empty for Polly
     */
-    PollyClient();
+    explicit PollyClient(const FString& EndpointOverride = FString());
 
     virtual ~PollyClient();
     /**
@@ -60,4 +107,39 @@ public:
     * @return PollyOutcome - the struct containing the PollyData
     */
     virtual PollyOutcome SynthesizeSpeech(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest);
-};
\ No newline at end of file
+    /**
+    * Queues a SynthesizeSpeech call on the FPollySynthesisScheduler and returns immediately, so that several
+    * requests can be in flight at the same time. The HTTP transfer is aborted as soon as the
+    * CancellationFlag is raised, and a failed request raises the flag itself.
+    * @param SpeechRequest - a configured SpeechRequest to be synthesized
+    * @param Scheduling - the priority and deadline of the request
+    * @param CancellationFlag - the flag shared by all requests that must succeed or fail together
+    * @return TFuture<PollyOutcome> - future fulfilled with the struct containing the PollyData
+    */
+    virtual TFuture<PollyOutcome> SynthesizeSpeechAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag);
+    /**
+    * Queues a SynthesizeSpeech call on the FPollySynthesisScheduler that writes the audio into RingBuffer chunk by chunk
+    * as the HTTP response arrives, instead of collecting it into PollyOutcome::StreamBuffer. Whenever the
+    * ring buffer is full, the audio goes to its overflow chunks rather than waiting for the consumer to catch up,
+    * so a slow consumer never holds a worker of the scheduler. The ring buffer is not finished
+    * when the call completes, so that the caller can append the audio of further requests to it.
+    * @param SpeechRequest - a configured SpeechRequest to be synthesized
+    * @param RingBuffer - the ring buffer receiving the audio
+    * @param Scheduling - the priority and deadline of the request
+    * @param CancellationFlag - the flag shared by all requests that must succeed or fail together
+    * @return TFuture<PollyOutcome> - future fulfilled with the outcome of the call (with an empty StreamBuffer)
+    */
+    virtual TFuture<PollyOutcome> SynthesizeSpeechStreamAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag);
+
+protected:
+    /**
+    * Runs a single synthesis under the rules of a PollyCancellationFlag: a raised flag skips the call
+    * and marks the outcome as cancelled, and a failure that was not caused by the flag raises it. The outcome and
+    * its latency are counted in FSpeechMetrics.
+    * @param SpeechRequest - the request Synthesize sends
+    * @param Synthesize - the function performing the call to Polly
+    * @param CancellationFlag - the flag shared by the request group
+    * @return PollyOutcome - the outcome of Synthesize, or a cancelled outcome
+    */
+    static PollyOutcome SynthesizeCancellable(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const TFunction<PollyOutcome()>& Synthesize, const PollyCancellationFlag& CancellationFlag);
+};
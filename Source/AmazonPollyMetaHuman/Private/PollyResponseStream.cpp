@@ -0,0 +1,119 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyResponseStream.h"
+#include "SpeechMemoryTracker.h"
+
+FPollyResponseBody::FPollyResponseBody(int32 InExpectedBytes) :
+    ExpectedBytes(FMath::Max(InExpectedBytes, 0))
+{
+}
+
+void FPollyResponseBody::Reset() {
+    LLM_SCOPE_POLLY_SPEECH();
+    Data.Reset();
+    Data.Reserve(ExpectedBytes);
+}
+
+void FPollyResponseBody::Write(const char* Bytes, std::streamsize NumBytes) {
+    LLM_SCOPE_POLLY_SPEECH();
+    Data.Append(reinterpret_cast<const uint8*>(Bytes), static_cast<int32>(NumBytes));
+}
+
+const TArray<uint8>& FPollyResponseBody::GetData() const {
+    return Data;
+}
+
+FPollyAudioBuffer FPollyResponseBody::Take() {
+    return PollyAudioBuffer::Make(MoveTemp(Data));
+}
+
+FPollyResponseStreamBuf::FPollyResponseStreamBuf(TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> InBody) :
+    Body(InBody),
+    ReadOffset(0)
+{
+}
+
+std::streamsize FPollyResponseStreamBuf::xsputn(const char* Bytes, std::streamsize NumBytes) {
+    Body->Write(Bytes, NumBytes);
+    return NumBytes;
+}
+
+FPollyResponseStreamBuf::int_type FPollyResponseStreamBuf::overflow(int_type Character) {
+    if (!traits_type::eq_int_type(Character, traits_type::eof())) {
+        const char Byte = traits_type::to_char_type(Character);
+        Body->Write(&Byte, 1);
+    }
+    return traits_type::not_eof(Character);
+}
+
+FPollyResponseStreamBuf::int_type FPollyResponseStreamBuf::underflow() {
+    // The get area is set again on each underflow, since writes may have moved the bytes meanwhile
+    ReadOffset += static_cast<int32>(gptr() - eback());
+    const TArray<uint8>& Data = Body->GetData();
+    if (ReadOffset >= Data.Num()) {
+        setg(nullptr, nullptr, nullptr);
+        return traits_type::eof();
+    }
+    char* Begin = const_cast<char*>(reinterpret_cast<const char*>(Data.GetData()));
+    setg(Begin + ReadOffset, Begin + ReadOffset, Begin + Data.Num());
+    return traits_type::to_int_type(*gptr());
+}
+
+FPollyResponseStreamBuf::pos_type FPollyResponseStreamBuf::seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which) {
+    const pos_type Failed = pos_type(off_type(-1));
+    if (Which & std::ios_base::in) {
+        const int32 NumBytes = Body->GetData().Num();
+        off_type Position = Offset;
+        if (Direction == std::ios_base::cur) {
+            Position += ReadOffset + (gptr() - eback());
+        }
+        else if (Direction == std::ios_base::end) {
+            Position += NumBytes;
+        }
+        if (Position < 0 || Position > NumBytes) {
+            return Failed;
+        }
+        // The get area is set again by the next underflow, at the new position
+        ReadOffset = static_cast<int32>(Position);
+        setg(nullptr, nullptr, nullptr);
+        return pos_type(Position);
+    }
+    if (Which & std::ios_base::out) {
+        // Bytes are only ever appended, so the write position can be told but not moved
+        const off_type NumWritten = GetNumBytesWritten();
+        const off_type Position = Direction == std::ios_base::beg ? Offset : NumWritten + Offset;
+        return Position == NumWritten ? pos_type(Position) : Failed;
+    }
+    return Failed;
+}
+
+FPollyResponseStreamBuf::pos_type FPollyResponseStreamBuf::seekpos(pos_type Position, std::ios_base::openmode Which) {
+    return seekoff(off_type(Position), std::ios_base::beg, Which);
+}
+
+int64 FPollyResponseStreamBuf::GetNumBytesWritten() const {
+    return Body->GetData().Num();
+}
+
+FPollyResponseStream::FPollyResponseStream(TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body) :
+    Aws::IOStream(nullptr),
+    StreamBuf(Body)
+{
+    rdbuf(&StreamBuf);
+}
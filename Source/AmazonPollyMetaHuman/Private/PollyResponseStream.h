@@ -0,0 +1,97 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <aws/core/Aws.h>
+#include <streambuf>
+#include "PollyAudioBuffer.h"
+
+/**
+* Body of a Polly response, written by the SDK through a FPollyResponseStream. The bytes are written into a single
+* allocation reserved for the expected size of the response, and handed over to the outcome without a copy.
+*/
+class FPollyResponseBody {
+public:
+    /**
+    * @param InExpectedBytes - the expected size of the response. A larger response grows the allocation.
+    */
+    explicit FPollyResponseBody(int32 InExpectedBytes);
+    /**
+    * Drops the bytes written so far, keeping their allocation, e.g. when the SDK retries the request
+    */
+    void Reset();
+    /**
+    * Appends bytes of the response
+    */
+    void Write(const char* Bytes, std::streamsize NumBytes);
+    /**
+    * Returns the bytes written so far
+    */
+    const TArray<uint8>& GetData() const;
+    /**
+    * Moves the bytes written so far into an immutable buffer, leaving the body empty
+    * @return FPollyAudioBuffer - the buffer
+    */
+    FPollyAudioBuffer Take();
+
+private:
+    int32 ExpectedBytes;
+    TArray<uint8> Data;
+};
+
+/**
+* Stream buffer writing into a FPollyResponseBody. The body can be read back, which the SDK does to parse the error
+* returned by Polly. The SDK only parses a body whose size tellp reports, so the buffer reports the position of both
+* ends, and the read position can be moved within the body.
+*/
+class FPollyResponseStreamBuf : public std::streambuf {
+public:
+    explicit FPollyResponseStreamBuf(TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> InBody);
+
+protected:
+    std::streamsize xsputn(const char* Bytes, std::streamsize NumBytes) override;
+    int_type overflow(int_type Character) override;
+    int_type underflow() override;
+    pos_type seekoff(off_type Offset, std::ios_base::seekdir Direction, std::ios_base::openmode Which) override;
+    pos_type seekpos(pos_type Position, std::ios_base::openmode Which) override;
+    /**
+    * Returns the number of bytes written through the buffer, the position tellp reports
+    */
+    virtual int64 GetNumBytesWritten() const;
+
+private:
+    TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body;
+    /**
+    * Number of bytes read back before the current get area
+    */
+    int32 ReadOffset;
+};
+
+/**
+* Response stream handed to the SDK in place of its default string stream, which would grow, and thereby copy, the
+* response several times before it could be copied out of it once more
+*/
+class FPollyResponseStream : public Aws::IOStream {
+public:
+    explicit FPollyResponseStream(TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body);
+
+private:
+    FPollyResponseStreamBuf StreamBuf;
+};
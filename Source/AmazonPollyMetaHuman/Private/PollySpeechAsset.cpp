@@ -0,0 +1,123 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySpeechAsset.h"
+#include "SpeechCache.h"
+#include "SpeechDiskCache.h"
+#include "SpeechEnvelope.h"
+
+namespace {
+    const float PollyBytesPerSecond = 16000 * sizeof(int16);
+}
+
+void UPollySpeechAsset::Serialize(FArchive& Ar) {
+    Super::Serialize(Ar);
+    FScopeLock lock(&AudioBulkDataMutex);
+    AudioBulkData.Serialize(Ar, this);
+}
+
+void UPollySpeechAsset::SetSpeech(const FString& InText, const EVoiceId InVoiceId, const TArray<uint8>& InAudio, const TArray<VisemeEvent>& InVisemeEvents) {
+    Text = InText;
+    VoiceId = InVoiceId;
+    SourceHash = GetSourceHash(InText, InVoiceId);
+    {
+        FScopeLock lock(&AudioBulkDataMutex);
+        // Kept out of the export so that the audio can be streamed from the .ubulk file of the cooked package
+        AudioBulkData.SetBulkDataFlags(BULKDATA_Force_NOT_InlinePayload);
+        AudioBulkData.Lock(LOCK_READ_WRITE);
+        FMemory::Memcpy(AudioBulkData.Realloc(InAudio.Num()), InAudio.GetData(), InAudio.Num());
+        AudioBulkData.Unlock();
+    }
+    Visemes.Reset(InVisemeEvents.Num());
+    VisemeTimesMs.Reset(InVisemeEvents.Num());
+    for (const VisemeEvent& Event : InVisemeEvents) {
+        Visemes.Add(Event.Viseme);
+        VisemeTimesMs.Add(Event.TimeMilliseconds);
+    }
+    IntensityEnvelope.Reset();
+    SpeechEnvelope::Compute(InAudio, IntensityEnvelope);
+}
+
+bool UPollySpeechAsset::IsUpToDate(const FString& InText, const EVoiceId InVoiceId) const {
+    return SourceHash == GetSourceHash(InText, InVoiceId) && Visemes.Num() > 0 && GetNumAudioBytes() > 0 && IntensityEnvelope.Num() > 0;
+}
+
+int32 UPollySpeechAsset::GetNumAudioBytes() const {
+    return static_cast<int32>(AudioBulkData.GetBulkDataSize());
+}
+
+int32 UPollySpeechAsset::GetNumAudioChunks() const {
+    return FMath::DivideAndRoundUp(GetNumAudioBytes(), AudioChunkBytes);
+}
+
+int32 UPollySpeechAsset::GetAudioChunkSize(int32 ChunkIndex) const {
+    return FMath::Clamp(GetNumAudioBytes() - ChunkIndex * AudioChunkBytes, 0, AudioChunkBytes);
+}
+
+bool UPollySpeechAsset::CopyResidentAudioChunk(int32 ChunkIndex, uint8* Dest) const {
+    FScopeLock lock(&AudioBulkDataMutex);
+    if (!AudioBulkData.IsBulkDataLoaded()) {
+        return false;
+    }
+    const uint8* AudioData = static_cast<const uint8*>(AudioBulkData.LockReadOnly());
+    FMemory::Memcpy(Dest, AudioData + ChunkIndex * AudioChunkBytes, GetAudioChunkSize(ChunkIndex));
+    AudioBulkData.Unlock();
+    return true;
+}
+
+IBulkDataIORequest* UPollySpeechAsset::ReadAudioChunkAsync(int32 ChunkIndex, uint8* Dest, FBulkDataIORequestCallBack* Callback) const {
+    if (!AudioBulkData.CanLoadFromDisk()) {
+        return nullptr;
+    }
+    return AudioBulkData.CreateStreamingRequest(ChunkIndex * AudioChunkBytes, GetAudioChunkSize(ChunkIndex), AIOP_High, Callback, Dest);
+}
+
+bool UPollySpeechAsset::GetAudio(TArray<uint8>& OutAudio) const {
+    OutAudio.SetNumUninitialized(GetNumAudioBytes());
+    for (int32 ChunkIndex = 0; ChunkIndex < GetNumAudioChunks(); ChunkIndex++) {
+        uint8* Dest = OutAudio.GetData() + ChunkIndex * AudioChunkBytes;
+        if (CopyResidentAudioChunk(ChunkIndex, Dest)) {
+            continue;
+        }
+        TUniquePtr<IBulkDataIORequest> Request(ReadAudioChunkAsync(ChunkIndex, Dest, nullptr));
+        if (!Request.IsValid() || !Request->WaitCompletion() || Request->GetSize() != GetAudioChunkSize(ChunkIndex)) {
+            UE_LOG(LogPollyMsg, Error, TEXT("Failed to load the audio of %s."), *GetPathName());
+            OutAudio.Empty();
+            return false;
+        }
+    }
+    return true;
+}
+
+void UPollySpeechAsset::GetVisemeEvents(TArray<VisemeEvent>& OutVisemeEvents) const {
+    OutVisemeEvents.Reset(Visemes.Num());
+    for (int32 VisemeIndex = 0; VisemeIndex < Visemes.Num() && VisemeIndex < VisemeTimesMs.Num(); VisemeIndex++) {
+        VisemeEvent Event;
+        Event.Viseme = Visemes[VisemeIndex];
+        Event.TimeMilliseconds = VisemeTimesMs[VisemeIndex];
+        OutVisemeEvents.Add(Event);
+    }
+}
+
+float UPollySpeechAsset::GetDurationSeconds() const {
+    return GetNumAudioBytes() / PollyBytesPerSecond;
+}
+
+FString UPollySpeechAsset::GetSourceHash(const FString& InText, const EVoiceId InVoiceId) {
+    return FSpeechDiskCache::HashKey(FSpeechCache::MakeKey(InText, InVoiceId, FSpeechCache::OutputFormat));
+}
@@ -0,0 +1,125 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySpeechBakeCommandlet.h"
+#include "Engine/DataTable.h"
+#include "Misc/FileHelper.h"
+#include "Misc/PackageName.h"
+#include "PollySpeechAsset.h"
+#include "PollySpeechBaker.h"
+#include "UObject/Package.h"
+
+UPollySpeechBakeCommandlet::UPollySpeechBakeCommandlet() {
+    IsClient = false;
+    IsServer = false;
+    IsEditor = true;
+    LogToConsole = true;
+}
+
+int32 UPollySpeechBakeCommandlet::Main(const FString& Params) {
+#if WITH_EDITOR
+    FString LinesPath;
+    FString DataTablePath;
+    FString OutputPath = TEXT("/Game/Speech");
+    FString Endpoint;
+    int32 Concurrency = 4;
+    float RequestsPerSecond = 8.0f;
+    FParse::Value(*Params, TEXT("Lines="), LinesPath);
+    FParse::Value(*Params, TEXT("DataTable="), DataTablePath);
+    FParse::Value(*Params, TEXT("OutputPath="), OutputPath);
+    FParse::Value(*Params, TEXT("Endpoint="), Endpoint);
+    FParse::Value(*Params, TEXT("Concurrency="), Concurrency);
+    FParse::Value(*Params, TEXT("RequestsPerSecond="), RequestsPerSecond);
+    const bool bForce = FParse::Param(*Params, TEXT("Force"));
+
+    UDataTable* Table = nullptr;
+    if (!DataTablePath.IsEmpty()) {
+        Table = LoadObject<UDataTable>(nullptr, *DataTablePath);
+    }
+    else if (!LinesPath.IsEmpty()) {
+        FString Csv;
+        if (!FFileHelper::LoadFileToString(Csv, *LinesPath)) {
+            UE_LOG(LogPollyMsg, Error, TEXT("Failed to read %s."), *LinesPath);
+            return 1;
+        }
+        Table = NewObject<UDataTable>();
+        Table->RowStruct = FPollySpeechLine::StaticStruct();
+        for (const FString& Problem : Table->CreateTableFromCSVString(Csv)) {
+            UE_LOG(LogPollyMsg, Warning, TEXT("%s: %s"), *LinesPath, *Problem);
+        }
+    }
+    if (Table == nullptr || Table->GetRowStruct() != FPollySpeechLine::StaticStruct()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("PollySpeechBake needs -Lines=<csv file> or -DataTable=<data table of FPollySpeechLine>."));
+        return 1;
+    }
+
+    // Lines whose asset holds the speech of the same text and voice are skipped
+    TArray<FPollySpeechBakeLine> Lines;
+    int32 NumUpToDate = 0;
+    for (const FName& RowName : Table->GetRowNames()) {
+        const FPollySpeechLine* Row = Table->FindRow<FPollySpeechLine>(RowName, TEXT("PollySpeechBake"));
+        if (Row == nullptr || Row->Text.IsEmpty()) {
+            continue;
+        }
+        const FString PackageName = FPaths::Combine(OutputPath, RowName.ToString());
+        if (!bForce && FPackageName::DoesPackageExist(PackageName)) {
+            const UPollySpeechAsset* Existing = LoadObject<UPollySpeechAsset>(nullptr, *(PackageName + TEXT(".") + RowName.ToString()), nullptr, LOAD_NoWarn | LOAD_Quiet);
+            if (Existing != nullptr && Existing->IsUpToDate(Row->Text, Row->VoiceId)) {
+                NumUpToDate++;
+                continue;
+            }
+        }
+        Lines.Add({ RowName, Row->Text, Row->VoiceId });
+    }
+    UE_LOG(LogPollyMsg, Display, TEXT("Baking %d lines, %d lines are up to date."), Lines.Num(), NumUpToDate);
+
+    USpeechComponent* SpeechComponent = NewObject<USpeechComponent>();
+    SpeechComponent->PollyEndpointOverride = Endpoint;
+    SpeechComponent->bUseSpeechCache = false;
+    FPollySpeechBaker Baker(SpeechComponent, Concurrency, RequestsPerSecond);
+    const TArray<FPollySpeechBakeResult> Results = Baker.Bake(Lines);
+
+    int32 NumFailed = 0;
+    for (int32 LineIndex = 0; LineIndex < Lines.Num(); LineIndex++) {
+        const FPollySpeechBakeLine& Line = Lines[LineIndex];
+        if (!Results[LineIndex].bSucceeded) {
+            NumFailed++;
+            continue;
+        }
+        const FString AssetName = Line.Name.ToString();
+        const FString PackageName = FPaths::Combine(OutputPath, AssetName);
+        UPackage* Package = CreatePackage(*PackageName);
+        UPollySpeechAsset* Asset = FindObject<UPollySpeechAsset>(Package, *AssetName);
+        if (Asset == nullptr) {
+            Asset = NewObject<UPollySpeechAsset>(Package, *AssetName, RF_Public | RF_Standalone);
+        }
+        Asset->SetSpeech(Line.Text, Line.VoiceId, Results[LineIndex].Audio, Results[LineIndex].Visemes);
+        Package->MarkPackageDirty();
+        const FString Filename = FPackageName::LongPackageNameToFilename(PackageName, FPackageName::GetAssetPackageExtension());
+        if (!UPackage::SavePackage(Package, Asset, RF_Public | RF_Standalone, *Filename)) {
+            UE_LOG(LogPollyMsg, Error, TEXT("Failed to save %s."), *Filename);
+            NumFailed++;
+        }
+    }
+    UE_LOG(LogPollyMsg, Display, TEXT("Baked %d lines, %d failed."), Lines.Num() - NumFailed, NumFailed);
+    return NumFailed > 0 ? 1 : 0;
+#else
+    UE_LOG(LogPollyMsg, Error, TEXT("PollySpeechBake can only run in the editor."));
+    return 1;
+#endif
+}
@@ -0,0 +1,46 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PollySpeechBakeCommandlet.generated.h"
+
+/**
+* Synthesizes the lines of a data table of FPollySpeechLine into UPollySpeechAsset assets, so that scripted speech
+* plays without calling Polly. Only lines whose text or voice changed since they were last baked are synthesized.
+*
+* Usage: UE4Editor-Cmd <project> -run=PollySpeechBake (-Lines=<csv file> | -DataTable=<data table path>)
+*     [-OutputPath=/Game/Speech] [-Concurrency=4] [-RequestsPerSecond=8] [-Endpoint=<url>] [-Force]
+*
+* The csv file has the columns of FPollySpeechLine: Name,Text,VoiceId. -Endpoint sends the requests to a local
+* stand-in instead of Polly, and -Force bakes every line.
+*/
+UCLASS()
+class UPollySpeechBakeCommandlet : public UCommandlet {
+    GENERATED_BODY()
+
+public:
+    UPollySpeechBakeCommandlet();
+    /**
+    * Bakes the lines. See UCommandlet::Main for details.
+    * @return int32 - 0 if every line is baked
+    */
+    virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,90 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySpeechBaker.h"
+#include "Async/Async.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "Misc/ScopeLock.h"
+#include "SpeechTextUtils.h"
+
+FPollySpeechBaker::FPollySpeechBaker(USpeechComponent* InSpeechComponent, int32 InMaxConcurrentLines, float InMaxRequestsPerSecond) :
+    SpeechComponent(InSpeechComponent),
+    MaxConcurrentLines(FMath::Max(InMaxConcurrentLines, 1)),
+    MaxRequestsPerSecond(FMath::Max(InMaxRequestsPerSecond, 0.0f))
+{
+}
+
+TArray<FPollySpeechBakeResult> FPollySpeechBaker::Bake(const TArray<FPollySpeechBakeLine>& Lines) {
+    if (!SpeechComponent->MyPollyClient.IsValid()) {
+        SpeechComponent->InitializePollyClient();
+    }
+    TArray<FPollySpeechBakeResult> Results;
+    Results.SetNum(Lines.Num());
+    NextLineIndex = 0;
+    NextRequestSeconds = FPlatformTime::Seconds();
+    // Each worker mostly waits for Polly, so it gets a thread of its own rather than holding a task graph thread
+    TArray<TFuture<void>> Workers;
+    for (int32 WorkerIndex = 0; WorkerIndex < FMath::Min(MaxConcurrentLines, Lines.Num()); WorkerIndex++) {
+        Workers.Add(Async(EAsyncExecution::Thread, [this, &Lines, &Results]() {
+            int32 LineIndex;
+            while (PopLine(Lines.Num(), LineIndex)) {
+                const FPollySpeechBakeLine& Line = Lines[LineIndex];
+                FPollySpeechBakeResult& Result = Results[LineIndex];
+                // Every segment of the text takes an audio and a viseme request
+                WaitForRequestSlots(2 * SpeechTextUtils::SplitText(Line.Text, SpeechTextUtils::PollyMaxTextLength, SpeechComponent->bPipelineSentences).Num());
+                TArray<FPollyAudioBuffer> Audio;
+                Result.bSucceeded = SpeechComponent->SynthesizeSpeechSync(Line.Text, Line.VoiceId, MakePollyCancellationFlag(), FPollyRequestScheduling(), Audio, Result.Visemes);
+                // The asset stores the audio of the line in one piece
+                PollyAudioBuffer::Flatten(Audio, Result.Audio);
+                if (!Result.bSucceeded) {
+                    UE_LOG(LogPollyMsg, Warning, TEXT("Failed to bake line %s."), *Line.Name.ToString());
+                }
+            }
+        }));
+    }
+    for (const TFuture<void>& Worker : Workers) {
+        Worker.Wait();
+    }
+    return Results;
+}
+
+bool FPollySpeechBaker::PopLine(int32 NumLines, int32& OutLineIndex) {
+    FScopeLock lock(&Mutex);
+    if (NextLineIndex >= NumLines) {
+        return false;
+    }
+    OutLineIndex = NextLineIndex++;
+    return true;
+}
+
+void FPollySpeechBaker::WaitForRequestSlots(int32 NumRequests) {
+    if (MaxRequestsPerSecond <= 0.0f) {
+        return;
+    }
+    double StartSeconds;
+    {
+        FScopeLock lock(&Mutex);
+        StartSeconds = FMath::Max(NextRequestSeconds, FPlatformTime::Seconds());
+        NextRequestSeconds = StartSeconds + NumRequests / MaxRequestsPerSecond;
+    }
+    const double WaitSeconds = StartSeconds - FPlatformTime::Seconds();
+    if (WaitSeconds > 0.0) {
+        FPlatformProcess::Sleep(static_cast<float>(WaitSeconds));
+    }
+}
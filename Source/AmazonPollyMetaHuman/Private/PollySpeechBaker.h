@@ -0,0 +1,83 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpeechComponent.h"
+
+/**
+* A line to bake, named after the asset it is baked into
+*/
+struct FPollySpeechBakeLine {
+    FName Name;
+    FString Text;
+    EVoiceId VoiceId;
+};
+
+/**
+* The synthesized speech of a line
+*/
+struct FPollySpeechBakeResult {
+    bool bSucceeded = false;
+    TArray<uint8> Audio;
+    TArray<VisemeEvent> Visemes;
+};
+
+/**
+* Synthesizes lines with a speech component, several at a time and without exceeding a request rate, for the
+* PollySpeechBake commandlet
+*/
+class FPollySpeechBaker {
+public:
+    /**
+    * @param InSpeechComponent - the component whose Polly client and settings are used
+    * @param InMaxConcurrentLines - the maximum number of lines synthesized at the same time
+    * @param InMaxRequestsPerSecond - the maximum rate at which Polly requests are started, 0 for no limit
+    */
+    FPollySpeechBaker(USpeechComponent* InSpeechComponent, int32 InMaxConcurrentLines, float InMaxRequestsPerSecond);
+    /**
+    * Synthesizes lines, blocking until all of them are done. A line that fails does not abort the others.
+    * @param Lines - the lines to synthesize
+    * @return TArray<FPollySpeechBakeResult> - the speech of each line, in the order of Lines
+    */
+    TArray<FPollySpeechBakeResult> Bake(const TArray<FPollySpeechBakeLine>& Lines);
+
+private:
+    /**
+    * Takes the next line to synthesize
+    * @param NumLines - the number of lines being baked
+    * @param OutLineIndex - the index of the line
+    * @return bool - false once there are no lines left
+    */
+    bool PopLine(int32 NumLines, int32& OutLineIndex);
+    /**
+    * Waits until a number of requests can be started without exceeding MaxRequestsPerSecond
+    */
+    void WaitForRequestSlots(int32 NumRequests);
+
+    USpeechComponent* SpeechComponent;
+    const int32 MaxConcurrentLines;
+    const float MaxRequestsPerSecond;
+    int32 NextLineIndex = 0;
+    /**
+    * Time at which the next request may be started, in FPlatformTime::Seconds
+    */
+    double NextRequestSeconds = 0.0;
+    FCriticalSection Mutex;
+};
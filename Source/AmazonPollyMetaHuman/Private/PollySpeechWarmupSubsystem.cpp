@@ -0,0 +1,138 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySpeechWarmupSubsystem.h"
+#include "Algo/Reverse.h"
+#include "Async/Async.h"
+#include "Engine/World.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/PackageName.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "SpeechComponent.h"
+
+namespace {
+    /**
+    * The manifest is saved every this many spoken lines, so that long-running sessions that never unload their
+    * map keep it up to date
+    */
+    const int32 ManifestSaveInterval = 16;
+}
+
+bool UPollySpeechWarmupSubsystem::ShouldCreateSubsystem(UObject* Outer) const {
+    // Editor and preview worlds do not speak
+    const UWorld* World = Cast<UWorld>(Outer);
+    return World != nullptr && (World->WorldType == EWorldType::Game || World->WorldType == EWorldType::PIE);
+}
+
+void UPollySpeechWarmupSubsystem::Initialize(FSubsystemCollectionBase& Collection) {
+    Super::Initialize(Collection);
+    const FString MapName = UWorld::RemovePIEPrefix(FPackageName::GetShortName(GetWorld()->GetOutermost()->GetName()));
+    const FString ManifestPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("PollySpeechWarmup"), MapName + TEXT(".json"));
+    Manifest = MakeShared<FSpeechWarmupManifest, ESPMode::ThreadSafe>(ManifestPath, ManifestSaveInterval);
+    Manifest->Load();
+}
+
+void UPollySpeechWarmupSubsystem::Deinitialize() {
+    {
+        FScopeLock lock(&Mutex);
+        if (WarmupCancellationFlag.IsValid()) {
+            *WarmupCancellationFlag = true;
+        }
+    }
+    while (NumRunningWarmups.GetValue() > 0) {
+        FPlatformProcess::Sleep(0.001f);
+    }
+    Manifest->Save();
+    Super::Deinitialize();
+}
+
+void UPollySpeechWarmupSubsystem::StartWarmup(USpeechComponent* SpeechComponent) {
+    if (SpeechComponent == nullptr) {
+        return;
+    }
+    FScopeLock lock(&Mutex);
+    if (bWarmupStarted) {
+        return;
+    }
+    bWarmupStarted = true;
+    PendingLines = Manifest->GetMostFrequentLines(SpeechComponent->MaxWarmupLines);
+    Algo::Reverse(PendingLines);
+    NumLinesToWarm = PendingLines.Num();
+    if (NumLinesToWarm == 0) {
+        TWeakObjectPtr<UPollySpeechWarmupSubsystem> WeakThis(this);
+        AsyncTask(ENamedThreads::GameThread, [WeakThis]() {
+            if (WeakThis.IsValid()) {
+                WeakThis->OnWarmupComplete.Broadcast();
+            }
+        });
+        return;
+    }
+    UE_LOG(LogPollyMsg, Display, TEXT("Warming up the speech cache with %d lines."), NumLinesToWarm);
+    // The warmup stops with the component whose Polly client it uses
+    PollyCancellationFlag CancellationFlag = SpeechComponent->WarmupCancellationFlag;
+    WarmupCancellationFlag = CancellationFlag;
+    const int32 NumWorkers = FMath::Clamp(SpeechComponent->MaxConcurrentWarmups, 1, NumLinesToWarm);
+    for (int32 WorkerIndex = 0; WorkerIndex < NumWorkers; WorkerIndex++) {
+        // The pending call holds back the destruction of the component (see USpeechComponent::IsReadyForFinishDestroy)
+        SpeechComponent->PendingGenerateSpeechCalls.Increment();
+        NumRunningWarmups.Increment();
+        Async(EAsyncExecution::ThreadPool, [this, SpeechComponent, CancellationFlag]() {
+            FSpeechWarmupLine Line;
+            while (!*CancellationFlag && PopWarmupLine(Line)) {
+                SpeechComponent->WarmSpeechCache(Line.Text, Line.VoiceId, CancellationFlag);
+                NoteLineWarmed();
+            }
+            SpeechComponent->PendingGenerateSpeechCalls.Decrement();
+            NumRunningWarmups.Decrement();
+        });
+    }
+}
+
+float UPollySpeechWarmupSubsystem::GetWarmupProgress() const {
+    if (NumLinesToWarm == 0) {
+        return bWarmupStarted ? 1.0f : 0.0f;
+    }
+    return FMath::Min(static_cast<float>(NumLinesWarmed.GetValue()) / NumLinesToWarm, 1.0f);
+}
+
+bool UPollySpeechWarmupSubsystem::IsWarmupComplete() const {
+    return bWarmupStarted && NumLinesWarmed.GetValue() >= NumLinesToWarm;
+}
+
+bool UPollySpeechWarmupSubsystem::PopWarmupLine(FSpeechWarmupLine& OutLine) {
+    FScopeLock lock(&Mutex);
+    if (PendingLines.Num() == 0) {
+        return false;
+    }
+    OutLine = PendingLines.Pop(false);
+    return true;
+}
+
+void UPollySpeechWarmupSubsystem::NoteLineWarmed() {
+    if (NumLinesWarmed.Increment() != NumLinesToWarm) {
+        return;
+    }
+    UE_LOG(LogPollyMsg, Display, TEXT("Speech cache warmup complete."));
+    TWeakObjectPtr<UPollySpeechWarmupSubsystem> WeakThis(this);
+    AsyncTask(ENamedThreads::GameThread, [WeakThis]() {
+        if (WeakThis.IsValid()) {
+            WeakThis->OnWarmupComplete.Broadcast();
+        }
+    });
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollyStreamingSoundWave.h"
+
+UPollyStreamingSoundWave::UPollyStreamingSoundWave(const FObjectInitializer& ObjectInitializer) :
+    Super(ObjectInitializer),
+    JitterBufferBytes(0),
+    bPrimed(false),
+    UnderflowCount(0),
+    bStopped(false)
+{
+}
+
+void UPollyStreamingSoundWave::SetRingBuffer(TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> InRingBuffer, int32 InJitterBufferBytes) {
+    RingBuffer = InRingBuffer;
+    JitterBufferBytes = FMath::Min(InJitterBufferBytes, InRingBuffer->GetCapacity());
+    bPrimed = false;
+}
+
+void UPollyStreamingSoundWave::StopStream() {
+    bStopped.store(true, std::memory_order_release);
+}
+
+int32 UPollyStreamingSoundWave::GetUnderflowCount() const {
+    return UnderflowCount.load(std::memory_order_relaxed);
+}
+
+int32 UPollyStreamingSoundWave::OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) {
+    OutAudio.Reset();
+    if (!RingBuffer.IsValid()) {
+        return 0;
+    }
+    if (bStopped.load(std::memory_order_acquire)) {
+        // Only the audio thread reads the ring buffer, so the unplayed audio is dropped here
+        RingBuffer->Discard();
+        return 0;
+    }
+    // Read the finished state before the byte count, so that bytes written just before the
+    // producer finished are never mistaken for the end of the stream
+    const bool bFinished = RingBuffer->IsFinished();
+    const int32 BytesAvailable = RingBuffer->Num();
+    if (bFinished && BytesAvailable == 0) {
+        return 0;
+    }
+    const int32 SampleBytes = sizeof(int16);
+    const int32 BytesNeeded = NumSamples * SampleBytes;
+    OutAudio.AddZeroed(BytesNeeded);
+    if (!bPrimed) {
+        if (BytesAvailable < JitterBufferBytes && !bFinished) {
+            // Still filling the jitter buffer, keep the source alive with silence
+            return NumSamples;
+        }
+        bPrimed = true;
+    }
+    const int32 BytesRead = RingBuffer->Read(OutAudio.GetData(), BytesNeeded);
+    if (BytesRead < BytesNeeded && !bFinished) {
+        UnderflowCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (bFinished) {
+        // The last callback only returns what is left of the stream
+        const int32 SamplesRead = (BytesRead + SampleBytes - 1) / SampleBytes;
+        OutAudio.SetNum(SamplesRead * SampleBytes, false);
+        return SamplesRead;
+    }
+    return NumSamples;
+}
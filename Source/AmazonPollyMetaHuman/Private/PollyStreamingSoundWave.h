@@ -0,0 +1,85 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Sound/SoundWaveProcedural.h"
+#include "PollyAudioRingBuffer.h"
+#include <atomic>
+#include "PollyStreamingSoundWave.generated.h"
+
+/**
+* Procedural sound wave that pulls Polly PCM audio from a FPollyAudioRingBuffer on the audio render
+* thread while the rest of the audio is still being downloaded. Playback starts once a small jitter
+* buffer has been filled (or the stream has completed); if the download falls behind afterwards,
+* the missing samples are replaced by silence and counted as an underflow.
+*/
+UCLASS()
+class UPollyStreamingSoundWave : public USoundWaveProcedural {
+
+    GENERATED_BODY()
+
+public:
+    /**
+    * Default constructor.
+    */
+    UPollyStreamingSoundWave(const FObjectInitializer& ObjectInitializer);
+    /**
+    * Attaches the ring buffer the audio is read from
+    * @param InRingBuffer - the ring buffer filled by the Polly response
+    * @param InJitterBufferBytes - the number of bytes to buffer before playback starts
+    */
+    void SetRingBuffer(TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> InRingBuffer, int32 InJitterBufferBytes);
+    /**
+    * Stops the sound at the next audio callback, dropping the audio that has not been played yet.
+    * Can be called from any thread.
+    */
+    void StopStream();
+    /**
+    * Returns the number of audio callbacks that found the ring buffer empty after playback started
+    */
+    int32 GetUnderflowCount() const;
+    /**
+    * Fills OutAudio with the next NumSamples samples from the ring buffer. Called on the audio render thread.
+    * See USoundWaveProcedural::OnGeneratePCMAudio for details.
+    */
+    virtual int32 OnGeneratePCMAudio(TArray<uint8>& OutAudio, int32 NumSamples) override;
+
+private:
+    /**
+    * Ring buffer the audio is read from
+    */
+    TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer;
+    /**
+    * Number of bytes to buffer before playback starts
+    */
+    int32 JitterBufferBytes;
+    /**
+    * Set once the jitter buffer has been filled
+    */
+    bool bPrimed;
+    /**
+    * Number of audio callbacks that found the ring buffer empty after playback started
+    */
+    std::atomic<int32> UnderflowCount;
+    /**
+    * Set by StopStream
+    */
+    std::atomic<bool> bStopped;
+};
@@ -0,0 +1,289 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySynthesisScheduler.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "SpeechMetrics.h"
+#include "SpeechTrace.h"
+
+namespace {
+    /**
+    * Number of recent wait times kept per priority for the statistics
+    */
+    const int32 WaitSampleCount = 1024;
+    /**
+    * Idle workers wake up this often to drop the requests that expired or were cancelled while waiting
+    */
+    const uint32 IdleWaitMilliseconds = 10;
+
+    TUniquePtr<FPollySynthesisScheduler> SharedScheduler;
+    FCriticalSection SharedSchedulerMutex;
+}
+
+struct FPollySynthesisScheduler::FRequest {
+    FRequest(int32 InPriorityIndex, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag InCancellationFlag, TFunction<PollyOutcome()>&& InSynthesize) :
+        PriorityIndex(InPriorityIndex),
+        QueuedSeconds(FPlatformTime::Seconds()),
+        DeadlineSeconds(Scheduling.DeadlineSeconds),
+        TraceUtteranceId(Scheduling.TraceUtteranceId),
+        CancellationFlag(InCancellationFlag),
+        Synthesize(MoveTemp(InSynthesize)) {
+    }
+    int32 PriorityIndex;
+    double QueuedSeconds;
+    double DeadlineSeconds;
+    uint32 TraceUtteranceId;
+    PollyCancellationFlag CancellationFlag;
+    TFunction<PollyOutcome()> Synthesize;
+    TPromise<PollyOutcome> Promise;
+    /**
+    * True if the request was dropped because of its deadline rather than its cancellation flag
+    */
+    bool bExpired = false;
+};
+
+class FPollySynthesisScheduler::FWorker : public FRunnable {
+public:
+    FWorker(FPollySynthesisScheduler& InScheduler, int32 WorkerIndex) : Scheduler(InScheduler) {
+        Thread = FRunnableThread::Create(this, *FString::Printf(TEXT("PollySynthesisWorker%d"), WorkerIndex));
+    }
+
+    virtual ~FWorker() {
+        if (Thread != nullptr) {
+            Thread->WaitForCompletion();
+            delete Thread;
+        }
+    }
+
+    virtual uint32 Run() override {
+        Scheduler.RunWorker();
+        return 0;
+    }
+
+private:
+    FPollySynthesisScheduler& Scheduler;
+    FRunnableThread* Thread;
+};
+
+FPollySynthesisScheduler& FPollySynthesisScheduler::Get() {
+    FScopeLock lock(&SharedSchedulerMutex);
+    if (!SharedScheduler.IsValid()) {
+        SharedScheduler = MakeUnique<FPollySynthesisScheduler>();
+    }
+    return *SharedScheduler;
+}
+
+void FPollySynthesisScheduler::Shutdown() {
+    FScopeLock lock(&SharedSchedulerMutex);
+    SharedScheduler.Reset();
+}
+
+FPollySynthesisScheduler::FPollySynthesisScheduler(const FPollySchedulerConfig& InConfig) :
+    Config(InConfig),
+    WorkEvent(FPlatformProcess::GetSynchEventFromPool(false)),
+    bStopping(false)
+{
+    for (int32 WorkerIndex = 0; WorkerIndex < FMath::Max(Config.NumWorkers, 1); WorkerIndex++) {
+        Workers.Add(MakeUnique<FWorker>(*this, WorkerIndex));
+    }
+}
+
+FPollySynthesisScheduler::~FPollySynthesisScheduler() {
+    bStopping = true;
+    for (int32 WorkerIndex = 0; WorkerIndex < Workers.Num(); WorkerIndex++) {
+        WorkEvent->Trigger();
+    }
+    Workers.Empty();
+    TArray<TUniquePtr<FRequest>> Dropped;
+    for (TArray<TUniquePtr<FRequest>>& Queue : Queues) {
+        Dropped.Append(MoveTemp(Queue));
+    }
+    CompleteDropped(Dropped);
+    FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+}
+
+TFuture<PollyOutcome> FPollySynthesisScheduler::Schedule(const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag, TFunction<PollyOutcome()> Synthesize) {
+    const int32 PriorityIndex = FMath::Clamp(static_cast<int32>(Scheduling.Priority), 0, NumSpeechPriorities - 1);
+    TUniquePtr<FRequest> Request = MakeUnique<FRequest>(PriorityIndex, Scheduling, CancellationFlag, MoveTemp(Synthesize));
+    TFuture<PollyOutcome> Future = Request->Promise.GetFuture();
+    SpeechTrace::BeginSpan(Scheduling.TraceUtteranceId, ESpeechTraceSpan::SchedulerWait);
+    {
+        FScopeLock lock(&Mutex);
+        Queues[PriorityIndex].Add(MoveTemp(Request));
+    }
+    WorkEvent->Trigger();
+    return Future;
+}
+
+void FPollySynthesisScheduler::Configure(const FPollySchedulerConfig& InConfig) {
+    {
+        FScopeLock lock(&Mutex);
+        const int32 NumWorkers = Config.NumWorkers;
+        Config = InConfig;
+        Config.NumWorkers = NumWorkers;
+    }
+    WorkEvent->Trigger();
+}
+
+FPollySchedulerStats FPollySynthesisScheduler::GetStats() const {
+    FPollySchedulerStats SchedulerStats;
+    FScopeLock lock(&Mutex);
+    SchedulerStats.NumWorkers = Workers.Num();
+    for (int32 PriorityIndex = 0; PriorityIndex < NumSpeechPriorities; PriorityIndex++) {
+        FPollySchedulerPriorityStats& PriorityStats = SchedulerStats.Priorities[PriorityIndex];
+        PriorityStats = Stats[PriorityIndex];
+        PriorityStats.QueueDepth = Queues[PriorityIndex].Num();
+        PriorityStats.InFlight = InFlight[PriorityIndex];
+        TArray<double> SortedWaits = WaitSamples[PriorityIndex];
+        if (SortedWaits.Num() > 0) {
+            SortedWaits.Sort();
+            double TotalWait = 0.0;
+            for (double Wait : SortedWaits) {
+                TotalWait += Wait;
+            }
+            PriorityStats.AverageWaitSeconds = TotalWait / SortedWaits.Num();
+            PriorityStats.P99WaitSeconds = SortedWaits[FMath::Min(SortedWaits.Num() * 99 / 100, SortedWaits.Num() - 1)];
+        }
+    }
+    return SchedulerStats;
+}
+
+void FPollySynthesisScheduler::RunWorker() {
+    while (!bStopping) {
+        TUniquePtr<FRequest> Request;
+        TArray<TUniquePtr<FRequest>> Dropped;
+        bool bMoreWaiting = false;
+        {
+            FScopeLock lock(&Mutex);
+            Request = PopNextRequest(Dropped);
+            if (Request.IsValid()) {
+                InFlight[Request->PriorityIndex]++;
+                const double WaitSeconds = FPlatformTime::Seconds() - Request->QueuedSeconds;
+                RecordWait(Request->PriorityIndex, WaitSeconds);
+                FSpeechMetrics::Get().RecordQueueWait(WaitSeconds);
+                for (const TArray<TUniquePtr<FRequest>>& Queue : Queues) {
+                    bMoreWaiting |= Queue.Num() > 0;
+                }
+            }
+        }
+        CompleteDropped(Dropped);
+        if (bMoreWaiting) {
+            // Several requests may have arrived while a single wake-up was pending
+            WorkEvent->Trigger();
+        }
+        if (!Request.IsValid()) {
+            WorkEvent->Wait(IdleWaitMilliseconds);
+            continue;
+        }
+        SpeechTrace::EndSpan(Request->TraceUtteranceId, ESpeechTraceSpan::SchedulerWait);
+        PollyOutcome Outcome;
+        {
+            SpeechTrace::FScopedSpan RequestSpan(Request->TraceUtteranceId, ESpeechTraceSpan::Request);
+            Outcome = Request->Synthesize();
+        }
+        {
+            FScopeLock lock(&Mutex);
+            InFlight[Request->PriorityIndex]--;
+            Stats[Request->PriorityIndex].NumCompleted++;
+        }
+        Request->Promise.SetValue(MoveTemp(Outcome));
+        // The freed slot may admit a request that another idle worker could not take
+        WorkEvent->Trigger();
+    }
+}
+
+TUniquePtr<FPollySynthesisScheduler::FRequest> FPollySynthesisScheduler::PopNextRequest(TArray<TUniquePtr<FRequest>>& OutDropped) {
+    const double NowSeconds = FPlatformTime::Seconds();
+    int32 BestPriorityIndex = INDEX_NONE;
+    double BestScore = 0.0;
+    // Higher priorities are visited first, so they win ties against aged requests of a lower priority
+    for (int32 PriorityIndex = NumSpeechPriorities - 1; PriorityIndex >= 0; PriorityIndex--) {
+        TArray<TUniquePtr<FRequest>>& Queue = Queues[PriorityIndex];
+        for (int32 RequestIndex = 0; RequestIndex < Queue.Num();) {
+            FRequest& Request = *Queue[RequestIndex];
+            const bool bExpired = Request.DeadlineSeconds > 0.0 && NowSeconds >= Request.DeadlineSeconds;
+            if (*Request.CancellationFlag || bExpired) {
+                Request.bExpired = !*Request.CancellationFlag;
+                if (Request.bExpired) {
+                    Stats[PriorityIndex].NumExpired++;
+                }
+                else {
+                    Stats[PriorityIndex].NumCancelled++;
+                }
+                OutDropped.Add(MoveTemp(Queue[RequestIndex]));
+                Queue.RemoveAt(RequestIndex);
+                continue;
+            }
+            RequestIndex++;
+        }
+        if (Queue.Num() == 0 || InFlight[PriorityIndex] >= Config.MaxInFlight[PriorityIndex]) {
+            continue;
+        }
+        double Score = PriorityIndex;
+        if (Config.AgingSeconds > 0.0) {
+            Score += FMath::FloorToDouble((NowSeconds - Queue[0]->QueuedSeconds) / Config.AgingSeconds);
+        }
+        if (BestPriorityIndex == INDEX_NONE || Score > BestScore) {
+            BestPriorityIndex = PriorityIndex;
+            BestScore = Score;
+        }
+    }
+    if (BestPriorityIndex == INDEX_NONE) {
+        return nullptr;
+    }
+    TUniquePtr<FRequest> Request = MoveTemp(Queues[BestPriorityIndex][0]);
+    Queues[BestPriorityIndex].RemoveAt(0);
+    return Request;
+}
+
+void FPollySynthesisScheduler::CompleteDropped(TArray<TUniquePtr<FRequest>>& Dropped) {
+    for (TUniquePtr<FRequest>& Request : Dropped) {
+        SpeechTrace::EndSpan(Request->TraceUtteranceId, ESpeechTraceSpan::SchedulerWait);
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = false;
+        if (Request->bExpired) {
+            // Like any failed request, an expired one aborts the rest of its group
+            Request->CancellationFlag->AtomicSet(true);
+            Outcome.PollyErrorMsg = "Request missed its deadline";
+        }
+        else {
+            Outcome.IsCancelled = true;
+            Outcome.PollyErrorMsg = "Request cancelled";
+        }
+        Request->Promise.SetValue(MoveTemp(Outcome));
+    }
+    Dropped.Empty();
+}
+
+void FPollySynthesisScheduler::RecordWait(int32 PriorityIndex, double WaitSeconds) {
+    FPollySchedulerPriorityStats& PriorityStats = Stats[PriorityIndex];
+    PriorityStats.MaxWaitSeconds = FMath::Max(PriorityStats.MaxWaitSeconds, WaitSeconds);
+    TArray<double>& Samples = WaitSamples[PriorityIndex];
+    if (Samples.Num() < WaitSampleCount) {
+        Samples.Add(WaitSeconds);
+    }
+    else {
+        Samples[NextWaitSample[PriorityIndex]] = WaitSeconds;
+    }
+    NextWaitSample[PriorityIndex] = (NextWaitSample[PriorityIndex] + 1) % WaitSampleCount;
+}
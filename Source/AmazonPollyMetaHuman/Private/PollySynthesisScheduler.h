@@ -0,0 +1,178 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "HAL/Event.h"
+#include "HAL/ThreadSafeBool.h"
+#include "PollyClient.h"
+
+/**
+* Number of values of ESpeechPriority
+*/
+const int32 NumSpeechPriorities = 3;
+
+/**
+* Configuration of a FPollySynthesisScheduler
+*/
+struct FPollySchedulerConfig {
+    /**
+    * Number of worker threads, which is the number of Polly requests in flight at the same time
+    */
+    int32 NumWorkers = 8;
+    /**
+    * Maximum number of requests of each priority in flight at the same time, indexed by ESpeechPriority. The
+    * workers a lower priority cannot occupy stay free for the higher ones.
+    */
+    int32 MaxInFlight[NumSpeechPriorities] = { 2, 4, 8 };
+    /**
+    * A waiting request is treated as one priority higher for every AgingSeconds it has waited, so that lower
+    * priorities are not starved by a steady stream of higher priority requests
+    */
+    double AgingSeconds = 2.0;
+};
+
+/**
+* Statistics of the requests of one priority
+*/
+struct FPollySchedulerPriorityStats {
+    /**
+    * Number of requests waiting for a worker
+    */
+    int32 QueueDepth = 0;
+    /**
+    * Number of requests being sent
+    */
+    int32 InFlight = 0;
+    int64 NumCompleted = 0;
+    /**
+    * Number of requests that failed because they were still waiting at their deadline
+    */
+    int64 NumExpired = 0;
+    /**
+    * Number of requests that were cancelled while waiting
+    */
+    int64 NumCancelled = 0;
+    /**
+    * Time the recently started requests waited for a worker
+    */
+    double AverageWaitSeconds = 0.0;
+    double P99WaitSeconds = 0.0;
+    double MaxWaitSeconds = 0.0;
+};
+
+/**
+* Statistics of a FPollySynthesisScheduler, indexed by ESpeechPriority
+*/
+struct FPollySchedulerStats {
+    FPollySchedulerPriorityStats Priorities[NumSpeechPriorities];
+    /**
+    * Number of worker threads, the most requests that can be in flight at once
+    */
+    int32 NumWorkers = 0;
+};
+
+/**
+* Sends the Polly requests of all speech components from a fixed set of worker threads. Whenever a worker is
+* free, it sends the waiting request of the highest priority (after aging) whose priority is below its in-flight
+* limit, oldest first. Requests whose cancellation flag is raised while waiting are dropped without being sent.
+*/
+class FPollySynthesisScheduler {
+public:
+    /**
+    * Returns the scheduler shared by all speech components, creating it on first use
+    */
+    static FPollySynthesisScheduler& Get();
+    /**
+    * Stops the shared scheduler. Called when the module shuts down.
+    */
+    static void Shutdown();
+    /**
+    * Creates a scheduler and starts its worker threads
+    * @param InConfig - the configuration
+    */
+    explicit FPollySynthesisScheduler(const FPollySchedulerConfig& InConfig = FPollySchedulerConfig());
+    /**
+    * Stops the worker threads after their current request. Requests still waiting are cancelled.
+    */
+    ~FPollySynthesisScheduler();
+    /**
+    * Queues a request
+    * @param Scheduling - the priority and deadline of the request
+    * @param CancellationFlag - the flag of the request group; a raised flag drops the request
+    * @param Synthesize - sends the request, called on a worker thread
+    * @return TFuture<PollyOutcome> - future fulfilled with the outcome of Synthesize, or a failed outcome if the
+    * request was dropped
+    */
+    TFuture<PollyOutcome> Schedule(const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag, TFunction<PollyOutcome()> Synthesize);
+    /**
+    * Changes the in-flight limits and the aging of the scheduler, the number of workers is kept
+    * @param InConfig - the new configuration
+    */
+    void Configure(const FPollySchedulerConfig& InConfig);
+    /**
+    * Returns the statistics of the scheduler
+    */
+    FPollySchedulerStats GetStats() const;
+
+private:
+    struct FRequest;
+    class FWorker;
+
+    /**
+    * Runs waiting requests until the scheduler stops, called by every worker thread
+    */
+    void RunWorker();
+    /**
+    * Takes the next request to send off the queues, and the requests that expired or were cancelled
+    * while waiting. Called with the Mutex held.
+    * @param OutDropped - receives the expired and cancelled requests
+    * @return TUniquePtr<FRequest> - the request to send, or null if none may be sent right now
+    */
+    TUniquePtr<FRequest> PopNextRequest(TArray<TUniquePtr<FRequest>>& OutDropped);
+    /**
+    * Fulfills the futures of requests that are not sent
+    */
+    static void CompleteDropped(TArray<TUniquePtr<FRequest>>& Dropped);
+    /**
+    * Records the wait time of a request that is being sent. Called with the Mutex held.
+    */
+    void RecordWait(int32 PriorityIndex, double WaitSeconds);
+
+    FPollySchedulerConfig Config;
+    /**
+    * Waiting requests of each priority, oldest first
+    */
+    TArray<TUniquePtr<FRequest>> Queues[NumSpeechPriorities];
+    int32 InFlight[NumSpeechPriorities] = { 0, 0, 0 };
+    FPollySchedulerPriorityStats Stats[NumSpeechPriorities];
+    /**
+    * Wait times of the most recently started requests of each priority, used as a ring of WaitSampleCount entries
+    */
+    TArray<double> WaitSamples[NumSpeechPriorities];
+    int32 NextWaitSample[NumSpeechPriorities] = { 0, 0, 0 };
+    /**
+    * Wakes up an idle worker when a request arrives or a worker becomes free
+    */
+    FEvent* WorkEvent;
+    FThreadSafeBool bStopping;
+    TArray<TUniquePtr<FWorker>> Workers;
+    mutable FCriticalSection Mutex;
+};
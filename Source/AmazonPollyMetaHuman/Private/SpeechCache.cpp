@@ -0,0 +1,181 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechCache.h"
+#include "Misc/ScopeLock.h"
+#include "SpeechDiskCache.h"
+#include "SpeechMemoryTracker.h"
+
+constexpr const TCHAR* FSpeechCache::OutputFormat;
+
+FSpeechCache& FSpeechCache::Get() {
+    static FSpeechCache SharedCache;
+    return SharedCache;
+}
+
+FSpeechCache::FSpeechCache() :
+    BudgetBytes(DefaultBudgetBytes),
+    SizeBytes(0)
+{
+}
+
+FString FSpeechCache::MakeKey(const FString& Text, EVoiceId VoiceId, const FString& OutputFormat) {
+    FString NormalizedText;
+    NormalizedText.Reserve(Text.Len());
+    bool bPendingSpace = false;
+    for (const TCHAR Character : Text) {
+        if (FChar::IsWhitespace(Character)) {
+            bPendingSpace = NormalizedText.Len() > 0;
+            continue;
+        }
+        if (bPendingSpace) {
+            NormalizedText.AppendChar(TEXT(' '));
+            bPendingSpace = false;
+        }
+        NormalizedText.AppendChar(Character);
+    }
+    return FString::Printf(TEXT("%d|%d|%s|%s"), static_cast<int32>(VoiceId), static_cast<int32>(ToPollyVoiceEngine(VoiceId)), *OutputFormat, *NormalizedText);
+}
+
+TSharedPtr<const FCachedSpeechSegment, ESPMode::ThreadSafe> FSpeechCache::Find(const FString& Key) {
+    {
+        FScopeLock lock(&Mutex);
+        if (FEntry* Entry = Entries.Find(Key)) {
+            Stats.NumHits++;
+            LruOrder.RemoveNode(Entry->LruNode, false);
+            LruOrder.AddHead(Entry->LruNode);
+            return Entry->Segment;
+        }
+    }
+    // The disk is read without holding the Mutex, so that other lookups are not held back
+    TSharedPtr<FCachedSpeechSegment, ESPMode::ThreadSafe> Loaded = FSpeechDiskCache::Get().Load(Key);
+    FScopeLock lock(&Mutex);
+    if (!Loaded.IsValid()) {
+        Stats.NumMisses++;
+        return nullptr;
+    }
+    Stats.NumHits++;
+    if (FEntry* Entry = Entries.Find(Key)) {
+        return Entry->Segment;
+    }
+    TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe> Segment = Loaded.ToSharedRef();
+    AddToMemory(Key, Segment);
+    return Segment;
+}
+
+bool FSpeechCache::Contains(const FString& Key) const {
+    {
+        FScopeLock lock(&Mutex);
+        if (Entries.Contains(Key)) {
+            return true;
+        }
+    }
+    return FSpeechDiskCache::Get().Contains(Key);
+}
+
+bool FSpeechCache::ContainsInMemory(const FString& Key) const {
+    FScopeLock lock(&Mutex);
+    return Entries.Contains(Key);
+}
+
+void FSpeechCache::Add(const FString& Key, const FPollyAudioBuffer& Audio, const TArray<VisemeEvent>& Visemes) {
+    LLM_SCOPE_POLLY_SPEECH();
+    TSharedRef<FCachedSpeechSegment, ESPMode::ThreadSafe> Segment = MakeShared<FCachedSpeechSegment, ESPMode::ThreadSafe>();
+    Segment->Audio = Audio;
+    Segment->Visemes = Visemes;
+    {
+        FScopeLock lock(&Mutex);
+        if (Entries.Contains(Key)) {
+            return;
+        }
+        AddToMemory(Key, Segment);
+    }
+    FSpeechDiskCache::Get().StoreAsync(Key, Segment);
+}
+
+void FSpeechCache::AddToMemory(const FString& Key, const TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe>& Segment) {
+    // Audio viewed in a memory mapped file is paged in and out by the OS rather than held on the heap
+    const int64 AudioBytes = Segment->Audio->IsView() ? 0 : Segment->Audio->Num();
+    const int64 EntrySizeBytes = AudioBytes + Segment->Visemes.Num() * sizeof(VisemeEvent) + Key.Len() * sizeof(TCHAR);
+    if (EntrySizeBytes > BudgetBytes) {
+        return;
+    }
+    LruOrder.AddHead(Key);
+    Entries.Add(Key, { Segment, EntrySizeBytes, LruOrder.GetHead() });
+    if (AudioBytes > 0) {
+        HeldAudio.Add(&Segment->Audio.Get());
+    }
+    SizeBytes += EntrySizeBytes;
+    EvictToBudget();
+}
+
+void FSpeechCache::SetBudgetBytes(int64 InBudgetBytes) {
+    FScopeLock lock(&Mutex);
+    BudgetBytes = FMath::Max<int64>(InBudgetBytes, 0);
+    EvictToBudget();
+}
+
+void FSpeechCache::Empty() {
+    FScopeLock lock(&Mutex);
+    Entries.Empty();
+    LruOrder.Empty();
+    HeldAudio.Empty();
+    SizeBytes = 0;
+}
+
+int64 FSpeechCache::Trim(int64 BytesToRelease) {
+    FScopeLock lock(&Mutex);
+    const int64 SizeBeforeBytes = SizeBytes;
+    EvictToSize(FMath::Max<int64>(SizeBytes - BytesToRelease, 0));
+    return SizeBeforeBytes - SizeBytes;
+}
+
+int64 FSpeechCache::GetSizeBytes() const {
+    FScopeLock lock(&Mutex);
+    return SizeBytes;
+}
+
+bool FSpeechCache::HoldsAudio(const FPollyAudioBuffer& Audio) const {
+    FScopeLock lock(&Mutex);
+    return HeldAudio.Contains(&Audio.Get());
+}
+
+FSpeechCacheStats FSpeechCache::GetStats() const {
+    FScopeLock lock(&Mutex);
+    FSpeechCacheStats CacheStats = Stats;
+    CacheStats.NumEntries = Entries.Num();
+    CacheStats.SizeKB = static_cast<int32>(SizeBytes / 1024);
+    FSpeechDiskCache::Get().GetStats(CacheStats);
+    return CacheStats;
+}
+
+void FSpeechCache::EvictToBudget() {
+    EvictToSize(BudgetBytes);
+}
+
+void FSpeechCache::EvictToSize(int64 MaxSizeBytes) {
+    while (SizeBytes > MaxSizeBytes && LruOrder.GetTail() != nullptr) {
+        TDoubleLinkedList<FString>::TDoubleLinkedListNode* LeastRecent = LruOrder.GetTail();
+        const FEntry& Entry = Entries.FindChecked(LeastRecent->GetValue());
+        SizeBytes -= Entry.SizeBytes;
+        HeldAudio.Remove(&Entry.Segment->Audio.Get());
+        Entries.Remove(LeastRecent->GetValue());
+        LruOrder.RemoveNode(LeastRecent);
+        Stats.NumEvictions++;
+    }
+}
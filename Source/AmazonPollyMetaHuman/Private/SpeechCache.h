@@ -0,0 +1,170 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/List.h"
+#include "SpeechComponent.h"
+#include "PollyAudioBuffer.h"
+
+/**
+* The synthesized audio and parsed visemes of one Polly request text
+*/
+struct FCachedSpeechSegment {
+    /**
+    * Returns the audio
+    */
+    TArrayView<const uint8> GetAudio() const {
+        return Audio->GetView();
+    }
+
+    /**
+    * Returns the audio as a buffer that can be kept beyond the entry. It is shared rather than copied, also when
+    * it views a memory mapped entry of the FSpeechDiskCache, which then stays mapped for as long as it is used.
+    */
+    FPollyAudioBuffer ShareAudio() const {
+        return Audio;
+    }
+
+    /**
+    * The audio, shared with the speech components playing it. It views the file of a memory mapped entry of the
+    * FSpeechDiskCache, or is held in memory.
+    */
+    FPollyAudioBuffer Audio = PollyAudioBuffer::GetEmpty();
+    TArray<VisemeEvent> Visemes;
+};
+
+/**
+* Process-wide cache of synthesized speech, shared by all speech components. Entries are keyed by the normalized
+* text, the voice, the engine and the output format, and the least recently used entries are evicted once the
+* cache exceeds its byte budget. Entries missing from memory are looked up in the FSpeechDiskCache, and new entries
+* are written to it. All functions are thread-safe.
+*/
+class FSpeechCache {
+public:
+    /**
+    * Returns the cache shared by all speech components
+    */
+    static FSpeechCache& Get();
+    /**
+    * Builds the key of a text. The text is trimmed and runs of whitespace are collapsed, as they do not change
+    * the speech.
+    * @param Text - the text sent to Polly
+    * @param VoiceId - the voice the text is synthesized with, which also determines the engine
+    * @param OutputFormat - the formats of the audio and speech marks requested
+    * @return FString - the key
+    */
+    static FString MakeKey(const FString& Text, EVoiceId VoiceId, const FString& OutputFormat);
+    /**
+    * Looks up an entry in memory, then on disk, marking it as the most recently used one and counting a hit or a miss
+    * @param Key - the key of the text
+    * @return TSharedPtr<const FCachedSpeechSegment> - the entry, or null on a miss
+    */
+    TSharedPtr<const FCachedSpeechSegment, ESPMode::ThreadSafe> Find(const FString& Key);
+    /**
+    * Returns true if there is an entry for the key in memory or on disk, without counting a hit or a miss
+    */
+    bool Contains(const FString& Key) const;
+    /**
+    * Returns true if there is an entry for the key in memory, so that Find returns it without reading the disk
+    */
+    bool ContainsInMemory(const FString& Key) const;
+    /**
+    * Stores an entry, evicting the least recently used entries beyond the byte budget, and writes it to disk
+    * @param Key - the key of the text
+    * @param Audio - the pcm audio of the text, which the entry shares rather than copies
+    * @param Visemes - the visemes of the text
+    */
+    void Add(const FString& Key, const FPollyAudioBuffer& Audio, const TArray<VisemeEvent>& Visemes);
+    /**
+    * Changes the byte budget, evicting entries beyond it. A budget of 0 disables the cache.
+    */
+    void SetBudgetBytes(int64 InBudgetBytes);
+    /**
+    * Removes all entries from memory, keeping those on disk
+    */
+    void Empty();
+    /**
+    * Evicts the least recently used entries from memory, e.g. when the speech memory exceeds its budget
+    * @param BytesToRelease - the memory to release
+    * @return int64 - the memory released, less than BytesToRelease once the cache is empty
+    */
+    int64 Trim(int64 BytesToRelease);
+    /**
+    * Returns the memory used by the entries in memory
+    */
+    int64 GetSizeBytes() const;
+    /**
+    * Returns true if an entry in memory shares a buffer, whose memory is then accounted for by the cache
+    * @param Audio - the buffer
+    */
+    bool HoldsAudio(const FPollyAudioBuffer& Audio) const;
+    /**
+    * Returns the counters of the cache
+    */
+    FSpeechCacheStats GetStats() const;
+
+    /**
+    * Output formats of the audio and speech mark requests of the speech components, part of their keys
+    */
+    static constexpr const TCHAR* OutputFormat = TEXT("pcm16000+viseme");
+    /**
+    * Byte budget of the cache until SetBudgetBytes is called
+    */
+    static const int64 DefaultBudgetBytes = 32 * 1024 * 1024;
+
+private:
+    FSpeechCache();
+
+    struct FEntry {
+        TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe> Segment;
+        int64 SizeBytes;
+        /**
+        * Node of the entry in LruOrder
+        */
+        TDoubleLinkedList<FString>::TDoubleLinkedListNode* LruNode;
+    };
+
+    /**
+    * Evicts the least recently used entries until the cache fits its budget. Called with the Mutex held.
+    */
+    void EvictToBudget();
+    /**
+    * Evicts the least recently used entries until the cache fits a size. Called with the Mutex held.
+    */
+    void EvictToSize(int64 MaxSizeBytes);
+    /**
+    * Stores an entry in memory. Called with the Mutex held.
+    */
+    void AddToMemory(const FString& Key, const TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe>& Segment);
+
+    TMap<FString, FEntry> Entries;
+    /**
+    * Keys of the entries, most recently used first
+    */
+    TDoubleLinkedList<FString> LruOrder;
+    /**
+    * The audio buffers of the entries in memory
+    */
+    TSet<const FPollyAudioData*> HeldAudio;
+    int64 BudgetBytes;
+    int64 SizeBytes;
+    FSpeechCacheStats Stats;
+    mutable FCriticalSection Mutex;
+};
@@ -18,7 +18,6 @@
 
 #include "SpeechComponent.h"
 #include <fstream>
-#include "Json.h"
 #include "UObject/Class.h"
 #include "TimerManager.h"
 #include "Kismet/GameplayStatics.h"
@@ -26,17 +25,99 @@
 #include <aws/core/client/AWSClient.h>
 #include "UnrealAWSUtils.h"
 #include "GenerateSpeechAction.h"
+#include "Async/Async.h"
+#include "PollyStreamingSoundWave.h"
+#include "PollyBakedSoundWave.h"
+#include "PollyBufferedSoundWave.h"
+#include "SpeechTextUtils.h"
+#include "SpeechPrefetchStore.h"
+#include "SpeechCache.h"
+#include "SpeechDiskCache.h"
+#include "SpeechWarmupManifest.h"
+#include "PollySpeechWarmupSubsystem.h"
+#include "PollySpeechAsset.h"
+#include "VisemeTrackCodec.h"
+#include "SpeechEnvelope.h"
+#include "SpeechMemoryTracker.h"
+#include "SpeechMarkParser.h"
+#include "SpeechMetrics.h"
+#include "SpeechTrace.h"
+#include "GameFramework/GameStateBase.h"
+#include "Net/UnrealNetwork.h"
 
 using UnrealAWSUtils::AwsStringToFString;
 using UnrealAWSUtils::FStringToAwsString;
 
 DEFINE_LOG_CATEGORY(LogPollyMsg);
 
+namespace {
+    /**
+    * Sample rate of the pcm audio requested from Polly (16-bit mono)
+    */
+    const int32 PollySampleRate = 16000;
+    const int32 PollyBytesPerMillisecond = PollySampleRate * sizeof(int16) / 1000;
+    /**
+    * Delay before PlayNextViseme checks again for a segment that has not been appended yet
+    */
+    const float PendingSegmentPollSeconds = 0.01f;
+
+    /**
+    * Computes the envelope of audio held in several buffers, one buffer at a time, replacing the envelope from
+    * the time the audio starts at
+    * @param StartMilliseconds - the playback time the audio starts at
+    * @param Audio - the buffers holding the pcm audio, in playback order
+    * @param OutEnvelope - the envelope
+    */
+    void ComputeIntensityEnvelope(int64 StartMilliseconds, const TArray<FPollyAudioBuffer>& Audio, TArray<uint8>& OutEnvelope) {
+        int64 OffsetBytes = 0;
+        for (const FPollyAudioBuffer& Buffer : Audio) {
+            OutEnvelope.SetNumZeroed((StartMilliseconds + OffsetBytes / PollyBytesPerMillisecond) / SpeechEnvelope::FrameMilliseconds);
+            SpeechEnvelope::Compute(Buffer->GetView(), OutEnvelope);
+            OffsetBytes += Buffer->Num();
+        }
+    }
+
+    /**
+    * Returns a future fulfilled with the outcome of Future, which triggers Signal right after it became ready
+    */
+    TFuture<PollyOutcome> SignalWhenReady(TFuture<PollyOutcome> Future, TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> Signal) {
+        TSharedRef<TPromise<PollyOutcome>, ESPMode::ThreadSafe> Promise = MakeShared<TPromise<PollyOutcome>, ESPMode::ThreadSafe>();
+        TFuture<PollyOutcome> SignallingFuture = Promise->GetFuture();
+        // The outcome is set before the signal, so that the woken task finds the future ready
+        Future.Then([Promise, Signal](TFuture<PollyOutcome> ReadyFuture) {
+            Promise->SetValue(ReadyFuture.Get());
+            Signal->Trigger();
+        });
+        return SignallingFuture;
+    }
+
+    /**
+    * Makes the requests of a segment trigger Signal as they return
+    */
+    void SignalWhenReady(FPendingSpeechSegment& Segment, TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> Signal) {
+        if (Segment.AudioFuture.IsValid()) {
+            Segment.AudioFuture = SignalWhenReady(MoveTemp(Segment.AudioFuture), Signal);
+        }
+        if (Segment.VisemeFuture.IsValid()) {
+            Segment.VisemeFuture = SignalWhenReady(MoveTemp(Segment.VisemeFuture), Signal);
+        }
+    }
+}
+
 USpeechComponent::USpeechComponent() {
     // Set this component to be initialized when the game starts, and to be ticked every frame. 
     // You can turn these features off to improve performance if you don't need them.
     PrimaryComponentTick.bCanEverTick = false;
     bWantsInitializeComponent = true;
+    SetIsReplicatedByDefault(true);
+    if (!HasAnyFlags(RF_ClassDefaultObject)) {
+        FSpeechMemoryTracker::Get().Register(this);
+    }
+}
+
+void USpeechComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const {
+    Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+    DOREPLIFETIME(USpeechComponent, ReplicatedSpeech);
 }
 
 void USpeechComponent::InitializeComponent() {
@@ -62,21 +143,71 @@ void USpeechComponent::GenerateSpeech(
     }
 }
 
+bool USpeechComponent::GenerateSpeechFromAsset(UPollySpeechAsset* SpeechAsset) {
+    if (SpeechAsset == nullptr || SpeechAsset->Visemes.Num() == 0 || SpeechAsset->GetNumAudioBytes() == 0) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech (check speech asset)."));
+        return false;
+    }
+    if (IsSpeaking()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech during playback."));
+        return false;
+    }
+    CancelUtteranceRequests();
+    FScopeLock lock(&Mutex);
+    if (bIsShuttingDown) {
+        return false;
+    }
+    UtteranceCancellationFlag = MakePollyCancellationFlag();
+    // The audio stays in the asset, it is streamed by the sound StartSpeech returns
+    SpeechAudio.Empty();
+    BakedSpeechAsset = SpeechAsset;
+    UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+    SpeechText = SpeechAsset->Text;
+    SpeechVoiceId = SpeechAsset->VoiceId;
+    TraceUtteranceId = SpeechTrace::NewUtteranceId();
+    TArray<VisemeEvent> Visemes;
+    SpeechAsset->GetVisemeEvents(Visemes);
+    VisemeTrack = FVisemeTrack::Make(Visemes);
+    IntensityEnvelope = SpeechAsset->IntensityEnvelope;
+    ActivePollyAudio.Reset();
+    bSpeechStarted = false;
+    UtteranceEndMilliseconds = SpeechAsset->GetNumAudioBytes() / PollyBytesPerMillisecond;
+    PendingSegmentCount = 0;
+    return true;
+}
+
 USoundWaveProcedural* USpeechComponent::StartSpeech() {
+    return StartSpeechAt(0.0f);
+}
+
+USoundWaveProcedural* USpeechComponent::StartSpeechAt(float Seconds) {
+    POLLY_TRACE_SCOPE(USpeechComponent::StartSpeech);
     FScopeLock lock(&Mutex);
-    if (VisemeEventArray.Num() == 0) {
+    if (VisemeTrack->Num() == 0) {
         UE_LOG(LogPollyMsg, Error, TEXT("Failed to start speech. GenerateSpeech must be invoked before StartSpeech."));
         return nullptr;
     }
-    else {
-        bIsSpeaking = true;
-        CurrentVisemeIndex = 0;
-        CurrentViseme = VisemeEventArray[CurrentVisemeIndex].Viseme;
-        StartTimePoint = std::chrono::steady_clock::now();
-        float CurrentVisemeDurationSeconds = VisemeEventArray[CurrentVisemeIndex].TimeMilliseconds / 1000.0f;
-        SetTimer(CurrentVisemeDurationSeconds);
-        return QueuePollyAudio();
+    const int64 StartMilliseconds = FMath::Clamp<int64>(FMath::RoundToInt(Seconds * 1000.0f), 0, FMath::Max<int64>(UtteranceEndMilliseconds, VisemeTrack->GetEndMilliseconds()));
+    if (StartMilliseconds > 0 && StreamingAudio.IsValid()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to start speech. Streamed speech can only be started at its beginning."));
+        return nullptr;
     }
+    BeginTraceSpeaking();
+    bIsSpeaking = true;
+    SyncVisemesToPlayback(StartMilliseconds);
+    // A speech without audio only plays its visemes
+    const bool bHasAudio = UtteranceSynthesisMode == ESpeechSynthesisMode::Full || UtteranceSynthesisMode == ESpeechSynthesisMode::AudioOnly;
+    USoundWaveProcedural* PollyAudio = bHasAudio ? QueuePollyAudio(StartMilliseconds) : nullptr;
+    ActivePollyAudio = PollyAudio;
+    bSpeechStarted = true;
+    StartedUtteranceFlag = UtteranceCancellationFlag;
+    WakeSpeechQueue();
+    UpdateReplicatedSpeech(true);
+    if (IsReplicatingSpeech()) {
+        // Clients start the speech where the server started it
+        ReplicatedSpeech.ServerStartSeconds -= StartMilliseconds / 1000.0;
+    }
+    return PollyAudio;
 }
 
 EViseme USpeechComponent::GetCurrentViseme() {
@@ -84,76 +215,1506 @@ EViseme USpeechComponent::GetCurrentViseme() {
     return CurrentViseme;
 }
 
+FVisemeTrackRef USpeechComponent::GetVisemeTrack() {
+    FScopeLock lock(&Mutex);
+    return VisemeTrack;
+}
+
+float USpeechComponent::GetCurrentIntensity() {
+    FScopeLock lock(&Mutex);
+    if (!bIsSpeaking) {
+        return 0.0f;
+    }
+    const int64 PlaybackMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTimePoint).count();
+    const int64 FrameIndex = PlaybackMilliseconds / SpeechEnvelope::FrameMilliseconds;
+    return FrameIndex >= 0 && FrameIndex < IntensityEnvelope.Num() ? SpeechEnvelope::ToIntensity(IntensityEnvelope[FrameIndex]) : 0.0f;
+}
+
 bool USpeechComponent::IsSpeaking() {
     FScopeLock lock(&Mutex);
     return bIsSpeaking;
 }
 
+float USpeechComponent::GetSpeechDurationSeconds() {
+    FScopeLock lock(&Mutex);
+    return UtteranceEndMilliseconds / 1000.0f;
+}
+
+void USpeechComponent::StopSpeech() {
+    const double StopStartSeconds = FPlatformTime::Seconds();
+    FScopeLock lock(&Mutex);
+    LastCancelledFlag = UtteranceCancellationFlag;
+    AbortUtterance();
+    if (USoundWaveProcedural* PollyAudio = ActivePollyAudio.Get()) {
+        if (UPollyStreamingSoundWave* StreamingPollyAudio = Cast<UPollyStreamingSoundWave>(PollyAudio)) {
+            StreamingPollyAudio->StopStream();
+        }
+        else if (UPollyBakedSoundWave* BakedPollyAudio = Cast<UPollyBakedSoundWave>(PollyAudio)) {
+            BakedPollyAudio->StopStream();
+        }
+        else if (UPollyBufferedSoundWave* BufferedPollyAudio = Cast<UPollyBufferedSoundWave>(PollyAudio)) {
+            BufferedPollyAudio->StopStream();
+        }
+        PollyAudio->ResetAudio();
+    }
+    ActivePollyAudio.Reset();
+    ClearTimer();
+    CurrentViseme = EViseme::Sil;
+    if (bIsSpeaking) {
+        SpeechTrace::EndSpan(TraceUtteranceId, ESpeechTraceSpan::Speaking);
+    }
+    bIsSpeaking = false;
+    if (IsReplicatingSpeech()) {
+        ReplicatedSpeech.bPlaying = false;
+    }
+    LastCancelSeconds = StopStartSeconds;
+    CancelMetrics.NumCancels++;
+    CancelMetrics.LastCancelToSilenceMs = (FPlatformTime::Seconds() - StopStartSeconds) * 1000.0;
+    CancelMetrics.LastCancelToIdleMs = 0.0;
+    UE_LOG(LogPollyMsg, Verbose, TEXT("Speech stopped, silent after %.3f ms."), CancelMetrics.LastCancelToSilenceMs);
+}
+
+bool USpeechComponent::SeekSpeech(float Seconds) {
+    FScopeLock lock(&Mutex);
+    UPollyBakedSoundWave* BakedPollyAudio = Cast<UPollyBakedSoundWave>(ActivePollyAudio.Get());
+    if (!bIsSpeaking || BakedPollyAudio == nullptr || VisemeTrack->Num() == 0) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Only speech generated from a speech asset can be seeked while it plays."));
+        return false;
+    }
+    const int64 SeekMilliseconds = FMath::Clamp<int64>(FMath::RoundToInt(Seconds * 1000.0f), 0, UtteranceEndMilliseconds);
+    BakedPollyAudio->Seek(SeekMilliseconds / 1000.0f);
+    SyncVisemesToPlayback(SeekMilliseconds);
+    if (IsReplicatingSpeech()) {
+        // Clients follow the seek as a restart of the speech at an earlier or later time
+        ReplicatedSpeech.SpeechId++;
+        ReplicatedSpeech.ServerStartSeconds = GetServerWorldSeconds() - SeekMilliseconds / 1000.0;
+    }
+    return true;
+}
+
+int32 USpeechComponent::GetReplicatedVisemeTrackBytes() const {
+    return ReplicatedSpeech.VisemeTrack.Num();
+}
+
+float USpeechComponent::GetReplicationDriftMilliseconds() {
+    FScopeLock lock(&Mutex);
+    if (!bIsSpeaking || PlayedReplicatedSpeechId == 0 || PlayedReplicatedSpeechId != ReplicatedSpeech.SpeechId) {
+        return 0.0f;
+    }
+    const double LocalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - StartTimePoint).count();
+    const double ServerMilliseconds = (GetServerWorldSeconds() - ReplicatedSpeech.ServerStartSeconds) * 1000.0;
+    return static_cast<float>(LocalMilliseconds - ServerMilliseconds);
+}
+
+void USpeechComponent::OnRep_ReplicatedSpeech() {
+    if (!ReplicatedSpeech.bPlaying) {
+        if (PlayedReplicatedSpeechId == ReplicatedSpeech.SpeechId && IsSpeaking()) {
+            StopSpeech();
+        }
+        return;
+    }
+    TArray<VisemeEvent> Visemes;
+    if (!VisemeTrackCodec::Decode(ReplicatedSpeech.VisemeTrack, Visemes) || Visemes.Num() == 0) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to decode the visemes of a replicated speech."));
+        return;
+    }
+    if (ReplicatedSpeech.SpeechId == PlayedReplicatedSpeechId) {
+        // Visemes of segments the server appended while the speech plays
+        FScopeLock lock(&Mutex);
+        if (Visemes.Num() > VisemeTrack->Num()) {
+            VisemeTrack = FVisemeTrack::Make(Visemes);
+        }
+        return;
+    }
+    PlayedReplicatedSpeechId = ReplicatedSpeech.SpeechId;
+    if (IsSpeaking()) {
+        StopSpeech();
+    }
+    CancelUtteranceRequests();
+    PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+    const FString Text = ReplicatedSpeech.Text;
+    const EVoiceId VoiceId = ReplicatedSpeech.VoiceId;
+    {
+        FScopeLock lock(&Mutex);
+        if (bIsShuttingDown) {
+            return;
+        }
+        UtteranceCancellationFlag = CancellationFlag;
+        SpeechAudio.Empty();
+        BakedSpeechAsset = ReplicatedSpeech.SpeechAsset;
+        UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+        SpeechText.Empty();
+        VisemeTrack = FVisemeTrack::Make(Visemes);
+        IntensityEnvelope = BakedSpeechAsset != nullptr ? BakedSpeechAsset->IntensityEnvelope : TArray<uint8>();
+        ActivePollyAudio.Reset();
+        bSpeechStarted = false;
+        PendingSegmentCount = 0;
+        UtteranceEndMilliseconds = BakedSpeechAsset != nullptr ? BakedSpeechAsset->GetNumAudioBytes() / PollyBytesPerMillisecond : VisemeTrack->GetEndMilliseconds();
+    }
+    if (BakedSpeechAsset != nullptr || Text.IsEmpty()) {
+        StartReplicatedSpeech();
+        return;
+    }
+    // Only the audio is synthesized, the visemes came from the server
+    PendingGenerateSpeechCalls.Increment();
+    TWeakObjectPtr<USpeechComponent> WeakThis(this);
+    Async(EAsyncExecution::ThreadPool, [this, WeakThis, Text, VoiceId, CancellationFlag]() {
+        LLM_SCOPE_POLLY_SPEECH();
+        TArray<FPollyAudioBuffer> Audio;
+        const bool bSucceeded = SynthesizeAudioSync(Text, VoiceId, CancellationFlag, Audio);
+        TArray<uint8> Envelope;
+        ComputeIntensityEnvelope(0, Audio, Envelope);
+        AsyncTask(ENamedThreads::GameThread, [WeakThis, CancellationFlag, bSucceeded, Audio = MoveTemp(Audio), Envelope = MoveTemp(Envelope)]() mutable {
+            USpeechComponent* SpeechComponent = WeakThis.Get();
+            if (SpeechComponent == nullptr || !bSucceeded) {
+                return;
+            }
+            {
+                FScopeLock lock(&SpeechComponent->Mutex);
+                if (SpeechComponent->UtteranceCancellationFlag != CancellationFlag) {
+                    return;
+                }
+                SpeechComponent->SpeechAudio = MoveTemp(Audio);
+                SpeechComponent->IntensityEnvelope = MoveTemp(Envelope);
+                SpeechComponent->UtteranceEndMilliseconds = PollyAudioBuffer::NumBytes(SpeechComponent->SpeechAudio) / PollyBytesPerMillisecond;
+            }
+            SpeechComponent->StartReplicatedSpeech();
+        });
+        PendingGenerateSpeechCalls.Decrement();
+    });
+}
+
+void USpeechComponent::SetIntensityEnvelope(int64 StartMilliseconds, const TArray<FPollyAudioBuffer>& Audio) {
+    POLLY_TRACE_SCOPE(USpeechComponent::SetIntensityEnvelope);
+    // Audio starting after a silence, e.g. a segment that arrived after the sound ran dry, follows silent frames
+    IntensityEnvelope.SetNumZeroed(StartMilliseconds / SpeechEnvelope::FrameMilliseconds);
+    ComputeIntensityEnvelope(StartMilliseconds, Audio, IntensityEnvelope);
+}
+
+void USpeechComponent::StartReplicatedSpeech() {
+    USoundWaveProcedural* PollyAudio = nullptr;
+    {
+        FScopeLock lock(&Mutex);
+        // A client that received the speech late, e.g. because it just joined, starts it where the server is
+        const int64 PlaybackMilliseconds = FMath::Max<int64>(FMath::RoundToInt((GetServerWorldSeconds() - ReplicatedSpeech.ServerStartSeconds) * 1000.0), 0);
+        if (PlaybackMilliseconds >= UtteranceEndMilliseconds) {
+            return;
+        }
+        BeginTraceSpeaking();
+        bIsSpeaking = true;
+        if (BakedSpeechAsset != nullptr || SpeechAudio.Num() > 0) {
+            PollyAudio = QueuePollyAudio(PlaybackMilliseconds);
+        }
+        ActivePollyAudio = PollyAudio;
+        bSpeechStarted = true;
+        StartedUtteranceFlag = UtteranceCancellationFlag;
+        WakeSpeechQueue();
+        SyncVisemesToPlayback(PlaybackMilliseconds);
+    }
+    OnReplicatedSpeechStarted.Broadcast(PollyAudio);
+}
+
+void USpeechComponent::SyncVisemesToPlayback(int64 PlaybackMilliseconds) {
+    StartTimePoint = std::chrono::steady_clock::now() - std::chrono::milliseconds(PlaybackMilliseconds);
+    // Past the last viseme it is held until the timer ends the speech, same as PlayNextViseme
+    CurrentVisemeIndex = FMath::Min(VisemeTrack->FindVisemeIndex(PlaybackMilliseconds), VisemeTrack->Num() - 1);
+    CurrentViseme = VisemeTrack->GetViseme(CurrentVisemeIndex);
+    ClearTimer();
+    SetTimer(FMath::Max<int64>(VisemeTrack->GetTimeMilliseconds(CurrentVisemeIndex) - PlaybackMilliseconds, 0) / 1000.0f);
+}
+
+void USpeechComponent::BeginTraceSpeaking() {
+    if (OpenTraceUtteranceId != 0) {
+        SpeechTrace::EndSpan(OpenTraceUtteranceId, ESpeechTraceSpan::Utterance);
+        OpenTraceUtteranceId = 0;
+    }
+    if (bIsSpeaking) {
+        // A speech started again while it plays
+        SpeechTrace::EndSpan(TraceUtteranceId, ESpeechTraceSpan::Speaking);
+    }
+    SpeechTrace::BeginSpan(TraceUtteranceId, ESpeechTraceSpan::Speaking);
+}
+
+bool USpeechComponent::IsReplicatingSpeech() const {
+    const AActor* Owner = GetOwner();
+    return bReplicateSpeech && Owner != nullptr && Owner->HasAuthority() && GetNetMode() != NM_Standalone;
+}
+
+double USpeechComponent::GetServerWorldSeconds() const {
+    const UWorld* World = GetWorld();
+    if (World == nullptr) {
+        return 0.0;
+    }
+    const AGameStateBase* GameState = World->GetGameState();
+    return GameState != nullptr ? GameState->GetServerWorldTimeSeconds() : World->GetTimeSeconds();
+}
+
+void USpeechComponent::UpdateReplicatedSpeech(bool bNewSpeech) {
+    if (!IsReplicatingSpeech()) {
+        return;
+    }
+    if (bNewSpeech) {
+        ReplicatedSpeech.SpeechId++;
+        ReplicatedSpeech.bPlaying = true;
+        ReplicatedSpeech.Text = SpeechText;
+        ReplicatedSpeech.VoiceId = SpeechVoiceId;
+        ReplicatedSpeech.SpeechAsset = BakedSpeechAsset;
+        ReplicatedSpeech.ServerStartSeconds = GetServerWorldSeconds();
+    }
+    TArray<VisemeEvent> Visemes;
+    VisemeTrack->GetVisemeEvents(Visemes);
+    VisemeTrackCodec::Encode(Visemes, ReplicatedSpeech.VisemeTrack);
+    NumReplicatedVisemes = VisemeTrack->Num();
+}
+
+bool USpeechComponent::SynthesizeAudioSync(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, TArray<FPollyAudioBuffer>& OutAudio) const {
+    // Segmented the way the server segmented the text, so that the audio lines up with the replicated visemes
+    for (const FString& Segment : SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, bPipelineSentences)) {
+        const FString CacheKey = GetSpeechCacheKey(Segment, VoiceId);
+        TSharedPtr<const FCachedSpeechSegment, ESPMode::ThreadSafe> Cached = CacheKey.IsEmpty() ? nullptr : FSpeechCache::Get().Find(CacheKey);
+        if (Cached.IsValid()) {
+            OutAudio.Add(Cached->ShareAudio());
+            continue;
+        }
+        const PollyOutcome Outcome = MyPollyClient->SynthesizeSpeechAsync(CreatePollyAudioRequest(Segment, VoiceId), GetRequestScheduling(), CancellationFlag).Get();
+        if (!CheckPollyOutcome(Outcome, TEXT("audio file"))) {
+            return false;
+        }
+        OutAudio.Add(Outcome.StreamBuffer);
+    }
+    return true;
+}
+
+void USpeechComponent::CancelSpeech() {
+    FScopeLock lock(&Mutex);
+    LastCancelledFlag = UtteranceCancellationFlag;
+    AbortUtterance();
+    LastCancelSeconds = FPlatformTime::Seconds();
+    CancelMetrics.NumCancels++;
+    CancelMetrics.LastCancelToIdleMs = 0.0;
+}
+
+bool USpeechComponent::EnqueueSpeech(const FString& Text, const EVoiceId VoiceId) {
+    if (Text.IsEmpty()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Cannot queue speech (check input text)."));
+        return false;
+    }
+    FScopeLock lock(&Mutex);
+    if (bIsShuttingDown) {
+        return false;
+    }
+    if (SpeechQueue.Num() >= MaxQueuedUtterances) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Cannot queue speech, the speech queue is full."));
+        return false;
+    }
+    SpeechQueue.Add(MakeShared<FQueuedUtterance, ESPMode::ThreadSafe>(Text, VoiceId));
+    RecordSpokenLine(Text, VoiceId);
+    // A queued speech that is still playing holds its last viseme until the new line is appended
+    if (SpeechQueueSpeechFlag.IsValid() && UtteranceCancellationFlag == SpeechQueueSpeechFlag && (bIsSpeaking || !bSpeechStarted)) {
+        PendingSegmentCount++;
+    }
+    if (!bSpeechQueueRunning) {
+        bSpeechQueueRunning = true;
+        TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> QueueSignal = MakeShared<FSpeechWorkSignal, ESPMode::ThreadSafe>();
+        SpeechQueueSignal = QueueSignal;
+        SpeechQueueWorker = Async(EAsyncExecution::ThreadPool, [this, QueueSignal]() {
+            RunSpeechQueue(QueueSignal);
+        });
+    }
+    WakeSpeechQueue();
+    return true;
+}
+
+int32 USpeechComponent::GetQueuedSpeechCount() {
+    FScopeLock lock(&Mutex);
+    return SpeechQueue.Num();
+}
+
+bool USpeechComponent::PrefetchSpeech(const FString& Text, const EVoiceId VoiceId, const ESpeechPriority Priority) {
+    if (Text.IsEmpty()) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Cannot prefetch speech (check input text)."));
+        return false;
+    }
+    FSpeechPrefetchStore& PrefetchStore = FSpeechPrefetchStore::Get();
+    if (PrefetchStore.Contains(Text, VoiceId) || IsSpeechCached(Text, VoiceId)) {
+        return true;
+    }
+    FScopeLock lock(&Mutex);
+    if (bIsShuttingDown) {
+        return false;
+    }
+    OwnPrefetches.RemoveAll([](const TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched) {
+        return Prefetched->IsReady();
+    });
+    TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched = MakeShared<FPrefetchedSpeech, ESPMode::ThreadSafe>(Text, VoiceId);
+    FPollyRequestScheduling Scheduling;
+    Scheduling.Priority = Priority;
+    for (const FString& Segment : SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, false)) {
+        Prefetched->Segments.Add(StartSegment(Segment, VoiceId, Prefetched->CancellationFlag, Scheduling));
+    }
+    OwnPrefetches.Add(Prefetched);
+    if (!PrefetchStore.Add(Prefetched)) {
+        // Another component prefetched the same text meanwhile
+        *Prefetched->CancellationFlag = true;
+    }
+    return true;
+}
+
+bool USpeechComponent::CancelPrefetchSpeech(const FString& Text, const EVoiceId VoiceId) {
+    return FSpeechPrefetchStore::Get().Discard(Text, VoiceId);
+}
+
+FSpeechPrefetchStats USpeechComponent::GetPrefetchStats() {
+    return FSpeechPrefetchStore::Get().GetStats();
+}
+
+FSpeechCacheStats USpeechComponent::GetSpeechCacheStats() {
+    return FSpeechCache::Get().GetStats();
+}
+
+void USpeechComponent::SetSpeechCacheBudget(int32 BudgetKB) {
+    FSpeechCache::Get().SetBudgetBytes(static_cast<int64>(BudgetKB) * 1024);
+}
+
+void USpeechComponent::SetSpeechDiskCacheBudget(int32 BudgetMB) {
+    FSpeechDiskCache::Get().SetBudgetBytes(static_cast<int64>(BudgetMB) * 1024 * 1024);
+}
+
+void USpeechComponent::ClearSpeechCache() {
+    FSpeechCache::Get().Empty();
+    FSpeechDiskCache::Get().Empty();
+}
+
+FSpeechMemoryStats USpeechComponent::GetSpeechMemoryStats() {
+    return FSpeechMemoryTracker::Get().GetStats();
+}
+
+void USpeechComponent::SetSpeechMemoryBudget(int32 BudgetMB) {
+    FSpeechMemoryTracker::SetBudgetMB(BudgetMB);
+}
+
+int64 USpeechComponent::GetSpeechMemoryBytes() {
+    FScopeLock lock(&Mutex);
+    int64 Bytes = SpeechAudio.GetAllocatedSize() + VisemeTrack->GetAllocatedSize() + IntensityEnvelope.GetAllocatedSize();
+    // Buffers shared with the FSpeechCache are accounted for by the cache
+    for (const FPollyAudioBuffer& Buffer : SpeechAudio) {
+        if (!FSpeechCache::Get().HoldsAudio(Buffer)) {
+            Bytes += Buffer->GetAllocatedSize();
+        }
+    }
+    if (StreamingAudio.IsValid()) {
+        Bytes += StreamingAudio->GetAllocatedSize();
+    }
+    if (USoundWaveProcedural* PollyAudio = ActivePollyAudio.Get()) {
+        // The sound of a speech held in buffers plays them where they are, it holds no audio of its own
+        if (UPollyBakedSoundWave* BakedPollyAudio = Cast<UPollyBakedSoundWave>(PollyAudio)) {
+            Bytes += BakedPollyAudio->GetResidentAudioBytes();
+        }
+        else if (Cast<UPollyBufferedSoundWave>(PollyAudio) == nullptr) {
+            Bytes += PollyAudio->GetAvailableAudioByteCount();
+        }
+    }
+    return Bytes;
+}
+
+int64 USpeechComponent::ReleaseIdleSpeech() {
+    FScopeLock lock(&Mutex);
+    const bool bIdle = bSpeechStarted && !bIsSpeaking && PendingSegmentCount == 0 && !bIncrementalTextOpen && SpeechQueue.Num() == 0;
+    if (!bIdle) {
+        return 0;
+    }
+    if (UPollyBufferedSoundWave* BufferedPollyAudio = Cast<UPollyBufferedSoundWave>(ActivePollyAudio.Get())) {
+        BufferedPollyAudio->StopStream();
+    }
+    const int64 ReleasedBytes = GetSpeechMemoryBytes();
+    SpeechAudio.Empty();
+    VisemeTrack = FVisemeTrack::GetEmpty();
+    IntensityEnvelope.Empty();
+    BakedSpeechAsset = nullptr;
+    ActivePollyAudio.Reset();
+    UtteranceEndMilliseconds = 0;
+    UE_LOG(LogPollyMsg, Verbose, TEXT("Released %lld bytes of speech of %s to stay within the speech memory budget."), ReleasedBytes, *GetPathName());
+    return ReleasedBytes;
+}
+
+FSpeechCancelMetrics USpeechComponent::GetCancelMetrics() {
+    FScopeLock lock(&Mutex);
+    return CancelMetrics;
+}
+
+void USpeechComponent::BeginPlay() {
+    Super::BeginPlay();
+    UPollySpeechWarmupSubsystem* WarmupSubsystem = GetWorld() != nullptr ? GetWorld()->GetSubsystem<UPollySpeechWarmupSubsystem>() : nullptr;
+    if (WarmupSubsystem == nullptr || !bWarmUpSpeechCache) {
+        return;
+    }
+    WarmupManifest = WarmupSubsystem->GetManifest();
+    if (bUseSpeechCache) {
+        WarmupSubsystem->StartWarmup(this);
+    }
+}
+
+void USpeechComponent::EndPlay(const EEndPlayReason::Type EndPlayReason) {
+    *WarmupCancellationFlag = true;
+    CancelUtteranceRequests();
+    Super::EndPlay(EndPlayReason);
+}
+
+void USpeechComponent::BeginDestroy() {
+    FSpeechMemoryTracker::Get().Unregister(this);
+    {
+        FScopeLock lock(&Mutex);
+        bIsShuttingDown = true;
+        *WarmupCancellationFlag = true;
+        AbortUtterance();
+        // Prefetches that returned already stay available to the other speech components
+        for (const TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched : OwnPrefetches) {
+            if (!Prefetched->IsReady()) {
+                FSpeechPrefetchStore::Get().Discard(Prefetched.ToSharedRef());
+            }
+        }
+    }
+    Super::BeginDestroy();
+}
+
+bool USpeechComponent::IsReadyForFinishDestroy() {
+    const bool bPipelineDone = !SegmentPipeline.IsValid() || SegmentPipeline.IsReady();
+    const bool bSpeechQueueDone = !SpeechQueueWorker.IsValid() || SpeechQueueWorker.IsReady();
+    bool bPrefetchesDone = true;
+    bool bCancelledWorkDone = true;
+    {
+        FScopeLock lock(&Mutex);
+        for (const TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched : OwnPrefetches) {
+            bPrefetchesDone &= Prefetched->IsReady();
+        }
+        for (const TFuture<void>& Work : CancelledWork) {
+            bCancelledWorkDone &= Work.IsReady();
+        }
+    }
+    return Super::IsReadyForFinishDestroy() && bPipelineDone && bSpeechQueueDone && bPrefetchesDone && bCancelledWorkDone && PendingGenerateSpeechCalls.GetValue() == 0;
+}
+
 void USpeechComponent::PlayNextViseme() {
+    POLLY_TRACE_SCOPE(USpeechComponent::PlayNextViseme);
     FScopeLock lock(&Mutex);
+    if (NumReplicatedVisemes > 0 && VisemeTrack->Num() > NumReplicatedVisemes) {
+        UpdateReplicatedSpeech(false);
+    }
     CurrentVisemeIndex++;
     ClearTimer();
-    if (CurrentVisemeIndex == VisemeEventArray.Num() || VisemeEventArray.Num() == 0) {
+    if (CurrentVisemeIndex == VisemeTrack->Num() && (PendingSegmentCount > 0 || bIncrementalTextOpen)) {
+        // The speech caught up with the segments synthesized so far, hold the last viseme until the next one arrives
+        CurrentVisemeIndex--;
+        SetTimer(PendingSegmentPollSeconds);
+        return;
+    }
+    if (CurrentVisemeIndex == VisemeTrack->Num() || VisemeTrack->Num() == 0) {
+        if (bIsSpeaking) {
+            SpeechTrace::EndSpan(TraceUtteranceId, ESpeechTraceSpan::Speaking);
+        }
         bIsSpeaking = false;
+        WakeSpeechQueue();
         return;
     }
     else {
-        CurrentViseme = VisemeEventArray[CurrentVisemeIndex].Viseme;
+        CurrentViseme = VisemeTrack->GetViseme(CurrentVisemeIndex);
         auto CurrentTimePoint = std::chrono::steady_clock::now();
         float SecondsSinceStart = std::chrono::duration<float, std::milli>(CurrentTimePoint - StartTimePoint).count() / 1000.0f;
-        float CurrentVisemeDurationSeconds = fmaxf(VisemeEventArray[CurrentVisemeIndex].TimeMilliseconds / 1000.0f - SecondsSinceStart, 0);
+        float CurrentVisemeDurationSeconds = fmaxf(VisemeTrack->GetTimeMilliseconds(CurrentVisemeIndex) / 1000.0f - SecondsSinceStart, 0);
         SetTimer(CurrentVisemeDurationSeconds);
     }
 }
 
-void USpeechComponent::GenerateSpeechSync(const FString Text, const EVoiceId VoiceId) {
+bool FPendingGeneratedSpeech::IsReady() const {
+    if (!bStarted) {
+        return true;
+    }
+    if (Prefetched.IsValid()) {
+        return Prefetched->IsReady();
+    }
+    if (RingBuffer.IsValid()) {
+        // Playback starts once the visemes and the jitter buffer of the audio have arrived
+        return StreamedVisemeFuture.IsReady() && (StreamedAudioFuture.IsReady() || RingBuffer->Num() >= JitterBufferBytes);
+    }
+    return !StartedSegments.ContainsByPredicate([](const FPendingSpeechSegment& Segment) {
+        return !Segment.IsReady();
+    });
+}
+
+bool USpeechComponent::GenerateSpeechSync(const FString Text, const EVoiceId VoiceId) {
+    // The utterance of a latent GenerateSpeech call began with the call, any other begins here
+    TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech = BeginGenerateSpeech(Text, VoiceId, SpeechTrace::GetThreadUtteranceId());
+    return FinishGenerateSpeech(*Speech);
+}
+
+TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> USpeechComponent::BeginGenerateSpeech(const FString& Text, const EVoiceId VoiceId, uint32 UtteranceId) {
+    if (UtteranceId == 0) {
+        UtteranceId = SpeechTrace::NewUtteranceId();
+        SpeechTrace::BeginSpan(UtteranceId, ESpeechTraceSpan::Utterance);
+    }
+    SpeechTrace::BeginSpan(UtteranceId, ESpeechTraceSpan::Synthesis);
+    TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> Speech = MakeShared<FPendingGeneratedSpeech, ESPMode::ThreadSafe>(Text, VoiceId, UtteranceId);
     if (Text.IsEmpty()) {
         UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech (check input text)."));
-        return;
+        return Speech;
     }
     if (IsSpeaking()) {
         UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech during playback."));
+        return Speech;
+    }
+    CancelUtteranceRequests();
+    RecordSpokenLine(Text, VoiceId);
+    {
+        FScopeLock lock(&Mutex);
+        SpeechText = Text;
+        SpeechVoiceId = VoiceId;
+        TraceUtteranceId = UtteranceId;
+    }
+    if (SynthesisMode != ESpeechSynthesisMode::Full) {
+        Speech->bStarted = StartReducedSpeechRequests(*Speech, SynthesisMode);
+        return Speech;
+    }
+    TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched = FSpeechPrefetchStore::Get().Take(Text, VoiceId);
+    if (Prefetched.IsValid()) {
+        // The requests of the prefetch become the requests of the speech, so that CancelSpeech aborts them
+        FScopeLock lock(&Mutex);
+        if (bIsShuttingDown) {
+            FSpeechPrefetchStore::Get().RecordLookup(false);
+            return Speech;
+        }
+        UtteranceCancellationFlag = Prefetched->CancellationFlag;
+        Speech->CancellationFlag = Prefetched->CancellationFlag;
+        Speech->Prefetched = Prefetched;
+        Speech->bStarted = true;
+        return Speech;
+    }
+    FSpeechPrefetchStore::Get().RecordLookup(false);
+    Speech->bStarted = StartSpeechRequests(*Speech);
+    return Speech;
+}
+
+bool USpeechComponent::FinishGenerateSpeech(FPendingGeneratedSpeech& Speech, bool bWaitForRetry) {
+    bool bSucceeded = false;
+    if (!Speech.bStarted) {
+        bSucceeded = false;
+    }
+    else if (Speech.Mode != ESpeechSynthesisMode::Full) {
+        bSucceeded = FinishReducedSpeech(Speech);
+    }
+    else if (Speech.Prefetched.IsValid()) {
+        bool bCancelled = false;
+        bSucceeded = FinishPrefetchedSpeech(*Speech.Prefetched, bCancelled);
+        FSpeechPrefetchStore::Get().RecordLookup(bSucceeded);
+        Speech.Prefetched.Reset();
+        if (!bSucceeded && !bCancelled) {
+            UE_LOG(LogPollyMsg, Warning, TEXT("Prefetched speech failed, synthesizing it again."));
+            Speech.bStarted = StartSpeechRequests(Speech);
+            if (Speech.bStarted && !bWaitForRetry) {
+                return false;
+            }
+            bSucceeded = Speech.bStarted && FinishSpeechRequests(Speech);
+        }
+    }
+    else {
+        bSucceeded = FinishSpeechRequests(Speech);
+    }
+    Speech.bFinished = true;
+    SpeechTrace::EndSpan(Speech.UtteranceId, ESpeechTraceSpan::Synthesis);
+    FScopeLock lock(&Mutex);
+    // The speech queue waits for a generated speech to play or fail before it starts one of its own
+    WakeSpeechQueue();
+    if (!bSucceeded) {
+        SpeechTrace::EndSpan(Speech.UtteranceId, ESpeechTraceSpan::Utterance);
+        return false;
+    }
+    // The utterance ends when its speech starts, or when it is replaced by the next one without having started
+    if (OpenTraceUtteranceId != 0) {
+        SpeechTrace::EndSpan(OpenTraceUtteranceId, ESpeechTraceSpan::Utterance);
+    }
+    OpenTraceUtteranceId = Speech.UtteranceId;
+    return true;
+}
+
+bool USpeechComponent::StartSpeechRequests(FPendingGeneratedSpeech& Speech) {
+    Speech.Segments = SpeechTextUtils::SplitText(Speech.Text, SpeechTextUtils::PollyMaxTextLength, bPipelineSentences);
+    // Splitting into sentences drops the pieces that are only whitespace, which may leave nothing to say
+    if (Speech.Segments.Num() == 0) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech (check input text)."));
+        return false;
+    }
+    PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+    {
+        // Installed before any request is issued, so that CancelSpeech can abort them
+        FScopeLock lock(&Mutex);
+        if (bIsShuttingDown) {
+            return false;
+        }
+        UtteranceCancellationFlag = CancellationFlag;
+    }
+    Speech.CancellationFlag = CancellationFlag;
+    // A cached first segment is faster than streaming it
+    if (bStreamAudio && !FSpeechCache::Get().Contains(GetSpeechCacheKey(Speech.Segments[0], Speech.VoiceId))) {
+        TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer = MakeShared<FPollyAudioRingBuffer, ESPMode::ThreadSafe>(StreamingBufferKB * 1024);
+        // The completed stream releases the jitter buffer wait of FinishStreamingSpeech, whether it failed, was
+        // cancelled or was too short
+        Speech.StreamedAudioFuture = MyPollyClient->SynthesizeSpeechStreamAsync(CreatePollyAudioRequest(Speech.Segments[0], Speech.VoiceId), RingBuffer, GetRequestScheduling(), CancellationFlag)
+            .Then([RingBuffer](TFuture<PollyOutcome> StreamFuture) {
+                PollyOutcome Outcome = StreamFuture.Get();
+                RingBuffer->StopWaiting();
+                return Outcome;
+            });
+        Speech.StreamedVisemeFuture = MyPollyClient->SynthesizeSpeechAsync(CreatePollyVisemeRequest(Speech.Segments[0], Speech.VoiceId), GetRequestScheduling(), CancellationFlag);
+        Speech.JitterBufferBytes = FMath::Min(StreamingJitterBufferMs * PollyBytesPerMillisecond, RingBuffer->GetCapacity());
+        Speech.RingBuffer = RingBuffer;
+        return true;
+    }
+    // Both requests of a segment are put in flight at once so that the wait is the slower of the two round trips
+    // rather than their sum. They share a cancellation flag, so a failure of either one aborts the other.
+    // Pipelined sentences after the first one are synthesized once the speech is generated, other segments are all
+    // waited for, so they are all put in flight now.
+    const int32 NumStartedSegments = bPipelineSentences ? 1 : Speech.Segments.Num();
+    for (int32 SegmentIndex = 0; SegmentIndex < NumStartedSegments; SegmentIndex++) {
+        Speech.StartedSegments.Add(StartSegment(Speech.Segments[SegmentIndex], Speech.VoiceId, CancellationFlag, GetRequestScheduling()));
+    }
+    return true;
+}
+
+bool USpeechComponent::StartReducedSpeechRequests(FPendingGeneratedSpeech& Speech, const ESpeechSynthesisMode Mode) {
+    Speech.Mode = Mode;
+    Speech.Segments = SpeechTextUtils::SplitText(Speech.Text, SpeechTextUtils::PollyMaxTextLength, false);
+    PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+    {
+        FScopeLock lock(&Mutex);
+        if (bIsShuttingDown) {
+            return false;
+        }
+        UtteranceCancellationFlag = CancellationFlag;
+    }
+    Speech.CancellationFlag = CancellationFlag;
+    for (const FString& Segment : Speech.Segments) {
+        Speech.StartedSegments.Add(StartSegment(Segment, Speech.VoiceId, CancellationFlag, GetRequestScheduling(), Mode));
+    }
+    return true;
+}
+
+bool USpeechComponent::FinishSpeechRequests(FPendingGeneratedSpeech& Speech) {
+    if (Speech.RingBuffer.IsValid()) {
+        return FinishStreamingSpeech(Speech);
+    }
+    const PollyCancellationFlag CancellationFlag = Speech.CancellationFlag.ToSharedRef();
+    TArray<FPollyAudioBuffer> FirstSegmentAudio;
+    TArray<VisemeEvent> FirstSegmentVisemes;
+    // A speech without visemes cannot be played, so it fails before it replaces the previous one
+    if (!FinishSegment(Speech.StartedSegments[0], FirstSegmentAudio, FirstSegmentVisemes) || FirstSegmentVisemes.Num() == 0) {
+        *CancellationFlag = true;
+        // All requests are waited for, as they use the Polly client of this component
+        for (const FPendingSpeechSegment& Segment : Speech.StartedSegments) {
+            Segment.Wait();
+        }
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    TArray<FString> Segments = Speech.Segments;
+    const EVoiceId VoiceId = Speech.VoiceId;
+    bool bCancelled = false;
+    {
+        FScopeLock lock(&Mutex);
+        bCancelled = UtteranceCancellationFlag != CancellationFlag;
+        if (!bCancelled) {
+            SpeechAudio = MoveTemp(FirstSegmentAudio);
+            SetIntensityEnvelope(0, SpeechAudio);
+            BakedSpeechAsset = nullptr;
+            UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+            VisemeTrack = FVisemeTrack::Make(FirstSegmentVisemes);
+            ActivePollyAudio.Reset();
+            bSpeechStarted = false;
+            UtteranceEndMilliseconds = PollyAudioBuffer::NumBytes(SpeechAudio) / PollyBytesPerMillisecond;
+            PendingSegmentCount = Segments.Num() - 1;
+            UE_LOG(LogPollyMsg, Display, TEXT("Polly called successfully!"));
+        }
+    }
+    if (bCancelled) {
+        UE_LOG(LogPollyMsg, Display, TEXT("Speech generation was cancelled."));
+        for (const FPendingSpeechSegment& Segment : Speech.StartedSegments) {
+            Segment.Wait();
+        }
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    if (Segments.Num() > 1) {
+        Segments.RemoveAt(0);
+        // Pipelined sentences are put in flight one after the other, starting with the first one
+        if (Speech.StartedSegments.Num() == 1) {
+            FScopeLock lock(&Mutex);
+            SegmentPipeline = Async(EAsyncExecution::ThreadPool, [this, Segments, VoiceId, CancellationFlag]() {
+                RunSegmentPipeline(Segments, VoiceId, CancellationFlag, nullptr);
+            });
+        }
+        else {
+            // The other segments were put in flight with the first one
+            TArray<FPendingSpeechSegment> StartedSegments = MoveTemp(Speech.StartedSegments);
+            StartedSegments.RemoveAt(0);
+            return RunSegmentPipeline(Segments, VoiceId, CancellationFlag, nullptr, MoveTemp(StartedSegments));
+        }
+    }
+    return true;
+}
+
+bool USpeechComponent::FinishPrefetchedSpeech(const FPrefetchedSpeech& Prefetched, bool& bOutCancelled) {
+    const PollyCancellationFlag CancellationFlag = Prefetched.CancellationFlag;
+    bOutCancelled = false;
+    TArray<FPollyAudioBuffer> Audio;
+    TArray<VisemeEvent> Visemes;
+    const bool bSucceeded = FinishSegments(Prefetched.Segments, Audio, Visemes) && Visemes.Num() > 0;
+    FScopeLock lock(&Mutex);
+    if (UtteranceCancellationFlag != CancellationFlag) {
+        UE_LOG(LogPollyMsg, Display, TEXT("Speech generation was cancelled."));
+        bOutCancelled = true;
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    if (!bSucceeded) {
+        UtteranceCancellationFlag.Reset();
+        return false;
+    }
+    SpeechAudio = MoveTemp(Audio);
+    SetIntensityEnvelope(0, SpeechAudio);
+    BakedSpeechAsset = nullptr;
+    UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+    VisemeTrack = FVisemeTrack::Make(Visemes);
+    ActivePollyAudio.Reset();
+    bSpeechStarted = false;
+    UtteranceEndMilliseconds = PollyAudioBuffer::NumBytes(SpeechAudio) / PollyBytesPerMillisecond;
+    PendingSegmentCount = 0;
+    UE_LOG(LogPollyMsg, Display, TEXT("Speech generated from prefetched Polly results."));
+    return true;
+}
+
+bool USpeechComponent::FinishReducedSpeech(FPendingGeneratedSpeech& Speech) {
+    const ESpeechSynthesisMode Mode = Speech.Mode;
+    const PollyCancellationFlag CancellationFlag = Speech.CancellationFlag.ToSharedRef();
+    const TArray<FString>& Segments = Speech.Segments;
+    const TArray<FPendingSpeechSegment>& PendingSegments = Speech.StartedSegments;
+    TArray<FPollyAudioBuffer> Audio;
+    TArray<VisemeEvent> Visemes;
+    int64 DurationMilliseconds = 0;
+    bool bSucceeded = true;
+    for (int32 SegmentIndex = 0; bSucceeded && SegmentIndex < Segments.Num(); SegmentIndex++) {
+        TArray<FPollyAudioBuffer> SegmentAudio;
+        TArray<VisemeEvent> SegmentVisemes;
+        int64 SegmentMilliseconds = 0;
+        bSucceeded = FinishSegmentInMode(PendingSegments[SegmentIndex], Segments[SegmentIndex], Mode, SegmentAudio, SegmentVisemes, SegmentMilliseconds) && !*CancellationFlag;
+        for (VisemeEvent& Event : SegmentVisemes) {
+            Event.TimeMilliseconds += DurationMilliseconds;
+        }
+        Audio.Append(SegmentAudio);
+        Visemes.Append(SegmentVisemes);
+        DurationMilliseconds += SegmentMilliseconds;
+    }
+    if (!bSucceeded) {
+        *CancellationFlag = true;
+        // All requests are waited for, as they use the Polly client of this component
+        for (const FPendingSpeechSegment& Segment : PendingSegments) {
+            Segment.Wait();
+        }
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    if (Mode != ESpeechSynthesisMode::VisemesOnly) {
+        // Without visemes the mouth stays closed for as long as the speech lasts
+        Visemes = { { EViseme::Sil, static_cast<int32>(DurationMilliseconds) } };
+    }
+    FScopeLock lock(&Mutex);
+    if (UtteranceCancellationFlag != CancellationFlag) {
+        UE_LOG(LogPollyMsg, Display, TEXT("Speech generation was cancelled."));
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    if (Visemes.Num() == 0) {
+        *CancellationFlag = true;
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    SpeechAudio = MoveTemp(Audio);
+    SetIntensityEnvelope(0, SpeechAudio);
+    BakedSpeechAsset = nullptr;
+    VisemeTrack = FVisemeTrack::Make(Visemes);
+    ActivePollyAudio.Reset();
+    bSpeechStarted = false;
+    UtteranceEndMilliseconds = DurationMilliseconds;
+    UtteranceSynthesisMode = Mode;
+    PendingSegmentCount = 0;
+    UE_LOG(LogPollyMsg, Display, TEXT("Polly called successfully!"));
+    return true;
+}
+
+bool USpeechComponent::FinishStreamingSpeech(FPendingGeneratedSpeech& Speech) {
+    const PollyCancellationFlag CancellationFlag = Speech.CancellationFlag.ToSharedRef();
+    TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer = Speech.RingBuffer.ToSharedRef();
+    const PollyOutcome& PollyVisemeOutcome = Speech.StreamedVisemeFuture.Get();
+    // Only the jitter buffer has to arrive before playback can start, the rest keeps streaming in the background
+    RingBuffer->WaitForBytes(Speech.JitterBufferBytes);
+    const bool bVisemesSucceeded = CheckPollyOutcome(PollyVisemeOutcome, TEXT("visemes"));
+    bool bAudioSucceeded = true;
+    if (Speech.StreamedAudioFuture.IsReady() || *CancellationFlag) {
+        bAudioSucceeded = CheckPollyOutcome(Speech.StreamedAudioFuture.Get(), TEXT("audio file"));
+    }
+    if (!bAudioSucceeded || !bVisemesSucceeded) {
+        *CancellationFlag = true;
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    // The visemes are checked before the current speech is touched, so that a bad response leaves it as it was
+    TArray<VisemeEvent> Visemes;
+    if (!ParseVisemeEvents(PollyVisemeOutcome.StreamBuffer->GetView(), Visemes)) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly."));
+    }
+    if (Visemes.Num() == 0) {
+        *CancellationFlag = true;
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    TArray<FString> Segments = Speech.Segments;
+    const EVoiceId VoiceId = Speech.VoiceId;
+    FScopeLock lock(&Mutex);
+    if (UtteranceCancellationFlag != CancellationFlag) {
+        UE_LOG(LogPollyMsg, Display, TEXT("Speech generation was cancelled."));
+        NoteAbortedWorkFinished(CancellationFlag);
+        return false;
+    }
+    SpeechAudio.Empty();
+    IntensityEnvelope.Empty();
+    BakedSpeechAsset = nullptr;
+    UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+    VisemeTrack = FVisemeTrack::Make(Visemes);
+    StreamingAudio = RingBuffer;
+    ActivePollyAudio.Reset();
+    bSpeechStarted = false;
+    UtteranceEndMilliseconds = 0;
+    PendingSegmentCount = Segments.Num() - 1;
+    UE_LOG(LogPollyMsg, Display, TEXT("Polly called successfully!"));
+    // The remaining segments can only be written into the ring buffer after the first stream completed
+    Segments.RemoveAt(0);
+    TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> PipelineRingBuffer = RingBuffer;
+    SegmentPipeline = Async(EAsyncExecution::ThreadPool, [this, AudioFuture = MoveTemp(Speech.StreamedAudioFuture), Segments, VoiceId, CancellationFlag, PipelineRingBuffer]() {
+        const PollyOutcome& Outcome = AudioFuture.Get();
+        if (!Outcome.IsSuccess) {
+            // Errors hitting the stream after playback started can only be reported once they happen
+            if (!Outcome.IsCancelled) {
+                UE_LOG(LogPollyMsg, Error, TEXT("Polly failed to stream audio file. Error: %s"), *AwsStringToFString(Outcome.PollyErrorMsg));
+            }
+            *CancellationFlag = true;
+        }
+        RunSegmentPipeline(Segments, VoiceId, CancellationFlag, PipelineRingBuffer);
+    });
+    return true;
+}
+
+void USpeechComponent::AppendText(const FString& Text, const EVoiceId VoiceId) {
+    bool bStartsSpeech;
+    {
+        FScopeLock lock(&Mutex);
+        bStartsSpeech = !bIncrementalTextOpen;
+        if (bStartsSpeech && bIsSpeaking) {
+            UE_LOG(LogPollyMsg, Error, TEXT("Cannot generate speech during playback."));
+            return;
+        }
+    }
+    if (bStartsSpeech) {
+        CancelUtteranceRequests();
+        PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+        FScopeLock lock(&Mutex);
+        if (bIsShuttingDown) {
+            return;
+        }
+        SpeechAudio.Empty();
+        IntensityEnvelope.Empty();
+        BakedSpeechAsset = nullptr;
+        UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+        // Built from text arriving over time, so clients only receive the visemes
+        SpeechText.Empty();
+        VisemeTrack = FVisemeTrack::GetEmpty();
+        ActivePollyAudio.Reset();
+        bSpeechStarted = false;
+        UtteranceCancellationFlag = CancellationFlag;
+        UtteranceEndMilliseconds = 0;
+        bIncrementalTextOpen = true;
+        IncrementalTextSegmenter = MakeShared<FSpeechPhraseSegmenter>(IncrementalMinClauseLength);
+        TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> TextSignal = MakeShared<FSpeechWorkSignal, ESPMode::ThreadSafe>();
+        IncrementalTextSignal = TextSignal;
+        SegmentPipeline = Async(EAsyncExecution::ThreadPool, [this, VoiceId, CancellationFlag, TextSignal]() {
+            RunIncrementalPipeline(VoiceId, CancellationFlag, TextSignal);
+        });
+    }
+    FScopeLock lock(&Mutex);
+    if (!bIncrementalTextOpen) {
         return;
     }
-    if (SynthesizeAudio(Text, VoiceId) && SynthesizeVisemes(Text, VoiceId)) {
-        UE_LOG(LogPollyMsg, Display, TEXT("Polly called successfully!"));
+    TArray<FString> Phrases;
+    IncrementalTextSegmenter->Append(Text, Phrases);
+    PendingPhrases.Append(Phrases);
+    PendingSegmentCount += Phrases.Num();
+    if (Phrases.Num() > 0) {
+        IncrementalTextSignal->Trigger();
     }
 }
 
-bool USpeechComponent::SynthesizeAudio(const FString& Text, const EVoiceId VoiceId) {
-    PollyOutcome PollyAudioOutcome = MyPollyClient->SynthesizeSpeech(CreatePollyAudioRequest(Text, VoiceId));
-    if (PollyAudioOutcome.IsSuccess) {
+void USpeechComponent::FinishText() {
+    FScopeLock lock(&Mutex);
+    if (!bIncrementalTextOpen) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("FinishText called without any text appended by AppendText."));
+        return;
+    }
+    TArray<FString> Phrases;
+    IncrementalTextSegmenter->Flush(Phrases);
+    PendingPhrases.Append(Phrases);
+    PendingSegmentCount += Phrases.Num();
+    bIncrementalTextOpen = false;
+    IncrementalTextSignal->Trigger();
+}
+
+FPollyRequestScheduling USpeechComponent::GetRequestScheduling() const {
+    FPollyRequestScheduling Scheduling;
+    Scheduling.Priority = SpeechPriority;
+    Scheduling.TraceUtteranceId = TraceUtteranceId;
+    if (SynthesisDeadlineMs > 0) {
+        Scheduling.DeadlineSeconds = FPlatformTime::Seconds() + SynthesisDeadlineMs / 1000.0;
+    }
+    return Scheduling;
+}
+
+FString USpeechComponent::GetSpeechCacheKey(const FString& Text, const EVoiceId VoiceId) const {
+    return bUseSpeechCache ? FSpeechCache::MakeKey(Text, VoiceId, FSpeechCache::OutputFormat) : FString();
+}
+
+bool USpeechComponent::IsSpeechCached(const FString& Text, const EVoiceId VoiceId) const {
+    return AreSegmentsCached(Text, VoiceId, false);
+}
+
+bool USpeechComponent::AreSegmentsCached(const FString& Text, const EVoiceId VoiceId, bool bInMemoryOnly) const {
+    if (!bUseSpeechCache || Text.IsEmpty()) {
+        return false;
+    }
+    const TArray<FString> Segments = SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, bPipelineSentences);
+    if (Segments.Num() == 0) {
+        return false;
+    }
+    for (const FString& Segment : Segments) {
+        const FString Key = GetSpeechCacheKey(Segment, VoiceId);
+        if (bInMemoryOnly ? !FSpeechCache::Get().ContainsInMemory(Key) : !FSpeechCache::Get().Contains(Key)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void USpeechComponent::RecordSpokenLine(const FString& Text, const EVoiceId VoiceId) {
+    if (WarmupManifest.IsValid()) {
+        WarmupManifest->Record(Text, VoiceId);
+    }
+}
+
+bool USpeechComponent::WarmSpeechCache(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag) {
+    if (!bUseSpeechCache || Text.IsEmpty()) {
+        return false;
+    }
+    if (IsSpeechCached(Text, VoiceId)) {
+        return true;
+    }
+    // FinishSegment adds each segment to the cache
+    FPollyRequestScheduling Scheduling;
+    Scheduling.Priority = ESpeechPriority::Ambient;
+    TArray<FPollyAudioBuffer> Audio;
+    TArray<VisemeEvent> Visemes;
+    return SynthesizeSpeechSync(Text, VoiceId, CancellationFlag, Scheduling, Audio, Visemes);
+}
+
+bool USpeechComponent::SynthesizeSpeechSync(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, const FPollyRequestScheduling& Scheduling, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents) {
+    TArray<FPendingSpeechSegment> Segments;
+    for (const FString& Segment : SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, bPipelineSentences)) {
+        Segments.Add(StartSegment(Segment, VoiceId, CancellationFlag, Scheduling));
+    }
+    const bool bSucceeded = FinishSegments(Segments, OutAudio, OutVisemeEvents) && !*CancellationFlag;
+    // All requests are waited for, as they use the Polly client of this component
+    for (const FPendingSpeechSegment& Segment : Segments) {
+        Segment.Wait();
+    }
+    return bSucceeded;
+}
+
+FPendingSpeechSegment USpeechComponent::StartSegment(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, const FPollyRequestScheduling& Scheduling, const ESpeechSynthesisMode Mode) {
+    FPendingSpeechSegment Segment;
+    Segment.CacheKey = GetSpeechCacheKey(Text, VoiceId);
+    if (!Segment.CacheKey.IsEmpty()) {
+        Segment.Cached = FSpeechCache::Get().Find(Segment.CacheKey);
+        if (Segment.Cached.IsValid()) {
+            return Segment;
+        }
+    }
+    if (Mode == ESpeechSynthesisMode::Full || Mode == ESpeechSynthesisMode::AudioOnly) {
+        Segment.AudioFuture = MyPollyClient->SynthesizeSpeechAsync(CreatePollyAudioRequest(Text, VoiceId), Scheduling, CancellationFlag);
+    }
+    if (Mode == ESpeechSynthesisMode::Full || Mode == ESpeechSynthesisMode::VisemesOnly) {
+        Segment.VisemeFuture = MyPollyClient->SynthesizeSpeechAsync(CreatePollyVisemeRequest(Text, VoiceId), Scheduling, CancellationFlag);
+    }
+    return Segment;
+}
+
+bool USpeechComponent::FinishSegment(const FPendingSpeechSegment& Segment, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents) const {
+    LLM_SCOPE_POLLY_SPEECH();
+    if (Segment.Cached.IsValid()) {
+        OutAudio.Add(Segment.Cached->ShareAudio());
+        OutVisemeEvents.Append(Segment.Cached->Visemes);
+        return true;
+    }
+    const PollyOutcome& PollyAudioOutcome = Segment.AudioFuture.Get();
+    const PollyOutcome& PollyVisemeOutcome = Segment.VisemeFuture.Get();
+    const bool bAudioSucceeded = CheckPollyOutcome(PollyAudioOutcome, TEXT("audio file"));
+    const bool bVisemesSucceeded = CheckPollyOutcome(PollyVisemeOutcome, TEXT("visemes"));
+    if (!bAudioSucceeded || !bVisemesSucceeded) {
+        return false;
+    }
+    if (!ParseVisemeEvents(PollyVisemeOutcome.StreamBuffer->GetView(), OutVisemeEvents)) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly."));
+        return false;
+    }
+    // The buffer of the response is shared with the cache and the speech rather than copied
+    OutAudio.Add(PollyAudioOutcome.StreamBuffer);
+    if (!Segment.CacheKey.IsEmpty()) {
+        FSpeechCache::Get().Add(Segment.CacheKey, PollyAudioOutcome.StreamBuffer, OutVisemeEvents);
+    }
+    return true;
+}
+
+bool USpeechComponent::FinishSegmentInMode(const FPendingSpeechSegment& Segment, const FString& Text, const ESpeechSynthesisMode Mode, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents, int64& OutDurationMilliseconds) const {
+    if (Segment.Cached.IsValid()) {
+        // A cached segment has both halves, only the ones the mode needs are used
+        OutDurationMilliseconds = Segment.Cached->GetAudio().Num() / PollyBytesPerMillisecond;
+        if (Mode == ESpeechSynthesisMode::AudioOnly) {
+            OutAudio.Add(Segment.Cached->ShareAudio());
+        }
+        else if (Mode == ESpeechSynthesisMode::VisemesOnly) {
+            OutVisemeEvents.Append(Segment.Cached->Visemes);
+        }
+        return true;
+    }
+    switch (Mode) {
+    case ESpeechSynthesisMode::AudioOnly: {
+        const PollyOutcome& PollyAudioOutcome = Segment.AudioFuture.Get();
+        if (!CheckPollyOutcome(PollyAudioOutcome, TEXT("audio file"))) {
+            return false;
+        }
+        OutAudio.Add(PollyAudioOutcome.StreamBuffer);
+        OutDurationMilliseconds = PollyAudioOutcome.StreamBuffer->Num() / PollyBytesPerMillisecond;
+        return true;
+    }
+    case ESpeechSynthesisMode::VisemesOnly: {
+        const PollyOutcome& PollyVisemeOutcome = Segment.VisemeFuture.Get();
+        if (!CheckPollyOutcome(PollyVisemeOutcome, TEXT("visemes"))) {
+            return false;
+        }
+        if (!ParseVisemeEvents(PollyVisemeOutcome.StreamBuffer->GetView(), OutVisemeEvents)) {
+            UE_LOG(LogPollyMsg, Error, TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly."));
+            return false;
+        }
+        // The last speech mark is the end of the segment, usually a sil
+        OutDurationMilliseconds = OutVisemeEvents.Num() > 0 ? OutVisemeEvents.Last().TimeMilliseconds : 0;
+        return true;
+    }
+    case ESpeechSynthesisMode::DurationOnly:
+        OutDurationMilliseconds = SpeechTextUtils::EstimateSpeechMilliseconds(Text);
+        return true;
+    default: {
+        const bool bSucceeded = FinishSegment(Segment, OutAudio, OutVisemeEvents);
+        OutDurationMilliseconds = PollyAudioBuffer::NumBytes(OutAudio) / PollyBytesPerMillisecond;
+        return bSucceeded;
+    }
+    }
+}
+
+bool USpeechComponent::RunSegmentPipeline(const TArray<FString>& Segments, const EVoiceId VoiceId, PollyCancellationFlag CancellationFlag, TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, TArray<FPendingSpeechSegment> StartedSegments) {
+    // All requests are issued from this thread in segment order, while the segments are appended strictly in order
+    TArray<FPendingSpeechSegment> InFlight = MoveTemp(StartedSegments);
+    int32 NextSegmentIndex = InFlight.Num();
+    bool bSucceeded = !*CancellationFlag;
+    for (int32 SegmentIndex = 0; bSucceeded && SegmentIndex < Segments.Num(); SegmentIndex++) {
+        while (NextSegmentIndex < Segments.Num() && NextSegmentIndex - SegmentIndex < FMath::Max(MaxConcurrentSegmentRequests, 1)) {
+            InFlight.Add(StartSegment(Segments[NextSegmentIndex++], VoiceId, CancellationFlag, GetRequestScheduling()));
+        }
+        TArray<FPollyAudioBuffer> Audio;
+        TArray<VisemeEvent> Visemes;
+        bSucceeded = FinishSegment(InFlight[0], Audio, Visemes) && !*CancellationFlag;
+        InFlight.RemoveAt(0);
+        if (bSucceeded) {
+            AppendSegment(Audio, Visemes, CancellationFlag, RingBuffer);
+        }
+    }
+    if (!bSucceeded) {
+        *CancellationFlag = true;
+        for (const FPendingSpeechSegment& Segment : InFlight) {
+            Segment.Wait();
+        }
+    }
+    {
         FScopeLock lock(&Mutex);
-        Audiobuffer = PollyAudioOutcome.StreamBuffer;
+        if (UtteranceCancellationFlag == CancellationFlag) {
+            PendingSegmentCount = 0;
+        }
+        WakeSpeechQueue();
     }
-    else {
-        UE_LOG(LogPollyMsg, Error, TEXT("Polly failed to generate audio file. Error: %s"), *AwsStringToFString(PollyAudioOutcome.PollyErrorMsg));
+    if (RingBuffer.IsValid()) {
+        RingBuffer->Finish(bSucceeded);
     }
-    return PollyAudioOutcome.IsSuccess;
+    if (!bSucceeded) {
+        NoteAbortedWorkFinished(CancellationFlag);
+    }
+    return bSucceeded;
 }
 
-bool USpeechComponent::SynthesizeVisemes(const FString& Text, const EVoiceId VoiceId) {
-    PollyOutcome PollyVisemeOutcome = MyPollyClient->SynthesizeSpeech(CreatePollyVisemeRequest(Text, VoiceId));
-    if (PollyVisemeOutcome.IsSuccess) {
+void USpeechComponent::RunIncrementalPipeline(const EVoiceId VoiceId, PollyCancellationFlag CancellationFlag, TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> TextSignal) {
+    TArray<FPendingSpeechSegment> InFlight;
+    bool bSucceeded = true;
+    bool bSpeechReady = false;
+    while (bSucceeded && !*CancellationFlag) {
+        TArray<FString> Phrases;
+        bool bTextOpen;
+        {
+            FScopeLock lock(&Mutex);
+            // A cancelled pipeline may still be running when the next speech opens, whose phrases are not its own
+            if (UtteranceCancellationFlag != CancellationFlag) {
+                break;
+            }
+            const int32 NumPhrases = FMath::Clamp(FMath::Max(MaxConcurrentSegmentRequests, 1) - InFlight.Num(), 0, PendingPhrases.Num());
+            Phrases.Append(PendingPhrases.GetData(), NumPhrases);
+            PendingPhrases.RemoveAt(0, NumPhrases);
+            bTextOpen = bIncrementalTextOpen;
+        }
+        for (const FString& Phrase : Phrases) {
+            InFlight.Add(StartSegment(Phrase, VoiceId, CancellationFlag, GetRequestScheduling()));
+        }
+        if (InFlight.Num() == 0) {
+            if (!bTextOpen) {
+                break;
+            }
+            TextSignal->Wait();
+            continue;
+        }
+        TArray<FPollyAudioBuffer> Audio;
+        TArray<VisemeEvent> Visemes;
+        bSucceeded = FinishSegment(InFlight[0], Audio, Visemes);
+        InFlight.RemoveAt(0);
+        if (bSucceeded) {
+            AppendSegment(Audio, Visemes, CancellationFlag, nullptr);
+        }
+        if (bSucceeded && !bSpeechReady) {
+            bSpeechReady = true;
+            TWeakObjectPtr<USpeechComponent> WeakThis(this);
+            AsyncTask(ENamedThreads::GameThread, [WeakThis]() {
+                if (USpeechComponent* SpeechComponent = WeakThis.Get()) {
+                    SpeechComponent->OnSpeechReady.Broadcast();
+                }
+            });
+        }
+    }
+    if (!bSucceeded || *CancellationFlag) {
+        *CancellationFlag = true;
+        for (const FPendingSpeechSegment& Segment : InFlight) {
+            Segment.Wait();
+        }
+    }
+    NoteAbortedWorkFinished(CancellationFlag);
+    FScopeLock lock(&Mutex);
+    WakeSpeechQueue();
+    if (UtteranceCancellationFlag == CancellationFlag && *CancellationFlag) {
+        // The rest of the text can no longer be appended, the next AppendText call starts a new speech
+        bIncrementalTextOpen = false;
+        PendingPhrases.Empty();
+        PendingSegmentCount = 0;
+    }
+}
+
+void USpeechComponent::RunSpeechQueue(TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> QueueSignal) {
+    // Lines with requests in flight, including lines dropped from the queue, which must be waited for before exiting
+    TArray<TSharedPtr<FQueuedUtterance, ESPMode::ThreadSafe>> InFlight;
+    while (true) {
+        InFlight.RemoveAll([](const TSharedPtr<FQueuedUtterance, ESPMode::ThreadSafe>& Utterance) {
+            return !Utterance->Segments.ContainsByPredicate([](const FPendingSpeechSegment& Segment) {
+                return !Segment.IsReady();
+            });
+        });
+        TSharedPtr<FQueuedUtterance, ESPMode::ThreadSafe> Head;
+        {
+            FScopeLock lock(&Mutex);
+            if (SpeechQueue.Num() == 0 && InFlight.Num() == 0) {
+                bSpeechQueueRunning = false;
+                SpeechQueueSignal.Reset();
+                return;
+            }
+            // Prefetch the front of the queue, as long as the audio synthesized ahead of time fits into its budget
+            int64 PrefetchedBytes = 0;
+            for (int32 Index = 0; Index < SpeechQueue.Num() && Index < FMath::Max(SpeechQueuePrefetchDepth, 1); Index++) {
+                FQueuedUtterance& Utterance = *SpeechQueue[Index];
+                if (Utterance.bPrefetched) {
+                    PrefetchedBytes += PollyAudioBuffer::NumBytes(Utterance.Audio);
+                    continue;
+                }
+                if (Index > 0 && PrefetchedBytes >= SpeechQueueMaxPrefetchKB * 1024) {
+                    break;
+                }
+                for (const FString& Segment : SpeechTextUtils::SplitText(Utterance.Text, SpeechTextUtils::PollyMaxTextLength, false)) {
+                    FPendingSpeechSegment& PendingSegment = Utterance.Segments.Add_GetRef(StartSegment(Segment, Utterance.VoiceId, Utterance.CancellationFlag, GetRequestScheduling()));
+                    SignalWhenReady(PendingSegment, QueueSignal);
+                }
+                Utterance.bPrefetched = true;
+                InFlight.Add(SpeechQueue[Index]);
+            }
+            if (SpeechQueue.Num() > 0 && !InFlight.Contains(SpeechQueue[0])) {
+                Head = SpeechQueue[0];
+            }
+        }
+        if (!Head.IsValid()) {
+            // Woken up by the requests in flight as they return, or by the next line queued
+            QueueSignal->Wait();
+            continue;
+        }
+        if (!Head->bFinished) {
+            Head->bSucceeded = FinishSegments(Head->Segments, Head->Audio, Head->Visemes);
+            Head->bFinished = true;
+        }
+        TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> AppendFlag;
+        uint32 WaitMilliseconds = MAX_uint32;
+        {
+            FScopeLock lock(&Mutex);
+            if (SpeechQueue.Num() == 0 || SpeechQueue[0] != Head) {
+                continue;
+            }
+            const bool bQueuedSpeechActive = SpeechQueueSpeechFlag.IsValid() && UtteranceCancellationFlag == SpeechQueueSpeechFlag && (bIsSpeaking || !bSpeechStarted);
+            if (!Head->bSucceeded) {
+                SpeechQueue.RemoveAt(0);
+                if (bQueuedSpeechActive) {
+                    PendingSegmentCount--;
+                }
+                continue;
+            }
+            if (bQueuedSpeechActive) {
+                // The line is appended shortly before the playing speech runs out, which keeps later lines cancellable
+                int64 PlaybackMilliseconds = 0;
+                if (bSpeechStarted) {
+                    PlaybackMilliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - StartTimePoint).count();
+                }
+                const int64 MillisecondsToAppend = UtteranceEndMilliseconds - PlaybackMilliseconds - SpeechQueueAppendLeadMs;
+                if (MillisecondsToAppend <= 0) {
+                    SpeechQueue.RemoveAt(0);
+                    AppendFlag = SpeechQueueSpeechFlag;
+                }
+                else if (bSpeechStarted) {
+                    // Playback does not signal its progress, so the worker wakes up when the line is due
+                    WaitMilliseconds = static_cast<uint32>(FMath::Min<int64>(MillisecondsToAppend, MAX_uint32 - 1));
+                }
+            }
+            else if (CanSpeechQueueStartSpeech()) {
+                // Nothing of the queue is playing anymore, the line becomes a new speech
+                SpeechQueue.RemoveAt(0);
+                if (UtteranceCancellationFlag.IsValid()) {
+                    *UtteranceCancellationFlag = true;
+                }
+                PollyCancellationFlag SpeechFlag = MakePollyCancellationFlag();
+                StreamingAudio.Reset();
+                ActivePollyAudio.Reset();
+                bSpeechStarted = false;
+                SpeechAudio = MoveTemp(Head->Audio);
+                SetIntensityEnvelope(0, SpeechAudio);
+                BakedSpeechAsset = nullptr;
+                UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+                // Later lines are appended to the speech, so clients only receive the visemes
+                SpeechText.Empty();
+                VisemeTrack = FVisemeTrack::Make(Head->Visemes);
+                UtteranceCancellationFlag = SpeechFlag;
+                SpeechQueueSpeechFlag = SpeechFlag;
+                UtteranceEndMilliseconds = PollyAudioBuffer::NumBytes(SpeechAudio) / PollyBytesPerMillisecond;
+                PendingSegmentCount = SpeechQueue.Num();
+                TWeakObjectPtr<USpeechComponent> WeakThis(this);
+                AsyncTask(ENamedThreads::GameThread, [WeakThis]() {
+                    if (USpeechComponent* SpeechComponent = WeakThis.Get()) {
+                        SpeechComponent->OnSpeechReady.Broadcast();
+                    }
+                });
+                continue;
+            }
+        }
+        if (AppendFlag.IsValid()) {
+            AppendSegment(Head->Audio, Head->Visemes, AppendFlag.ToSharedRef(), nullptr);
+        }
+        else {
+            // Woken up when playback starts or ends, when the speech in the way is done, or when the line is due
+            QueueSignal->Wait(WaitMilliseconds);
+        }
+    }
+}
+
+bool USpeechComponent::FinishSegments(const TArray<FPendingSpeechSegment>& Segments, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents) const {
+    for (const FPendingSpeechSegment& Segment : Segments) {
+        TArray<FPollyAudioBuffer> SegmentAudio;
+        TArray<VisemeEvent> SegmentVisemes;
+        if (!FinishSegment(Segment, SegmentAudio, SegmentVisemes)) {
+            return false;
+        }
+        const int32 OffsetMilliseconds = PollyAudioBuffer::NumBytes(OutAudio) / PollyBytesPerMillisecond;
+        for (VisemeEvent Event : SegmentVisemes) {
+            Event.TimeMilliseconds += OffsetMilliseconds;
+            OutVisemeEvents.Add(Event);
+        }
+        OutAudio.Append(SegmentAudio);
+    }
+    return true;
+}
+
+void USpeechComponent::AppendSegment(const TArray<FPollyAudioBuffer>& Audio, const TArray<VisemeEvent>& Visemes, const PollyCancellationFlag& CancellationFlag, TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer) {
+    LLM_SCOPE_POLLY_SPEECH();
+    {
         FScopeLock lock(&Mutex);
-        FString VisemeJson;
-        FFileHelper::BufferToString(VisemeJson, PollyVisemeOutcome.StreamBuffer.GetData(), PollyVisemeOutcome.StreamBuffer.Num());
-        GenerateVisemeEvents(VisemeJson);
+        if (UtteranceCancellationFlag != CancellationFlag) {
+            return;
+        }
+        // The visemes of a segment are timed from its own start, which is where the audio so far ends. Once the
+        // sound plays, a segment arriving after the sound ran dry starts after the silence played meanwhile.
+        int64 SegmentStartMilliseconds = UtteranceEndMilliseconds;
+        if (RingBuffer.IsValid()) {
+            SegmentStartMilliseconds = FMath::Max(SegmentStartMilliseconds, RingBuffer->GetTotalBytesWritten() / PollyBytesPerMillisecond);
+        }
+        if (ActivePollyAudio.IsValid()) {
+            const auto PlaybackDuration = std::chrono::steady_clock::now() - StartTimePoint;
+            SegmentStartMilliseconds = FMath::Max<int64>(SegmentStartMilliseconds, std::chrono::duration_cast<std::chrono::milliseconds>(PlaybackDuration).count());
+        }
+        VisemeTrack = VisemeTrack->Append(Visemes, static_cast<int32>(SegmentStartMilliseconds));
+        UtteranceEndMilliseconds = SegmentStartMilliseconds + PollyAudioBuffer::NumBytes(Audio) / PollyBytesPerMillisecond;
+        SetIntensityEnvelope(SegmentStartMilliseconds, Audio);
+        PendingSegmentCount--;
+        if (!RingBuffer.IsValid()) {
+            SpeechAudio.Append(Audio);
+        }
+        if (USoundWaveProcedural* PollyAudio = ActivePollyAudio.Get()) {
+            if (UPollyBufferedSoundWave* BufferedPollyAudio = Cast<UPollyBufferedSoundWave>(PollyAudio)) {
+                BufferedPollyAudio->AppendAudio(Audio);
+            }
+            PollyAudio->Duration = UtteranceEndMilliseconds / 1000.0f;
+        }
     }
-    else {
-        UE_LOG(LogPollyMsg, Error, TEXT("Polly failed to generate visemes. Error: %s"), *AwsStringToFString(PollyVisemeOutcome.PollyErrorMsg));
+    // The ring buffer overflows rather than waiting for playback to catch up, the pipeline moves on right away
+    if (RingBuffer.IsValid()) {
+        for (const FPollyAudioBuffer& Buffer : Audio) {
+            RingBuffer->WriteAll(Buffer->GetData(), Buffer->Num());
+        }
+    }
+}
+
+void USpeechComponent::AbortUtterance() {
+    if (UtteranceCancellationFlag.IsValid()) {
+        *UtteranceCancellationFlag = true;
+    }
+    UtteranceCancellationFlag.Reset();
+    StreamingAudio.Reset();
+    PendingSegmentCount = 0;
+    bIncrementalTextOpen = false;
+    PendingPhrases.Empty();
+    if (IncrementalTextSignal.IsValid()) {
+        // The pipeline of the aborted speech may be waiting for text that will never come
+        IncrementalTextSignal->Trigger();
+        IncrementalTextSignal.Reset();
+    }
+    for (const TSharedPtr<FQueuedUtterance, ESPMode::ThreadSafe>& Utterance : SpeechQueue) {
+        *Utterance->CancellationFlag = true;
+    }
+    SpeechQueue.Empty();
+    SpeechQueueSpeechFlag.Reset();
+    WakeSpeechQueue();
+}
+
+void USpeechComponent::WakeSpeechQueue() {
+    if (SpeechQueueSignal.IsValid()) {
+        SpeechQueueSignal->Trigger();
     }
-    return PollyVisemeOutcome.IsSuccess;
 }
 
-USoundWaveProcedural* USpeechComponent::QueuePollyAudio() {
-    USoundWaveProcedural* PollyAudio = NewObject<USoundWaveProcedural>();
-    PollyAudio->SetSampleRate(16000);
+void USpeechComponent::NoteAbortedWorkFinished(const PollyCancellationFlag& CancellationFlag) {
+    FScopeLock lock(&Mutex);
+    if (LastCancelledFlag == CancellationFlag) {
+        CancelMetrics.LastCancelToIdleMs = FMath::Max(CancelMetrics.LastCancelToIdleMs, (FPlatformTime::Seconds() - LastCancelSeconds) * 1000.0);
+        UE_LOG(LogPollyMsg, Verbose, TEXT("Aborted Polly requests returned %.3f ms after the speech was cancelled."), CancelMetrics.LastCancelToIdleMs);
+    }
+}
+
+void USpeechComponent::CancelUtteranceRequests() {
+    FScopeLock lock(&Mutex);
+    AbortUtterance();
+    // The aborted tasks only touch the speech while their cancellation flag is installed, so the next speech does not
+    // wait for them to return. They are kept until they do, see IsReadyForFinishDestroy.
+    CancelledWork.RemoveAll([](const TFuture<void>& Work) {
+        return Work.IsReady();
+    });
+    if (SegmentPipeline.IsValid()) {
+        CancelledWork.Add(MoveTemp(SegmentPipeline));
+    }
+    if (SpeechQueueWorker.IsValid()) {
+        CancelledWork.Add(MoveTemp(SpeechQueueWorker));
+    }
+}
+
+bool USpeechComponent::CanSpeechQueueStartSpeech() const {
+    if (bIsSpeaking) {
+        return false;
+    }
+    // A speech generated by GenerateSpeech or AppendText keeps its place until it played, failed or was cancelled
+    return !UtteranceCancellationFlag.IsValid() || *UtteranceCancellationFlag || UtteranceCancellationFlag == SpeechQueueSpeechFlag || UtteranceCancellationFlag == StartedUtteranceFlag;
+}
+
+bool USpeechComponent::CheckPollyOutcome(const PollyOutcome& Outcome, const TCHAR* Description) const {
+    if (Outcome.IsCancelled) {
+        UE_LOG(LogPollyMsg, Verbose, TEXT("Polly request for %s was cancelled."), Description);
+    }
+    else if (!Outcome.IsSuccess) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Polly failed to generate %s. Error: %s"), Description, *AwsStringToFString(Outcome.PollyErrorMsg));
+    }
+    return Outcome.IsSuccess;
+}
+
+USoundWaveProcedural* USpeechComponent::QueuePollyAudio(int64 StartMilliseconds) {
+    POLLY_TRACE_SCOPE(USpeechComponent::QueuePollyAudio);
+    LLM_SCOPE_POLLY_SPEECH();
+    if (StreamingAudio.IsValid()) {
+        UPollyStreamingSoundWave* PollyAudio = NewObject<UPollyStreamingSoundWave>();
+        PollyAudio->SetSampleRate(PollySampleRate);
+        PollyAudio->NumChannels = 1;
+        PollyAudio->DecompressionType = DTYPE_Procedural;
+        // The total length is unknown until the stream ends, the final viseme marks the end of the speech
+        PollyAudio->Duration = VisemeTrack->GetEndMilliseconds() / 1000.0f;
+        PollyAudio->SetRingBuffer(StreamingAudio.ToSharedRef(), StreamingJitterBufferMs * PollyBytesPerMillisecond);
+        // The ring buffer can only be consumed once, the stream itself keeps running until it completes
+        StreamingAudio.Reset();
+        return PollyAudio;
+    }
+    if (BakedSpeechAsset != nullptr) {
+        UPollyBakedSoundWave* PollyAudio = NewObject<UPollyBakedSoundWave>();
+        PollyAudio->SetSampleRate(PollySampleRate);
+        PollyAudio->NumChannels = 1;
+        PollyAudio->DecompressionType = DTYPE_Procedural;
+        PollyAudio->Duration = BakedSpeechAsset->GetDurationSeconds();
+        PollyAudio->SetSpeechAsset(BakedSpeechAsset, BakedSpeechReadAheadChunks);
+        if (StartMilliseconds > 0) {
+            PollyAudio->Seek(StartMilliseconds / 1000.0f);
+        }
+        return PollyAudio;
+    }
+    // The sound plays the buffers of the speech where they are rather than a copy in its audio queue
+    UPollyBufferedSoundWave* PollyAudio = NewObject<UPollyBufferedSoundWave>();
+    PollyAudio->SetSampleRate(PollySampleRate);
     PollyAudio->NumChannels = 1;
     PollyAudio->DecompressionType = DTYPE_Procedural;
     int32 BitRate = 16 * PollyAudio->NumChannels * PollyAudio->GetSampleRateForCurrentPlatform();
-    PollyAudio->Duration = Audiobuffer.Num() * 8.0f / BitRate;
-    PollyAudio->QueueAudio(Audiobuffer.GetData(), Audiobuffer.Num());
+    const int64 NumBytes = PollyAudioBuffer::NumBytes(SpeechAudio);
+    const int64 StartByte = FMath::Min<int64>(StartMilliseconds * PollyBytesPerMillisecond, NumBytes);
+    PollyAudio->Duration = (NumBytes - StartByte) * 8.0f / BitRate;
+    PollyAudio->SetAudio(SpeechAudio, StartByte);
     return PollyAudio;
 }
 
@@ -176,32 +1737,29 @@ Aws::Polly::Model::SynthesizeSpeechRequest USpeechComponent::CreatePollyVisemeRe
     return PollyRequest;
 }
 
-void USpeechComponent::GenerateVisemeEvents(FString VisemeJson) {
-    VisemeEventArray = {};
-    TArray<FString> VisemeStrings;
-    VisemeJson.ParseIntoArray(VisemeStrings, TEXT("\n"), true);
-    for (FString VisemeSet : VisemeStrings) {
-        TSharedPtr<FJsonObject> JsonParsed = MakeShareable(new FJsonObject);
-        TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(VisemeSet);
-        FString OutString;
-        double OutNumber;
-        if (FJsonSerializer::Deserialize(JsonReader, JsonParsed) && JsonParsed->TryGetStringField("value", OutString) && JsonParsed->TryGetNumberField("time", OutNumber)) {
-            VisemeEvent CurrentVisemeEvent;
-            CurrentVisemeEvent.Viseme = GetVisemeValueFromString(JsonParsed->GetStringField("value"));
-            CurrentVisemeEvent.TimeMilliseconds = JsonParsed->GetIntegerField("time");
-            VisemeEventArray.Add(CurrentVisemeEvent);
-        }
-        else {
-            UE_LOG(LogPollyMsg, Error, TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly."));
-            VisemeEventArray = {};
-            Audiobuffer.Empty();
-            break;
-        }
+void USpeechComponent::GenerateVisemeEvents(TArrayView<const uint8> VisemeJson) {
+    POLLY_TRACE_SCOPE(USpeechComponent::GenerateVisemeEvents);
+    TArray<VisemeEvent> Visemes;
+    const bool bParsed = ParseVisemeEvents(VisemeJson, Visemes);
+    VisemeTrack = bParsed ? FVisemeTrack::Make(Visemes) : FVisemeTrack::GetEmpty();
+    if (!bParsed) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly."));
+        SpeechAudio.Empty();
+        IntensityEnvelope.Empty();
+        AbortUtterance();
     }
 }
 
+bool USpeechComponent::ParseVisemeEvents(TArrayView<const uint8> VisemeJson, TArray<VisemeEvent>& OutVisemeEvents) {
+    POLLY_TRACE_SCOPE(USpeechComponent::ParseVisemeEvents);
+    const double StartSeconds = FPlatformTime::Seconds();
+    const bool bParsed = FSpeechMarkParser::Parse(VisemeJson, OutVisemeEvents);
+    FSpeechMetrics::Get().RecordParseTime(FPlatformTime::Seconds() - StartSeconds);
+    return bParsed;
+}
+
 void USpeechComponent::InitializePollyClient() {
-    MyPollyClient = MakeUnique<PollyClient>();
+    MyPollyClient = MakeUnique<PollyClient>(PollyEndpointOverride);
 }
 
 void USpeechComponent::SetTimer(float CurrentVisemeDurationSeconds) {
@@ -0,0 +1,333 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechDiskCache.h"
+#include "Async/Async.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Crc.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Guid.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/SecureHash.h"
+#include "SpeechMemoryTracker.h"
+
+namespace {
+    const TCHAR* const EntryExtension = TEXT(".pspeech");
+    const TCHAR* const TempExtension = TEXT(".tmp");
+    const uint32 EntryMagic = 0x43505350; // "PSPC"
+    /**
+    * Entries of other versions are discarded when they are read
+    */
+    const uint32 EntryVersion = 1;
+
+    /**
+    * Header of an entry, followed by NumVisemes FEntryViseme records and NumAudioBytes of pcm audio. The header and
+    * the records are 8 byte multiples, so the audio samples are aligned in the mapped file.
+    */
+    struct FEntryHeader {
+        uint32 Magic;
+        uint32 Version;
+        uint32 NumVisemes;
+        uint32 NumAudioBytes;
+        /**
+        * CRC32 of the visemes and the audio. An entry that was only partially flushed to disk before a crash fails it.
+        */
+        uint32 PayloadCrc;
+        uint32 Reserved;
+    };
+
+    struct FEntryViseme {
+        int32 TimeMilliseconds;
+        uint32 Viseme;
+    };
+
+    /**
+    * Memory mapped entry, owned by the audio buffers viewing it. The region is declared after the file so that it
+    * is unmapped first.
+    */
+    struct FMappedEntry {
+        TUniquePtr<IMappedFileHandle> File;
+        TUniquePtr<IMappedFileRegion> Region;
+    };
+
+    /**
+    * Checks an entry and reads its visemes
+    * @param Data - the contents of the entry file
+    * @param Size - the size of the entry file
+    * @param OutVisemes - the visemes of the entry
+    * @param OutAudio - the audio of the entry, pointing into Data
+    * @return bool - true if the entry is valid
+    */
+    bool ParseEntry(const uint8* Data, int64 Size, TArray<VisemeEvent>& OutVisemes, TArrayView<const uint8>& OutAudio) {
+        if (Data == nullptr || Size < static_cast<int64>(sizeof(FEntryHeader))) {
+            return false;
+        }
+        FEntryHeader Header;
+        FMemory::Memcpy(&Header, Data, sizeof(FEntryHeader));
+        const int64 PayloadSize = static_cast<int64>(Header.NumVisemes) * sizeof(FEntryViseme) + Header.NumAudioBytes;
+        if (Header.Magic != EntryMagic || Header.Version != EntryVersion || sizeof(FEntryHeader) + PayloadSize != Size) {
+            return false;
+        }
+        const uint8* Payload = Data + sizeof(FEntryHeader);
+        if (FCrc::MemCrc32(Payload, PayloadSize) != Header.PayloadCrc) {
+            return false;
+        }
+        const FEntryViseme* Visemes = reinterpret_cast<const FEntryViseme*>(Payload);
+        OutVisemes.Reserve(Header.NumVisemes);
+        for (uint32 VisemeIndex = 0; VisemeIndex < Header.NumVisemes; VisemeIndex++) {
+            VisemeEvent Event;
+            Event.Viseme = static_cast<EViseme>(Visemes[VisemeIndex].Viseme);
+            Event.TimeMilliseconds = Visemes[VisemeIndex].TimeMilliseconds;
+            OutVisemes.Add(Event);
+        }
+        OutAudio = TArrayView<const uint8>(Payload + Header.NumVisemes * sizeof(FEntryViseme), Header.NumAudioBytes);
+        return true;
+    }
+}
+
+FSpeechDiskCache& FSpeechDiskCache::Get() {
+    static FSpeechDiskCache SharedCache;
+    return SharedCache;
+}
+
+FSpeechDiskCache::FSpeechDiskCache() :
+    Directory(FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("PollySpeechCache"))),
+    BudgetBytes(DefaultBudgetBytes),
+    SizeBytes(0),
+    NumDiskHits(0)
+{
+    ScanDirectory();
+}
+
+FString FSpeechDiskCache::HashKey(const FString& Key) {
+    FTCHARToUTF8 Utf8Key(*Key);
+    uint8 Hash[FSHA1::DigestSize];
+    FSHA1::HashBuffer(Utf8Key.Get(), Utf8Key.Length(), Hash);
+    return BytesToHex(Hash, FSHA1::DigestSize);
+}
+
+FString FSpeechDiskCache::GetEntryPath(const FString& Hash) const {
+    return FPaths::Combine(Directory, Hash + EntryExtension);
+}
+
+TSharedPtr<FCachedSpeechSegment, ESPMode::ThreadSafe> FSpeechDiskCache::Load(const FString& Key) {
+    LLM_SCOPE_POLLY_SPEECH();
+    const FString Hash = HashKey(Key);
+    {
+        FScopeLock lock(&Mutex);
+        if (BudgetBytes == 0 || !Entries.Contains(Hash)) {
+            return nullptr;
+        }
+    }
+    const FString Path = GetEntryPath(Hash);
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    TSharedRef<FCachedSpeechSegment, ESPMode::ThreadSafe> Segment = MakeShared<FCachedSpeechSegment, ESPMode::ThreadSafe>();
+    TSharedRef<FMappedEntry, ESPMode::ThreadSafe> MappedEntry = MakeShared<FMappedEntry, ESPMode::ThreadSafe>();
+    MappedEntry->File.Reset(PlatformFile.OpenMapped(*Path));
+    if (MappedEntry->File.IsValid()) {
+        MappedEntry->Region.Reset(MappedEntry->File->MapRegion(0, MappedEntry->File->GetFileSize()));
+    }
+    // Platforms without memory mapped files read the entry instead
+    TArray<uint8> FileData;
+    const bool bMapped = MappedEntry->Region.IsValid();
+    if (!bMapped && !FFileHelper::LoadFileToArray(FileData, *Path, FILEREAD_Silent)) {
+        Discard(Hash);
+        return nullptr;
+    }
+    const uint8* Data = bMapped ? MappedEntry->Region->GetMappedPtr() : FileData.GetData();
+    const int64 Size = bMapped ? MappedEntry->Region->GetMappedSize() : FileData.Num();
+    TArrayView<const uint8> Audio;
+    if (!ParseEntry(Data, Size, Segment->Visemes, Audio)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Discarding corrupt speech cache entry %s."), *Path);
+        MappedEntry->Region.Reset();
+        MappedEntry->File.Reset();
+        Discard(Hash);
+        return nullptr;
+    }
+    // The mapped audio is shared with the sounds playing it without a copy, and stays mapped while they do
+    if (bMapped) {
+        Segment->Audio = PollyAudioBuffer::MakeView(Audio, MappedEntry);
+    }
+    else {
+        Segment->Audio = PollyAudioBuffer::Make(TArray<uint8>(Audio.GetData(), Audio.Num()));
+    }
+    // The modification time orders the entries for eviction across runs
+    const FDateTime Now = FDateTime::UtcNow();
+    PlatformFile.SetTimeStamp(*Path, Now);
+    FScopeLock lock(&Mutex);
+    if (FEntry* Entry = Entries.Find(Hash)) {
+        Entry->LastUsed = Now;
+    }
+    NumDiskHits++;
+    return Segment;
+}
+
+bool FSpeechDiskCache::Contains(const FString& Key) const {
+    const FString Hash = HashKey(Key);
+    FScopeLock lock(&Mutex);
+    return BudgetBytes > 0 && Entries.Contains(Hash);
+}
+
+void FSpeechDiskCache::StoreAsync(const FString& Key, const TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe>& Segment) {
+    {
+        FScopeLock lock(&Mutex);
+        if (BudgetBytes == 0) {
+            return;
+        }
+    }
+    PendingWrites.Increment();
+    Async(EAsyncExecution::ThreadPool, [this, Key, Segment]() {
+        Store(Key, *Segment);
+        PendingWrites.Decrement();
+    });
+}
+
+void FSpeechDiskCache::Flush() {
+    while (PendingWrites.GetValue() > 0) {
+        FPlatformProcess::Sleep(0.001f);
+    }
+}
+
+void FSpeechDiskCache::Store(const FString& Key, const FCachedSpeechSegment& Segment) {
+    const FString Hash = HashKey(Key);
+    {
+        FScopeLock lock(&Mutex);
+        if (BudgetBytes == 0 || Entries.Contains(Hash)) {
+            return;
+        }
+    }
+    const TArrayView<const uint8> Audio = Segment.GetAudio();
+    const int64 VisemesSize = Segment.Visemes.Num() * sizeof(FEntryViseme);
+    TArray<uint8> FileData;
+    FileData.SetNumUninitialized(sizeof(FEntryHeader) + VisemesSize + Audio.Num());
+    uint8* Payload = FileData.GetData() + sizeof(FEntryHeader);
+    FEntryViseme* Visemes = reinterpret_cast<FEntryViseme*>(Payload);
+    for (int32 VisemeIndex = 0; VisemeIndex < Segment.Visemes.Num(); VisemeIndex++) {
+        Visemes[VisemeIndex].TimeMilliseconds = Segment.Visemes[VisemeIndex].TimeMilliseconds;
+        Visemes[VisemeIndex].Viseme = static_cast<uint32>(Segment.Visemes[VisemeIndex].Viseme);
+    }
+    FMemory::Memcpy(Payload + VisemesSize, Audio.GetData(), Audio.Num());
+    FEntryHeader Header;
+    Header.Magic = EntryMagic;
+    Header.Version = EntryVersion;
+    Header.NumVisemes = Segment.Visemes.Num();
+    Header.NumAudioBytes = Audio.Num();
+    Header.PayloadCrc = FCrc::MemCrc32(Payload, VisemesSize + Audio.Num());
+    Header.Reserved = 0;
+    FMemory::Memcpy(FileData.GetData(), &Header, sizeof(FEntryHeader));
+    // The entry only gets its name once it is complete, so a crash while writing leaves a temporary file that the
+    // next ScanDirectory deletes rather than a truncated entry
+    const FString Path = GetEntryPath(Hash);
+    const FString TempPath = FPaths::Combine(Directory, Hash + TEXT(".") + FGuid::NewGuid().ToString() + TempExtension);
+    IFileManager& FileManager = IFileManager::Get();
+    if (!FFileHelper::SaveArrayToFile(FileData, *TempPath) || !FileManager.Move(*Path, *TempPath, true, true, false, true)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Failed to write speech cache entry %s."), *Path);
+        FileManager.Delete(*TempPath, false, false, true);
+        return;
+    }
+    FScopeLock lock(&Mutex);
+    if (!Entries.Contains(Hash)) {
+        Entries.Add(Hash, { FileData.Num(), FDateTime::UtcNow() });
+        SizeBytes += FileData.Num();
+    }
+    EvictToBudget();
+}
+
+void FSpeechDiskCache::Discard(const FString& Hash) {
+    IFileManager::Get().Delete(*GetEntryPath(Hash), false, false, true);
+    FScopeLock lock(&Mutex);
+    FEntry Entry;
+    if (Entries.RemoveAndCopyValue(Hash, Entry)) {
+        SizeBytes -= Entry.SizeBytes;
+    }
+}
+
+void FSpeechDiskCache::SetBudgetBytes(int64 InBudgetBytes) {
+    FScopeLock lock(&Mutex);
+    BudgetBytes = FMath::Max<int64>(InBudgetBytes, 0);
+    EvictToBudget();
+}
+
+void FSpeechDiskCache::Empty() {
+    Flush();
+    FScopeLock lock(&Mutex);
+    for (const TPair<FString, FEntry>& Entry : Entries) {
+        IFileManager::Get().Delete(*GetEntryPath(Entry.Key), false, false, true);
+    }
+    Entries.Empty();
+    SizeBytes = 0;
+}
+
+void FSpeechDiskCache::GetStats(FSpeechCacheStats& OutStats) const {
+    FScopeLock lock(&Mutex);
+    OutStats.NumDiskHits = NumDiskHits;
+    OutStats.NumDiskEntries = Entries.Num();
+    OutStats.DiskSizeKB = static_cast<int32>(SizeBytes / 1024);
+}
+
+void FSpeechDiskCache::ScanDirectory() {
+    IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+    if (!PlatformFile.CreateDirectoryTree(*Directory)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Failed to create the speech cache directory %s."), *Directory);
+        return;
+    }
+    TArray<FString> TempFiles;
+    PlatformFile.IterateDirectoryStat(*Directory, [this, &TempFiles](const TCHAR* Filename, const FFileStatData& StatData) {
+        const FString Path(Filename);
+        if (StatData.bIsDirectory) {
+            return true;
+        }
+        if (Path.EndsWith(TempExtension)) {
+            TempFiles.Add(Path);
+        } else if (Path.EndsWith(EntryExtension)) {
+            Entries.Add(FPaths::GetBaseFilename(Path), { StatData.FileSize, StatData.ModificationTime });
+            SizeBytes += StatData.FileSize;
+        }
+        return true;
+    });
+    for (const FString& TempFile : TempFiles) {
+        PlatformFile.DeleteFile(*TempFile);
+    }
+    FScopeLock lock(&Mutex);
+    EvictToBudget();
+}
+
+void FSpeechDiskCache::EvictToBudget() {
+    if (BudgetBytes == 0 || SizeBytes <= BudgetBytes) {
+        return;
+    }
+    TArray<FString> Hashes;
+    Entries.GetKeys(Hashes);
+    Hashes.Sort([this](const FString& A, const FString& B) {
+        return Entries.FindChecked(A).LastUsed < Entries.FindChecked(B).LastUsed;
+    });
+    for (const FString& Hash : Hashes) {
+        if (SizeBytes <= BudgetBytes) {
+            break;
+        }
+        // An entry that is still mapped cannot be deleted on some platforms. It is forgotten anyway, and indexed
+        // again by the next run.
+        IFileManager::Get().Delete(*GetEntryPath(Hash), false, false, true);
+        SizeBytes -= Entries.FindChecked(Hash).SizeBytes;
+        Entries.Remove(Hash);
+    }
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "SpeechCache.h"
+
+/**
+* Persistent cache of synthesized speech under Saved/PollySpeechCache, so that lines heard before a restart are not
+* sent to Polly again. Each entry is a file named after the SHA-1 of its FSpeechCache key, holding a header with a
+* checksum, the visemes and the pcm audio. Entries are read through a memory mapping, written to a temporary file
+* that is renamed into place, and the least recently used entries are deleted beyond the byte budget. All functions
+* are thread-safe.
+*/
+class FSpeechDiskCache {
+public:
+    /**
+    * Returns the disk cache shared by all speech components, indexing its directory on the first call
+    */
+    static FSpeechDiskCache& Get();
+    /**
+    * Maps the entry of a key into memory. A corrupt entry is deleted and reported as missing.
+    * @param Key - the FSpeechCache key of the text
+    * @return TSharedPtr<FCachedSpeechSegment> - the entry, whose audio points into the mapped file, or null
+    */
+    TSharedPtr<FCachedSpeechSegment, ESPMode::ThreadSafe> Load(const FString& Key);
+    /**
+    * Returns true if there is an entry for the key, without reading it
+    */
+    bool Contains(const FString& Key) const;
+    /**
+    * Writes an entry on the thread pool, unless there is one for the key already
+    * @param Key - the FSpeechCache key of the text
+    * @param Segment - the audio and visemes of the text
+    */
+    void StoreAsync(const FString& Key, const TSharedRef<const FCachedSpeechSegment, ESPMode::ThreadSafe>& Segment);
+    /**
+    * Waits for the entries being written by StoreAsync
+    */
+    void Flush();
+    /**
+    * Changes the byte budget, deleting the least recently used entries beyond it. A budget of 0 disables the disk
+    * cache without deleting its entries.
+    */
+    void SetBudgetBytes(int64 InBudgetBytes);
+    /**
+    * Deletes all entries
+    */
+    void Empty();
+    /**
+    * Fills in the disk counters of the cache statistics
+    */
+    void GetStats(FSpeechCacheStats& OutStats) const;
+    /**
+    * Returns the hex SHA-1 of a key, which names its entry
+    */
+    static FString HashKey(const FString& Key);
+    /**
+    * Returns the directory of the entries
+    */
+    const FString& GetDirectory() const { return Directory; }
+
+    /**
+    * Byte budget of the disk cache until SetBudgetBytes is called
+    */
+    static const int64 DefaultBudgetBytes = 256 * 1024 * 1024;
+
+private:
+    FSpeechDiskCache();
+
+    struct FEntry {
+        int64 SizeBytes;
+        FDateTime LastUsed;
+    };
+
+    FString GetEntryPath(const FString& Hash) const;
+    /**
+    * Writes an entry and renames it into place
+    */
+    void Store(const FString& Key, const FCachedSpeechSegment& Segment);
+    /**
+    * Deletes a corrupt entry
+    */
+    void Discard(const FString& Hash);
+    /**
+    * Indexes the entries left by previous runs and deletes the temporary files of interrupted writes
+    */
+    void ScanDirectory();
+    /**
+    * Deletes the least recently used entries until the cache fits its budget. Called with the Mutex held.
+    */
+    void EvictToBudget();
+
+    /**
+    * Entries by the hash of their key
+    */
+    TMap<FString, FEntry> Entries;
+    FString Directory;
+    int64 BudgetBytes;
+    int64 SizeBytes;
+    int32 NumDiskHits;
+    FThreadSafeCounter PendingWrites;
+    mutable FCriticalSection Mutex;
+};
@@ -0,0 +1,87 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechEnvelope.h"
+
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+#include <arm_neon.h>
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#endif
+
+namespace {
+    const int32 SamplesPerFrame = 16 * SpeechEnvelope::FrameMilliseconds;
+
+    /**
+    * Returns the sum of the squares of samples. Squares of 16 bit samples are summed in pairs, which fit 32 bits,
+    * and the pairs in 64 bits.
+    */
+    uint64 SumOfSquares(const int16* Samples, int32 NumSamples) {
+        uint64 Sum = 0;
+        int32 SampleIndex = 0;
+#if PLATFORM_ENABLE_VECTORINTRINSICS_NEON
+        uint64x2_t Sums = vdupq_n_u64(0);
+        for (; SampleIndex + 8 <= NumSamples; SampleIndex += 8) {
+            const int16x8_t Vector = vld1q_s16(Samples + SampleIndex);
+            const int32x4_t LowSquares = vmull_s16(vget_low_s16(Vector), vget_low_s16(Vector));
+            const uint32x4_t Pairs = vreinterpretq_u32_s32(vmlal_s16(LowSquares, vget_high_s16(Vector), vget_high_s16(Vector)));
+            Sums = vpadalq_u32(Sums, Pairs);
+        }
+        Sum = vgetq_lane_u64(Sums, 0) + vgetq_lane_u64(Sums, 1);
+#elif PLATFORM_ENABLE_VECTORINTRINSICS
+        __m128i Sums = _mm_setzero_si128();
+        const __m128i Zero = _mm_setzero_si128();
+        for (; SampleIndex + 8 <= NumSamples; SampleIndex += 8) {
+            const __m128i Vector = _mm_loadu_si128(reinterpret_cast<const __m128i*>(Samples + SampleIndex));
+            // Each 32 bit lane holds the sum of 2 squares, at most 2^31, which is read as unsigned
+            const __m128i Pairs = _mm_madd_epi16(Vector, Vector);
+            Sums = _mm_add_epi64(Sums, _mm_unpacklo_epi32(Pairs, Zero));
+            Sums = _mm_add_epi64(Sums, _mm_unpackhi_epi32(Pairs, Zero));
+        }
+        alignas(16) uint64 Lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(Lanes), Sums);
+        Sum = Lanes[0] + Lanes[1];
+#endif
+        for (; SampleIndex < NumSamples; SampleIndex++) {
+            Sum += static_cast<uint64>(static_cast<int32>(Samples[SampleIndex]) * Samples[SampleIndex]);
+        }
+        return Sum;
+    }
+
+    uint8 ToEnvelopeValue(uint64 SumOfSquares, int32 NumSamples) {
+        if (SumOfSquares == 0) {
+            return 0;
+        }
+        const float Rms = FMath::Sqrt(static_cast<float>(static_cast<double>(SumOfSquares) / NumSamples)) / 32768.0f;
+        const float Decibels = 20.0f * FMath::LogX(10.0f, Rms);
+        const float Level = FMath::Clamp((Decibels - SpeechEnvelope::FloorDecibels) / -SpeechEnvelope::FloorDecibels, 0.0f, 1.0f);
+        return static_cast<uint8>(FMath::RoundToInt(Level * 255.0f));
+    }
+}
+
+namespace SpeechEnvelope {
+    void Compute(TArrayView<const uint8> Audio, TArray<uint8>& OutEnvelope) {
+        const int16* Samples = reinterpret_cast<const int16*>(Audio.GetData());
+        const int32 NumSamples = Audio.Num() / sizeof(int16);
+        OutEnvelope.Reserve(OutEnvelope.Num() + FMath::DivideAndRoundUp(NumSamples, SamplesPerFrame));
+        for (int32 FrameStart = 0; FrameStart < NumSamples; FrameStart += SamplesPerFrame) {
+            const int32 FrameSamples = FMath::Min(SamplesPerFrame, NumSamples - FrameStart);
+            OutEnvelope.Add(ToEnvelopeValue(SumOfSquares(Samples + FrameStart, FrameSamples), FrameSamples));
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+* Amplitude envelope of synthesized speech, computed once when the audio is synthesized so that the loudness of the
+* speech can drive e.g. how wide the jaw opens without analyzing the audio while it plays. Every FrameMilliseconds
+* of audio is summarized by its RMS level, on a decibel scale from FloorDecibels (0) to full scale (255).
+*/
+namespace SpeechEnvelope {
+    /**
+    * Milliseconds of audio summarized by each value of an envelope, 100 values per second
+    */
+    const int32 FrameMilliseconds = 10;
+    /**
+    * Level mapped to 0, quieter frames are silent
+    */
+    const float FloorDecibels = -60.0f;
+    /**
+    * Appends the envelope of 16 kHz 16 bit mono pcm audio. A partial frame at the end is summarized too.
+    * @param Audio - the pcm audio
+    * @param OutEnvelope - receives a value per frame
+    */
+    void Compute(TArrayView<const uint8> Audio, TArray<uint8>& OutEnvelope);
+    /**
+    * Converts a value of an envelope to an intensity
+    * @param Value - the value
+    * @return float - the intensity, between 0 and 1
+    */
+    inline float ToIntensity(uint8 Value) {
+        return Value / 255.0f;
+    }
+}
@@ -0,0 +1,234 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechMarkParser.h"
+
+namespace {
+    /**
+    * Typical size of a line of speech marks, used to reserve the visemes of a chunk at once
+    */
+    const int32 TypicalLineBytes = 40;
+
+    /**
+    * Position in a line being parsed
+    */
+    struct FLineCursor {
+        const uint8* Pos;
+        const uint8* End;
+
+        void SkipWhitespace() {
+            while (Pos < End && (*Pos == ' ' || *Pos == '\t' || *Pos == '\r')) {
+                Pos++;
+            }
+        }
+
+        bool Consume(uint8 Character) {
+            SkipWhitespace();
+            if (Pos < End && *Pos == Character) {
+                Pos++;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+        * Reads a string, leaving its escape sequences as they are
+        */
+        bool ReadString(const uint8*& OutBegin, int32& OutLength) {
+            if (!Consume('"')) {
+                return false;
+            }
+            OutBegin = Pos;
+            while (Pos < End && *Pos != '"') {
+                if (*Pos == '\\' && ++Pos == End) {
+                    return false;
+                }
+                Pos++;
+            }
+            if (Pos == End) {
+                return false;
+            }
+            OutLength = static_cast<int32>(Pos - OutBegin);
+            Pos++;
+            return true;
+        }
+
+        /**
+        * Reads a number, dropping its fraction
+        */
+        bool ReadInteger(int64& OutValue) {
+            SkipWhitespace();
+            const bool bNegative = Pos < End && *Pos == '-';
+            Pos += bNegative ? 1 : 0;
+            const uint8* DigitsBegin = Pos;
+            int64 Value = 0;
+            while (Pos < End && *Pos >= '0' && *Pos <= '9' && Value < MAX_int32) {
+                Value = Value * 10 + (*Pos++ - '0');
+            }
+            if (Pos == DigitsBegin || Value >= MAX_int32) {
+                return false;
+            }
+            if (Pos < End && *Pos == '.') {
+                do {
+                    Pos++;
+                } while (Pos < End && *Pos >= '0' && *Pos <= '9');
+            }
+            OutValue = bNegative ? -Value : Value;
+            return true;
+        }
+
+        /**
+        * Skips the value of a field that is not used
+        */
+        bool SkipValue() {
+            SkipWhitespace();
+            if (Pos == End) {
+                return false;
+            }
+            if (*Pos == '"') {
+                const uint8* Begin;
+                int32 Length;
+                return ReadString(Begin, Length);
+            }
+            if (*Pos == '{' || *Pos == '[') {
+                int32 Depth = 0;
+                do {
+                    if (*Pos == '"') {
+                        const uint8* Begin;
+                        int32 Length;
+                        if (!ReadString(Begin, Length)) {
+                            return false;
+                        }
+                        continue;
+                    }
+                    Depth += (*Pos == '{' || *Pos == '[') ? 1 : (*Pos == '}' || *Pos == ']') ? -1 : 0;
+                    Pos++;
+                } while (Depth > 0 && Pos < End);
+                return Depth == 0;
+            }
+            // A number, true, false or null
+            const uint8* Begin = Pos;
+            while (Pos < End && *Pos != ',' && *Pos != '}' && *Pos != ' ' && *Pos != '\t' && *Pos != '\r') {
+                Pos++;
+            }
+            return Pos > Begin;
+        }
+    };
+
+    bool IsKey(const uint8* Key, int32 Length, const char* Expected, int32 ExpectedLength) {
+        return Length == ExpectedLength && FMemory::Memcmp(Key, Expected, ExpectedLength) == 0;
+    }
+}
+
+bool FSpeechMarkParser::Append(TArrayView<const uint8> Bytes, TArray<VisemeEvent>& OutVisemeEvents) {
+    if (bFailed) {
+        return false;
+    }
+    OutVisemeEvents.Reserve(OutVisemeEvents.Num() + Bytes.Num() / TypicalLineBytes + 1);
+    const uint8* Pos = Bytes.GetData();
+    const uint8* End = Pos + Bytes.Num();
+    while (Pos < End) {
+        const uint8* LineEnd = static_cast<const uint8*>(FMemory::Memchr(Pos, '\n', End - Pos));
+        if (LineEnd == nullptr) {
+            PartialLine.Append(Pos, static_cast<int32>(End - Pos));
+            break;
+        }
+        if (PartialLine.Num() > 0) {
+            PartialLine.Append(Pos, static_cast<int32>(LineEnd - Pos));
+            bFailed = !ParseLine(PartialLine.GetData(), PartialLine.GetData() + PartialLine.Num(), OutVisemeEvents);
+            PartialLine.Reset();
+        }
+        else {
+            bFailed = !ParseLine(Pos, LineEnd, OutVisemeEvents);
+        }
+        if (bFailed) {
+            return false;
+        }
+        Pos = LineEnd + 1;
+    }
+    return true;
+}
+
+bool FSpeechMarkParser::Finish(TArray<VisemeEvent>& OutVisemeEvents) {
+    if (!bFailed && PartialLine.Num() > 0) {
+        bFailed = !ParseLine(PartialLine.GetData(), PartialLine.GetData() + PartialLine.Num(), OutVisemeEvents);
+    }
+    PartialLine.Reset();
+    return !bFailed;
+}
+
+bool FSpeechMarkParser::Parse(TArrayView<const uint8> Bytes, TArray<VisemeEvent>& OutVisemeEvents) {
+    FSpeechMarkParser Parser;
+    return Parser.Append(Bytes, OutVisemeEvents) && Parser.Finish(OutVisemeEvents);
+}
+
+bool FSpeechMarkParser::ParseLine(const uint8* Begin, const uint8* End, TArray<VisemeEvent>& OutVisemeEvents) {
+    FLineCursor Cursor = { Begin, End };
+    Cursor.SkipWhitespace();
+    if (Cursor.Pos == End) {
+        return true;
+    }
+    if (!Cursor.Consume('{')) {
+        return false;
+    }
+    bool bHasTime = false;
+    bool bHasValue = false;
+    int64 Time = 0;
+    const uint8* Value = nullptr;
+    int32 ValueLength = 0;
+    if (!Cursor.Consume('}')) {
+        do {
+            const uint8* Key;
+            int32 KeyLength;
+            if (!Cursor.ReadString(Key, KeyLength) || !Cursor.Consume(':')) {
+                return false;
+            }
+            if (IsKey(Key, KeyLength, "time", 4)) {
+                bHasTime = Cursor.ReadInteger(Time);
+                if (!bHasTime) {
+                    return false;
+                }
+            }
+            else if (IsKey(Key, KeyLength, "value", 5)) {
+                bHasValue = Cursor.ReadString(Value, ValueLength);
+                if (!bHasValue) {
+                    return false;
+                }
+            }
+            else if (!Cursor.SkipValue()) {
+                return false;
+            }
+        } while (Cursor.Consume(','));
+        if (!Cursor.Consume('}')) {
+            return false;
+        }
+    }
+    Cursor.SkipWhitespace();
+    if (Cursor.Pos != End || !bHasTime || !bHasValue) {
+        return false;
+    }
+    VisemeEvent Event;
+    Event.TimeMilliseconds = static_cast<int>(Time);
+    if (!TryGetVisemeFromSymbol(reinterpret_cast<const ANSICHAR*>(Value), ValueLength, Event.Viseme)) {
+        const FUTF8ToTCHAR Symbol(reinterpret_cast<const ANSICHAR*>(Value), ValueLength);
+        UE_LOG(LogAmazonPollyViseme, Error, TEXT("Tried to read an invalid viseme value. Returning Sil as default. Invalid value: %s"), *FString(Symbol.Length(), Symbol.Get()));
+        Event.Viseme = EViseme::Sil;
+    }
+    OutVisemeEvents.Add(Event);
+    return true;
+}
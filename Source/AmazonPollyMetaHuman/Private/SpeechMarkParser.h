@@ -0,0 +1,63 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpeechComponent.h"
+
+/**
+* Parser of the newline-delimited speech marks returned by Polly, e.g. {"time":125,"type":"viseme","value":"k"}.
+* Works on the UTF-8 bytes of the response as they are, without allocating per line, and accepts them in chunks
+* of any size, e.g. as they arrive. Each line must be an object with a numeric "time" and a string "value".
+*/
+class FSpeechMarkParser {
+public:
+    /**
+    * Parses the complete lines of a chunk of speech marks, keeping an incomplete last line until the next chunk
+    * @param Bytes - the next bytes of the speech marks
+    * @param OutVisemeEvents - receives the visemes of the complete lines
+    * @return bool - false if a line is malformed, after which the parser rejects all further bytes
+    */
+    bool Append(TArrayView<const uint8> Bytes, TArray<VisemeEvent>& OutVisemeEvents);
+    /**
+    * Parses the last line of the speech marks, which does not end in a newline
+    * @param OutVisemeEvents - receives the visemes of the line
+    * @return bool - false if a line is malformed
+    */
+    bool Finish(TArray<VisemeEvent>& OutVisemeEvents);
+    /**
+    * Parses complete speech marks
+    * @param Bytes - the speech marks
+    * @param OutVisemeEvents - receives the visemes
+    * @return bool - false if a line is malformed
+    */
+    static bool Parse(TArrayView<const uint8> Bytes, TArray<VisemeEvent>& OutVisemeEvents);
+
+private:
+    /**
+    * Parses a line without its newline. Blank lines hold no viseme.
+    */
+    static bool ParseLine(const uint8* Begin, const uint8* End, TArray<VisemeEvent>& OutVisemeEvents);
+
+    /**
+    * Bytes of a line split across chunks. A line of Polly is about 50 bytes, so it is held inline.
+    */
+    TArray<uint8, TInlineAllocator<256>> PartialLine;
+    bool bFailed = false;
+};
@@ -0,0 +1,192 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechMemoryTracker.h"
+#include "HAL/IConsoleManager.h"
+#include "Containers/Ticker.h"
+#include "SpeechCache.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Speech Components"), STAT_PollySpeechComponents, STATGROUP_AmazonPolly);
+DECLARE_MEMORY_STAT(TEXT("Speech Buffers"), STAT_PollySpeechBuffers, STATGROUP_AmazonPolly);
+DECLARE_MEMORY_STAT(TEXT("Speech Cache"), STAT_PollySpeechCache, STATGROUP_AmazonPolly);
+DECLARE_MEMORY_STAT(TEXT("Speech Memory Budget"), STAT_PollySpeechMemoryBudget, STATGROUP_AmazonPolly);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Released Speeches"), STAT_PollyReleasedSpeeches, STATGROUP_AmazonPolly);
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+DECLARE_LLM_MEMORY_STAT(TEXT("PollySpeech"), STAT_PollySpeechLLM, STATGROUP_LLMFULL);
+#endif
+
+namespace {
+    TAutoConsoleVariable<int32> CVarSpeechMemoryBudgetMB(
+        TEXT("Polly.SpeechMemoryBudgetMB"),
+        0,
+        TEXT("Memory the speech of all speech components and the cache of synthesized speech may use together, in MB.\n")
+        TEXT("Beyond it the speech of idle components is released, largest first, and then cached texts are evicted.\n")
+        TEXT("0: no budget (default)"),
+        ECVF_Default);
+
+    FAutoConsoleCommand DumpMemoryCommand(
+        TEXT("Polly.DumpMemory"),
+        TEXT("Logs the speech memory and the speech components holding the most of it. Polly.DumpMemory [NumComponents=10]"),
+        FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& Args) {
+            FSpeechMemoryTracker::Get().Dump(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10);
+        }));
+
+    const float TickIntervalSeconds = 1.0f;
+
+    float ToMegabytes(int64 Bytes) {
+        return Bytes / (1024.0f * 1024.0f);
+    }
+}
+
+FSpeechMemoryTracker& FSpeechMemoryTracker::Get() {
+    static FSpeechMemoryTracker SharedTracker;
+    return SharedTracker;
+}
+
+void FSpeechMemoryTracker::Start() {
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+    FLowLevelMemTracker::Get().RegisterProjectTag(LLMTag, TEXT("PollySpeech"), GET_STATFNAME(STAT_PollySpeechLLM), GET_STATFNAME(STAT_AudioSummaryLLM));
+#endif
+    TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSpeechMemoryTracker::Tick), TickIntervalSeconds);
+}
+
+void FSpeechMemoryTracker::Stop() {
+    FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    TickerHandle.Reset();
+}
+
+void FSpeechMemoryTracker::Register(USpeechComponent* Component) {
+    FScopeLock lock(&Mutex);
+    Components.Add(Component);
+}
+
+void FSpeechMemoryTracker::Unregister(USpeechComponent* Component) {
+    FScopeLock lock(&Mutex);
+    Components.RemoveSwap(Component);
+}
+
+int64 FSpeechMemoryTracker::GetBudgetBytes() {
+    return static_cast<int64>(FMath::Max(CVarSpeechMemoryBudgetMB.GetValueOnAnyThread(), 0)) * 1024 * 1024;
+}
+
+void FSpeechMemoryTracker::SetBudgetMB(int32 BudgetMB) {
+    CVarSpeechMemoryBudgetMB->Set(BudgetMB, ECVF_SetByCode);
+}
+
+bool FSpeechMemoryTracker::Tick(float DeltaTime) {
+    EnforceBudget();
+#if STATS
+    const FSpeechMemoryStats Stats = GetStats();
+    SET_DWORD_STAT(STAT_PollySpeechComponents, Stats.NumComponents);
+    SET_MEMORY_STAT(STAT_PollySpeechBuffers, static_cast<int64>(Stats.SpeechBuffersKB) * 1024);
+    SET_MEMORY_STAT(STAT_PollySpeechCache, static_cast<int64>(Stats.SpeechCacheKB) * 1024);
+    SET_MEMORY_STAT(STAT_PollySpeechMemoryBudget, static_cast<int64>(Stats.BudgetKB) * 1024);
+    SET_DWORD_STAT(STAT_PollyReleasedSpeeches, Stats.NumReleasedSpeeches);
+#endif
+    return true;
+}
+
+int64 FSpeechMemoryTracker::EnforceBudget() {
+    const int64 BudgetBytes = GetBudgetBytes();
+    FScopeLock lock(&Mutex);
+    if (BudgetBytes <= 0) {
+        bOverBudgetReported = false;
+        return 0;
+    }
+    TArray<TPair<int64, USpeechComponent*>> Holders;
+    int64 UsedBytes = FSpeechCache::Get().GetSizeBytes();
+    for (USpeechComponent* Component : Components) {
+        const int64 ComponentBytes = Component->GetSpeechMemoryBytes();
+        Holders.Emplace(ComponentBytes, Component);
+        UsedBytes += ComponentBytes;
+    }
+    const int64 ExcessBytes = UsedBytes - BudgetBytes;
+    if (ExcessBytes <= 0) {
+        bOverBudgetReported = false;
+        return 0;
+    }
+    // Speech that has been played is only kept to be played again, which makes it the cheapest to release.
+    // The largest ones go first, so that as few speeches as possible are released.
+    Holders.Sort([](const TPair<int64, USpeechComponent*>& A, const TPair<int64, USpeechComponent*>& B) {
+        return A.Key > B.Key;
+    });
+    int64 ReleasedBytes = 0;
+    for (const TPair<int64, USpeechComponent*>& Holder : Holders) {
+        if (ReleasedBytes >= ExcessBytes) {
+            break;
+        }
+        const int64 SpeechBytes = Holder.Value->ReleaseIdleSpeech();
+        if (SpeechBytes > 0) {
+            ReleasedBytes += SpeechBytes;
+            NumReleasedSpeeches++;
+        }
+    }
+    if (ReleasedBytes < ExcessBytes) {
+        ReleasedBytes += FSpeechCache::Get().Trim(ExcessBytes - ReleasedBytes);
+    }
+    if (ReleasedBytes < ExcessBytes && !bOverBudgetReported) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Speech memory exceeds its budget of %.1f MB by %.1f MB held by speech in use. Run Polly.DumpMemory for the largest holders."), ToMegabytes(BudgetBytes), ToMegabytes(ExcessBytes - ReleasedBytes));
+        bOverBudgetReported = true;
+    }
+    return ReleasedBytes;
+}
+
+FSpeechMemoryStats FSpeechMemoryTracker::GetStats() const {
+    FSpeechMemoryStats Stats;
+    int64 SpeechBuffersBytes = 0;
+    {
+        FScopeLock lock(&Mutex);
+        for (USpeechComponent* Component : Components) {
+            SpeechBuffersBytes += Component->GetSpeechMemoryBytes();
+        }
+        Stats.NumComponents = Components.Num();
+        Stats.NumReleasedSpeeches = NumReleasedSpeeches;
+    }
+    Stats.SpeechBuffersKB = static_cast<int32>(SpeechBuffersBytes / 1024);
+    Stats.SpeechCacheKB = static_cast<int32>(FSpeechCache::Get().GetSizeBytes() / 1024);
+    Stats.BudgetKB = static_cast<int32>(GetBudgetBytes() / 1024);
+    return Stats;
+}
+
+void FSpeechMemoryTracker::Dump(int32 NumHolders) const {
+    TArray<TPair<int64, FString>> Holders;
+    int64 SpeechBuffersBytes = 0;
+    int32 NumReleased = 0;
+    {
+        FScopeLock lock(&Mutex);
+        NumReleased = NumReleasedSpeeches;
+        for (USpeechComponent* Component : Components) {
+            const int64 ComponentBytes = Component->GetSpeechMemoryBytes();
+            SpeechBuffersBytes += ComponentBytes;
+            Holders.Emplace(ComponentBytes, FString::Printf(TEXT("%s%s"), *Component->GetPathName(), Component->IsSpeaking() ? TEXT(" (speaking)") : TEXT("")));
+        }
+    }
+    const FSpeechCacheStats CacheStats = FSpeechCache::Get().GetStats();
+    const int64 CacheBytes = FSpeechCache::Get().GetSizeBytes();
+    const int64 BudgetBytes = GetBudgetBytes();
+    UE_LOG(LogPollyMsg, Display, TEXT("Speech memory: %.2f MB, budget %s"), ToMegabytes(SpeechBuffersBytes + CacheBytes), BudgetBytes > 0 ? *FString::Printf(TEXT("%.1f MB"), ToMegabytes(BudgetBytes)) : TEXT("none"));
+    UE_LOG(LogPollyMsg, Display, TEXT("  Speech components: %.2f MB in %d components, %d speeches released"), ToMegabytes(SpeechBuffersBytes), Holders.Num(), NumReleased);
+    UE_LOG(LogPollyMsg, Display, TEXT("  Speech cache: %.2f MB in %d texts"), ToMegabytes(CacheBytes), CacheStats.NumEntries);
+    Holders.Sort([](const TPair<int64, FString>& A, const TPair<int64, FString>& B) {
+        return A.Key > B.Key;
+    });
+    for (int32 HolderIndex = 0; HolderIndex < FMath::Min(NumHolders, Holders.Num()); HolderIndex++) {
+        UE_LOG(LogPollyMsg, Display, TEXT("  %8.1f KB  %s"), Holders[HolderIndex].Key / 1024.0f, *Holders[HolderIndex].Value);
+    }
+}
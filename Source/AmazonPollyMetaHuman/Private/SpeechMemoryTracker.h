@@ -0,0 +1,111 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+#include "SpeechComponent.h"
+
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+/**
+* Attributes the allocations of the enclosing scope to the PollySpeech tag of the low level memory tracker
+*/
+#define LLM_SCOPE_POLLY_SPEECH() LLM_SCOPE(static_cast<ELLMTag>(FSpeechMemoryTracker::LLMTag))
+#else
+#define LLM_SCOPE_POLLY_SPEECH()
+#endif
+
+DECLARE_STATS_GROUP(TEXT("AmazonPolly"), STATGROUP_AmazonPolly, STATCAT_Advanced);
+
+/**
+* Accounts for the memory of the speech of all speech components and of the FSpeechCache, and keeps it within the
+* budget set by the Polly.SpeechMemoryBudgetMB console variable. Once a second it updates the "stat AmazonPolly"
+* counters and, over budget, releases the speech of idle components, largest first, and then evicts cached texts.
+* Speech components register themselves when they are constructed. Register and Unregister are thread-safe, the
+* other functions must be called on the game thread, where speech components are destroyed.
+*/
+class FSpeechMemoryTracker {
+public:
+#if ENABLE_LOW_LEVEL_MEM_TRACKER
+    /**
+    * Project tag of the low level memory tracker the speech memory is reported under, as "PollySpeech"
+    */
+    static const int32 LLMTag = static_cast<int32>(ELLMTag::ProjectTagStart) + 16;
+#endif
+
+    /**
+    * Returns the tracker of all speech components
+    */
+    static FSpeechMemoryTracker& Get();
+    /**
+    * Registers the low level memory tracker tag and starts the periodic update. Called on module startup.
+    */
+    void Start();
+    /**
+    * Stops the periodic update. Called on module shutdown.
+    */
+    void Stop();
+    /**
+    * Adds a speech component to the accounting
+    */
+    void Register(USpeechComponent* Component);
+    /**
+    * Removes a speech component from the accounting, before it is destroyed
+    */
+    void Unregister(USpeechComponent* Component);
+    /**
+    * Releases speech memory until it fits the budget, if there is one
+    * @return int64 - the memory released in bytes
+    */
+    int64 EnforceBudget();
+    /**
+    * Returns the memory of all speech components and of the cache
+    */
+    FSpeechMemoryStats GetStats() const;
+    /**
+    * Logs the speech memory and the speech components holding the most of it
+    * @param NumHolders - the number of speech components to list
+    */
+    void Dump(int32 NumHolders) const;
+    /**
+    * Returns the budget set by Polly.SpeechMemoryBudgetMB, 0 if there is none
+    */
+    static int64 GetBudgetBytes();
+    /**
+    * Changes Polly.SpeechMemoryBudgetMB
+    */
+    static void SetBudgetMB(int32 BudgetMB);
+
+private:
+    FSpeechMemoryTracker() = default;
+    /**
+    * Updates the stats and enforces the budget, once a second
+    */
+    bool Tick(float DeltaTime);
+
+    mutable FCriticalSection Mutex;
+    TArray<USpeechComponent*> Components;
+    int32 NumReleasedSpeeches = 0;
+    /**
+    * Set while the speech memory in use exceeds the budget, so that it is reported once
+    */
+    bool bOverBudgetReported = false;
+    FDelegateHandle TickerHandle;
+};
@@ -0,0 +1,412 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechMetrics.h"
+#include <aws/polly/model/Engine.h>
+#include <aws/polly/model/VoiceId.h>
+#include "Async/Async.h"
+#include "Containers/Ticker.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "PollyClient.h"
+#include "SpeechCache.h"
+#include "SpeechMemoryTracker.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Polly Requests"), STAT_PollyRequests, STATGROUP_AmazonPolly);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Failed Requests"), STAT_PollyFailedRequests, STATGROUP_AmazonPolly);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Throttled Requests"), STAT_PollyThrottledRequests, STATGROUP_AmazonPolly);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cancelled Requests"), STAT_PollyCancelledRequests, STATGROUP_AmazonPolly);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Received (KB)"), STAT_PollyReceivedKB, STATGROUP_AmazonPolly);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Request Latency p50 (ms)"), STAT_PollyRequestLatencyP50, STATGROUP_AmazonPolly);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Request Latency p99 (ms)"), STAT_PollyRequestLatencyP99, STATGROUP_AmazonPolly);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Queue Wait p99 (ms)"), STAT_PollyQueueWaitP99, STATGROUP_AmazonPolly);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Parse Time p99 (ms)"), STAT_PollyParseTimeP99, STATGROUP_AmazonPolly);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Cache Hit Rate (%)"), STAT_PollyCacheHitRate, STATGROUP_AmazonPolly);
+
+CSV_DEFINE_CATEGORY(AmazonPolly, true);
+
+namespace {
+    TAutoConsoleVariable<float> CVarMetricsSnapshotSeconds(
+        TEXT("Polly.MetricsSnapshotSeconds"),
+        0.0f,
+        TEXT("Interval at which the speech metrics are written to the JSON file set by Polly.MetricsSnapshotPath, in seconds.\n")
+        TEXT("0: no snapshots (default)"),
+        ECVF_Default);
+
+    TAutoConsoleVariable<FString> CVarMetricsSnapshotPath(
+        TEXT("Polly.MetricsSnapshotPath"),
+        FString(),
+        TEXT("File the speech metrics are written to every Polly.MetricsSnapshotSeconds.\n")
+        TEXT("Empty: Saved/Metrics/AmazonPollyMetrics.json (default)"),
+        ECVF_Default);
+
+    FAutoConsoleCommand DumpMetricsCommand(
+        TEXT("Polly.DumpMetrics"),
+        TEXT("Logs the counters and the latency of the requests to Polly"),
+        FConsoleCommandDelegate::CreateLambda([]() {
+            FSpeechMetrics::Get().Dump();
+        }));
+
+    const double StatsIntervalSeconds = 1.0;
+    /**
+    * Shortest interval between JSON snapshots, so that a small Polly.MetricsSnapshotSeconds does not write every frame
+    */
+    const double MinJsonSnapshotSeconds = 1.0;
+
+    uint64 ToMicroseconds(double Seconds) {
+        return static_cast<uint64>(FMath::Max(Seconds, 0.0) * 1e6);
+    }
+
+    double ToMilliseconds(double Microseconds) {
+        return Microseconds / 1000.0;
+    }
+
+    /**
+    * Voice and engine pairs are told apart by the enums of the SDK, the engine being either standard or neural
+    */
+    int32 ToVoiceKey(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
+        return static_cast<int32>(SpeechRequest.GetVoiceId()) * 2 + (SpeechRequest.GetEngine() == Aws::Polly::Model::Engine::neural ? 1 : 0);
+    }
+
+    TSharedRef<FJsonObject> ToJsonObject(const FSpeechHistogramSnapshot& Histogram) {
+        TSharedRef<FJsonObject> JsonHistogram = MakeShared<FJsonObject>();
+        JsonHistogram->SetNumberField(TEXT("count"), Histogram.Count);
+        JsonHistogram->SetNumberField(TEXT("mean"), ToMilliseconds(Histogram.GetMean()));
+        JsonHistogram->SetNumberField(TEXT("p50"), ToMilliseconds(Histogram.GetPercentile(0.5)));
+        JsonHistogram->SetNumberField(TEXT("p90"), ToMilliseconds(Histogram.GetPercentile(0.9)));
+        JsonHistogram->SetNumberField(TEXT("p99"), ToMilliseconds(Histogram.GetPercentile(0.99)));
+        JsonHistogram->SetNumberField(TEXT("max"), ToMilliseconds(Histogram.Max));
+        // Only the buckets in use are written, by their lower bound, so that histograms of several
+        // processes can be added up
+        TArray<TSharedPtr<FJsonValue>> JsonBuckets;
+        for (int32 BucketIndex = 0; BucketIndex < Histogram.Buckets.Num(); BucketIndex++) {
+            if (Histogram.Buckets[BucketIndex] > 0) {
+                TArray<TSharedPtr<FJsonValue>> JsonBucket;
+                JsonBucket.Add(MakeShared<FJsonValueNumber>(ToMilliseconds(FSpeechMetricHistogram::GetBucketLowerBound(BucketIndex))));
+                JsonBucket.Add(MakeShared<FJsonValueNumber>(Histogram.Buckets[BucketIndex]));
+                JsonBuckets.Add(MakeShared<FJsonValueArray>(JsonBucket));
+            }
+        }
+        JsonHistogram->SetArrayField(TEXT("buckets"), JsonBuckets);
+        return JsonHistogram;
+    }
+
+    void LogHistogram(const TCHAR* Name, const FSpeechHistogramSnapshot& Histogram) {
+        UE_LOG(LogPollyMsg, Display, TEXT("  %-24s %8llu  p50 %8.1f ms  p90 %8.1f ms  p99 %8.1f ms  max %8.1f ms"), Name, Histogram.Count,
+            ToMilliseconds(Histogram.GetPercentile(0.5)), ToMilliseconds(Histogram.GetPercentile(0.9)), ToMilliseconds(Histogram.GetPercentile(0.99)), ToMilliseconds(Histogram.Max));
+    }
+
+    /**
+    * Writes a file through a temporary one, so that it is never collected half written
+    */
+    void SaveSnapshotFile(const FString& Json, const FString& Path) {
+        const FString TemporaryPath = Path + TEXT(".tmp");
+        if (!FFileHelper::SaveStringToFile(Json, *TemporaryPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM) || !IFileManager::Get().Move(*Path, *TemporaryPath, true)) {
+            UE_LOG(LogPollyMsg, Warning, TEXT("Failed to write the speech metrics to %s."), *Path);
+        }
+    }
+}
+
+double FSpeechHistogramSnapshot::GetPercentile(double Fraction) const {
+    if (Count == 0) {
+        return 0.0;
+    }
+    const uint64 Rank = FMath::Clamp<uint64>(static_cast<uint64>(FMath::CeilToDouble(Fraction * Count)), 1, Count);
+    uint64 NumBelow = 0;
+    for (int32 BucketIndex = 0; BucketIndex < Buckets.Num(); BucketIndex++) {
+        NumBelow += Buckets[BucketIndex];
+        if (NumBelow >= Rank) {
+            const double LowerBound = FSpeechMetricHistogram::GetBucketLowerBound(BucketIndex);
+            const double UpperBound = BucketIndex + 1 < Buckets.Num() ? FSpeechMetricHistogram::GetBucketLowerBound(BucketIndex + 1) : Max + 1.0;
+            return FMath::Min((LowerBound + UpperBound - 1.0) / 2.0, static_cast<double>(Max));
+        }
+    }
+    // Values recorded while the buckets were copied may be missing from them
+    return Max;
+}
+
+double FSpeechHistogramSnapshot::GetMean() const {
+    return Count > 0 ? static_cast<double>(Sum) / Count : 0.0;
+}
+
+void FSpeechHistogramSnapshot::Merge(const FSpeechHistogramSnapshot& Other) {
+    Buckets.SetNumZeroed(FMath::Max(Buckets.Num(), Other.Buckets.Num()));
+    for (int32 BucketIndex = 0; BucketIndex < Other.Buckets.Num(); BucketIndex++) {
+        Buckets[BucketIndex] += Other.Buckets[BucketIndex];
+    }
+    Count += Other.Count;
+    Sum += Other.Sum;
+    Max = FMath::Max(Max, Other.Max);
+}
+
+FSpeechMetricHistogram::FSpeechMetricHistogram() {
+    for (std::atomic<uint64>& Bucket : Buckets) {
+        Bucket.store(0, std::memory_order_relaxed);
+    }
+    Count.store(0, std::memory_order_relaxed);
+    Sum.store(0, std::memory_order_relaxed);
+    Max.store(0, std::memory_order_relaxed);
+}
+
+void FSpeechMetricHistogram::Record(uint64 Value) {
+    // The counters are independent of each other, so none of them needs to be ordered with the others
+    Buckets[GetBucketIndex(Value)].fetch_add(1, std::memory_order_relaxed);
+    Count.fetch_add(1, std::memory_order_relaxed);
+    Sum.fetch_add(Value, std::memory_order_relaxed);
+    uint64 PreviousMax = Max.load(std::memory_order_relaxed);
+    while (Value > PreviousMax && !Max.compare_exchange_weak(PreviousMax, Value, std::memory_order_relaxed)) {
+    }
+}
+
+FSpeechHistogramSnapshot FSpeechMetricHistogram::GetSnapshot() const {
+    FSpeechHistogramSnapshot Snapshot;
+    Snapshot.Buckets.SetNumUninitialized(NumBuckets);
+    for (int32 BucketIndex = 0; BucketIndex < NumBuckets; BucketIndex++) {
+        Snapshot.Buckets[BucketIndex] = Buckets[BucketIndex].load(std::memory_order_relaxed);
+    }
+    Snapshot.Count = Count.load(std::memory_order_relaxed);
+    Snapshot.Sum = Sum.load(std::memory_order_relaxed);
+    Snapshot.Max = Max.load(std::memory_order_relaxed);
+    return Snapshot;
+}
+
+int32 FSpeechMetricHistogram::GetBucketIndex(uint64 Value) {
+    if (Value < NumSubBuckets) {
+        return static_cast<int32>(Value);
+    }
+    // The highest bit selects the power of two, the SubBucketBits below it the bucket within it
+    const int32 Exponent = static_cast<int32>(FPlatformMath::FloorLog2_64(Value));
+    const int32 SubBucket = static_cast<int32>((Value >> (Exponent - SubBucketBits)) & (NumSubBuckets - 1));
+    return (Exponent - SubBucketBits + 1) * NumSubBuckets + SubBucket;
+}
+
+uint64 FSpeechMetricHistogram::GetBucketLowerBound(int32 BucketIndex) {
+    if (BucketIndex < NumSubBuckets) {
+        return BucketIndex;
+    }
+    const int32 Exponent = BucketIndex / NumSubBuckets + SubBucketBits - 1;
+    const uint64 SubBucket = BucketIndex % NumSubBuckets;
+    return (NumSubBuckets + SubBucket) << (Exponent - SubBucketBits);
+}
+
+double FSpeechMetricsSnapshot::GetCacheHitRate() const {
+    const int32 NumLookups = NumCacheHits + NumCacheMisses;
+    return NumLookups > 0 ? static_cast<double>(NumCacheHits) / NumLookups : 0.0;
+}
+
+FSpeechMetrics& FSpeechMetrics::Get() {
+    static FSpeechMetrics SharedMetrics;
+    return SharedMetrics;
+}
+
+FSpeechMetrics::FSpeechMetrics() {
+    for (std::atomic<FSpeechMetricHistogram*>& VoiceLatency : VoiceLatencies) {
+        VoiceLatency.store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+FSpeechMetrics::~FSpeechMetrics() {
+    for (std::atomic<FSpeechMetricHistogram*>& VoiceLatency : VoiceLatencies) {
+        delete VoiceLatency.load(std::memory_order_relaxed);
+    }
+}
+
+void FSpeechMetrics::Start() {
+    NextStatsUpdateSeconds = 0.0;
+    NextJsonSnapshotSeconds = FPlatformTime::Seconds() + CVarMetricsSnapshotSeconds.GetValueOnGameThread();
+    TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSpeechMetrics::Tick));
+}
+
+void FSpeechMetrics::Stop() {
+    FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+    TickerHandle.Reset();
+    // The requests since the last snapshot are not lost when the process exits between two of them
+    if (CVarMetricsSnapshotSeconds.GetValueOnGameThread() > 0.0f) {
+        SaveSnapshotFile(ToJson(GetSnapshot()), GetSnapshotPath());
+    }
+}
+
+void FSpeechMetrics::RecordRequest(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, double LatencySeconds, const PollyOutcome& Outcome) {
+    NumRequests.fetch_add(1, std::memory_order_relaxed);
+    if (!Outcome.IsSuccess) {
+        NumFailedRequests.fetch_add(1, std::memory_order_relaxed);
+        if (Outcome.IsThrottled) {
+            NumThrottledRequests.fetch_add(1, std::memory_order_relaxed);
+        }
+        return;
+    }
+    // Failures are left out of the latency, most of them return before Polly synthesizes anything
+    const uint64 LatencyMicroseconds = ToMicroseconds(LatencySeconds);
+    RequestLatency.Record(LatencyMicroseconds);
+    const int32 VoiceKey = ToVoiceKey(SpeechRequest);
+    if (VoiceKey >= 0 && VoiceKey < MaxVoiceKeys) {
+        GetVoiceLatency(VoiceKey)->Record(LatencyMicroseconds);
+    }
+    BytesReceived.fetch_add(Outcome.StreamBuffer->Num(), std::memory_order_relaxed);
+}
+
+void FSpeechMetrics::RecordCancelledRequest() {
+    NumCancelledRequests.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FSpeechMetrics::RecordBytesReceived(int64 NumBytes) {
+    BytesReceived.fetch_add(NumBytes, std::memory_order_relaxed);
+}
+
+void FSpeechMetrics::RecordQueueWait(double WaitSeconds) {
+    QueueWait.Record(ToMicroseconds(WaitSeconds));
+}
+
+void FSpeechMetrics::RecordParseTime(double Seconds) {
+    ParseTime.Record(ToMicroseconds(Seconds));
+}
+
+FSpeechMetricHistogram* FSpeechMetrics::GetVoiceLatency(int32 VoiceKey) {
+    FSpeechMetricHistogram* Histogram = VoiceLatencies[VoiceKey].load(std::memory_order_acquire);
+    if (Histogram == nullptr) {
+        // Threads racing on the first request of a voice each create a histogram, the one published first is kept
+        FSpeechMetricHistogram* CreatedHistogram = new FSpeechMetricHistogram();
+        if (VoiceLatencies[VoiceKey].compare_exchange_strong(Histogram, CreatedHistogram, std::memory_order_acq_rel, std::memory_order_acquire)) {
+            Histogram = CreatedHistogram;
+        }
+        else {
+            delete CreatedHistogram;
+        }
+    }
+    return Histogram;
+}
+
+FSpeechMetricsSnapshot FSpeechMetrics::GetSnapshot() const {
+    FSpeechMetricsSnapshot Snapshot;
+    Snapshot.NumRequests = NumRequests.load(std::memory_order_relaxed);
+    Snapshot.NumFailedRequests = NumFailedRequests.load(std::memory_order_relaxed);
+    Snapshot.NumThrottledRequests = NumThrottledRequests.load(std::memory_order_relaxed);
+    Snapshot.NumCancelledRequests = NumCancelledRequests.load(std::memory_order_relaxed);
+    Snapshot.BytesReceived = BytesReceived.load(std::memory_order_relaxed);
+    const FSpeechCacheStats CacheStats = FSpeechCache::Get().GetStats();
+    Snapshot.NumCacheHits = CacheStats.NumHits;
+    Snapshot.NumCacheMisses = CacheStats.NumMisses;
+    Snapshot.RequestLatency = RequestLatency.GetSnapshot();
+    Snapshot.QueueWait = QueueWait.GetSnapshot();
+    Snapshot.ParseTime = ParseTime.GetSnapshot();
+    for (int32 VoiceKey = 0; VoiceKey < MaxVoiceKeys; VoiceKey++) {
+        const FSpeechMetricHistogram* Histogram = VoiceLatencies[VoiceKey].load(std::memory_order_acquire);
+        if (Histogram != nullptr) {
+            FSpeechVoiceLatency& VoiceLatency = Snapshot.VoiceLatencies.AddDefaulted_GetRef();
+            VoiceLatency.Voice = UnrealAWSUtils::AwsStringToFString(Aws::Polly::Model::VoiceIdMapper::GetNameForVoiceId(static_cast<Aws::Polly::Model::VoiceId>(VoiceKey / 2)));
+            VoiceLatency.Engine = UnrealAWSUtils::AwsStringToFString(Aws::Polly::Model::EngineMapper::GetNameForEngine(VoiceKey % 2 == 1 ? Aws::Polly::Model::Engine::neural : Aws::Polly::Model::Engine::standard));
+            VoiceLatency.Latency = Histogram->GetSnapshot();
+        }
+    }
+    return Snapshot;
+}
+
+FString FSpeechMetrics::ToJson(const FSpeechMetricsSnapshot& Snapshot) {
+    TArray<TSharedPtr<FJsonValue>> JsonVoices;
+    for (const FSpeechVoiceLatency& VoiceLatency : Snapshot.VoiceLatencies) {
+        TSharedRef<FJsonObject> JsonVoice = MakeShared<FJsonObject>();
+        JsonVoice->SetStringField(TEXT("voice"), VoiceLatency.Voice);
+        JsonVoice->SetStringField(TEXT("engine"), VoiceLatency.Engine);
+        JsonVoice->SetObjectField(TEXT("request_latency_ms"), ToJsonObject(VoiceLatency.Latency));
+        JsonVoices.Add(MakeShared<FJsonValueObject>(JsonVoice));
+    }
+    TSharedRef<FJsonObject> JsonMetrics = MakeShared<FJsonObject>();
+    JsonMetrics->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+    JsonMetrics->SetNumberField(TEXT("process_id"), FPlatformProcess::GetCurrentProcessId());
+    JsonMetrics->SetNumberField(TEXT("uptime_seconds"), FPlatformTime::Seconds() - GStartTime);
+    JsonMetrics->SetNumberField(TEXT("requests"), Snapshot.NumRequests);
+    JsonMetrics->SetNumberField(TEXT("failed_requests"), Snapshot.NumFailedRequests);
+    JsonMetrics->SetNumberField(TEXT("throttled_requests"), Snapshot.NumThrottledRequests);
+    JsonMetrics->SetNumberField(TEXT("cancelled_requests"), Snapshot.NumCancelledRequests);
+    JsonMetrics->SetNumberField(TEXT("bytes_received"), Snapshot.BytesReceived);
+    JsonMetrics->SetNumberField(TEXT("cache_hits"), Snapshot.NumCacheHits);
+    JsonMetrics->SetNumberField(TEXT("cache_misses"), Snapshot.NumCacheMisses);
+    JsonMetrics->SetNumberField(TEXT("cache_hit_rate"), Snapshot.GetCacheHitRate());
+    JsonMetrics->SetObjectField(TEXT("request_latency_ms"), ToJsonObject(Snapshot.RequestLatency));
+    JsonMetrics->SetObjectField(TEXT("queue_wait_ms"), ToJsonObject(Snapshot.QueueWait));
+    JsonMetrics->SetObjectField(TEXT("parse_time_ms"), ToJsonObject(Snapshot.ParseTime));
+    JsonMetrics->SetArrayField(TEXT("voices"), JsonVoices);
+    FString Json;
+    TSharedRef<TJsonWriter<TCHAR>> JsonWriter = TJsonWriterFactory<TCHAR>::Create(&Json);
+    FJsonSerializer::Serialize(JsonMetrics, JsonWriter);
+    return Json;
+}
+
+FString FSpeechMetrics::GetSnapshotPath() {
+    const FString Path = CVarMetricsSnapshotPath.GetValueOnGameThread();
+    return Path.IsEmpty() ? FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Metrics"), TEXT("AmazonPollyMetrics.json")) : Path;
+}
+
+bool FSpeechMetrics::Tick(float DeltaTime) {
+    const double NowSeconds = FPlatformTime::Seconds();
+    if (NowSeconds >= NextStatsUpdateSeconds) {
+        NextStatsUpdateSeconds = NowSeconds + StatsIntervalSeconds;
+        LastSnapshot = GetSnapshot();
+#if STATS
+        SET_DWORD_STAT(STAT_PollyRequests, LastSnapshot.NumRequests);
+        SET_DWORD_STAT(STAT_PollyFailedRequests, LastSnapshot.NumFailedRequests);
+        SET_DWORD_STAT(STAT_PollyThrottledRequests, LastSnapshot.NumThrottledRequests);
+        SET_DWORD_STAT(STAT_PollyCancelledRequests, LastSnapshot.NumCancelledRequests);
+        SET_DWORD_STAT(STAT_PollyReceivedKB, LastSnapshot.BytesReceived / 1024);
+        SET_FLOAT_STAT(STAT_PollyRequestLatencyP50, ToMilliseconds(LastSnapshot.RequestLatency.GetPercentile(0.5)));
+        SET_FLOAT_STAT(STAT_PollyRequestLatencyP99, ToMilliseconds(LastSnapshot.RequestLatency.GetPercentile(0.99)));
+        SET_FLOAT_STAT(STAT_PollyQueueWaitP99, ToMilliseconds(LastSnapshot.QueueWait.GetPercentile(0.99)));
+        SET_FLOAT_STAT(STAT_PollyParseTimeP99, ToMilliseconds(LastSnapshot.ParseTime.GetPercentile(0.99)));
+        SET_FLOAT_STAT(STAT_PollyCacheHitRate, LastSnapshot.GetCacheHitRate() * 100.0);
+#endif
+    }
+    const float JsonSnapshotSeconds = CVarMetricsSnapshotSeconds.GetValueOnGameThread();
+    if (JsonSnapshotSeconds > 0.0f && NowSeconds >= NextJsonSnapshotSeconds) {
+        NextJsonSnapshotSeconds = NowSeconds + FMath::Max<double>(JsonSnapshotSeconds, MinJsonSnapshotSeconds);
+        // Only the formatting happens on the game thread, the file is written in the background
+        const FString Json = ToJson(GetSnapshot());
+        const FString Path = GetSnapshotPath();
+        Async(EAsyncExecution::ThreadPool, [Json, Path]() {
+            SaveSnapshotFile(Json, Path);
+        });
+    }
+    // The CSV profiler records a value per frame, it is given the last snapshot in between updates
+    CSV_CUSTOM_STAT(AmazonPolly, Requests, static_cast<int32>(LastSnapshot.NumRequests), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, FailedRequests, static_cast<int32>(LastSnapshot.NumFailedRequests), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, ThrottledRequests, static_cast<int32>(LastSnapshot.NumThrottledRequests), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, ReceivedKB, static_cast<int32>(LastSnapshot.BytesReceived / 1024), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, RequestLatencyP50Ms, static_cast<float>(ToMilliseconds(LastSnapshot.RequestLatency.GetPercentile(0.5))), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, RequestLatencyP99Ms, static_cast<float>(ToMilliseconds(LastSnapshot.RequestLatency.GetPercentile(0.99))), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, QueueWaitP99Ms, static_cast<float>(ToMilliseconds(LastSnapshot.QueueWait.GetPercentile(0.99))), ECsvCustomStatOp::Set);
+    CSV_CUSTOM_STAT(AmazonPolly, CacheHitRate, static_cast<float>(LastSnapshot.GetCacheHitRate()), ECsvCustomStatOp::Set);
+    return true;
+}
+
+void FSpeechMetrics::Dump() const {
+    const FSpeechMetricsSnapshot Snapshot = GetSnapshot();
+    UE_LOG(LogPollyMsg, Display, TEXT("Polly requests: %lld, %lld failed, %lld throttled, %lld cancelled, %.2f MB received"),
+        Snapshot.NumRequests, Snapshot.NumFailedRequests, Snapshot.NumThrottledRequests, Snapshot.NumCancelledRequests, Snapshot.BytesReceived / (1024.0 * 1024.0));
+    UE_LOG(LogPollyMsg, Display, TEXT("  Speech cache: %d hits, %d misses, %.1f%% hit rate"), Snapshot.NumCacheHits, Snapshot.NumCacheMisses, Snapshot.GetCacheHitRate() * 100.0);
+    LogHistogram(TEXT("Request latency"), Snapshot.RequestLatency);
+    LogHistogram(TEXT("Queue wait"), Snapshot.QueueWait);
+    LogHistogram(TEXT("Parse time"), Snapshot.ParseTime);
+    for (const FSpeechVoiceLatency& VoiceLatency : Snapshot.VoiceLatencies) {
+        LogHistogram(*FString::Printf(TEXT("%s (%s)"), *VoiceLatency.Voice, *VoiceLatency.Engine), VoiceLatency.Latency);
+    }
+}
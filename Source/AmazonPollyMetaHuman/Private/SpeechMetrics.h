@@ -0,0 +1,251 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+#include <aws/polly/model/SynthesizeSpeechRequest.h>
+
+struct PollyOutcome;
+
+/**
+* Copy of the counts of a FSpeechMetricHistogram at one moment
+*/
+struct FSpeechHistogramSnapshot {
+    uint64 Count = 0;
+    uint64 Sum = 0;
+    uint64 Max = 0;
+    /**
+    * Number of values recorded in each bucket, see FSpeechMetricHistogram::GetBucketIndex
+    */
+    TArray<uint64> Buckets;
+
+    /**
+    * Returns the value a fraction of the recorded values do not exceed, the middle of the bucket it falls in
+    * @param Fraction - the fraction, e.g. 0.99 for the 99th percentile
+    * @return double - the value, or 0 if nothing was recorded
+    */
+    double GetPercentile(double Fraction) const;
+    /**
+    * Returns the mean of the recorded values, or 0 if nothing was recorded
+    */
+    double GetMean() const;
+    /**
+    * Adds the counts of another snapshot to this one
+    */
+    void Merge(const FSpeechHistogramSnapshot& Other);
+};
+
+/**
+* Histogram of non-negative values with log-linear buckets: every power of two is split into 8 buckets of equal
+* width, so that any value from 1 to 2^64 is known to within 12.5% from 496 counters. Record is lock-free and
+* wait-free, so that it can be called from the threads sending requests without contending with each other.
+*/
+class FSpeechMetricHistogram {
+public:
+    static const int32 SubBucketBits = 3;
+    static const int32 NumSubBuckets = 1 << SubBucketBits;
+    static const int32 NumBuckets = (64 - SubBucketBits + 1) * NumSubBuckets;
+
+    FSpeechMetricHistogram();
+    /**
+    * Counts a value. Thread-safe.
+    */
+    void Record(uint64 Value);
+    /**
+    * Copies the counts. Thread-safe, while values are recorded the copy may be a few values behind.
+    */
+    FSpeechHistogramSnapshot GetSnapshot() const;
+    /**
+    * Returns the bucket a value is counted in
+    */
+    static int32 GetBucketIndex(uint64 Value);
+    /**
+    * Returns the smallest value counted in a bucket
+    */
+    static uint64 GetBucketLowerBound(int32 BucketIndex);
+
+private:
+    std::atomic<uint64> Buckets[NumBuckets];
+    std::atomic<uint64> Count;
+    std::atomic<uint64> Sum;
+    std::atomic<uint64> Max;
+};
+
+/**
+* Latency of the requests of one voice and engine
+*/
+struct FSpeechVoiceLatency {
+    FString Voice;
+    FString Engine;
+    /**
+    * Request latency in microseconds
+    */
+    FSpeechHistogramSnapshot Latency;
+};
+
+/**
+* The speech metrics at one moment, see FSpeechMetrics. Times are in microseconds.
+*/
+struct FSpeechMetricsSnapshot {
+    /**
+    * Requests that reached Polly, whether they succeeded or not
+    */
+    int64 NumRequests = 0;
+    /**
+    * Requests that failed on their own, including the throttled ones
+    */
+    int64 NumFailedRequests = 0;
+    /**
+    * Requests Polly rejected for exceeding the request rate of the account
+    */
+    int64 NumThrottledRequests = 0;
+    /**
+    * Requests aborted through their cancellation flag, before or while being sent
+    */
+    int64 NumCancelledRequests = 0;
+    /**
+    * Bytes of audio and speech marks received from Polly
+    */
+    int64 BytesReceived = 0;
+    int32 NumCacheHits = 0;
+    int32 NumCacheMisses = 0;
+    /**
+    * Time from sending a request to receiving its whole response, of the successful requests of all voices
+    */
+    FSpeechHistogramSnapshot RequestLatency;
+    /**
+    * Time requests waited in the FPollySynthesisScheduler before being sent
+    */
+    FSpeechHistogramSnapshot QueueWait;
+    /**
+    * Time taken to parse the speech marks of a response
+    */
+    FSpeechHistogramSnapshot ParseTime;
+    /**
+    * Request latency of every voice and engine that sent requests
+    */
+    TArray<FSpeechVoiceLatency> VoiceLatencies;
+
+    /**
+    * Returns the fraction of lookups the FSpeechCache answered, or 0 if there were none
+    */
+    double GetCacheHitRate() const;
+};
+
+/**
+* Counters and latency histograms of the requests to Polly for production monitoring. They are updated lock-free
+* from the threads sending requests, and exported on the game thread: every frame to the CSV profiler under the
+* AmazonPolly category, once a second to the "stat AmazonPolly" group, and every Polly.MetricsSnapshotSeconds to a
+* JSON file that monitoring agents can collect.
+*/
+class FSpeechMetrics {
+public:
+    /**
+    * Returns the metrics of all speech components
+    */
+    static FSpeechMetrics& Get();
+    /**
+    * Starts the periodic export. Called on module startup.
+    */
+    void Start();
+    /**
+    * Stops the periodic export, writing a last JSON snapshot if they are enabled. Called on module shutdown.
+    */
+    void Stop();
+    /**
+    * Counts a request that reached Polly. Thread-safe.
+    * @param SpeechRequest - the request
+    * @param LatencySeconds - the time from sending the request to receiving its whole response
+    * @param Outcome - the outcome of the request
+    */
+    void RecordRequest(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, double LatencySeconds, const PollyOutcome& Outcome);
+    /**
+    * Counts a request aborted through its cancellation flag. Thread-safe.
+    */
+    void RecordCancelledRequest();
+    /**
+    * Counts bytes received from Polly that do not end up in the StreamBuffer of an outcome, e.g. streamed audio.
+    * Thread-safe.
+    */
+    void RecordBytesReceived(int64 NumBytes);
+    /**
+    * Counts the time a request waited in the FPollySynthesisScheduler. Thread-safe.
+    */
+    void RecordQueueWait(double WaitSeconds);
+    /**
+    * Counts the time taken to parse the speech marks of a response. Thread-safe.
+    */
+    void RecordParseTime(double Seconds);
+    /**
+    * Returns all metrics. Thread-safe.
+    */
+    FSpeechMetricsSnapshot GetSnapshot() const;
+    /**
+    * Formats a snapshot as the JSON written by the periodic export
+    */
+    static FString ToJson(const FSpeechMetricsSnapshot& Snapshot);
+    /**
+    * Logs the metrics
+    */
+    void Dump() const;
+    /**
+    * Returns the path of the JSON snapshot set by Polly.MetricsSnapshotPath, or Saved/Metrics/AmazonPollyMetrics.json
+    */
+    static FString GetSnapshotPath();
+
+private:
+    /**
+    * Number of voice and engine pairs the latency is kept apart for. Voices the SDK adds beyond it only count
+    * towards the latency of all voices.
+    */
+    static const int32 MaxVoiceKeys = 256;
+
+    FSpeechMetrics();
+    ~FSpeechMetrics();
+    /**
+    * Exports the metrics, every frame
+    */
+    bool Tick(float DeltaTime);
+    /**
+    * Returns the latency histogram of a voice and engine, creating it on its first request
+    */
+    FSpeechMetricHistogram* GetVoiceLatency(int32 VoiceKey);
+
+    std::atomic<int64> NumRequests{0};
+    std::atomic<int64> NumFailedRequests{0};
+    std::atomic<int64> NumThrottledRequests{0};
+    std::atomic<int64> NumCancelledRequests{0};
+    std::atomic<int64> BytesReceived{0};
+    FSpeechMetricHistogram RequestLatency;
+    FSpeechMetricHistogram QueueWait;
+    FSpeechMetricHistogram ParseTime;
+    /**
+    * Latency histograms indexed by voice * 2 + engine, null until the voice sends a request
+    */
+    std::atomic<FSpeechMetricHistogram*> VoiceLatencies[MaxVoiceKeys];
+
+    FDelegateHandle TickerHandle;
+    /**
+    * Snapshot the stats and the CSV profiler are fed from between updates
+    */
+    FSpeechMetricsSnapshot LastSnapshot;
+    double NextStatsUpdateSeconds = 0.0;
+    double NextJsonSnapshotSeconds = 0.0;
+};
@@ -0,0 +1,109 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechPrefetchStore.h"
+#include "Misc/ScopeLock.h"
+
+bool FPrefetchedSpeech::IsReady() const {
+    return !Segments.ContainsByPredicate([](const FPendingSpeechSegment& Segment) {
+        return !Segment.IsReady();
+    });
+}
+
+FSpeechPrefetchStore& FSpeechPrefetchStore::Get() {
+    static FSpeechPrefetchStore SharedStore;
+    return SharedStore;
+}
+
+bool FSpeechPrefetchStore::Contains(const FString& Text, EVoiceId VoiceId) const {
+    FScopeLock lock(&Mutex);
+    return Find(Text, VoiceId) != INDEX_NONE;
+}
+
+bool FSpeechPrefetchStore::Add(TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched) {
+    FScopeLock lock(&Mutex);
+    if (Find(Prefetched->Text, Prefetched->VoiceId) != INDEX_NONE) {
+        return false;
+    }
+    if (Prefetches.Num() >= MaxPrefetchedSpeeches) {
+        DiscardAt(0);
+    }
+    Prefetches.Add(Prefetched);
+    Stats.NumPrefetches++;
+    return true;
+}
+
+TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe> FSpeechPrefetchStore::Take(const FString& Text, EVoiceId VoiceId) {
+    FScopeLock lock(&Mutex);
+    const int32 Index = Find(Text, VoiceId);
+    if (Index == INDEX_NONE) {
+        return nullptr;
+    }
+    TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched = Prefetches[Index];
+    Prefetches.RemoveAt(Index);
+    return Prefetched;
+}
+
+bool FSpeechPrefetchStore::Discard(const FString& Text, EVoiceId VoiceId) {
+    FScopeLock lock(&Mutex);
+    const int32 Index = Find(Text, VoiceId);
+    if (Index == INDEX_NONE) {
+        return false;
+    }
+    DiscardAt(Index);
+    return true;
+}
+
+void FSpeechPrefetchStore::Discard(const TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched) {
+    FScopeLock lock(&Mutex);
+    const int32 Index = Prefetches.IndexOfByKey(Prefetched);
+    if (Index != INDEX_NONE) {
+        DiscardAt(Index);
+    }
+    else {
+        // A speech that took the prefetch falls back to synthesizing the text itself
+        *Prefetched->CancellationFlag = true;
+    }
+}
+
+void FSpeechPrefetchStore::RecordLookup(bool bHit) {
+    FScopeLock lock(&Mutex);
+    if (bHit) {
+        Stats.NumHits++;
+    }
+    else {
+        Stats.NumMisses++;
+    }
+}
+
+FSpeechPrefetchStats FSpeechPrefetchStore::GetStats() const {
+    FScopeLock lock(&Mutex);
+    return Stats;
+}
+
+void FSpeechPrefetchStore::DiscardAt(int32 Index) {
+    *Prefetches[Index]->CancellationFlag = true;
+    Prefetches.RemoveAt(Index);
+    Stats.NumWasted++;
+}
+
+int32 FSpeechPrefetchStore::Find(const FString& Text, EVoiceId VoiceId) const {
+    return Prefetches.IndexOfByPredicate([&Text, VoiceId](const TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched) {
+        return Prefetched->VoiceId == VoiceId && Prefetched->Text.Equals(Text, ESearchCase::CaseSensitive);
+    });
+}
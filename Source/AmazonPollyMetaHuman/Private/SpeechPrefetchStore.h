@@ -0,0 +1,113 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpeechComponent.h"
+
+/**
+* A text synthesized ahead of time by USpeechComponent::PrefetchSpeech
+*/
+struct FPrefetchedSpeech {
+    FPrefetchedSpeech(const FString& InText, EVoiceId InVoiceId) :
+        Text(InText),
+        VoiceId(InVoiceId),
+        CancellationFlag(MakePollyCancellationFlag()) {
+    }
+    /**
+    * Returns true once every request of the text has returned
+    */
+    bool IsReady() const;
+    FString Text;
+    EVoiceId VoiceId;
+    /**
+    * Aborts the requests of this text only
+    */
+    PollyCancellationFlag CancellationFlag;
+    /**
+    * Requests of the segments of the text
+    */
+    TArray<FPendingSpeechSegment> Segments;
+};
+
+/**
+* Holds the texts prefetched by all speech components until a GenerateSpeech call for the same text and voice
+* takes them. The oldest prefetch is dropped once MaxPrefetchedSpeeches are stored.
+*/
+class FSpeechPrefetchStore {
+public:
+    /**
+    * Returns the store shared by all speech components
+    */
+    static FSpeechPrefetchStore& Get();
+    /**
+    * Returns true if a prefetch of the text and voice is stored
+    */
+    bool Contains(const FString& Text, EVoiceId VoiceId) const;
+    /**
+    * Stores a prefetch
+    * @param Prefetched - the prefetch, with its requests in flight
+    * @return bool - false if a prefetch of the same text and voice is stored already
+    */
+    bool Add(TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched);
+    /**
+    * Removes the prefetch of a text and voice, so that its results can be used by a speech
+    * @return TSharedPtr<FPrefetchedSpeech> - the prefetch, or null if there is none
+    */
+    TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe> Take(const FString& Text, EVoiceId VoiceId);
+    /**
+    * Removes the prefetch of a text and voice and aborts its requests
+    * @return bool - false if there is no such prefetch
+    */
+    bool Discard(const FString& Text, EVoiceId VoiceId);
+    /**
+    * Removes a prefetch if it is still stored and aborts its requests
+    */
+    void Discard(const TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe>& Prefetched);
+    /**
+    * Counts a GenerateSpeech call as a hit if it was served by a prefetch, as a miss otherwise
+    */
+    void RecordLookup(bool bHit);
+    /**
+    * Returns the counters of the store
+    */
+    FSpeechPrefetchStats GetStats() const;
+
+    /**
+    * Maximum number of prefetches stored at the same time
+    */
+    static const int32 MaxPrefetchedSpeeches = 32;
+
+private:
+    /**
+    * Removes the prefetch at Index, aborts its requests and counts it as wasted. Called with the Mutex held.
+    */
+    void DiscardAt(int32 Index);
+    /**
+    * Returns the index of the prefetch of a text and voice, or INDEX_NONE. Called with the Mutex held.
+    */
+    int32 Find(const FString& Text, EVoiceId VoiceId) const;
+
+    /**
+    * The stored prefetches, oldest first
+    */
+    TArray<TSharedRef<FPrefetchedSpeech, ESPMode::ThreadSafe>> Prefetches;
+    FSpeechPrefetchStats Stats;
+    mutable FCriticalSection Mutex;
+};
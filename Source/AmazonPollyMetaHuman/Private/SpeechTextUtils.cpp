@@ -0,0 +1,248 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechTextUtils.h"
+
+namespace {
+    bool IsSentenceTerminator(TCHAR Character) {
+        return Character == TEXT('.') || Character == TEXT('!') || Character == TEXT('?') || Character == 0x2026;
+    }
+
+    bool IsClauseTerminator(TCHAR Character) {
+        return Character == TEXT(',') || Character == TEXT(';') || Character == TEXT(':') || Character == 0x2013 || Character == 0x2014;
+    }
+
+    bool IsClosingPunctuation(TCHAR Character) {
+        return Character == TEXT('"') || Character == TEXT('\'') || Character == TEXT(')') || Character == TEXT(']') || Character == 0x2019 || Character == 0x201D;
+    }
+
+    /**
+    * Result of checking whether a terminator ends a piece of text
+    */
+    enum class EBoundary {
+        None,
+        Boundary,
+        // The text ends before it can be decided
+        Undecided
+    };
+
+    /**
+    * Checks whether the terminator at Index ends a piece of text, which requires it to be followed by
+    * whitespace (closing quotes and brackets stay with the piece they close). A sentence terminator followed
+    * by a lowercase word, as in "e.g. this", is not treated as a boundary.
+    * @param OutEnd - receives the index just past the piece
+    */
+    EBoundary CheckBoundary(const FString& Text, int32 Index, bool bIsSentenceTerminator, int32& OutEnd) {
+        OutEnd = Index + 1;
+        while (OutEnd < Text.Len() && IsClosingPunctuation(Text[OutEnd])) {
+            OutEnd++;
+        }
+        if (OutEnd == Text.Len()) {
+            return EBoundary::Undecided;
+        }
+        if (!FChar::IsWhitespace(Text[OutEnd])) {
+            return EBoundary::None;
+        }
+        if (!bIsSentenceTerminator) {
+            return EBoundary::Boundary;
+        }
+        int32 NextWord = OutEnd;
+        while (NextWord < Text.Len() && FChar::IsWhitespace(Text[NextWord])) {
+            NextWord++;
+        }
+        if (NextWord == Text.Len()) {
+            return EBoundary::Undecided;
+        }
+        return FChar::IsLower(Text[NextWord]) ? EBoundary::None : EBoundary::Boundary;
+    }
+
+    /**
+    * Splits text after every terminator that ends a piece, see CheckBoundary
+    */
+    TArray<FString> SplitAtBoundaries(const FString& Text, bool (*IsTerminator)(TCHAR)) {
+        TArray<FString> Pieces;
+        int32 Start = 0;
+        for (int32 Index = 0; Index < Text.Len(); Index++) {
+            int32 End;
+            if (!IsTerminator(Text[Index]) || CheckBoundary(Text, Index, IsTerminator == IsSentenceTerminator, End) == EBoundary::None) {
+                continue;
+            }
+            Pieces.Add(Text.Mid(Start, End - Start).TrimStartAndEnd());
+            Start = End;
+            Index = End - 1;
+        }
+        Pieces.Add(Text.Mid(Start).TrimStartAndEnd());
+        Pieces.RemoveAll([](const FString& Piece) { return Piece.IsEmpty(); });
+        return Pieces;
+    }
+
+    /**
+    * Splits a piece without any usable punctuation into chunks of at most MaxLength characters,
+    * cutting at the last whitespace before the limit whenever there is one
+    */
+    void SplitAtWhitespace(const FString& Piece, int32 MaxLength, TArray<FString>& OutSegments) {
+        FString Remaining = Piece;
+        while (Remaining.Len() > MaxLength) {
+            int32 Cut = MaxLength;
+            while (Cut > 0 && !FChar::IsWhitespace(Remaining[Cut])) {
+                Cut--;
+            }
+            if (Cut == 0) {
+                Cut = MaxLength;
+            }
+            OutSegments.Add(Remaining.Left(Cut).TrimEnd());
+            Remaining = Remaining.Mid(Cut).TrimStart();
+        }
+        if (!Remaining.IsEmpty()) {
+            OutSegments.Add(Remaining);
+        }
+    }
+
+    /**
+    * Appends Pieces to OutSegments, joining consecutive pieces as long as they fit into MaxLength
+    */
+    void PackPieces(const TArray<FString>& Pieces, int32 MaxLength, TArray<FString>& OutSegments) {
+        FString Segment;
+        for (const FString& Piece : Pieces) {
+            if (!Segment.IsEmpty() && Segment.Len() + 1 + Piece.Len() > MaxLength) {
+                OutSegments.Add(Segment);
+                Segment.Reset();
+            }
+            Segment = Segment.IsEmpty() ? Piece : Segment + TEXT(" ") + Piece;
+        }
+        if (!Segment.IsEmpty()) {
+            OutSegments.Add(Segment);
+        }
+    }
+}
+
+int32 SpeechTextUtils::EstimateSpeechMilliseconds(const FString& Text) {
+    // Roughly the default speaking rate of the English voices, about 14 letters per second
+    const int32 LetterMilliseconds = 70;
+    const int32 ClausePauseMilliseconds = 150;
+    const int32 SentencePauseMilliseconds = 300;
+    int32 Milliseconds = 0;
+    for (int32 Index = 0; Index < Text.Len(); Index++) {
+        const TCHAR Character = Text[Index];
+        if (FChar::IsAlnum(Character)) {
+            Milliseconds += LetterMilliseconds;
+        }
+        else if (IsClauseTerminator(Character)) {
+            Milliseconds += ClausePauseMilliseconds;
+        }
+        else if (IsSentenceTerminator(Character) && Index + 1 < Text.Len() && !IsSentenceTerminator(Text[Index + 1])) {
+            // The pause after the last sentence is not part of the speech
+            Milliseconds += SentencePauseMilliseconds;
+        }
+    }
+    return Milliseconds;
+}
+
+TArray<FString> SpeechTextUtils::SplitText(const FString& Text, int32 MaxSegmentLength, bool bSplitSentences) {
+    TArray<FString> Segments;
+    if (!bSplitSentences && Text.Len() <= MaxSegmentLength) {
+        Segments.Add(Text);
+        return Segments;
+    }
+    // Break every sentence down until no piece is longer than a segment
+    TArray<FString> Sentences;
+    for (const FString& Sentence : SplitAtBoundaries(Text, IsSentenceTerminator)) {
+        if (Sentence.Len() <= MaxSegmentLength) {
+            Sentences.Add(Sentence);
+            continue;
+        }
+        TArray<FString> Clauses;
+        for (const FString& Clause : SplitAtBoundaries(Sentence, IsClauseTerminator)) {
+            if (Clause.Len() <= MaxSegmentLength) {
+                Clauses.Add(Clause);
+            }
+            else {
+                SplitAtWhitespace(Clause, MaxSegmentLength, Clauses);
+            }
+        }
+        PackPieces(Clauses, MaxSegmentLength, Sentences);
+    }
+    if (bSplitSentences) {
+        return Sentences;
+    }
+    PackPieces(Sentences, MaxSegmentLength, Segments);
+    return Segments;
+}
+
+FSpeechPhraseSegmenter::FSpeechPhraseSegmenter(int32 InMinClauseLength, int32 InMaxPhraseLength) :
+    MinClauseLength(InMinClauseLength),
+    MaxPhraseLength(InMaxPhraseLength) {
+}
+
+void FSpeechPhraseSegmenter::Append(const FString& TextDelta, TArray<FString>& OutPhrases) {
+    Buffer += TextDelta;
+    while (true) {
+        int32 PhraseEnd = FindPhraseEnd();
+        if (PhraseEnd == INDEX_NONE) {
+            if (Buffer.Len() <= MaxPhraseLength) {
+                return;
+            }
+            // A phrase without any boundary is cut at the last whitespace that keeps it within a request
+            PhraseEnd = MaxPhraseLength;
+            while (PhraseEnd > 0 && !FChar::IsWhitespace(Buffer[PhraseEnd])) {
+                PhraseEnd--;
+            }
+            if (PhraseEnd == 0) {
+                PhraseEnd = MaxPhraseLength;
+            }
+        }
+        const FString Phrase = Buffer.Left(PhraseEnd).TrimStartAndEnd();
+        if (!Phrase.IsEmpty()) {
+            OutPhrases.Add(Phrase);
+        }
+        Buffer = Buffer.Mid(PhraseEnd);
+    }
+}
+
+void FSpeechPhraseSegmenter::Flush(TArray<FString>& OutPhrases) {
+    const FString Phrase = Buffer.TrimStartAndEnd();
+    if (!Phrase.IsEmpty()) {
+        OutPhrases.Add(Phrase);
+    }
+    Buffer.Reset();
+}
+
+void FSpeechPhraseSegmenter::Reset() {
+    Buffer.Reset();
+}
+
+int32 FSpeechPhraseSegmenter::FindPhraseEnd() const {
+    for (int32 Index = 0; Index < Buffer.Len(); Index++) {
+        const bool bIsSentenceTerminator = IsSentenceTerminator(Buffer[Index]);
+        // Clauses only end a phrase once it is long enough to be worth a request of its own
+        const bool bIsClauseTerminator = IsClauseTerminator(Buffer[Index]) && Index + 1 >= MinClauseLength;
+        if (!bIsSentenceTerminator && !bIsClauseTerminator) {
+            continue;
+        }
+        int32 End;
+        switch (CheckBoundary(Buffer, Index, bIsSentenceTerminator, End)) {
+        case EBoundary::Boundary:
+            return End;
+        case EBoundary::Undecided:
+            return INDEX_NONE;
+        default:
+            break;
+        }
+    }
+    return INDEX_NONE;
+}
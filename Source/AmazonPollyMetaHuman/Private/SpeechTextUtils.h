@@ -0,0 +1,88 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+namespace SpeechTextUtils {
+    /**
+    * Maximum number of characters Polly accepts in a single SynthesizeSpeech request
+    */
+    const int32 PollyMaxTextLength = 3000;
+    /**
+    * Splits text into segments that can each be synthesized by a separate Polly request.
+    * Segments end at sentence boundaries where possible; sentences longer than MaxSegmentLength
+    * are split at clause boundaries, then at whitespace, and only as a last resort mid-word.
+    * @param Text - the text to split
+    * @param MaxSegmentLength - the maximum number of characters in a segment
+    * @param bSplitSentences - if true every sentence becomes its own segment, otherwise sentences
+    * are packed together into as few segments as MaxSegmentLength allows
+    * @return the segments, in order
+    */
+    TArray<FString> SplitText(const FString& Text, int32 MaxSegmentLength, bool bSplitSentences);
+    /**
+    * Estimates how long Polly takes to speak a text at the default speaking rate, from its letters and the
+    * pauses of its punctuation
+    * @param Text - the text
+    * @return the estimated duration in milliseconds
+    */
+    int32 EstimateSpeechMilliseconds(const FString& Text);
+}
+
+/**
+* Cuts text that arrives piece by piece, e.g. token by token from a text generator, into phrases that can
+* be synthesized as soon as they are complete. A phrase ends at a sentence boundary, or at a clause boundary
+* once it is at least MinClauseLength characters long. A boundary is only accepted once the text following
+* it has arrived, so that "3." followed by "50" is not mistaken for the end of a sentence.
+*/
+class FSpeechPhraseSegmenter {
+public:
+    /**
+    * @param InMinClauseLength - minimum number of characters before a clause boundary ends a phrase
+    * @param InMaxPhraseLength - maximum number of characters in a phrase
+    */
+    explicit FSpeechPhraseSegmenter(int32 InMinClauseLength = 80, int32 InMaxPhraseLength = SpeechTextUtils::PollyMaxTextLength);
+    /**
+    * Appends text and returns the phrases it completed
+    * @param TextDelta - the text following the text appended so far
+    * @param OutPhrases - receives the completed phrases, in order
+    */
+    void Append(const FString& TextDelta, TArray<FString>& OutPhrases);
+    /**
+    * Returns the remaining text as the final phrase, once no more text will be appended
+    * @param OutPhrases - receives the final phrase, unless there is no remaining text
+    */
+    void Flush(TArray<FString>& OutPhrases);
+    /**
+    * Drops the remaining text
+    */
+    void Reset();
+
+private:
+    /**
+    * Returns the index just past the first complete phrase in the Buffer, or INDEX_NONE
+    */
+    int32 FindPhraseEnd() const;
+    /**
+    * Text appended since the last completed phrase
+    */
+    FString Buffer;
+    int32 MinClauseLength;
+    int32 MaxPhraseLength;
+};
@@ -0,0 +1,87 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechTrace.h"
+#include "Trace/Trace.inl"
+#include <atomic>
+
+UE_TRACE_CHANNEL_DEFINE(PollyChannel)
+
+UE_TRACE_EVENT_BEGIN(Polly, SpanBegin)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, UtteranceId)
+    UE_TRACE_EVENT_FIELD(uint8, Span)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(Polly, SpanEnd)
+    UE_TRACE_EVENT_FIELD(uint64, Cycle)
+    UE_TRACE_EVENT_FIELD(uint32, UtteranceId)
+    UE_TRACE_EVENT_FIELD(uint8, Span)
+UE_TRACE_EVENT_END()
+
+namespace {
+    std::atomic<uint32> LastUtteranceId(0);
+    thread_local uint32 ThreadUtteranceId = 0;
+}
+
+uint32 SpeechTrace::NewUtteranceId() {
+    uint32 UtteranceId = ++LastUtteranceId;
+    // 0 stands for no utterance, skipped when the counter wraps around
+    while (UtteranceId == 0) {
+        UtteranceId = ++LastUtteranceId;
+    }
+    return UtteranceId;
+}
+
+void SpeechTrace::BeginSpan(uint32 UtteranceId, ESpeechTraceSpan Span) {
+    if (UtteranceId != 0) {
+        UE_TRACE_LOG(Polly, SpanBegin, PollyChannel)
+            << SpanBegin.Cycle(FPlatformTime::Cycles64())
+            << SpanBegin.UtteranceId(UtteranceId)
+            << SpanBegin.Span(static_cast<uint8>(Span));
+    }
+}
+
+void SpeechTrace::EndSpan(uint32 UtteranceId, ESpeechTraceSpan Span) {
+    if (UtteranceId != 0) {
+        UE_TRACE_LOG(Polly, SpanEnd, PollyChannel)
+            << SpanEnd.Cycle(FPlatformTime::Cycles64())
+            << SpanEnd.UtteranceId(UtteranceId)
+            << SpanEnd.Span(static_cast<uint8>(Span));
+    }
+}
+
+uint32 SpeechTrace::GetThreadUtteranceId() {
+    return ThreadUtteranceId;
+}
+
+SpeechTrace::FUtteranceScope::FUtteranceScope(uint32 UtteranceId) : PreviousUtteranceId(ThreadUtteranceId) {
+    ThreadUtteranceId = UtteranceId;
+}
+
+SpeechTrace::FUtteranceScope::~FUtteranceScope() {
+    ThreadUtteranceId = PreviousUtteranceId;
+}
+
+SpeechTrace::FScopedSpan::FScopedSpan(uint32 InUtteranceId, ESpeechTraceSpan InSpan) : UtteranceId(InUtteranceId), Span(InSpan) {
+    BeginSpan(UtteranceId, Span);
+}
+
+SpeechTrace::FScopedSpan::~FScopedSpan() {
+    EndSpan(UtteranceId, Span);
+}
@@ -0,0 +1,118 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Trace.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+
+/**
+* Trace channel of the speech components, enabled with -trace=cpu,polly. It carries CPU events of the speech code
+* and the spans of every utterance, so that a single Unreal Insights capture shows where the time of a late line went.
+*/
+UE_TRACE_CHANNEL_EXTERN(PollyChannel)
+
+/**
+* Traces a CPU event over the rest of the scope on the Polly channel
+*/
+#define POLLY_TRACE_SCOPE(Name) TRACE_CPUPROFILER_EVENT_SCOPE_ON_CHANNEL(Name, PollyChannel)
+
+/**
+* Stages of the lifecycle of an utterance. Each is traced as a begin and an end event carrying the ID of the
+* utterance, since most of them start on one thread and end on another.
+*/
+enum class ESpeechTraceSpan : uint8 {
+    /**
+    * From the request of the speech until its audio starts, or until its generation fails
+    */
+    Utterance,
+    /**
+    * A latent GenerateSpeech call waiting for a worker of the thread pool to put its requests in flight
+    */
+    LatentAction,
+    /**
+    * GenerateSpeechSync synthesizing the speech
+    */
+    Synthesis,
+    /**
+    * A Polly request waiting for a worker of the FPollySynthesisScheduler
+    */
+    SchedulerWait,
+    /**
+    * A Polly request being sent by a worker of the FPollySynthesisScheduler
+    */
+    Request,
+    /**
+    * Generated speech waiting for its latent GenerateSpeech call to complete on the game thread
+    */
+    Handoff,
+    /**
+    * The speech playing, from StartSpeech until its last viseme or StopSpeech
+    */
+    Speaking
+};
+
+namespace SpeechTrace {
+    /**
+    * Returns a new utterance ID, never 0
+    */
+    uint32 NewUtteranceId();
+    /**
+    * Traces the beginning of a span of an utterance. Nothing is traced for the utterance ID 0.
+    * @param UtteranceId - the utterance
+    * @param Span - the stage of the utterance
+    */
+    void BeginSpan(uint32 UtteranceId, ESpeechTraceSpan Span);
+    /**
+    * Traces the end of a span of an utterance. Nothing is traced for the utterance ID 0.
+    * @param UtteranceId - the utterance
+    * @param Span - the stage of the utterance
+    */
+    void EndSpan(uint32 UtteranceId, ESpeechTraceSpan Span);
+    /**
+    * Returns the utterance of the calling thread set by a FUtteranceScope, or 0 if there is none
+    */
+    uint32 GetThreadUtteranceId();
+
+    /**
+    * Makes an utterance that of the calling thread while in scope, so that the GenerateSpeechSync call it makes
+    * continues the utterance rather than beginning a new one
+    */
+    class FUtteranceScope {
+    public:
+        explicit FUtteranceScope(uint32 UtteranceId);
+        ~FUtteranceScope();
+
+    private:
+        uint32 PreviousUtteranceId;
+    };
+
+    /**
+    * Traces a span of an utterance over its scope
+    */
+    class FScopedSpan {
+    public:
+        FScopedSpan(uint32 InUtteranceId, ESpeechTraceSpan InSpan);
+        ~FScopedSpan();
+
+    private:
+        uint32 UtteranceId;
+        ESpeechTraceSpan Span;
+    };
+}
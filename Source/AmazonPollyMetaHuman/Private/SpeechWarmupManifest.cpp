@@ -0,0 +1,144 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechWarmupManifest.h"
+#include "Dom/JsonObject.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "SpeechComponent.h"
+
+FSpeechWarmupManifest::FSpeechWarmupManifest(const FString& InPath, int32 InSaveInterval) :
+    Path(InPath),
+    SaveInterval(InSaveInterval),
+    NumUnsavedRecords(0)
+{
+}
+
+FString FSpeechWarmupManifest::MakeKey(const FString& Text, EVoiceId VoiceId) {
+    return FString::Printf(TEXT("%d|%s"), static_cast<int32>(VoiceId), *Text);
+}
+
+void FSpeechWarmupManifest::Record(const FString& Text, EVoiceId VoiceId) {
+    bool bSave = false;
+    {
+        FScopeLock lock(&Mutex);
+        FSpeechWarmupLine& Line = Lines.FindOrAdd(MakeKey(Text, VoiceId));
+        if (Line.Count == 0) {
+            Line.Text = Text;
+            Line.VoiceId = VoiceId;
+        }
+        Line.Count++;
+        NumUnsavedRecords++;
+        bSave = SaveInterval > 0 && NumUnsavedRecords >= SaveInterval;
+    }
+    if (bSave) {
+        Save();
+    }
+}
+
+TArray<FSpeechWarmupLine> FSpeechWarmupManifest::GetMostFrequentLines(int32 MaxLines) const {
+    TArray<FSpeechWarmupLine> MostFrequentLines;
+    {
+        FScopeLock lock(&Mutex);
+        Lines.GenerateValueArray(MostFrequentLines);
+    }
+    MostFrequentLines.Sort([](const FSpeechWarmupLine& A, const FSpeechWarmupLine& B) {
+        return A.Count > B.Count;
+    });
+    if (MostFrequentLines.Num() > MaxLines) {
+        MostFrequentLines.SetNum(FMath::Max(MaxLines, 0));
+    }
+    return MostFrequentLines;
+}
+
+bool FSpeechWarmupManifest::Load() {
+    if (!IFileManager::Get().FileExists(*Path)) {
+        return true;
+    }
+    FString Json;
+    if (!FFileHelper::LoadFileToString(Json, *Path)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Failed to read the speech warmup manifest %s."), *Path);
+        return false;
+    }
+    TSharedPtr<FJsonObject> Manifest;
+    TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(Json);
+    const TArray<TSharedPtr<FJsonValue>>* JsonLines = nullptr;
+    if (!FJsonSerializer::Deserialize(JsonReader, Manifest) || !Manifest.IsValid() || !Manifest->TryGetArrayField(TEXT("lines"), JsonLines)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Failed to parse the speech warmup manifest %s."), *Path);
+        return false;
+    }
+    const UEnum* VoiceIdEnum = StaticEnum<EVoiceId>();
+    FScopeLock lock(&Mutex);
+    for (const TSharedPtr<FJsonValue>& JsonLine : *JsonLines) {
+        const TSharedPtr<FJsonObject>* LineObject = nullptr;
+        FSpeechWarmupLine Line;
+        FString VoiceName;
+        if (!JsonLine->TryGetObject(LineObject) || !(*LineObject)->TryGetStringField(TEXT("text"), Line.Text) || !(*LineObject)->TryGetStringField(TEXT("voice"), VoiceName) || !(*LineObject)->TryGetNumberField(TEXT("count"), Line.Count)) {
+            continue;
+        }
+        // Voices are saved by name, so that the manifest survives changes of EVoiceId
+        const int64 VoiceValue = VoiceIdEnum->GetValueByNameString(VoiceName);
+        if (VoiceValue == INDEX_NONE || Line.Text.IsEmpty() || Line.Count <= 0) {
+            continue;
+        }
+        Line.VoiceId = static_cast<EVoiceId>(VoiceValue);
+        FSpeechWarmupLine& ExistingLine = Lines.FindOrAdd(MakeKey(Line.Text, Line.VoiceId));
+        Line.Count += ExistingLine.Count;
+        ExistingLine = Line;
+    }
+    return true;
+}
+
+bool FSpeechWarmupManifest::Save() {
+    FScopeLock SaveLock(&SaveMutex);
+    TArray<TSharedPtr<FJsonValue>> JsonLines;
+    {
+        FScopeLock lock(&Mutex);
+        if (NumUnsavedRecords == 0) {
+            return true;
+        }
+        NumUnsavedRecords = 0;
+        const UEnum* VoiceIdEnum = StaticEnum<EVoiceId>();
+        for (const TPair<FString, FSpeechWarmupLine>& Line : Lines) {
+            TSharedRef<FJsonObject> LineObject = MakeShared<FJsonObject>();
+            LineObject->SetStringField(TEXT("text"), Line.Value.Text);
+            LineObject->SetStringField(TEXT("voice"), VoiceIdEnum->GetNameStringByValue(static_cast<int64>(Line.Value.VoiceId)));
+            LineObject->SetNumberField(TEXT("count"), Line.Value.Count);
+            JsonLines.Add(MakeShared<FJsonValueObject>(LineObject));
+        }
+    }
+    TSharedRef<FJsonObject> Manifest = MakeShared<FJsonObject>();
+    Manifest->SetArrayField(TEXT("lines"), JsonLines);
+    FString Json;
+    TSharedRef<TJsonWriter<TCHAR>> JsonWriter = TJsonWriterFactory<TCHAR>::Create(&Json);
+    FJsonSerializer::Serialize(Manifest, JsonWriter);
+    // Written next to the manifest and renamed, so that a crash cannot leave a truncated manifest behind
+    const FString TempPath = Path + TEXT(".tmp");
+    IFileManager& FileManager = IFileManager::Get();
+    if (!FFileHelper::SaveStringToFile(Json, *TempPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM) || !FileManager.Move(*Path, *TempPath, true, true, false, true)) {
+        UE_LOG(LogPollyMsg, Warning, TEXT("Failed to write the speech warmup manifest %s."), *Path);
+        FileManager.Delete(*TempPath, false, false, true);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "VoiceId.h"
+
+/**
+* A line spoken in a map and the number of times it was spoken
+*/
+struct FSpeechWarmupLine {
+    FString Text;
+    EVoiceId VoiceId;
+    int32 Count = 0;
+};
+
+/**
+* Counts of the lines spoken in a map, kept in a json file so that the most frequent lines can be synthesized in
+* the background the next time the map is loaded. All functions are thread-safe.
+*/
+class FSpeechWarmupManifest {
+public:
+    /**
+    * @param InPath - the json file of the manifest
+    * @param InSaveInterval - the manifest is saved every this many recorded lines, 0 to only save it explicitly
+    */
+    FSpeechWarmupManifest(const FString& InPath, int32 InSaveInterval);
+    /**
+    * Counts a spoken line, saving the manifest every SaveInterval lines
+    * @param Text - the text of the line
+    * @param VoiceId - the voice of the line
+    */
+    void Record(const FString& Text, EVoiceId VoiceId);
+    /**
+    * Returns the most frequently spoken lines, most frequent first
+    * @param MaxLines - the maximum number of lines returned
+    * @return TArray<FSpeechWarmupLine> - the lines
+    */
+    TArray<FSpeechWarmupLine> GetMostFrequentLines(int32 MaxLines) const;
+    /**
+    * Reads the counts saved by a previous run, if any
+    * @return bool - false if the file exists but could not be read
+    */
+    bool Load();
+    /**
+    * Writes the counts, if any line was recorded since the last save. The file is replaced atomically.
+    * @return bool - false if the file could not be written
+    */
+    bool Save();
+    /**
+    * Returns the json file of the manifest
+    */
+    const FString& GetPath() const { return Path; }
+
+private:
+    /**
+    * Returns the key of a line in Lines
+    */
+    static FString MakeKey(const FString& Text, EVoiceId VoiceId);
+
+    const FString Path;
+    const int32 SaveInterval;
+    TMap<FString, FSpeechWarmupLine> Lines;
+    /**
+    * Number of lines recorded since the last save
+    */
+    int32 NumUnsavedRecords;
+    mutable FCriticalSection Mutex;
+    /**
+    * Serializes the writes of the file
+    */
+    FCriticalSection SaveMutex;
+};
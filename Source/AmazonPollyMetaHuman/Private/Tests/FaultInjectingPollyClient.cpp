@@ -0,0 +1,115 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "FaultInjectingPollyClient.h"
+
+namespace {
+    /**
+    * Visemes cycled through by the made up speech marks
+    */
+    const TCHAR* const SpeechMarkVisemes[] = { TEXT("p"), TEXT("t"), TEXT("S"), TEXT("T"), TEXT("f"), TEXT("k"), TEXT("i"), TEXT("r"), TEXT("s"), TEXT("u"), TEXT("@"), TEXT("a"), TEXT("e"), TEXT("E"), TEXT("o"), TEXT("O") };
+    const int32 SpeechMarkIntervalMs = 80;
+}
+
+const char* FaultInjectingPollyClient::ThrottlingErrorMessage = "ThrottlingException: Rate exceeded";
+
+FaultInjectingPollyClient::FaultInjectingPollyClient(const FPollyFaultConfig& InConfig) : Config(InConfig), Random(InConfig.Seed) {}
+
+int64 FaultInjectingPollyClient::GetNumRequests() const {
+    return NumRequests.GetValue();
+}
+
+int64 FaultInjectingPollyClient::GetNumThrottled() const {
+    return NumThrottled.GetValue();
+}
+
+MockSynthesizeSpeechBehavior FaultInjectingPollyClient::NextBehavior(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
+    NumRequests.Increment();
+    bool bThrottled = false;
+    MockSynthesizeSpeechBehavior Behavior;
+    {
+        FScopeLock lock(&RandomMutex);
+        bThrottled = Random.GetFraction() < Config.ThrottleRate;
+        Behavior.DelaySeconds = SampleLatencyMs() / 1000.0f;
+    }
+    if (bThrottled) {
+        NumThrottled.Increment();
+        Behavior.Outcome = []() {
+            PollyOutcome Outcome;
+            Outcome.IsSuccess = false;
+            Outcome.IsThrottled = true;
+            Outcome.PollyErrorMsg = ThrottlingErrorMessage;
+            return Outcome;
+        };
+        return Behavior;
+    }
+    const int32 DurationMs = FMath::Max<int32>(SpeechRequest.GetText().length(), 1) * Config.MillisecondsPerCharacter;
+    const bool bSpeechMarks = SpeechRequest.GetOutputFormat() == Aws::Polly::Model::OutputFormat::json;
+    // The response is made up on the worker thread, where the real one is read
+    Behavior.Outcome = [DurationMs, bSpeechMarks]() {
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = true;
+        Outcome.StreamBuffer = bSpeechMarks ? CreateSpeechMarks(DurationMs) : CreateAudio(DurationMs);
+        return Outcome;
+    };
+    return Behavior;
+}
+
+float FaultInjectingPollyClient::SampleLatencyMs() {
+    float LatencyMs = Config.MedianLatencyMs;
+    switch (Config.LatencyDistribution) {
+    case EPollyLatencyDistribution::Uniform:
+        LatencyMs = Random.FRandRange(Config.MinLatencyMs, Config.MaxLatencyMs);
+        break;
+    case EPollyLatencyDistribution::LogNormal: {
+        // Box-Muller transform of two uniform fractions into a standard normal one
+        const float Uniform1 = 1.0f - Random.GetFraction();
+        const float Uniform2 = Random.GetFraction();
+        const float Normal = FMath::Sqrt(-2.0f * FMath::Loge(Uniform1)) * FMath::Cos(2.0f * PI * Uniform2);
+        LatencyMs = Config.MedianLatencyMs * FMath::Exp(Config.LatencySigma * Normal);
+        break;
+    }
+    default:
+        break;
+    }
+    return FMath::Clamp(LatencyMs, 0.0f, Config.MaxLatencyMs);
+}
+
+FPollyAudioBuffer FaultInjectingPollyClient::CreateAudio(int32 DurationMs) {
+    // 16 kHz 16-bit mono pcm, a 200 Hz triangle wave so that the intensity of the speech is not flat
+    const int32 NumSamples = DurationMs * 16;
+    TArray<uint8> Audio;
+    Audio.SetNumUninitialized(NumSamples * sizeof(int16));
+    int16* Samples = reinterpret_cast<int16*>(Audio.GetData());
+    for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++) {
+        const int32 Phase = SampleIndex % 80;
+        Samples[SampleIndex] = static_cast<int16>((Phase < 40 ? Phase : 80 - Phase) * 400 - 8000);
+    }
+    return PollyAudioBuffer::Make(MoveTemp(Audio));
+}
+
+FPollyAudioBuffer FaultInjectingPollyClient::CreateSpeechMarks(int32 DurationMs) {
+    FString SpeechMarks;
+    int32 VisemeIndex = 0;
+    for (int32 TimeMs = 0; TimeMs < DurationMs; TimeMs += SpeechMarkIntervalMs) {
+        SpeechMarks += FString::Printf(TEXT("{\"time\":%d,\"type\":\"viseme\",\"value\":\"%s\"}\n"), TimeMs, SpeechMarkVisemes[VisemeIndex++ % UE_ARRAY_COUNT(SpeechMarkVisemes)]);
+    }
+    SpeechMarks += FString::Printf(TEXT("{\"time\":%d,\"type\":\"viseme\",\"value\":\"sil\"}"), DurationMs);
+    FTCHARToUTF8 Utf8(*SpeechMarks);
+    return PollyAudioBuffer::Make(TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()));
+}
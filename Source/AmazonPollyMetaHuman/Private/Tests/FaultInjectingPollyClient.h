@@ -0,0 +1,131 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "MockPollyClient.h"
+#include "Math/RandomStream.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+/**
+* Distribution of the round trip times simulated by a FaultInjectingPollyClient
+*/
+enum class EPollyLatencyDistribution : uint8 {
+    /**
+    * Every request takes MedianLatencyMs
+    */
+    Constant,
+    /**
+    * Requests take between MinLatencyMs and MaxLatencyMs
+    */
+    Uniform,
+    /**
+    * Requests take a log-normal time around MedianLatencyMs, with the long tail of requests sent over the internet
+    */
+    LogNormal
+};
+
+/**
+* Latencies and faults injected by a FaultInjectingPollyClient
+*/
+struct FPollyFaultConfig {
+    EPollyLatencyDistribution LatencyDistribution = EPollyLatencyDistribution::LogNormal;
+    float MedianLatencyMs = 150.0f;
+    float MinLatencyMs = 50.0f;
+    /**
+    * Longest round trip time, whatever the distribution
+    */
+    float MaxLatencyMs = 2000.0f;
+    /**
+    * Standard deviation of the logarithm of a LogNormal latency. At 0.5 the 99th percentile is about 3.2 times the median.
+    */
+    float LatencySigma = 0.5f;
+    /**
+    * Fraction of the requests that fail with a throttling error, from 0 to 1
+    */
+    float ThrottleRate = 0.0f;
+    /**
+    * Milliseconds of speech synthesized per character of text
+    */
+    int32 MillisecondsPerCharacter = 65;
+    /**
+    * Seed of the random latencies and faults, so that a run can be repeated
+    */
+    int32 Seed = 0;
+};
+
+/**
+* MockPollyClient that makes up the response of every request instead of dequeuing behaviors, for load tests that
+* issue more requests than can be queued up front. Audio requests receive pcm audio and speech mark requests receive
+* visemes, as long as the text takes to speak. Every request takes a random round trip time, and fails with a
+* throttling error at the configured rate like Polly does under load. The texts of the requests are not recorded.
+*/
+class FaultInjectingPollyClient : public MockPollyClient {
+
+public:
+    /**
+    * @param InConfig - the latencies and faults to inject
+    */
+    explicit FaultInjectingPollyClient(const FPollyFaultConfig& InConfig);
+    /**
+    * Returns the number of requests issued so far
+    */
+    int64 GetNumRequests() const;
+    /**
+    * Returns the number of requests that failed with a throttling error so far
+    */
+    int64 GetNumThrottled() const;
+    /**
+    * Error message of the throttled requests
+    */
+    static const char* ThrottlingErrorMessage;
+
+protected:
+    /**
+    * Makes up the behavior of a request: its round trip time and either a response or a throttling error
+    * @param - SpeechRequest, the request being issued
+    * @return - the behavior
+    */
+    virtual MockSynthesizeSpeechBehavior NextBehavior(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) override;
+
+private:
+    /**
+    * Draws a round trip time from the distribution of the configuration. Called with the RandomMutex held.
+    * @return - the round trip time, in milliseconds
+    */
+    float SampleLatencyMs();
+    /**
+    * Creates pcm audio of a tone
+    * @param DurationMs - the length of the audio
+    */
+    static FPollyAudioBuffer CreateAudio(int32 DurationMs);
+    /**
+    * Creates the speech marks of a speech, with a viseme every 80 ms
+    * @param DurationMs - the length of the speech
+    */
+    static FPollyAudioBuffer CreateSpeechMarks(int32 DurationMs);
+
+    const FPollyFaultConfig Config;
+    FRandomStream Random;
+    /**
+    * Mutex guarding Random against concurrent requests
+    */
+    FCriticalSection RandomMutex;
+    FThreadSafeCounter64 NumRequests;
+    FThreadSafeCounter64 NumThrottled;
+};
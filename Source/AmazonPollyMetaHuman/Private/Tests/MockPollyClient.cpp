@@ -17,16 +17,84 @@
  */
 
 #include "MockPollyClient.h"
+#include "PollySynthesisScheduler.h"
 
 MockPollyClient::~MockPollyClient() {};
 
 PollyOutcome MockPollyClient::SynthesizeSpeech(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
-    (void)SpeechRequest;
-    TFunction<PollyOutcome()> SynthesizeSpeechLambda;
-    SynthesizeSpeechBehaviors.Dequeue(SynthesizeSpeechLambda);
-    return SynthesizeSpeechLambda();
+    MockSynthesizeSpeechBehavior Behavior = NextBehavior(SpeechRequest);
+    SimulateDelay(Behavior.DelaySeconds, MakePollyCancellationFlag());
+    return Behavior.Outcome();
 };
 
-void MockPollyClient::AddSynthesizeSpeechBehavior(TFunction<PollyOutcome()> SynthesizeSpeechLambda) {
-    SynthesizeSpeechBehaviors.Enqueue(SynthesizeSpeechLambda);
+TFuture<PollyOutcome> MockPollyClient::SynthesizeSpeechAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) {
+    MockSynthesizeSpeechBehavior Behavior = NextBehavior(SpeechRequest);
+    return FPollySynthesisScheduler::Get().Schedule(Scheduling, CancellationFlag, [Behavior, SpeechRequest, CancellationFlag]() {
+        return RunBehavior(Behavior, SpeechRequest, CancellationFlag);
+    });
+}
+
+TFuture<PollyOutcome> MockPollyClient::SynthesizeSpeechStreamAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) {
+    MockSynthesizeSpeechBehavior Behavior = NextBehavior(SpeechRequest);
+    const int32 ChunkBytes = StreamChunkBytes;
+    return FPollySynthesisScheduler::Get().Schedule(Scheduling, CancellationFlag, [Behavior, SpeechRequest, RingBuffer, CancellationFlag, ChunkBytes]() {
+        PollyOutcome Outcome = RunBehavior(Behavior, SpeechRequest, CancellationFlag);
+        for (int32 Offset = 0; Outcome.IsSuccess && Offset < Outcome.StreamBuffer->Num(); Offset += ChunkBytes) {
+            const int32 NumBytes = FMath::Min(ChunkBytes, Outcome.StreamBuffer->Num() - Offset);
+            RingBuffer->WriteAll(Outcome.StreamBuffer->GetData() + Offset, NumBytes);
+        }
+        Outcome.StreamBuffer = PollyAudioBuffer::GetEmpty();
+        return Outcome;
+    });
+}
+
+PollyOutcome MockPollyClient::RunBehavior(const MockSynthesizeSpeechBehavior& Behavior, const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const PollyCancellationFlag& CancellationFlag) {
+    return SynthesizeCancellable(SpeechRequest, [&Behavior, &CancellationFlag]() {
+        if (!SimulateDelay(Behavior.DelaySeconds, CancellationFlag)) {
+            PollyOutcome AbortedOutcome;
+            AbortedOutcome.IsSuccess = false;
+            AbortedOutcome.PollyErrorMsg = "Request aborted";
+            return AbortedOutcome;
+        }
+        return Behavior.Outcome();
+    }, CancellationFlag);
+}
+
+void MockPollyClient::AddSynthesizeSpeechBehavior(TFunction<PollyOutcome()> SynthesizeSpeechLambda, float DelaySeconds) {
+    FScopeLock lock(&BehaviorsMutex);
+    SynthesizeSpeechBehaviors.Enqueue({ SynthesizeSpeechLambda, DelaySeconds });
+}
+
+TArray<FString> MockPollyClient::GetRequestedAudioTexts() {
+    FScopeLock lock(&BehaviorsMutex);
+    return RequestedAudioTexts;
+}
+
+TArray<FString> MockPollyClient::GetRequestedVisemeTexts() {
+    FScopeLock lock(&BehaviorsMutex);
+    return RequestedVisemeTexts;
+}
+
+MockSynthesizeSpeechBehavior MockPollyClient::NextBehavior(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) {
+    FScopeLock lock(&BehaviorsMutex);
+    if (SpeechRequest.GetOutputFormat() != Aws::Polly::Model::OutputFormat::json) {
+        RequestedAudioTexts.Add(UnrealAWSUtils::AwsStringToFString(SpeechRequest.GetText()));
+    }
+    else {
+        RequestedVisemeTexts.Add(UnrealAWSUtils::AwsStringToFString(SpeechRequest.GetText()));
+    }
+    MockSynthesizeSpeechBehavior Behavior;
+    SynthesizeSpeechBehaviors.Dequeue(Behavior);
+    return Behavior;
+}
+
+bool MockPollyClient::SimulateDelay(float DelaySeconds, const PollyCancellationFlag& CancellationFlag) {
+    const double EndTime = FPlatformTime::Seconds() + DelaySeconds;
+    while (FPlatformTime::Seconds() < EndTime) {
+        if (*CancellationFlag) {
+            return false;
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+    return true;
 }
@@ -20,6 +20,20 @@
 
 #include "PollyClient.h"
 
+/**
+* A mocked response to a single call to SynthesizeSpeech
+*/
+struct MockSynthesizeSpeechBehavior {
+    /**
+    * Lambda returning the custom PollyOutcome object
+    */
+    TFunction<PollyOutcome()> Outcome;
+    /**
+    * Simulated round trip time of the call, in seconds
+    */
+    float DelaySeconds = 0.0f;
+};
+
 /**
 * Overrides PollyClient class methods to avoid calling on AWS SDK 
 * UTestableSpeechComponent uses this derived class instead of PollyClient 
@@ -31,16 +45,86 @@ public:
     virtual ~MockPollyClient();
     /**
     * Simulates a call to the Polly SDK (SynthesizeSpeech) 
-    * @param - SpeechRequest, not used since SDK not called
+    * @param - SpeechRequest, only recorded since SDK not called
     * @return - a custom PollyOutcome object
     */
     virtual PollyOutcome SynthesizeSpeech(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest) override;
     /**
+    * Simulates an asynchronous call to the Polly SDK. The behavior is dequeued on the calling thread,
+    * so behaviors are matched to requests in the order the requests are issued. The simulated delay
+    * runs on the FPollySynthesisScheduler and is interrupted as soon as the CancellationFlag is raised,
+    * like an aborted HTTP transfer.
+    * @param - SpeechRequest, only recorded since SDK not called
+    * @param - Scheduling, the priority and deadline of the request
+    * @param - CancellationFlag, the flag shared by the request group
+    * @return - a future fulfilled with the custom PollyOutcome object
+    */
+    virtual TFuture<PollyOutcome> SynthesizeSpeechAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) override;
+    /**
+    * Simulates a streamed call to the Polly SDK. Like SynthesizeSpeechAsync, but the StreamBuffer of the
+    * custom PollyOutcome object is written into the ring buffer in chunks of StreamChunkBytes.
+    * @param - SpeechRequest, only recorded since SDK not called
+    * @param - RingBuffer, the ring buffer receiving the audio
+    * @param - Scheduling, the priority and deadline of the request
+    * @param - CancellationFlag, the flag shared by the request group
+    * @return - a future fulfilled with the custom PollyOutcome object, without its StreamBuffer
+    */
+    virtual TFuture<PollyOutcome> SynthesizeSpeechStreamAsync(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, const FPollyRequestScheduling& Scheduling, PollyCancellationFlag CancellationFlag) override;
+    /**
+    * Size of the chunks written into the ring buffer by SynthesizeSpeechStreamAsync
+    */
+    int32 StreamChunkBytes = 4096;
+    /**
     * A queue containing lambdas for returning custom PollyOutcome objects in SynthesizeSpeech 
     */
-    TQueue<TFunction<PollyOutcome()>> SynthesizeSpeechBehaviors;
+    TQueue<MockSynthesizeSpeechBehavior> SynthesizeSpeechBehaviors;
     /**
     * Adds a modification to behavior of SynthesizeSpeech for use in mocking calls to Polly API 
+    * @param SynthesizeSpeechBehavior - lambda returning the custom PollyOutcome object
+    * @param DelaySeconds - simulated round trip time of the call
     */  
-    void AddSynthesizeSpeechBehavior(TFunction<PollyOutcome()> SynthesizeSpeechBehavior);
-};
\ No newline at end of file
+    void AddSynthesizeSpeechBehavior(TFunction<PollyOutcome()> SynthesizeSpeechBehavior, float DelaySeconds = 0.0f);
+    /**
+    * Returns the texts of the requests for audio (as opposed to speech marks), in the order they were issued
+    * @return - the texts
+    */
+    TArray<FString> GetRequestedAudioTexts();
+    /**
+    * Returns the texts of the requests for speech marks, in the order they were issued
+    * @return - the texts
+    */
+    TArray<FString> GetRequestedVisemeTexts();
+
+protected:
+    /**
+    * Records the request and dequeues the next behavior. Requests may be issued from several threads at once.
+    * Derived clients override it to make up the behavior of each request instead.
+    * @param - SpeechRequest, the request being issued
+    * @return - the next behavior
+    */
+    virtual MockSynthesizeSpeechBehavior NextBehavior(const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest);
+
+private:
+    /**
+    * Runs a behavior under the rules of the CancellationFlag, simulating its delay
+    * @return - the custom PollyOutcome object, or an aborted outcome
+    */
+    static PollyOutcome RunBehavior(const MockSynthesizeSpeechBehavior& Behavior, const Aws::Polly::Model::SynthesizeSpeechRequest& SpeechRequest, const PollyCancellationFlag& CancellationFlag);
+    /**
+    * Sleeps for the behavior's delay, waking up early if the CancellationFlag is raised
+    * @return - false if the delay was interrupted by the CancellationFlag
+    */
+    static bool SimulateDelay(float DelaySeconds, const PollyCancellationFlag& CancellationFlag);
+    /**
+    * Mutex guarding SynthesizeSpeechBehaviors and the requested texts against concurrent requests
+    */
+    FCriticalSection BehaviorsMutex;
+    /**
+    * Texts of the requests for audio, in the order they were issued
+    */
+    TArray<FString> RequestedAudioTexts;
+    /**
+    * Texts of the requests for speech marks, in the order they were issued
+    */
+    TArray<FString> RequestedVisemeTexts;
+};
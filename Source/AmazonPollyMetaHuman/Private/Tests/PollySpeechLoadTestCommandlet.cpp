@@ -0,0 +1,124 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "PollySpeechLoadTestCommandlet.h"
+#include "SpeechLoadTest.h"
+#include "SpeechComponent.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Misc/App.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+UPollySpeechLoadTestCommandlet::UPollySpeechLoadTestCommandlet() {
+    IsClient = false;
+    IsServer = false;
+    IsEditor = false;
+    LogToConsole = true;
+}
+
+int32 UPollySpeechLoadTestCommandlet::Main(const FString& Params) {
+    FSpeechLoadTestConfig Config;
+    FString Latency;
+    float FrameRate = 60.0f;
+    FString ReportPath = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("LoadTests"), TEXT("AmazonPollySpeechLoad.json"));
+    FParse::Value(*Params, TEXT("Speakers="), Config.NumSpeakers);
+    FParse::Value(*Params, TEXT("Seconds="), Config.DurationSeconds);
+    FParse::Value(*Params, TEXT("FrameRate="), FrameRate);
+    FParse::Value(*Params, TEXT("Latency="), Latency);
+    FParse::Value(*Params, TEXT("MedianLatencyMs="), Config.Faults.MedianLatencyMs);
+    FParse::Value(*Params, TEXT("MinLatencyMs="), Config.Faults.MinLatencyMs);
+    FParse::Value(*Params, TEXT("MaxLatencyMs="), Config.Faults.MaxLatencyMs);
+    FParse::Value(*Params, TEXT("LatencySigma="), Config.Faults.LatencySigma);
+    FParse::Value(*Params, TEXT("ThrottleRate="), Config.Faults.ThrottleRate);
+    FParse::Value(*Params, TEXT("MinLineChars="), Config.MinLineChars);
+    FParse::Value(*Params, TEXT("MaxLineChars="), Config.MaxLineChars);
+    FParse::Value(*Params, TEXT("Seed="), Config.Faults.Seed);
+    FParse::Value(*Params, TEXT("Report="), ReportPath);
+    Config.bPipelineSentences = FParse::Param(*Params, TEXT("PipelineSentences"));
+    Config.FrameSeconds = 1.0f / FMath::Max(FrameRate, 1.0f);
+    if (Latency.IsEmpty() || Latency == TEXT("LogNormal")) {
+        Config.Faults.LatencyDistribution = EPollyLatencyDistribution::LogNormal;
+    }
+    else if (Latency == TEXT("Uniform")) {
+        Config.Faults.LatencyDistribution = EPollyLatencyDistribution::Uniform;
+    }
+    else if (Latency == TEXT("Constant")) {
+        Config.Faults.LatencyDistribution = EPollyLatencyDistribution::Constant;
+    }
+    else {
+        UE_LOG(LogPollyMsg, Error, TEXT("Unknown latency distribution %s, expected LogNormal, Uniform or Constant."), *Latency);
+        return 1;
+    }
+
+    UE_LOG(LogPollyMsg, Display, TEXT("Running %d speakers for %.0f seconds..."), Config.NumSpeakers, Config.DurationSeconds);
+    const FSpeechLoadTestResult Result = SpeechLoadTest::Run(Config);
+    UE_LOG(LogPollyMsg, Display, TEXT("%s"), *SpeechLoadTest::ToString(Result));
+
+    TSharedRef<FJsonObject> JsonConfig = MakeShared<FJsonObject>();
+    JsonConfig->SetNumberField(TEXT("speakers"), Result.NumSpeakers);
+    JsonConfig->SetNumberField(TEXT("seconds"), Config.DurationSeconds);
+    JsonConfig->SetNumberField(TEXT("frame_rate"), FrameRate);
+    JsonConfig->SetStringField(TEXT("latency"), Latency.IsEmpty() ? TEXT("LogNormal") : Latency);
+    JsonConfig->SetNumberField(TEXT("median_latency_ms"), Config.Faults.MedianLatencyMs);
+    JsonConfig->SetNumberField(TEXT("min_latency_ms"), Config.Faults.MinLatencyMs);
+    JsonConfig->SetNumberField(TEXT("max_latency_ms"), Config.Faults.MaxLatencyMs);
+    JsonConfig->SetNumberField(TEXT("latency_sigma"), Config.Faults.LatencySigma);
+    JsonConfig->SetNumberField(TEXT("throttle_rate"), Config.Faults.ThrottleRate);
+    JsonConfig->SetNumberField(TEXT("min_line_chars"), Config.MinLineChars);
+    JsonConfig->SetNumberField(TEXT("max_line_chars"), Config.MaxLineChars);
+    JsonConfig->SetNumberField(TEXT("seed"), Config.Faults.Seed);
+    JsonConfig->SetBoolField(TEXT("pipeline_sentences"), Config.bPipelineSentences);
+    TSharedRef<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+    JsonResult->SetNumberField(TEXT("elapsed_seconds"), Result.ElapsedSeconds);
+    JsonResult->SetNumberField(TEXT("lines_spoken"), Result.NumSpoken);
+    JsonResult->SetNumberField(TEXT("lines_failed"), Result.NumFailed);
+    JsonResult->SetNumberField(TEXT("requests"), Result.NumRequests);
+    JsonResult->SetNumberField(TEXT("requests_throttled"), Result.NumThrottled);
+    JsonResult->SetNumberField(TEXT("lines_per_second"), Result.LinesPerSecond);
+    JsonResult->SetNumberField(TEXT("requests_per_second"), Result.RequestsPerSecond);
+    JsonResult->SetNumberField(TEXT("time_to_first_audio_p50_ms"), Result.TimeToFirstAudioP50Ms);
+    JsonResult->SetNumberField(TEXT("time_to_first_audio_p95_ms"), Result.TimeToFirstAudioP95Ms);
+    JsonResult->SetNumberField(TEXT("time_to_first_audio_p99_ms"), Result.TimeToFirstAudioP99Ms);
+    JsonResult->SetNumberField(TEXT("time_to_first_audio_max_ms"), Result.TimeToFirstAudioMaxMs);
+    JsonResult->SetNumberField(TEXT("mean_worker_occupancy"), Result.MeanWorkerOccupancy);
+    JsonResult->SetNumberField(TEXT("peak_worker_occupancy"), Result.PeakWorkerOccupancy);
+    JsonResult->SetNumberField(TEXT("game_thread_p50_ms"), Result.GameThreadP50Ms);
+    JsonResult->SetNumberField(TEXT("game_thread_p99_ms"), Result.GameThreadP99Ms);
+    JsonResult->SetNumberField(TEXT("game_thread_max_ms"), Result.GameThreadMaxMs);
+    JsonResult->SetNumberField(TEXT("frames"), Result.NumFrames);
+    TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+    Report->SetStringField(TEXT("engine_version"), FEngineVersion::Current().ToString());
+    Report->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+    Report->SetStringField(TEXT("configuration"), LexToString(FApp::GetBuildConfiguration()));
+    Report->SetStringField(TEXT("cpu"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+    Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+    Report->SetObjectField(TEXT("config"), JsonConfig);
+    Report->SetObjectField(TEXT("results"), JsonResult);
+    FString Json;
+    TSharedRef<TJsonWriter<TCHAR>> JsonWriter = TJsonWriterFactory<TCHAR>::Create(&Json);
+    FJsonSerializer::Serialize(Report, JsonWriter);
+    if (!FFileHelper::SaveStringToFile(Json, *ReportPath, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)) {
+        UE_LOG(LogPollyMsg, Error, TEXT("Failed to write the load test report to %s."), *ReportPath);
+        return 1;
+    }
+    UE_LOG(LogPollyMsg, Display, TEXT("Load test report written to %s."), *ReportPath);
+    return 0;
+}
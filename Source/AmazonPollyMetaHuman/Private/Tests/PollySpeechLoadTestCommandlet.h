@@ -0,0 +1,48 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "PollySpeechLoadTestCommandlet.generated.h"
+
+/**
+* Runs the load test of SpeechLoadTest::Run: virtual speakers generating and speaking lines at once, against Polly
+* clients that inject latency and throttling errors instead of calling Polly. Needs neither network access nor
+* credentials, so it runs headless on build machines.
+*
+* Usage: UE4Editor-Cmd <project> -run=PollySpeechLoadTest [-Speakers=100] [-Seconds=30] [-FrameRate=60]
+*     [-Latency=LogNormal|Uniform|Constant] [-MedianLatencyMs=150] [-MinLatencyMs=50] [-MaxLatencyMs=2000]
+*     [-LatencySigma=0.5] [-ThrottleRate=0] [-MinLineChars=20] [-MaxLineChars=200] [-Seed=0]
+*     [-PipelineSentences] [-Report=<json file>] -nullrhi -nosound
+*
+* The results are logged and written as JSON to -Report, by default Saved/LoadTests/AmazonPollySpeechLoad.json.
+*/
+UCLASS()
+class UPollySpeechLoadTestCommandlet : public UCommandlet {
+    GENERATED_BODY()
+
+public:
+    UPollySpeechLoadTestCommandlet();
+    /**
+    * Runs the load test. See UCommandlet::Main for details.
+    * @return int32 - 0 if the report is written
+    */
+    virtual int32 Main(const FString& Params) override;
+};
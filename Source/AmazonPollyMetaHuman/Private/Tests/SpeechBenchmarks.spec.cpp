@@ -0,0 +1,587 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+#include "TestableSpeechComponent.h"
+#include "PollyResponseStream.h"
+#include "SpeechMarkParser.h"
+#include "SpeechLoadTest.h"
+#include "Dom/JsonObject.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
+#include "Misc/EngineVersion.h"
+#include "Misc/App.h"
+#include "UnrealAWSUtils.h"
+#include <atomic>
+
+namespace {
+    /**
+    * Size of the audio of a long utterance, 2 MB or about a minute of speech
+    */
+    const int32 UtteranceBytes = 2 * 1024 * 1024;
+    /**
+    * Size of the chunks the HTTP client writes a response in
+    */
+    const int32 ResponseChunkBytes = 16 * 1024;
+    /**
+    * Allocations from this size on are counted, which covers every allocation holding audio while leaving out the
+    * small allocations of other threads running meanwhile
+    */
+    const SIZE_T CountedAllocationBytes = 64 * 1024;
+
+    /**
+    * Allocator counting the allocations from a size on made through GMalloc while it is installed. Every
+    * allocation and reallocation holding audio is counted, as each one is filled by copying the audio.
+    */
+    class FCountingMalloc : public FMalloc {
+    public:
+        explicit FCountingMalloc(FMalloc* InInner) : Inner(InInner), MinBytes(CountedAllocationBytes), NumAllocations(0), NumBytes(0) {}
+
+        virtual void* Malloc(SIZE_T Count, uint32 Alignment) override {
+            Record(Count);
+            return Inner->Malloc(Count, Alignment);
+        }
+
+        virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override {
+            Record(Count);
+            return Inner->Realloc(Original, Count, Alignment);
+        }
+
+        virtual void Free(void* Original) override {
+            Inner->Free(Original);
+        }
+
+        virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override {
+            return Inner->QuantizeSize(Count, Alignment);
+        }
+
+        virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override {
+            return Inner->GetAllocationSize(Original, SizeOut);
+        }
+
+        virtual bool IsInternallyThreadSafe() const override {
+            return Inner->IsInternallyThreadSafe();
+        }
+
+        virtual void Trim(bool bTrimThreadCaches) override {
+            Inner->Trim(bTrimThreadCaches);
+        }
+
+        virtual const TCHAR* GetDescriptiveName() override {
+            return TEXT("PollyBenchmarkCountingMalloc");
+        }
+
+        void Reset(SIZE_T InMinBytes) {
+            MinBytes = InMinBytes;
+            NumAllocations.store(0);
+            NumBytes.store(0);
+        }
+
+        int64 GetNumAllocations() const {
+            return NumAllocations.load();
+        }
+
+        int64 GetNumBytes() const {
+            return NumBytes.load();
+        }
+
+    private:
+        void Record(SIZE_T Count) {
+            if (Count >= MinBytes) {
+                NumAllocations.fetch_add(1);
+                NumBytes.fetch_add(static_cast<int64>(Count));
+            }
+        }
+
+        FMalloc* Inner;
+        SIZE_T MinBytes;
+        std::atomic<int64> NumAllocations;
+        std::atomic<int64> NumBytes;
+    };
+
+    /**
+    * Installs a FCountingMalloc for its lifetime. Memory allocated before is freed through the counting allocator,
+    * and memory allocated meanwhile after it, which both end up in the allocator it wraps. The counting allocator
+    * is never destroyed, as other threads may still be calling it after it was uninstalled.
+    */
+    class FScopedCountingMalloc {
+    public:
+        explicit FScopedCountingMalloc(SIZE_T MinBytes = CountedAllocationBytes) : Previous(GMalloc) {
+            static FCountingMalloc Counter(GMalloc);
+            Counting = &Counter;
+            Counting->Reset(MinBytes);
+            FPlatformMisc::MemoryBarrier();
+            GMalloc = Counting;
+            FPlatformMisc::MemoryBarrier();
+        }
+
+        ~FScopedCountingMalloc() {
+            FPlatformMisc::MemoryBarrier();
+            GMalloc = Previous;
+            FPlatformMisc::MemoryBarrier();
+        }
+
+        const FCountingMalloc& Get() const {
+            return *Counting;
+        }
+
+    private:
+        FCountingMalloc* Counting;
+        FMalloc* Previous;
+    };
+
+    /**
+    * Number of speech marks Polly returns for about 3000 characters of text
+    */
+    const int32 SpeechMarkLines = 2500;
+    /**
+    * Number of times each speech mark parser is timed, of which the fastest is kept
+    */
+    const int32 ParseIterations = 20;
+
+    /**
+    * Viseme symbols of Polly
+    */
+    const char* VisemeSymbols[] = { "sil", "p", "t", "S", "T", "f", "k", "i", "r", "s", "u", "@", "a", "e", "E", "o", "O" };
+
+    /**
+    * Creates the speech marks of an utterance, cycling through every viseme
+    * @param NumLines - the number of speech marks
+    */
+    TArray<uint8> CreateSpeechMarks(int32 NumLines = SpeechMarkLines) {
+        const TArrayView<const char* const> Symbols(VisemeSymbols, UE_ARRAY_COUNT(VisemeSymbols));
+        FString SpeechMarks;
+        for (int32 Line = 0; Line < NumLines; Line++) {
+            SpeechMarks += FString::Printf(TEXT("{\"time\":%d,\"type\":\"viseme\",\"value\":\"%s\"}\n"), Line * 60, ANSI_TO_TCHAR(Symbols[Line % Symbols.Num()]));
+        }
+        const FTCHARToUTF8 Utf8(*SpeechMarks);
+        return TArray<uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length());
+    }
+
+    /**
+    * Parses speech marks the way the speech component did before FSpeechMarkParser, converting them to a string
+    * and deserializing each line into a FJsonObject
+    */
+    bool ParseSpeechMarksWithJsonObjects(const TArray<uint8>& Bytes, TArray<VisemeEvent>& OutVisemeEvents) {
+        FString VisemeJson;
+        FFileHelper::BufferToString(VisemeJson, Bytes.GetData(), Bytes.Num());
+        TArray<FString> VisemeStrings;
+        VisemeJson.ParseIntoArray(VisemeStrings, TEXT("\n"), true);
+        for (const FString& VisemeSet : VisemeStrings) {
+            TSharedPtr<FJsonObject> JsonParsed = MakeShareable(new FJsonObject);
+            TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(VisemeSet);
+            FString Value;
+            double Time;
+            if (!FJsonSerializer::Deserialize(JsonReader, JsonParsed) || !JsonParsed->TryGetStringField("value", Value) || !JsonParsed->TryGetNumberField("time", Time)) {
+                return false;
+            }
+            VisemeEvent CurrentVisemeEvent;
+            CurrentVisemeEvent.Viseme = GetVisemeValueFromString(Value);
+            CurrentVisemeEvent.TimeMilliseconds = static_cast<int>(Time);
+            OutVisemeEvents.Add(CurrentVisemeEvent);
+        }
+        return true;
+    }
+
+    /**
+    * Times the fastest of a number of runs of a speech mark parser
+    * @param Parse - parses the speech marks into the visemes
+    * @return double - the seconds taken by the fastest run
+    */
+    double TimeFastestParse(TFunctionRef<void(TArray<VisemeEvent>&)> Parse) {
+        double FastestSeconds = MAX_dbl;
+        TArray<VisemeEvent> VisemeEvents;
+        for (int32 Iteration = 0; Iteration < ParseIterations; Iteration++) {
+            VisemeEvents.Reset();
+            const double StartSeconds = FPlatformTime::Seconds();
+            Parse(VisemeEvents);
+            FastestSeconds = FMath::Min(FastestSeconds, FPlatformTime::Seconds() - StartSeconds);
+        }
+        return FastestSeconds;
+    }
+
+    /**
+    * A hot path measured over a corpus. Allocations are counted through GMalloc while the benchmark runs, so
+    * allocations of other threads meanwhile are included. Bytes copied are counted as the bytes allocated, as the
+    * copies these paths make are into buffers they allocate.
+    */
+    struct FBenchmarkResult {
+        FString Name;
+        FString Corpus;
+        int64 Iterations = 0;
+        double NanosecondsPerOp = 0.0;
+        double AllocationsPerOp = 0.0;
+        double AllocatedBytesPerOp = 0.0;
+    };
+
+    /**
+    * Time a benchmark runs for at least, so that the timer resolution does not matter
+    */
+    const double BenchmarkMinSeconds = 0.1;
+
+    /**
+    * Results of the benchmarks run in this session, by name and corpus, written to the report
+    */
+    TMap<FString, FBenchmarkResult>& GetBenchmarkResults() {
+        static TMap<FString, FBenchmarkResult> Results;
+        return Results;
+    }
+
+    /**
+    * Measures a hot path: first how many calls take BenchmarkMinSeconds, then the time of that many calls, then
+    * their allocations, apart from the timing as counting slows allocations down
+    * @param Name - the hot path
+    * @param Corpus - the input of the hot path
+    * @param MaxIterations - the most calls to make, e.g. for calls creating objects that are only freed by GC
+    * @param Op - calls the hot path once
+    * @return FBenchmarkResult - the measurements, also kept for the report
+    */
+    FBenchmarkResult RunBenchmark(const FString& Name, const FString& Corpus, int64 MaxIterations, TFunctionRef<void()> Op) {
+        Op();
+        int64 Iterations = 0;
+        const double CalibrationStartSeconds = FPlatformTime::Seconds();
+        do {
+            Op();
+            Iterations++;
+        } while (FPlatformTime::Seconds() - CalibrationStartSeconds < BenchmarkMinSeconds && Iterations < MaxIterations);
+        const double StartSeconds = FPlatformTime::Seconds();
+        for (int64 Iteration = 0; Iteration < Iterations; Iteration++) {
+            Op();
+        }
+        const double Seconds = FPlatformTime::Seconds() - StartSeconds;
+        FBenchmarkResult Result;
+        {
+            FScopedCountingMalloc Counting(1);
+            for (int64 Iteration = 0; Iteration < Iterations; Iteration++) {
+                Op();
+            }
+            Result.AllocationsPerOp = static_cast<double>(Counting.Get().GetNumAllocations()) / Iterations;
+            Result.AllocatedBytesPerOp = static_cast<double>(Counting.Get().GetNumBytes()) / Iterations;
+        }
+        Result.Name = Name;
+        Result.Corpus = Corpus;
+        Result.Iterations = Iterations;
+        Result.NanosecondsPerOp = Seconds * 1e9 / Iterations;
+        GetBenchmarkResults().Add(Name + TEXT("/") + Corpus, Result);
+        return Result;
+    }
+
+    /**
+    * Writes the results of the benchmarks run so far as JSON, to the path given by -PollyBenchmarkReport= or to
+    * Saved/Benchmarks/AmazonPollyBenchmarks.json, along with what they ran on so that runs can be compared
+    * @return FString - the path of the report
+    */
+    FString WriteBenchmarkReport() {
+        FString Path;
+        if (!FParse::Value(FCommandLine::Get(), TEXT("PollyBenchmarkReport="), Path)) {
+            Path = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Benchmarks"), TEXT("AmazonPollyBenchmarks.json"));
+        }
+        TMap<FString, FBenchmarkResult>& Results = GetBenchmarkResults();
+        Results.KeySort(TLess<FString>());
+        TArray<TSharedPtr<FJsonValue>> JsonResults;
+        for (const TPair<FString, FBenchmarkResult>& Result : Results) {
+            TSharedRef<FJsonObject> JsonResult = MakeShared<FJsonObject>();
+            JsonResult->SetStringField(TEXT("name"), Result.Value.Name);
+            JsonResult->SetStringField(TEXT("corpus"), Result.Value.Corpus);
+            JsonResult->SetNumberField(TEXT("iterations"), Result.Value.Iterations);
+            JsonResult->SetNumberField(TEXT("ns_per_op"), Result.Value.NanosecondsPerOp);
+            JsonResult->SetNumberField(TEXT("allocations_per_op"), Result.Value.AllocationsPerOp);
+            JsonResult->SetNumberField(TEXT("bytes_copied_per_op"), Result.Value.AllocatedBytesPerOp);
+            JsonResults.Add(MakeShared<FJsonValueObject>(JsonResult));
+        }
+        TSharedRef<FJsonObject> Report = MakeShared<FJsonObject>();
+        Report->SetStringField(TEXT("engine_version"), FEngineVersion::Current().ToString());
+        Report->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+        Report->SetStringField(TEXT("configuration"), LexToString(FApp::GetBuildConfiguration()));
+        Report->SetStringField(TEXT("cpu"), FPlatformMisc::GetCPUBrand().TrimStartAndEnd());
+        Report->SetStringField(TEXT("timestamp"), FDateTime::UtcNow().ToIso8601());
+        Report->SetArrayField(TEXT("benchmarks"), JsonResults);
+        FString Json;
+        TSharedRef<TJsonWriter<TCHAR>> JsonWriter = TJsonWriterFactory<TCHAR>::Create(&Json);
+        FJsonSerializer::Serialize(Report, JsonWriter);
+        if (!FFileHelper::SaveStringToFile(Json, *Path, FFileHelper::EEncodingOptions::ForceUTF8WithoutBOM)) {
+            UE_LOG(LogTemp, Warning, TEXT("Failed to write the benchmark report to %s."), *Path);
+        }
+        return Path;
+    }
+
+    /**
+    * Creates text of a length, made of sentences the way dialogue is
+    * @param NumChars - the length of the text
+    */
+    FString CreateText(int32 NumChars) {
+        const FString Sentence = TEXT("The quick brown fox jumps over the lazy dog. ");
+        FString Text;
+        while (Text.Len() < NumChars) {
+            Text += Sentence;
+        }
+        return Text.Left(NumChars);
+    }
+
+    /**
+    * Writes a response to a stream in chunks, the way the HTTP client of the SDK does
+    */
+    void WriteResponse(Aws::IOStream& Stream, const TArray<uint8>& Response) {
+        for (int32 Offset = 0; Offset < Response.Num(); Offset += ResponseChunkBytes) {
+            Stream.write(reinterpret_cast<const char*>(Response.GetData()) + Offset, FMath::Min(ResponseChunkBytes, Response.Num() - Offset));
+        }
+    }
+}
+
+BEGIN_DEFINE_SPEC(AmazonPollyBenchmarkSpec, "AmazonPolly.Benchmarks", EAutomationTestFlags::ClientContext | EAutomationTestFlags::EditorContext | EAutomationTestFlags::PerfFilter)
+UTestableSpeechComponent* TestableSpeechComponent;
+END_DEFINE_SPEC(AmazonPollyBenchmarkSpec)
+
+void AmazonPollyBenchmarkSpec::Define() {
+
+    Describe("Audio copies per utterance", [this]() {
+
+        It("should receive a response without growing and copying it", [this]() {
+            TArray<uint8> Response;
+            Response.SetNumZeroed(UtteranceBytes);
+            // given the string stream the SDK writes responses to by default, and the data copied out of it
+            int64 StringStreamAllocations;
+            int64 StringStreamBytes;
+            {
+                FScopedCountingMalloc Counting;
+                Aws::StringStream Stream;
+                WriteResponse(Stream, Response);
+                TArray<uint8> Data = UnrealAWSUtils::PreparePollyData(Stream);
+                StringStreamAllocations = Counting.Get().GetNumAllocations();
+                StringStreamBytes = Counting.Get().GetNumBytes();
+            }
+            // when the response is written to a response body expecting its size instead
+            int64 BodyAllocations;
+            int64 BodyBytes;
+            {
+                FScopedCountingMalloc Counting;
+                TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body = MakeShared<FPollyResponseBody, ESPMode::ThreadSafe>(UtteranceBytes);
+                Body->Reset();
+                {
+                    FPollyResponseStream Stream(Body);
+                    WriteResponse(Stream, Response);
+                }
+                FPollyAudioBuffer Audio = Body->Take();
+                TestEqual("The body holds the response", Audio->Num(), UtteranceBytes);
+                BodyAllocations = Counting.Get().GetNumAllocations();
+                BodyBytes = Counting.Get().GetNumBytes();
+            }
+            AddInfo(FString::Printf(TEXT("Receiving %d KB: %lld allocations of %lld KB through a string stream, %lld allocations of %lld KB through a response body"),
+                UtteranceBytes / 1024, StringStreamAllocations, StringStreamBytes / 1024, BodyAllocations, BodyBytes / 1024));
+            // then the response is allocated once
+            TestEqual("The response body allocates the response once", BodyAllocations, (int64)1);
+            TestTrue("The response body allocates less than the string stream", BodyBytes < StringStreamBytes);
+        });
+
+        It("should play a synthesized utterance without copying its audio", [this]() {
+            TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+            TestableSpeechComponent->InitializePollyClient();
+            TestableSpeechComponent->bUseSpeechCache = false;
+            MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+            // given a response of 2 MB of audio, which is allocated once by the response body
+            MockPollyClient->AddSynthesizeSpeechBehavior([]() {
+                TArray<uint8> Audio;
+                Audio.SetNumZeroed(UtteranceBytes);
+                PollyOutcome Outcome;
+                Outcome.IsSuccess = true;
+                Outcome.StreamBuffer = PollyAudioBuffer::Make(MoveTemp(Audio));
+                return Outcome;
+            });
+            MockPollyClient->AddSynthesizeSpeechBehavior([]() {
+                const char* VisemeJson = "{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}";
+                PollyOutcome Outcome;
+                Outcome.IsSuccess = true;
+                Outcome.StreamBuffer = PollyAudioBuffer::Make(TArray<uint8>(reinterpret_cast<const uint8*>(VisemeJson), FCStringAnsi::Strlen(VisemeJson)));
+                return Outcome;
+            });
+            // when the utterance is synthesized and started
+            int64 NumAllocations;
+            int64 NumBytes;
+            {
+                FScopedCountingMalloc Counting;
+                TestTrue("The speech is generated", TestableSpeechComponent->GenerateSpeechSync("A long utterance.", EVoiceId::Joanna));
+                TestNotNull("The speech is started", TestableSpeechComponent->StartSpeech());
+                NumAllocations = Counting.Get().GetNumAllocations();
+                NumBytes = Counting.Get().GetNumBytes();
+            }
+            TestableSpeechComponent->StopSpeech();
+            AddInfo(FString::Printf(TEXT("Playing %d KB: %lld allocations of %lld KB"), UtteranceBytes / 1024, NumAllocations, NumBytes / 1024));
+            // then the audio is only allocated by the response, while a copy for the speech and one for the sound
+            // took three times its size
+            TestTrue("The audio is not copied", NumBytes < 2 * UtteranceBytes);
+        });
+    });
+
+    Describe("Speech mark parsing", [this]() {
+
+        It("should parse the speech marks of a long utterance at least 10 times faster than with json objects", [this]() {
+            // given the speech marks of about 3000 characters of text
+            const TArray<uint8> SpeechMarks = CreateSpeechMarks();
+            TArray<VisemeEvent> JsonObjectEvents;
+            TArray<VisemeEvent> ParserEvents;
+            TestTrue("The speech marks are parsed with json objects", ParseSpeechMarksWithJsonObjects(SpeechMarks, JsonObjectEvents));
+            TestTrue("The speech marks are parsed with the parser", FSpeechMarkParser::Parse(SpeechMarks, ParserEvents));
+            TestEqual("Both parsers find every viseme", ParserEvents.Num(), JsonObjectEvents.Num());
+            for (int32 Index = 0; Index < ParserEvents.Num() && Index < JsonObjectEvents.Num(); Index++) {
+                if (ParserEvents[Index].Viseme != JsonObjectEvents[Index].Viseme || ParserEvents[Index].TimeMilliseconds != JsonObjectEvents[Index].TimeMilliseconds) {
+                    AddError(FString::Printf(TEXT("The parsers differ on speech mark %d"), Index));
+                    break;
+                }
+            }
+            // when each parser is timed
+            const double JsonObjectSeconds = TimeFastestParse([&SpeechMarks](TArray<VisemeEvent>& OutVisemeEvents) {
+                ParseSpeechMarksWithJsonObjects(SpeechMarks, OutVisemeEvents);
+            });
+            const double ParserSeconds = TimeFastestParse([&SpeechMarks](TArray<VisemeEvent>& OutVisemeEvents) {
+                FSpeechMarkParser::Parse(SpeechMarks, OutVisemeEvents);
+            });
+            const double Speedup = JsonObjectSeconds / FMath::Max(ParserSeconds, 1e-9);
+            AddInfo(FString::Printf(TEXT("Parsing %d speech marks (%d KB): %.3fms with json objects, %.3fms with the parser, %.1fx faster"),
+                SpeechMarkLines, SpeechMarks.Num() / 1024, JsonObjectSeconds * 1000.0, ParserSeconds * 1000.0, Speedup));
+            // then the parser is at least 10 times faster
+            TestTrue("The parser is at least 10 times faster", Speedup >= 10.0);
+        });
+    });
+
+    Describe("Speech hot paths", [this]() {
+
+        AfterEach([this]() {
+            AddInfo(FString::Printf(TEXT("Benchmark report written to %s"), *WriteBenchmarkReport()));
+        });
+
+        // Logs a result the way it is reported
+        auto AddResultInfo = [this](const FBenchmarkResult& Result) {
+            AddInfo(FString::Printf(TEXT("%s (%s): %.0f ns/op, %.1f allocations/op, %.0f bytes copied/op over %lld iterations"),
+                *Result.Name, *Result.Corpus, Result.NanosecondsPerOp, Result.AllocationsPerOp, Result.AllocatedBytesPerOp, Result.Iterations));
+        };
+
+        It("should measure GetVisemeValueFromString", [this, AddResultInfo]() {
+            // given every viseme symbol of Polly
+            TArray<FString> Symbols;
+            for (const char* Symbol : VisemeSymbols) {
+                Symbols.Add(ANSI_TO_TCHAR(Symbol));
+            }
+            // when each one is looked up
+            const FBenchmarkResult Result = RunBenchmark(TEXT("GetVisemeValueFromString"), TEXT("17 symbols"), MAX_int64, [&Symbols]() {
+                for (const FString& Symbol : Symbols) {
+                    GetVisemeValueFromString(Symbol);
+                }
+            });
+            // then the lookups are measured
+            AddResultInfo(Result);
+            TestTrue("The lookups are measured", Result.Iterations > 0);
+        });
+
+        It("should measure GenerateVisemeEvents", [this, AddResultInfo]() {
+            TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+            TestableSpeechComponent->InitializePollyClient();
+            // given the speech marks of a short line, a sentence and a paragraph of 3000 characters
+            for (const int32 NumLines : { 10, 250, SpeechMarkLines }) {
+                const TArray<uint8> SpeechMarks = CreateSpeechMarks(NumLines);
+                // when the visemes are generated from them
+                const FBenchmarkResult Result = RunBenchmark(TEXT("GenerateVisemeEvents"), FString::Printf(TEXT("%d speech marks"), NumLines), MAX_int64, [this, &SpeechMarks]() {
+                    TestableSpeechComponent->ApplyVisemeJson(SpeechMarks);
+                });
+                // then every viseme is generated
+                AddResultInfo(Result);
+                TestEqual("Every viseme is generated", TestableSpeechComponent->GetVisemeTrack()->Num(), NumLines);
+            }
+        });
+
+        It("should measure UnrealAWSUtils::PreparePollyData", [this, AddResultInfo]() {
+            // given responses of 2 seconds, 32 seconds and 2 minutes of pcm audio
+            for (const int32 NumBytes : { 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 }) {
+                TArray<uint8> Response;
+                Response.SetNumZeroed(NumBytes);
+                Aws::StringStream Stream;
+                WriteResponse(Stream, Response);
+                // when the audio is read out of the stream
+                const FBenchmarkResult Result = RunBenchmark(TEXT("PreparePollyData"), FString::Printf(TEXT("%d KB pcm"), NumBytes / 1024), MAX_int64, [&Stream]() {
+                    Stream.clear();
+                    Stream.seekg(0);
+                    UnrealAWSUtils::PreparePollyData(Stream);
+                });
+                // then the audio is copied once
+                AddResultInfo(Result);
+                TestTrue("The audio is copied once", Result.AllocatedBytesPerOp < 2.0 * NumBytes);
+            }
+        });
+
+        It("should measure UnrealAWSUtils::FStringToAwsString", [this, AddResultInfo]() {
+            // given a 10 character line, a sentence and a paragraph of 3000 characters
+            for (const int32 NumChars : { 10, 300, 3000 }) {
+                const FString Text = CreateText(NumChars);
+                // when the text is converted for a Polly request
+                const FBenchmarkResult Result = RunBenchmark(TEXT("FStringToAwsString"), FString::Printf(TEXT("%d chars"), NumChars), MAX_int64, [&Text]() {
+                    UnrealAWSUtils::FStringToAwsString(Text);
+                });
+                // then the conversion is measured
+                AddResultInfo(Result);
+                TestTrue("The conversion is measured", Result.Iterations > 0);
+            }
+        });
+
+        It("should measure QueuePollyAudio", [this, AddResultInfo]() {
+            TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+            TestableSpeechComponent->InitializePollyClient();
+            // given speeches of 2 seconds, 32 seconds and 2 minutes of pcm audio
+            for (const int32 NumBytes : { 64 * 1024, 1024 * 1024, 4 * 1024 * 1024 }) {
+                TArray<uint8> Audio;
+                Audio.SetNumZeroed(NumBytes);
+                TestableSpeechComponent->SetSpeechAudio({ PollyAudioBuffer::Make(MoveTemp(Audio)) });
+                // when sounds playing them are created, which are only freed by the next garbage collection
+                const FBenchmarkResult Result = RunBenchmark(TEXT("QueuePollyAudio"), FString::Printf(TEXT("%d KB pcm"), NumBytes / 1024), 1000, [this]() {
+                    TestableSpeechComponent->CreateSpeechSound(0);
+                });
+                // then the sounds play the audio without copying it
+                AddResultInfo(Result);
+                TestTrue("The audio is not copied", Result.AllocatedBytesPerOp < NumBytes / 2);
+            }
+        });
+    });
+
+    Describe("Speaker load", [this]() {
+
+        It("should generate and speak the lines of many speakers at once", [this]() {
+            // given 32 speakers with short lines and pauses, against Polly clients with a log-normal latency and 5% throttling
+            FSpeechLoadTestConfig Config;
+            Config.NumSpeakers = 32;
+            Config.DurationSeconds = 3.0f;
+            Config.MinLineChars = 10;
+            Config.MaxLineChars = 40;
+            Config.MinPauseSeconds = 0.1f;
+            Config.MaxPauseSeconds = 0.5f;
+            Config.Faults.MedianLatencyMs = 50.0f;
+            Config.Faults.ThrottleRate = 0.05f;
+            AddExpectedError(TEXT("Polly failed to generate"), EAutomationExpectedErrorFlags::Contains, 0);
+            // when the speakers run
+            const FSpeechLoadTestResult Result = SpeechLoadTest::Run(Config);
+            // then the speakers speak, and only the throttled requests fail lines
+            AddInfo(SpeechLoadTest::ToString(Result));
+            TestTrue("Lines are spoken", Result.NumSpoken >= Config.NumSpeakers);
+            TestTrue("Only throttled requests fail lines", Result.NumFailed <= Result.NumThrottled);
+            TestTrue("The requests are sent by the scheduler workers", Result.PeakWorkerOccupancy > 0.0);
+        });
+    });
+}
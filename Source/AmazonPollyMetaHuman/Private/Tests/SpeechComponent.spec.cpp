@@ -18,6 +18,26 @@
 
 #include "Misc/AutomationTest.h"
 #include "TestableSpeechComponent.h"
+#include "PollyStreamingSoundWave.h"
+#include "SpeechTextUtils.h"
+#include "PollySynthesisScheduler.h"
+#include "SpeechCache.h"
+#include "SpeechDiskCache.h"
+#include "SpeechWarmupManifest.h"
+#include "PollySpeechAsset.h"
+#include "PollySpeechBaker.h"
+#include "PollyBakedSoundWave.h"
+#include "PollyBufferedSoundWave.h"
+#include "VisemeTrackCodec.h"
+#include "SpeechEnvelope.h"
+#include "SpeechMemoryTracker.h"
+#include "SpeechMarkParser.h"
+#include "SpeechMetrics.h"
+#include "PollyResponseStream.h"
+#include "Async/Async.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include <iterator>
 #include <strstream>
 
 /**
@@ -44,12 +64,131 @@ TFunction<PollyOutcome()> CreatePollySuccessfulOutcome(Aws::String text) {
         PollyOutcome Outcome;
         Outcome.IsSuccess = true;
         Aws::StringStream PollyStream(text);
-        Outcome.StreamBuffer = UnrealAWSUtils::PreparePollyData(PollyStream);
+        Outcome.StreamBuffer = PollyAudioBuffer::Make(UnrealAWSUtils::PreparePollyData(PollyStream));
         return Outcome;
     };
     return SuccessfulOutcomeLambda;
 }
 
+/**
+* Creates a lambda function that returns a successful PollyOutcome holding silent pcm audio
+* @param NumBytes - size of the audio (32 bytes per millisecond)
+* @return - the lambda function
+*/
+TFunction<PollyOutcome()> CreatePollyAudioOutcome(int32 NumBytes) {
+    auto AudioOutcomeLambda = [NumBytes]() {
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = true;
+        TArray<uint8> Audio;
+        Audio.SetNumZeroed(NumBytes);
+        Outcome.StreamBuffer = PollyAudioBuffer::Make(MoveTemp(Audio));
+        return Outcome;
+    };
+    return AudioOutcomeLambda;
+}
+
+/**
+* Creates pcm audio of a square wave, which is as loud as its amplitude
+* @param NumSamples - the number of samples, 16 per millisecond
+* @param Amplitude - the amplitude of the wave
+* @return - the audio
+*/
+TArray<uint8> CreateSquareWaveAudio(int32 NumSamples, int16 Amplitude) {
+    TArray<int16> Samples;
+    for (int32 SampleIndex = 0; SampleIndex < NumSamples; SampleIndex++) {
+        Samples.Add(SampleIndex % 2 == 0 ? Amplitude : -Amplitude);
+    }
+    return TArray<uint8>(reinterpret_cast<const uint8*>(Samples.GetData()), Samples.Num() * sizeof(int16));
+}
+
+/**
+* Polls a condition that is fulfilled by background work
+* @param Condition - the condition
+* @param TimeoutSeconds - how long to wait for the condition
+* @return - true if the condition was fulfilled in time
+*/
+bool WaitUntil(TFunction<bool()> Condition, double TimeoutSeconds = 2.0) {
+    const double Deadline = FPlatformTime::Seconds() + TimeoutSeconds;
+    while (!Condition()) {
+        if (FPlatformTime::Seconds() > Deadline) {
+            return false;
+        }
+        FPlatformProcess::Sleep(0.001f);
+    }
+    return true;
+}
+
+/**
+* Creates a scheduler job that occupies its worker until the gate is raised
+* @param Gate - the gate
+* @return - the job
+*/
+TFunction<PollyOutcome()> CreateGatedJob(TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate) {
+    return [Gate]() {
+        while (!*Gate) {
+            FPlatformProcess::Sleep(0.001f);
+        }
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = true;
+        return Outcome;
+    };
+}
+
+/**
+* Creates a scheduler job that appends its name to Order when it runs
+* @param Order - the names of the jobs that ran, only safe to share between jobs of a single worker
+* @param Name - the name of the job
+* @return - the job
+*/
+TFunction<PollyOutcome()> CreateRecordingJob(TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Order, const FString& Name) {
+    return [Order, Name]() {
+        Order->Add(Name);
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = true;
+        return Outcome;
+    };
+}
+
+/**
+* Schedules requests of two priorities and returns the 99th percentile latency of the high priority ones
+* @param Scheduler - the scheduler under load
+* @param NumLowPriorityRequests - the number of ambient requests queued ahead of the dialogue requests
+* @return - the 99th percentile of the time from scheduling a dialogue request until it completed, in seconds
+*/
+double MeasureDialogueP99Latency(FPollySynthesisScheduler& Scheduler, int32 NumLowPriorityRequests) {
+    const float RequestSeconds = 0.02f;
+    auto SimulatedRequest = [RequestSeconds]() {
+        FPlatformProcess::Sleep(RequestSeconds);
+        PollyOutcome Outcome;
+        Outcome.IsSuccess = true;
+        return Outcome;
+    };
+    PollyCancellationFlag AmbientFlag = MakePollyCancellationFlag();
+    TArray<TFuture<PollyOutcome>> AmbientFutures;
+    for (int32 RequestIndex = 0; RequestIndex < NumLowPriorityRequests; RequestIndex++) {
+        AmbientFutures.Add(Scheduler.Schedule({ ESpeechPriority::Ambient, 0.0 }, AmbientFlag, SimulatedRequest));
+    }
+    // Dialogue requests arrive in bursts, like the audio and viseme requests of the segments of a speech
+    TArray<double> Latencies;
+    for (int32 Burst = 0; Burst < 10; Burst++) {
+        TArray<TFuture<PollyOutcome>> DialogueFutures;
+        const double ScheduledSeconds = FPlatformTime::Seconds();
+        for (int32 RequestIndex = 0; RequestIndex < 4; RequestIndex++) {
+            DialogueFutures.Add(Scheduler.Schedule({ ESpeechPriority::Dialogue, 0.0 }, MakePollyCancellationFlag(), SimulatedRequest));
+        }
+        for (TFuture<PollyOutcome>& Future : DialogueFutures) {
+            Future.Wait();
+            Latencies.Add(FPlatformTime::Seconds() - ScheduledSeconds);
+        }
+    }
+    *AmbientFlag = true;
+    for (TFuture<PollyOutcome>& Future : AmbientFutures) {
+        Future.Wait();
+    }
+    Latencies.Sort();
+    return Latencies[FMath::Min(Latencies.Num() * 99 / 100, Latencies.Num() - 1)];
+}
+
 BEGIN_DEFINE_SPEC(AmazonPollySpec, "AmazonPolly.Unit Tests", EAutomationTestFlags::ClientContext | EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
 UTestableSpeechComponent* TestableSpeechComponent;
 END_DEFINE_SPEC(AmazonPollySpec)
@@ -185,8 +324,251 @@ void::AmazonPollySpec::Define() {
         });
     });
 
+    Describe("FPollySynthesisScheduler tests", [this]() {
+
+        It("should send the waiting request of the highest priority first", [this]() {
+            // given a single worker that is busy
+            FPollySchedulerConfig Config;
+            Config.NumWorkers = 1;
+            Config.AgingSeconds = 0.0;
+            FPollySynthesisScheduler Scheduler(Config);
+            TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+            TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Order = MakeShared<TArray<FString>, ESPMode::ThreadSafe>();
+            TFuture<PollyOutcome> Blocker = Scheduler.Schedule({ ESpeechPriority::Normal, 0.0 }, MakePollyCancellationFlag(), CreateGatedJob(Gate));
+            WaitUntil([&Scheduler]() { return Scheduler.GetStats().Priorities[(int32)ESpeechPriority::Normal].InFlight == 1; });
+            // when an ambient request is queued before a dialogue request
+            TFuture<PollyOutcome> Ambient = Scheduler.Schedule({ ESpeechPriority::Ambient, 0.0 }, MakePollyCancellationFlag(), CreateRecordingJob(Order, "Ambient"));
+            TFuture<PollyOutcome> Dialogue = Scheduler.Schedule({ ESpeechPriority::Dialogue, 0.0 }, MakePollyCancellationFlag(), CreateRecordingJob(Order, "Dialogue"));
+            *Gate = true;
+            Ambient.Wait();
+            Dialogue.Wait();
+            // then the dialogue request is sent first
+            TestEqual("Both requests are sent", Order->Num(), 2);
+            if (Order->Num() == 2) {
+                TestEqual("The dialogue request is sent first", (*Order)[0], FString(TEXT("Dialogue")));
+            }
+        });
+
+        It("should not send more requests of a priority than its in-flight limit", [this]() {
+            // given a limit of one ambient request in flight
+            FPollySchedulerConfig Config;
+            Config.NumWorkers = 4;
+            Config.MaxInFlight[(int32)ESpeechPriority::Ambient] = 1;
+            FPollySynthesisScheduler Scheduler(Config);
+            TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+            // when three ambient requests are queued
+            TArray<TFuture<PollyOutcome>> Futures;
+            for (int32 RequestIndex = 0; RequestIndex < 3; RequestIndex++) {
+                Futures.Add(Scheduler.Schedule({ ESpeechPriority::Ambient, 0.0 }, MakePollyCancellationFlag(), CreateGatedJob(Gate)));
+            }
+            WaitUntil([&Scheduler]() { return Scheduler.GetStats().Priorities[(int32)ESpeechPriority::Ambient].InFlight == 1; });
+            FPlatformProcess::Sleep(0.05f);
+            // then only one of them is sent while the others wait, even though workers are free
+            FPollySchedulerPriorityStats Stats = Scheduler.GetStats().Priorities[(int32)ESpeechPriority::Ambient];
+            TestEqual("One request is in flight", Stats.InFlight, 1);
+            TestEqual("Two requests are waiting", Stats.QueueDepth, 2);
+            *Gate = true;
+            for (TFuture<PollyOutcome>& Future : Futures) {
+                TestTrue("Every request is sent eventually", Future.Get().IsSuccess);
+            }
+        });
+
+        It("should fail a request that is still waiting at its deadline", [this]() {
+            // given a single worker that is busy
+            FPollySchedulerConfig Config;
+            Config.NumWorkers = 1;
+            FPollySynthesisScheduler Scheduler(Config);
+            TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+            TFuture<PollyOutcome> Blocker = Scheduler.Schedule({ ESpeechPriority::Normal, 0.0 }, MakePollyCancellationFlag(), CreateGatedJob(Gate));
+            // when a request with a deadline of 20ms is queued behind it
+            PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+            TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Order = MakeShared<TArray<FString>, ESPMode::ThreadSafe>();
+            TFuture<PollyOutcome> Late = Scheduler.Schedule({ ESpeechPriority::Normal, FPlatformTime::Seconds() + 0.02 }, CancellationFlag, CreateRecordingJob(Order, "Late"));
+            FPlatformProcess::Sleep(0.1f);
+            *Gate = true;
+            const PollyOutcome& Outcome = Late.Get();
+            // then it fails without being sent, and aborts its request group
+            TestFalse("The request fails", Outcome.IsSuccess);
+            TestFalse("The request is not reported as cancelled", Outcome.IsCancelled);
+            TestEqual("The request is not sent", Order->Num(), 0);
+            TestTrue("The cancellation flag of the request group is raised", (bool)*CancellationFlag);
+            TestEqual("The expiry is counted", Scheduler.GetStats().Priorities[(int32)ESpeechPriority::Normal].NumExpired, (int64)1);
+        });
+
+        It("should drop a request that is cancelled while waiting", [this]() {
+            // given a single worker that is busy
+            FPollySchedulerConfig Config;
+            Config.NumWorkers = 1;
+            FPollySynthesisScheduler Scheduler(Config);
+            TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+            TFuture<PollyOutcome> Blocker = Scheduler.Schedule({ ESpeechPriority::Normal, 0.0 }, MakePollyCancellationFlag(), CreateGatedJob(Gate));
+            PollyCancellationFlag CancellationFlag = MakePollyCancellationFlag();
+            TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Order = MakeShared<TArray<FString>, ESPMode::ThreadSafe>();
+            TFuture<PollyOutcome> Cancelled = Scheduler.Schedule({ ESpeechPriority::Normal, 0.0 }, CancellationFlag, CreateRecordingJob(Order, "Cancelled"));
+            // when its cancellation flag is raised
+            *CancellationFlag = true;
+            // then it completes without waiting for the worker
+            TestTrue("The request completes while the worker is busy", WaitUntil([&Cancelled]() { return Cancelled.IsReady(); }));
+            *Gate = true;
+            TestTrue("The request is reported as cancelled", Cancelled.Get().IsCancelled);
+            TestEqual("The request is not sent", Order->Num(), 0);
+        });
+
+        It("should age waiting requests so that lower priorities are not starved", [this]() {
+            // given a single worker that is busy and an aging of 20ms per priority
+            FPollySchedulerConfig Config;
+            Config.NumWorkers = 1;
+            Config.AgingSeconds = 0.02;
+            FPollySynthesisScheduler Scheduler(Config);
+            TSharedRef<FThreadSafeBool, ESPMode::ThreadSafe> Gate = MakeShared<FThreadSafeBool, ESPMode::ThreadSafe>(false);
+            TSharedRef<TArray<FString>, ESPMode::ThreadSafe> Order = MakeShared<TArray<FString>, ESPMode::ThreadSafe>();
+            TFuture<PollyOutcome> Blocker = Scheduler.Schedule({ ESpeechPriority::Normal, 0.0 }, MakePollyCancellationFlag(), CreateGatedJob(Gate));
+            // when an ambient request has waited long before a dialogue request arrives
+            TFuture<PollyOutcome> Ambient = Scheduler.Schedule({ ESpeechPriority::Ambient, 0.0 }, MakePollyCancellationFlag(), CreateRecordingJob(Order, "Ambient"));
+            FPlatformProcess::Sleep(0.2f);
+            TFuture<PollyOutcome> Dialogue = Scheduler.Schedule({ ESpeechPriority::Dialogue, 0.0 }, MakePollyCancellationFlag(), CreateRecordingJob(Order, "Dialogue"));
+            *Gate = true;
+            Ambient.Wait();
+            Dialogue.Wait();
+            // then the aged ambient request is sent first
+            TestEqual("Both requests are sent", Order->Num(), 2);
+            if (Order->Num() == 2) {
+                TestEqual("The aged ambient request is sent first", (*Order)[0], FString(TEXT("Ambient")));
+            }
+        });
+
+        It("should keep the latency of dialogue flat as the ambient load grows (load test)", [this]() {
+            // given the default configuration, where ambient requests may occupy 2 of 8 workers
+            FPollySynthesisScheduler Scheduler;
+            // when bursts of dialogue requests compete with a growing backlog of ambient requests
+            const double UnloadedP99 = MeasureDialogueP99Latency(Scheduler, 0);
+            const double LoadedP99 = MeasureDialogueP99Latency(Scheduler, 64);
+            const double HeavilyLoadedP99 = MeasureDialogueP99Latency(Scheduler, 256);
+            AddInfo(FString::Printf(TEXT("Dialogue p99 latency: %.1fms unloaded, %.1fms with 64 ambient requests, %.1fms with 256"),
+                UnloadedP99 * 1000.0, LoadedP99 * 1000.0, HeavilyLoadedP99 * 1000.0));
+            // then the p99 latency of dialogue grows by less than a single request duration
+            TestTrue("Dialogue p99 latency is flat under ambient load", LoadedP99 < UnloadedP99 + 0.02);
+            TestTrue("Dialogue p99 latency is flat under heavy ambient load", HeavilyLoadedP99 < UnloadedP99 + 0.02);
+            TestTrue("Dialogue requests did not wait for a worker long", Scheduler.GetStats().Priorities[(int32)ESpeechPriority::Dialogue].P99WaitSeconds < 0.02);
+        });
+    });
+
+    Describe("FSpeechMarkParser tests", [this]() {
+
+        It("should parse a line that is split across chunks", [this]() {
+            // given speech marks that arrive in chunks ending in the middle of a line
+            const char* Chunks[] = { "{\"time\":6,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":1", "25,\"type\":\"vis", "eme\",\"value\":\"E\"}\n{\"time\":250,\"type\":\"viseme\",\"value\":\"sil\"}" };
+            FSpeechMarkParser Parser;
+            TArray<VisemeEvent> VisemeEvents;
+            // when the chunks are appended one by one
+            bool bParsed = true;
+            for (const char* Chunk : Chunks) {
+                bParsed &= Parser.Append(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Chunk), FCStringAnsi::Strlen(Chunk)), VisemeEvents);
+            }
+            bParsed &= Parser.Finish(VisemeEvents);
+            // then every line is parsed as a whole
+            TestTrue("The speech marks are parsed", bParsed);
+            TestEqual("Every line has a viseme", VisemeEvents.Num(), 3);
+            if (VisemeEvents.Num() == 3) {
+                TestEqual("The split line keeps its time", VisemeEvents[1].TimeMilliseconds, 125);
+                TestTrue("The split line keeps its viseme", VisemeEvents[1].Viseme == EViseme::E);
+                TestTrue("The last line without a newline is parsed", VisemeEvents[2].Viseme == EViseme::Sil);
+            }
+        });
+
+        It("should map every viseme symbol of Polly", [this]() {
+            // given a line for each viseme symbol, with its fields in any order
+            const TPair<const char*, EViseme> Symbols[] = {
+                { "p", EViseme::P }, { "t", EViseme::LowerT }, { "S", EViseme::S }, { "T", EViseme::T }, { "f", EViseme::F },
+                { "k", EViseme::K }, { "i", EViseme::I }, { "r", EViseme::R }, { "s", EViseme::LowerS }, { "u", EViseme::U },
+                { "@", EViseme::At }, { "a", EViseme::A }, { "e", EViseme::LowerE }, { "E", EViseme::E }, { "o", EViseme::LowerO },
+                { "O", EViseme::O }, { "sil", EViseme::Sil } };
+            FString SpeechMarks;
+            for (const TPair<const char*, EViseme>& Symbol : Symbols) {
+                SpeechMarks += FString::Printf(TEXT("{ \"value\" : \"%s\", \"type\":\"viseme\", \"start\":null, \"time\" : 42.0 }\r\n"), ANSI_TO_TCHAR(Symbol.Key));
+            }
+            const FTCHARToUTF8 Utf8(*SpeechMarks);
+            // when the speech marks are parsed
+            TArray<VisemeEvent> VisemeEvents;
+            const bool bParsed = FSpeechMarkParser::Parse(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Utf8.Get()), Utf8.Length()), VisemeEvents);
+            // then each symbol maps to its viseme
+            TestTrue("The speech marks are parsed", bParsed);
+            TestEqual("Every line has a viseme", VisemeEvents.Num(), (int32)UE_ARRAY_COUNT(Symbols));
+            for (int32 Index = 0; Index < VisemeEvents.Num() && Index < (int32)UE_ARRAY_COUNT(Symbols); Index++) {
+                TestTrue(FString::Printf(TEXT("'%s' maps to its viseme"), ANSI_TO_TCHAR(Symbols[Index].Key)), VisemeEvents[Index].Viseme == Symbols[Index].Value);
+                TestEqual("The time is read", VisemeEvents[Index].TimeMilliseconds, 42);
+            }
+        });
+
+        It("should reject a line that is not a speech mark", [this]() {
+            // given speech marks where a line is cut short, or lacks the time of its viseme
+            const char* Malformed[] = { "{\"time\":125,\"type\":\"viseme\",\"value\":\"k\"", "{\"type\":\"viseme\",\"value\":\"k\"}", "{\"time\":125,\"value\":\"k\"} trailing" };
+            for (const char* Line : Malformed) {
+                // when the speech marks are parsed
+                FSpeechMarkParser Parser;
+                TArray<VisemeEvent> VisemeEvents;
+                const bool bAppended = Parser.Append(TArrayView<const uint8>(reinterpret_cast<const uint8*>(Line), FCStringAnsi::Strlen(Line)), VisemeEvents);
+                const bool bFinished = Parser.Finish(VisemeEvents);
+                // then the parser fails, and rejects any further speech marks
+                TestFalse(FString::Printf(TEXT("'%s' is rejected"), ANSI_TO_TCHAR(Line)), bAppended && bFinished);
+                TestEqual("No viseme is parsed", VisemeEvents.Num(), 0);
+                TestFalse("Further speech marks are rejected", Parser.Append(TArrayView<const uint8>(reinterpret_cast<const uint8*>("\n"), 1), VisemeEvents));
+            }
+        });
+    });
+
+    Describe("FVisemeTrack tests", [this]() {
+
+        It("should find the viseme played at any time", [this]() {
+            // given a track of visemes
+            FVisemeTrackRef Track = FVisemeTrack::Make({ { EViseme::P, 100 }, { EViseme::A, 250 }, { EViseme::Sil, 400 } });
+            // when it is evaluated before, at and between the times of the visemes, and after the last one
+            // then the viseme played is the first one whose time has not passed yet
+            TestEqual("Before the first viseme", Track->Evaluate(0), EViseme::P);
+            TestEqual("At the time of the first viseme", Track->Evaluate(100), EViseme::P);
+            TestEqual("Between the first and second viseme", Track->Evaluate(101), EViseme::A);
+            TestEqual("At the time of the last viseme", Track->Evaluate(400), EViseme::Sil);
+            TestEqual("The visemes ended", Track->FindVisemeIndex(401), 3);
+            TestEqual("The mouth is closed after the visemes", FVisemeTrack::Make({ { EViseme::P, 100 } })->Evaluate(101), EViseme::Sil);
+            TestEqual("The visemes end at the last one", Track->GetEndMilliseconds(), 400);
+            TestEqual("An empty track ends at once", FVisemeTrack::GetEmpty()->GetEndMilliseconds(), 0);
+        });
+
+        It("should append visemes to a new track", [this]() {
+            // given a track that is being sampled
+            FVisemeTrackRef Track = FVisemeTrack::Make({ { EViseme::P, 100 } });
+            // when the visemes of a segment starting at 150ms are appended
+            FVisemeTrackRef Appended = Track->Append({ { EViseme::K, 50 }, { EViseme::Sil, 90 } }, 150);
+            // then the new track holds them at their offset, and the sampled track is unchanged
+            TestEqual("The sampled track is unchanged", Track->Num(), 1);
+            TestEqual("The new track holds every viseme", Appended->Num(), 3);
+            TestEqual("The appended visemes are offset", Appended->GetTimeMilliseconds(1), 200);
+            TestEqual("The appended viseme is played", Appended->Evaluate(150), EViseme::K);
+            TArray<VisemeEvent> Visemes;
+            Appended->GetVisemeEvents(Visemes);
+            TestTrue("The visemes are copied out in order", Visemes.Num() == 3 && Visemes[2].Viseme == EViseme::Sil && Visemes[2].TimeMilliseconds == 240);
+        });
+
+        It("should take less memory than an array of viseme events", [this]() {
+            // given the visemes of a long speech
+            TArray<VisemeEvent> Visemes;
+            for (int32 Index = 0; Index < 1000; Index++) {
+                Visemes.Add({ Index % 2 == 0 ? EViseme::P : EViseme::A, Index * 60 });
+            }
+            // when they are made into a track
+            FVisemeTrackRef Track = FVisemeTrack::Make(Visemes);
+            // then a viseme takes 5 bytes rather than 8
+            TestEqual("Every viseme is held", Track->Num(), 1000);
+            TestTrue("The track is smaller than the array", Track->GetAllocatedSize() * 8 <= Visemes.GetAllocatedSize() * 5 + 64);
+        });
+    });
+
     Describe("SpeechComponent tests", [this]() {
 
+        BeforeEach([this]() {
+            USpeechComponent::ClearSpeechCache();
+        });
+
         Describe("Initializing a SpeechComponent", [this]() {
 
             It("should have an empty Audiobuffer and VisemeEventArray'", [this]() {
@@ -218,6 +600,37 @@ void::AmazonPollySpec::Define() {
                 TestTrue("VisemeEventArray is empty after call", TestableSpeechComponent->GetVisemeEventArray().Num() == 0);
             });
 
+            It("should not synthesize any audio or visemes for a whitespace text input with pipelining", [this]() {
+                // given a text of whitespace only, which leaves no sentence once split
+                TestableSpeechComponent->bPipelineSentences = true;
+                TestableSpeechComponent->bUseSpeechCache = true;
+                AddExpectedError(TEXT("Cannot generate speech (check input text)"), EAutomationExpectedErrorFlags::Contains);
+                // when GenerateSpeechSync is invoked with the text
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("   ", EVoiceId::Joanna);
+                HasMetExpectedErrors();
+                // then it fails without requesting anything, and the text is not taken as cached
+                TestFalse("GenerateSpeechSync fails", bGenerated);
+                TestFalse("The text is not cached", TestableSpeechComponent->IsSpeechCached("   ", EVoiceId::Joanna));
+                TestEqual("No audio is requested", TestableSpeechComponent->GetPollyClient()->GetRequestedAudioTexts().Num(), 0);
+                TestTrue("Audiobuffer is empty after call", TestableSpeechComponent->GetAudiobuffer().Num() == 0);
+            });
+
+            It("should keep the previous speech when Polly returns no visemes", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(1600));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome(""));
+                // given a generated speech
+                TestTrue("The first speech is generated", TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna));
+                // when the next speech comes back without visemes
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("How are you?", EVoiceId::Joanna);
+                // then it fails without replacing the previous speech
+                TestFalse("GenerateSpeechSync fails", bGenerated);
+                TestEqual("The audio of the previous speech is kept", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+                TestEqual("The visemes of the previous speech are kept", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+            });
+
             It("should not synthesize any audio or visemes when StartSpeech invoked (bIsSpeaking is true)", [this]() {
                 AddExpectedError(TEXT("Cannot generate speech during playback"), EAutomationExpectedErrorFlags::Contains);
                 // given a bool value of true for bIsSpeaking (StartSpeech invoked)
@@ -235,12 +648,14 @@ void::AmazonPollySpec::Define() {
                 // given an error while generating audio 
                 // and thus a PollyOutcome object that has an IsSuccess value of false
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome());
-                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome());
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"));
                 AddExpectedError(TEXT("Polly failed to generate audio file. Error: error"), EAutomationExpectedErrorFlags::Contains);
                 // when GenerateSpeechSync is invoked
                 TestableSpeechComponent->GenerateSpeechSync(TEXT("sampletext"), EVoiceId::Joanna);
                 // then an error should be logged 
                 HasMetExpectedErrors();
+                // and the visemes of the successful request should not be kept without their audio
+                TestTrue("VisemeEventArray is empty after call", TestableSpeechComponent->GetVisemeEventArray().Num() == 0);
             });
 
             It("should log an error when an error occurs while generating visemes and log the error from Polly", [this]() {
@@ -425,6 +840,8 @@ void::AmazonPollySpec::Define() {
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"k\"}\n{\"time\":237,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":562,\"type\":\"viseme\",\"value\":\"sil\"}\n{\"time\":1330,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":1442,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":1505,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1642,\"type\":\"viseme\",\"value\":\"e\"}\n{\"time\":1692,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":1755,\"type\":\"viseme\",\"value\":\"i\"}\n{\"time\":1817,\"type\":\"viseme\",\"value\":\"s\"}\n{\"time\":1905,\"type\":\"viseme\",\"value\":\"S\"}\n{\"time\":2030,\"type\":\"viseme\",\"value\":\"o\"}\n{\"time\":2192,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":2230,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":2330,\"type\":\"viseme\",\"value\":\"@\"}\n{\"time\":2542,\"type\":\"viseme\",\"value\":\"sil\"}"));
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("@#ABCDE12345"));
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":62,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":187,\"type\":\"viseme\",\"value\":\"E\"}\n{\"time\":237,\"type\":\"viseme\",\"value\":\"s\"}\n{\"time\":300,\"type\":\"viseme\",\"value\":\"E\"}\n{\"time\":375,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":450,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":562,\"type\":\"viseme\",\"value\":\"k\"}\n{\"time\":625,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":712,\"type\":\"viseme\",\"value\":\"r\"}\n{\"time\":750,\"type\":\"viseme\",\"value\":\"@\"}\n{\"time\":937,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1037,\"type\":\"viseme\",\"value\":\"@\"}\n{\"time\":1062,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1125,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1200,\"type\":\"viseme\",\"value\":\"u\"}\n{\"time\":1250,\"type\":\"viseme\",\"value\":\"E\"}\n{\"time\":1312,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1487,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1562,\"type\":\"viseme\",\"value\":\"u\"}\n{\"time\":1587,\"type\":\"viseme\",\"value\":\"E\"}\n{\"time\":1625,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1700,\"type\":\"viseme\",\"value\":\"t\"}\n{\"time\":1750,\"type\":\"viseme\",\"value\":\"i\"}\n{\"time\":1875,\"type\":\"viseme\",\"value\":\"T\"}\n{\"time\":1937,\"type\":\"viseme\",\"value\":\"r\"}\n{\"time\":2087,\"type\":\"viseme\",\"value\":\"i\"}\n{\"time\":2275,\"type\":\"viseme\",\"value\":\"sil\"}"));
+                // and a SpeechComponent that does not cache speech
+                TestableSpeechComponent->bUseSpeechCache = false;
                 // when GenerateSpeechSync is invoked for the first time
                 TestableSpeechComponent->GenerateSpeechSync("sampletext", EVoiceId::Joanna);
                 // then VisemeEventArray should be filled with 16 visemes from the first PollyVisemeOutcome object 
@@ -543,6 +960,8 @@ void::AmazonPollySpec::Define() {
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"));
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Hi! My name is Chandler!"));
                 MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // and a SpeechComponent that does not cache speech
+                TestableSpeechComponent->bUseSpeechCache = false;
                 // when GenerateSpeechSync is invoked for the first time
                 TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Chandler!", EVoiceId::Joey);
                 // then the Audiobuffer should be filled with the buffer data from
@@ -557,6 +976,1517 @@ void::AmazonPollySpec::Define() {
             });
         });
 
+        Describe("GenerateSpeechSync(text, VoiceId) request concurrency", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should wait for the slower of the audio and viseme calls rather than their sum", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given an audio call taking 0.3s and a viseme call taking 0.2s
+                const float AudioDelaySeconds = 0.3f;
+                const float VisemeDelaySeconds = 0.2f;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Hi! My name is Chandler!"), AudioDelaySeconds);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"), VisemeDelaySeconds);
+                // when GenerateSpeechSync is invoked
+                const double StartTime = FPlatformTime::Seconds();
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Chandler!", EVoiceId::Joey);
+                const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+                // then the join time should be max(a,b) = 0.3s, well below a+b = 0.5s
+                TestTrue("GenerateSpeechSync waits for the slower call", ElapsedSeconds >= FMath::Max(AudioDelaySeconds, VisemeDelaySeconds) - 0.01);
+                TestTrue("GenerateSpeechSync does not wait for both calls back-to-back", ElapsedSeconds < AudioDelaySeconds + VisemeDelaySeconds - 0.05);
+                // and both results should be stored
+                TestEqual("Audiobuffer holds the audio", TestableSpeechComponent->GetAudiobuffer().Num(), 24);
+                TestEqual("VisemeEventArray holds the visemes", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+                TestTrue("All lambdas invoked during GenerateSpeechSync", MockPollyClient->SynthesizeSpeechBehaviors.IsEmpty());
+            });
+
+            It("should cancel the in-flight viseme call when the audio call fails", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given an audio call that fails immediately and a viseme call that would take 2s
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome());
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                AddExpectedError(TEXT("Polly failed to generate audio file. Error: error"), EAutomationExpectedErrorFlags::Contains, 1);
+                // when GenerateSpeechSync is invoked
+                const double StartTime = FPlatformTime::Seconds();
+                TestableSpeechComponent->GenerateSpeechSync("sampletext", EVoiceId::Joanna);
+                const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+                // then only the audio error should be logged, and the viseme call should be aborted early
+                HasMetExpectedErrors();
+                TestTrue("The viseme call is aborted instead of running to completion", ElapsedSeconds < 1.0);
+                TestTrue("Audiobuffer is empty after call", TestableSpeechComponent->GetAudiobuffer().Num() == 0);
+                TestTrue("VisemeEventArray is empty after call", TestableSpeechComponent->GetVisemeEventArray().Num() == 0);
+            });
+
+            It("should cancel the in-flight audio call when the viseme call fails", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given an audio call that would take 2s and a viseme call that fails after 0.1s
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Hi! My name is Chandler!"), 2.0f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome(), 0.1f);
+                AddExpectedError(TEXT("Polly failed to generate visemes. Error: error"), EAutomationExpectedErrorFlags::Contains, 1);
+                // when GenerateSpeechSync is invoked
+                const double StartTime = FPlatformTime::Seconds();
+                TestableSpeechComponent->GenerateSpeechSync("sampletext", EVoiceId::Joanna);
+                const double ElapsedSeconds = FPlatformTime::Seconds() - StartTime;
+                // then only the viseme error should be logged, and no audio should be kept
+                HasMetExpectedErrors();
+                TestTrue("The audio call is aborted instead of running to completion", ElapsedSeconds < 1.0);
+                TestTrue("Audiobuffer is empty after call", TestableSpeechComponent->GetAudiobuffer().Num() == 0);
+            });
+        });
+
+        Describe("Progressive playback (bStreamAudio)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should keep the byte order of a FPollyAudioRingBuffer across the wrap-around", [this]() {
+                // given a ring buffer of 8 bytes that has been partially written and read
+                FPollyAudioRingBuffer RingBuffer(8);
+                const uint8 FirstWrite[] = { 1, 2, 3, 4, 5, 6 };
+                const uint8 SecondWrite[] = { 7, 8, 9, 10, 11, 12, 13 };
+                uint8 ReadBytes[8] = {};
+                TestEqual("The first write fits", RingBuffer.Write(FirstWrite, 6), 6);
+                TestEqual("The first read returns the requested bytes", RingBuffer.Read(ReadBytes, 4), 4);
+                // when more bytes are written than there is room left
+                const int32 BytesWritten = RingBuffer.Write(SecondWrite, 7);
+                // then only the free space is used and the bytes come out in order
+                TestEqual("Only the free space is written", BytesWritten, 6);
+                TestEqual("The ring buffer is full", RingBuffer.Num(), RingBuffer.GetCapacity());
+                TestEqual("The second read drains the ring buffer", RingBuffer.Read(ReadBytes, 8), 8);
+                const uint8 ExpectedBytes[] = { 5, 6, 7, 8, 9, 10, 11, 12 };
+                TestTrue("Bytes are read in the order they were written", FMemory::Memcmp(ReadBytes, ExpectedBytes, 8) == 0);
+                TestEqual("The ring buffer is empty", RingBuffer.Num(), 0);
+            });
+
+            It("should overflow a full FPollyAudioRingBuffer instead of waiting for the consumer", [this]() {
+                // given a ring buffer of 4 bytes
+                FPollyAudioRingBuffer RingBuffer(4);
+                const uint8 FirstWrite[] = { 1, 2, 3, 4, 5, 6 };
+                const uint8 SecondWrite[] = { 7, 8 };
+                uint8 ReadBytes[8] = {};
+                // when more bytes are written than it can hold, with no consumer reading them
+                RingBuffer.WriteAll(FirstWrite, 6);
+                TestEqual("The bytes that did not fit are kept in the overflow", RingBuffer.Num(), 6);
+                TestEqual("The first read stops after part of the ring", RingBuffer.Read(ReadBytes, 3), 3);
+                RingBuffer.WriteAll(SecondWrite, 2);
+                // then every byte is read once, in the order it was written
+                TestEqual("The second read drains the ring and the overflow", RingBuffer.Read(ReadBytes + 3, 5), 5);
+                const uint8 ExpectedBytes[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+                TestTrue("Bytes are read in the order they were written", FMemory::Memcmp(ReadBytes, ExpectedBytes, 8) == 0);
+                TestEqual("Every byte is counted as written", RingBuffer.GetTotalBytesWritten(), static_cast<int64>(8));
+                TestEqual("The ring buffer is empty", RingBuffer.Num(), 0);
+            });
+
+            It("should stream the audio into the sound returned by StartSpeech", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->StreamChunkBytes = 4;
+                TestableSpeechComponent->bStreamAudio = true;
+                // given an audio stream delivered in 4 byte chunks
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Hi! My name is Chandler!"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // when GenerateSpeechSync and StartSpeech are invoked
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Chandler!", EVoiceId::Joey);
+                UPollyStreamingSoundWave* PollyAudio = Cast<UPollyStreamingSoundWave>(TestableSpeechComponent->StartSpeech());
+                // then the audio is not materialized in the Audiobuffer but read from the stream by the sound
+                TestTrue("StartSpeech returns a streaming sound", PollyAudio != nullptr);
+                if (PollyAudio == nullptr) {
+                    return;
+                }
+                TestTrue("Audiobuffer is not filled in streaming mode", TestableSpeechComponent->GetAudiobuffer().Num() == 0);
+                TArray<uint8> PCM;
+                TestEqual("The first callback returns the requested samples", PollyAudio->OnGeneratePCMAudio(PCM, 8), 8);
+                TestTrue("The first callback returns the start of the stream", FMemory::Memcmp(PCM.GetData(), "Hi! My name is C", 16) == 0);
+                TestEqual("The second callback returns the rest of the stream", PollyAudio->OnGeneratePCMAudio(PCM, 8), 4);
+                TestTrue("The second callback returns the end of the stream", FMemory::Memcmp(PCM.GetData(), "handler!", 8) == 0);
+                TestEqual("The stream is over", PollyAudio->OnGeneratePCMAudio(PCM, 8), 0);
+                TestEqual("No underflow occurred", PollyAudio->GetUnderflowCount(), 0);
+            });
+
+            It("should keep the current speech when the streamed visemes cannot be parsed", [this]() {
+                AddExpectedError(TEXT("Failed to parse json formatted viseme sequence returned by Amazon Polly"), EAutomationExpectedErrorFlags::Contains);
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a generated speech
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Hi! My name is Chandler!"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":125,\"type\":\"viseme\",\"value\":\"p\"}"));
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Chandler!", EVoiceId::Joey);
+                // when the next speech is streamed with visemes that are not a Json
+                TestableSpeechComponent->bStreamAudio = true;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("Could I BE any more streamed?"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("NOT A JSON"));
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Could I BE any more streamed?", EVoiceId::Joey);
+                // then the generation fails and the previous speech is left as it was
+                TestFalse("GenerateSpeechSync fails", bGenerated);
+                TestEqual("The visemes of the previous speech are kept", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+                TestTrue("The audio of the previous speech is kept", TestableSpeechComponent->GetAudiobuffer().Num() > 0);
+                HasMetExpectedErrors();
+            });
+
+            It("should play silence until the jitter buffer is filled", [this]() {
+                // given a stream that has only delivered 2 of the 8 bytes of jitter buffer
+                TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer = MakeShared<FPollyAudioRingBuffer, ESPMode::ThreadSafe>(64);
+                const uint8 Bytes[] = { 1, 2 };
+                RingBuffer->Write(Bytes, 2);
+                UPollyStreamingSoundWave* PollyAudio = NewObject<UPollyStreamingSoundWave>();
+                PollyAudio->SetRingBuffer(RingBuffer, 8);
+                // when the audio thread asks for samples
+                TArray<uint8> PCM;
+                const int32 SamplesGenerated = PollyAudio->OnGeneratePCMAudio(PCM, 4);
+                // then silence is returned and the buffered bytes are kept
+                TestEqual("Silence is generated", SamplesGenerated, 4);
+                TestTrue("The samples are silent", PCM.Num() == 8 && PCM[0] == 0 && PCM[1] == 0);
+                TestEqual("The buffered bytes are kept", RingBuffer->Num(), 2);
+                TestEqual("Priming is not an underflow", PollyAudio->GetUnderflowCount(), 0);
+            });
+
+            It("should pad with silence and count an underflow when the stream falls behind", [this]() {
+                // given a primed stream holding 8 bytes that is still downloading
+                TSharedRef<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer = MakeShared<FPollyAudioRingBuffer, ESPMode::ThreadSafe>(64);
+                const uint8 Bytes[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+                RingBuffer->Write(Bytes, 8);
+                UPollyStreamingSoundWave* PollyAudio = NewObject<UPollyStreamingSoundWave>();
+                PollyAudio->SetRingBuffer(RingBuffer, 4);
+                // when the audio thread asks for more samples than are available
+                TArray<uint8> PCM;
+                const int32 SamplesGenerated = PollyAudio->OnGeneratePCMAudio(PCM, 8);
+                // then the available bytes are followed by silence and the underflow is counted
+                TestEqual("All requested samples are generated", SamplesGenerated, 8);
+                TestTrue("The available bytes are played", FMemory::Memcmp(PCM.GetData(), Bytes, 8) == 0);
+                TestTrue("The missing bytes are silent", PCM[8] == 0 && PCM[15] == 0);
+                TestEqual("The underflow is counted", PollyAudio->GetUnderflowCount(), 1);
+            });
+        });
+
+        Describe("Sentence pipelining (bPipelineSentences)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should split text at sentence boundaries only", [this]() {
+                // given sentences containing a decimal number and an abbreviation
+                const FString Text = TEXT("Hi! My name is Joanna. It costs 3.50 dollars, e.g. today.");
+                // when the text is split sentence by sentence
+                TArray<FString> Segments = SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, true);
+                // then neither the number nor the abbreviation end a sentence
+                TestEqual("Text is split into 3 sentences", Segments.Num(), 3);
+                if (Segments.Num() == 3) {
+                    TestEqual("First sentence", Segments[0], FString(TEXT("Hi!")));
+                    TestEqual("Second sentence", Segments[1], FString(TEXT("My name is Joanna.")));
+                    TestEqual("Third sentence", Segments[2], FString(TEXT("It costs 3.50 dollars, e.g. today.")));
+                }
+            });
+
+            It("should pack sentences into as few segments as the Polly limit allows", [this]() {
+                // given 4 sentences of 1000 characters each
+                const FString Sentence = FString::ChrN(999, TEXT('A')) + TEXT(".");
+                const FString Text = FString::Join(TArray<FString>{ Sentence, Sentence, Sentence, Sentence }, TEXT(" "));
+                // when the text is split without splitting sentences
+                TArray<FString> Segments = SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, false);
+                // then 2 sentences fit into each segment
+                TestEqual("Text is split into 2 segments", Segments.Num(), 2);
+                for (const FString& Segment : Segments) {
+                    TestEqual("Each segment holds 2 sentences", Segment.Len(), 2001);
+                }
+                TestEqual("Short text is kept as is", SpeechTextUtils::SplitText(TEXT(" Hi! Bye. "), 3000, false)[0], FString(TEXT(" Hi! Bye. ")));
+            });
+
+            It("should split a sentence without punctuation at whitespace", [this]() {
+                // given a 5000 character sentence without any punctuation
+                TArray<FString> Words;
+                Words.Init(TEXT("word"), 1000);
+                const FString Text = FString::Join(Words, TEXT(" "));
+                // when the text is split
+                TArray<FString> Segments = SpeechTextUtils::SplitText(Text, SpeechTextUtils::PollyMaxTextLength, false);
+                // then every segment fits into a request and no word is cut
+                TestEqual("Text is split into 2 segments", Segments.Num(), 2);
+                for (const FString& Segment : Segments) {
+                    TestTrue("Segment fits into a request", Segment.Len() <= SpeechTextUtils::PollyMaxTextLength);
+                    TestTrue("Segment starts with a whole word", Segment.StartsWith(TEXT("word")));
+                    TestTrue("Segment ends with a whole word", Segment.EndsWith(TEXT("word")));
+                }
+                TestEqual("No text is lost", FString::Join(Segments, TEXT(" ")), Text);
+            });
+
+            It("should synthesize text over the Polly limit in several requests and stitch the results", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given 2 segments, the first one 100ms long
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(32));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":10,\"type\":\"viseme\",\"value\":\"k\"}"));
+                const FString Sentence = FString::ChrN(1999, TEXT('A')) + TEXT(".");
+                // when GenerateSpeechSync is invoked without pipelining
+                TestableSpeechComponent->GenerateSpeechSync(Sentence + TEXT(" ") + Sentence, EVoiceId::Joanna);
+                // then both segments are synthesized before it returns
+                TestTrue("All lambdas invoked during GenerateSpeechSync", MockPollyClient->SynthesizeSpeechBehaviors.IsEmpty());
+                TestEqual("Audiobuffer holds the audio of both segments", TestableSpeechComponent->GetAudiobuffer().Num(), 3232);
+                TArray<VisemeEvent> VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestEqual("VisemeEventArray holds the visemes of both segments", VisemeEventArray.Num(), 2);
+                if (VisemeEventArray.Num() == 2) {
+                    TestEqual("The first segment keeps its timing", VisemeEventArray[0].TimeMilliseconds, 50);
+                    TestEqual("The second segment starts where the first one ends", VisemeEventArray[1].TimeMilliseconds, 110);
+                    TestEqual("The second segment keeps its viseme", VisemeEventArray[1].Viseme, EViseme::K);
+                }
+            });
+
+            It("should start speaking after the first sentence and append the next one while playing", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TestableSpeechComponent->bPipelineSentences = true;
+                // given a first sentence that is ready at once and a second one taking 0.3s
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(32), 0.3f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":10,\"type\":\"viseme\",\"value\":\"k\"}"), 0.3f);
+                // when GenerateSpeechSync and StartSpeech are invoked
+                const double StartTime = FPlatformTime::Seconds();
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna);
+                TestTrue("GenerateSpeechSync returns before the second sentence is ready", FPlatformTime::Seconds() - StartTime < 0.25);
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                TestNotNull("StartSpeech returns a sound", PollyAudio);
+                // then the last viseme is held while the second sentence is pending
+                TestableSpeechComponent->PlayNextViseme();
+                TestTrue("Speech waits for the pending sentence", TestableSpeechComponent->IsSpeaking());
+                TestEqual("The last viseme is held", TestableSpeechComponent->GetCurrentViseme(), EViseme::P);
+                // and the second sentence is played once it has been appended
+                TestableSpeechComponent->WaitForSegmentPipeline();
+                TestEqual("No segment is pending", TestableSpeechComponent->GetPendingSegmentCount(), 0);
+                if (PollyAudio != nullptr) {
+                    TestEqual("The audio of the second sentence is queued to the sound", Cast<UPollyBufferedSoundWave>(PollyAudio)->GetRemainingAudioBytes(), (int64)3232);
+                }
+                TestableSpeechComponent->PlayNextViseme();
+                TestEqual("The viseme of the second sentence is played", TestableSpeechComponent->GetCurrentViseme(), EViseme::K);
+                // the sound ran dry while the second sentence was pending, so its visemes follow the silence played meanwhile
+                TestTrue("The viseme of the second sentence is offset", TestableSpeechComponent->GetVisemeEventArray()[1].TimeMilliseconds >= 110);
+                TestableSpeechComponent->PlayNextViseme();
+                TestFalse("Speech ends after the second sentence", TestableSpeechComponent->IsSpeaking());
+            });
+        });
+
+        Describe("Incremental text (AppendText / FinishText)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should only end a phrase once the text following the boundary has arrived", [this]() {
+                FSpeechPhraseSegmenter Segmenter;
+                TArray<FString> Phrases;
+                // given tokens splitting a decimal number and a sentence boundary
+                for (const TCHAR* Token : { TEXT("It costs 3"), TEXT("."), TEXT("50"), TEXT(" dollars"), TEXT("."), TEXT(" ") }) {
+                    Segmenter.Append(Token, Phrases);
+                }
+                // then no phrase is complete until the next word shows it is a new sentence
+                TestEqual("No phrase is complete yet", Phrases.Num(), 0);
+                Segmenter.Append(TEXT("Next"), Phrases);
+                TestEqual("The sentence is complete", Phrases.Num(), 1);
+                if (Phrases.Num() == 1) {
+                    TestEqual("The decimal number is kept", Phrases[0], FString(TEXT("It costs 3.50 dollars.")));
+                }
+                // and the remaining text is the last phrase
+                Segmenter.Append(TEXT(" one"), Phrases);
+                Segmenter.Flush(Phrases);
+                TestEqual("The remaining text is flushed", Phrases.Num(), 2);
+                if (Phrases.Num() == 2) {
+                    TestEqual("The last phrase", Phrases[1], FString(TEXT("Next one")));
+                }
+            });
+
+            It("should end a long phrase at a clause boundary", [this]() {
+                FSpeechPhraseSegmenter Segmenter(10);
+                TArray<FString> Phrases;
+                // when a sentence with an early and a late comma is appended
+                Segmenter.Append(TEXT("Well, this is a long clause, and more"), Phrases);
+                // then only the comma past the minimum clause length ends a phrase
+                TestEqual("One phrase is complete", Phrases.Num(), 1);
+                if (Phrases.Num() == 1) {
+                    TestEqual("The phrase ends at the second comma", Phrases[0], FString(TEXT("Well, this is a long clause,")));
+                }
+            });
+
+            It("should synthesize the phrases of a scripted token source in order and stitch them", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given 3 phrases of 100ms each
+                for (int32 PhraseIndex = 0; PhraseIndex < 3; PhraseIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // when the text arrives token by token
+                const TArray<FString> Tokens = { TEXT("Hi"), TEXT("!"), TEXT(" My"), TEXT(" name"), TEXT(" is"), TEXT(" Joanna"), TEXT("."), TEXT(" How"), TEXT(" are"), TEXT(" you"), TEXT("?") };
+                for (const FString& Token : Tokens) {
+                    TestableSpeechComponent->AppendText(Token, EVoiceId::Joanna);
+                }
+                TestableSpeechComponent->FinishText();
+                TestableSpeechComponent->WaitForSegmentPipeline();
+                // then every phrase is synthesized once, in order
+                TArray<FString> RequestedTexts = MockPollyClient->GetRequestedAudioTexts();
+                TestEqual("3 phrases are synthesized", RequestedTexts.Num(), 3);
+                if (RequestedTexts.Num() == 3) {
+                    TestEqual("First phrase", RequestedTexts[0], FString(TEXT("Hi!")));
+                    TestEqual("Second phrase", RequestedTexts[1], FString(TEXT("My name is Joanna.")));
+                    TestEqual("Third phrase", RequestedTexts[2], FString(TEXT("How are you?")));
+                }
+                // and the phrases follow each other without gaps
+                TestEqual("Audiobuffer holds the audio of every phrase", TestableSpeechComponent->GetAudiobuffer().Num(), 9600);
+                TArray<VisemeEvent> VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestEqual("VisemeEventArray holds the visemes of every phrase", VisemeEventArray.Num(), 3);
+                if (VisemeEventArray.Num() == 3) {
+                    TestEqual("First phrase viseme", VisemeEventArray[0].TimeMilliseconds, 50);
+                    TestEqual("Second phrase viseme", VisemeEventArray[1].TimeMilliseconds, 150);
+                    TestEqual("Third phrase viseme", VisemeEventArray[2].TimeMilliseconds, 250);
+                }
+            });
+
+            It("should keep speaking while the text source is still producing text", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"k\"}"));
+                // given a first phrase that has been synthesized
+                TestableSpeechComponent->AppendText(TEXT("Hi! My"), EVoiceId::Joanna);
+                const double Deadline = FPlatformTime::Seconds() + 2.0;
+                while (TestableSpeechComponent->GetPendingSegmentCount() > 0 && FPlatformTime::Seconds() < Deadline) {
+                    FPlatformProcess::Sleep(0.001f);
+                }
+                // when the speech is started before the text is finished
+                TestNotNull("StartSpeech returns a sound", TestableSpeechComponent->StartSpeech());
+                TestableSpeechComponent->PlayNextViseme();
+                // then the last viseme is held while more text may arrive
+                TestTrue("Speech waits for more text", TestableSpeechComponent->IsSpeaking());
+                TestEqual("The last viseme is held", TestableSpeechComponent->GetCurrentViseme(), EViseme::P);
+                // and the next phrase is played once the text is finished
+                TestableSpeechComponent->AppendText(TEXT(" name is Joanna."), EVoiceId::Joanna);
+                TestableSpeechComponent->FinishText();
+                TestableSpeechComponent->WaitForSegmentPipeline();
+                TestableSpeechComponent->PlayNextViseme();
+                TestEqual("The viseme of the next phrase is played", TestableSpeechComponent->GetCurrentViseme(), EViseme::K);
+                TestableSpeechComponent->PlayNextViseme();
+                TestFalse("Speech ends after the last phrase", TestableSpeechComponent->IsSpeaking());
+            });
+        });
+
+        Describe("Barge-in (StopSpeech / CancelSpeech)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should abort a GenerateSpeechSync call that is waiting for Polly", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given audio and viseme calls that would take 2s
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                UTestableSpeechComponent* SpeechComponent = TestableSpeechComponent;
+                const double StartTime = FPlatformTime::Seconds();
+                TFuture<bool> Generated = Async(EAsyncExecution::ThreadPool, [SpeechComponent]() {
+                    return SpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna);
+                });
+                while (!MockPollyClient->SynthesizeSpeechBehaviors.IsEmpty() && FPlatformTime::Seconds() - StartTime < 1.0) {
+                    FPlatformProcess::Sleep(0.001f);
+                }
+                // when the speech is stopped while the calls are in flight
+                TestableSpeechComponent->StopSpeech();
+                // then GenerateSpeechSync fails right away instead of waiting for Polly
+                TestFalse("GenerateSpeechSync reports the cancellation", Generated.Get());
+                TestTrue("The calls are aborted instead of running to completion", FPlatformTime::Seconds() - StartTime < 1.0);
+                TestEqual("No visemes are stored", TestableSpeechComponent->GetVisemeEventArray().Num(), 0);
+                FSpeechCancelMetrics CancelMetrics = TestableSpeechComponent->GetCancelMetrics();
+                TestEqual("The cancel is counted", CancelMetrics.NumCancels, 1);
+                TestTrue("The time until the aborted calls returned is measured", CancelMetrics.LastCancelToIdleMs > 0.0 && CancelMetrics.LastCancelToIdleMs < 1000.0);
+            });
+
+            It("should silence the sound and reset the viseme within the call", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":50,\"type\":\"viseme\",\"value\":\"k\"}"));
+                // given a speech that is playing
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna);
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                TestNotNull("StartSpeech returns a sound", PollyAudio);
+                // when the speech is stopped
+                TestableSpeechComponent->StopSpeech();
+                // then playback is over and the unplayed audio is dropped
+                TestFalse("The speech is no longer playing", TestableSpeechComponent->IsSpeaking());
+                TestEqual("The viseme is reset", TestableSpeechComponent->GetCurrentViseme(), EViseme::Sil);
+                if (PollyAudio != nullptr) {
+                    TestEqual("The unplayed audio is dropped", Cast<UPollyBufferedSoundWave>(PollyAudio)->GetRemainingAudioBytes(), (int64)0);
+                }
+                TestTrue("Silence is reached within a frame", TestableSpeechComponent->GetCancelMetrics().LastCancelToSilenceMs < 1000.0 / 60.0);
+                // and new speech can be generated right away
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(32));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"p\"}"));
+                TestTrue("New speech is generated", TestableSpeechComponent->GenerateSpeechSync("Sorry?", EVoiceId::Joanna));
+            });
+
+            It("should end a streamed sound at the next audio callback", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TestableSpeechComponent->bStreamAudio = true;
+                TestableSpeechComponent->StreamingJitterBufferMs = 0;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a streamed speech that is playing
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna);
+                UPollyStreamingSoundWave* PollyAudio = Cast<UPollyStreamingSoundWave>(TestableSpeechComponent->StartSpeech());
+                TestNotNull("StartSpeech returns a streaming sound", PollyAudio);
+                // when the speech is stopped
+                TestableSpeechComponent->StopSpeech();
+                // then the sound ends instead of playing the buffered audio
+                if (PollyAudio != nullptr) {
+                    TArray<uint8> PCM;
+                    TestEqual("The stream is over", PollyAudio->OnGeneratePCMAudio(PCM, 160), 0);
+                }
+            });
+
+            It("should let the playing speech end after the segments it already has when cancelled", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TestableSpeechComponent->bPipelineSentences = true;
+                // given a second sentence that would take 2s
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"k\"}"), 2.0f);
+                TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna);
+                TestableSpeechComponent->StartSpeech();
+                // when the synthesis is cancelled while the first sentence plays
+                const double StartTime = FPlatformTime::Seconds();
+                TestableSpeechComponent->CancelSpeech();
+                TestableSpeechComponent->WaitForSegmentPipeline();
+                // then the second sentence is aborted and the speech ends after the first one
+                TestTrue("The pending sentence is aborted", FPlatformTime::Seconds() - StartTime < 1.0);
+                TestTrue("The first sentence keeps playing", TestableSpeechComponent->IsSpeaking());
+                TestableSpeechComponent->PlayNextViseme();
+                TestFalse("The speech ends after the first sentence", TestableSpeechComponent->IsSpeaking());
+            });
+        });
+
+        Describe("Speech queue (EnqueueSpeech)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            AfterEach([this]() {
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should play queued lines back to back in a single speech", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given 3 lines of 100ms each
+                for (int32 LineIndex = 0; LineIndex < 3; LineIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // when the lines are queued and the first one is started as soon as it is ready
+                TestTrue("First line is queued", TestableSpeechComponent->EnqueueSpeech("Hi!", EVoiceId::Joanna));
+                TestTrue("Second line is queued", TestableSpeechComponent->EnqueueSpeech("My name is Joanna.", EVoiceId::Joanna));
+                TestTrue("Third line is queued", TestableSpeechComponent->EnqueueSpeech("How are you?", EVoiceId::Joanna));
+                TestTrue("The first line becomes the speech", WaitUntil([this]() { return TestableSpeechComponent->GetQueuedSpeechCount() < 3; }));
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                TestNotNull("StartSpeech returns a sound", PollyAudio);
+                // then the next lines are appended to the playing speech without a gap
+                TestTrue("All lines are appended", WaitUntil([this]() { return TestableSpeechComponent->GetQueuedSpeechCount() == 0 && TestableSpeechComponent->GetPendingSegmentCount() == 0; }));
+                TArray<FString> RequestedTexts = MockPollyClient->GetRequestedAudioTexts();
+                TestEqual("Every line is synthesized once", RequestedTexts.Num(), 3);
+                if (RequestedTexts.Num() == 3) {
+                    TestEqual("Lines are synthesized in order", RequestedTexts[2], FString(TEXT("How are you?")));
+                }
+                if (PollyAudio != nullptr) {
+                    TestEqual("The audio of every line is queued to the sound", Cast<UPollyBufferedSoundWave>(PollyAudio)->GetRemainingAudioBytes(), (int64)9600);
+                }
+                TArray<VisemeEvent> VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestEqual("VisemeEventArray holds the visemes of every line", VisemeEventArray.Num(), 3);
+                if (VisemeEventArray.Num() == 3) {
+                    TestEqual("Second line starts where the first one ends", VisemeEventArray[1].TimeMilliseconds, 150);
+                    TestEqual("Third line starts where the second one ends", VisemeEventArray[2].TimeMilliseconds, 250);
+                }
+            });
+
+            It("should not replace a generated speech that has not started", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"k\"}"));
+                // given a generated speech that has not been started
+                TestTrue("The speech is generated", TestableSpeechComponent->GenerateSpeechSync("Hi! My name is Joanna.", EVoiceId::Joanna));
+                // when a line is queued and synthesized
+                TestTrue("The line is queued", TestableSpeechComponent->EnqueueSpeech("How are you?", EVoiceId::Joanna));
+                WaitUntil([MockPollyClient]() { return MockPollyClient->GetRequestedAudioTexts().Num() == 2; });
+                FPlatformProcess::Sleep(0.05f);
+                // then the line waits for the generated speech
+                TestEqual("The line stays queued", TestableSpeechComponent->GetQueuedSpeechCount(), 1);
+                TArray<VisemeEvent> VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestTrue("The generated speech is kept", VisemeEventArray.Num() == 1 && VisemeEventArray[0].Viseme == EViseme::P);
+                // and becomes the speech once the generated speech played
+                TestNotNull("StartSpeech returns a sound", TestableSpeechComponent->StartSpeech());
+                TestableSpeechComponent->PlayNextViseme();
+                TestTrue("The line becomes the speech", WaitUntil([this]() { return TestableSpeechComponent->GetQueuedSpeechCount() == 0; }));
+                VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestTrue("The visemes of the line replace the played speech", VisemeEventArray.Num() == 1 && VisemeEventArray[0].Viseme == EViseme::K);
+            });
+
+            It("should reject lines beyond the queue depth", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TestableSpeechComponent->MaxQueuedUtterances = 2;
+                // given 2 queued lines that take 2s to synthesize
+                for (int32 LineIndex = 0; LineIndex < 2; LineIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                }
+                TestableSpeechComponent->EnqueueSpeech("Hi!", EVoiceId::Joanna);
+                TestableSpeechComponent->EnqueueSpeech("My name is Joanna.", EVoiceId::Joanna);
+                AddExpectedError(TEXT("the speech queue is full"), EAutomationExpectedErrorFlags::Contains, 1);
+                // when a third line is queued
+                const bool bQueued = TestableSpeechComponent->EnqueueSpeech("How are you?", EVoiceId::Joanna);
+                // then it is rejected
+                TestFalse("The third line is rejected", bQueued);
+                TestEqual("The queue keeps its depth", TestableSpeechComponent->GetQueuedSpeechCount(), 2);
+            });
+
+            It("should only synthesize the prefetch depth ahead of time", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TestableSpeechComponent->SpeechQueuePrefetchDepth = 1;
+                // given 3 queued lines that take 2s to synthesize
+                for (int32 LineIndex = 0; LineIndex < 3; LineIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                }
+                TestableSpeechComponent->EnqueueSpeech("Hi!", EVoiceId::Joanna);
+                TestableSpeechComponent->EnqueueSpeech("My name is Joanna.", EVoiceId::Joanna);
+                TestableSpeechComponent->EnqueueSpeech("How are you?", EVoiceId::Joanna);
+                // when the queue has had time to prefetch
+                WaitUntil([MockPollyClient]() { return MockPollyClient->GetRequestedAudioTexts().Num() > 0; });
+                FPlatformProcess::Sleep(0.05f);
+                // then only the first line is being synthesized
+                TestEqual("Only the prefetch depth is synthesized", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+            });
+
+            It("should clear the queue when the speech is stopped", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 LineIndex = 0; LineIndex < 2; LineIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                }
+                TestableSpeechComponent->EnqueueSpeech("Hi!", EVoiceId::Joanna);
+                TestableSpeechComponent->EnqueueSpeech("My name is Joanna.", EVoiceId::Joanna);
+                // when the speech is stopped
+                TestableSpeechComponent->StopSpeech();
+                // then no line is left
+                TestEqual("The queue is empty", TestableSpeechComponent->GetQueuedSpeechCount(), 0);
+                TestEqual("No visemes are stored", TestableSpeechComponent->GetVisemeEventArray().Num(), 0);
+            });
+        });
+
+        Describe("Speculative prefetch (PrefetchSpeech)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should generate a prefetched line without calling Polly again", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                const FSpeechPrefetchStats StatsBefore = USpeechComponent::GetPrefetchStats();
+                // given a prefetched line
+                TestTrue("The line is prefetched", TestableSpeechComponent->PrefetchSpeech("Would you like some tea?", EVoiceId::Joanna));
+                // when the same line is generated
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Would you like some tea?", EVoiceId::Joanna);
+                // then the prefetched results are used
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Polly is only called by the prefetch", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+                TestEqual("The audio of the prefetch is used", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+                TestEqual("The visemes of the prefetch are used", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+                const FSpeechPrefetchStats StatsAfter = USpeechComponent::GetPrefetchStats();
+                TestEqual("One prefetch is counted", StatsAfter.NumPrefetches - StatsBefore.NumPrefetches, 1);
+                TestEqual("One hit is counted", StatsAfter.NumHits - StatsBefore.NumHits, 1);
+                TestEqual("No miss is counted", StatsAfter.NumMisses - StatsBefore.NumMisses, 0);
+            });
+
+            It("should count a miss for a line that was not prefetched", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 RequestIndex = 0; RequestIndex < 2; RequestIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                const FSpeechPrefetchStats StatsBefore = USpeechComponent::GetPrefetchStats();
+                // given a prefetched line
+                TestableSpeechComponent->PrefetchSpeech("Follow me.", EVoiceId::Joanna);
+                // when another line is generated
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Wait here.", EVoiceId::Joanna);
+                // then the line is synthesized, and the prefetch is kept
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Both lines are synthesized", MockPollyClient->GetRequestedAudioTexts().Num(), 2);
+                const FSpeechPrefetchStats StatsAfter = USpeechComponent::GetPrefetchStats();
+                TestEqual("One miss is counted", StatsAfter.NumMisses - StatsBefore.NumMisses, 1);
+                TestTrue("The prefetch is kept", TestableSpeechComponent->CancelPrefetchSpeech("Follow me.", EVoiceId::Joanna));
+            });
+
+            It("should abort and count a cancelled prefetch as wasted", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200), 2.0f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 2.0f);
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(6400));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                const FSpeechPrefetchStats StatsBefore = USpeechComponent::GetPrefetchStats();
+                // given a line whose prefetch is still in flight
+                TestableSpeechComponent->PrefetchSpeech("Goodbye!", EVoiceId::Joanna);
+                // when the prefetch is cancelled
+                const double CancelSeconds = FPlatformTime::Seconds();
+                TestTrue("The prefetch is cancelled", TestableSpeechComponent->CancelPrefetchSpeech("Goodbye!", EVoiceId::Joanna));
+                // then the line is synthesized again when it is generated
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Goodbye!", EVoiceId::Joanna);
+                TestTrue("The speech is generated", bGenerated);
+                TestTrue("The prefetch does not delay the speech", FPlatformTime::Seconds() - CancelSeconds < 1.0);
+                TestEqual("The audio is synthesized again", TestableSpeechComponent->GetAudiobuffer().Num(), 6400);
+                const FSpeechPrefetchStats StatsAfter = USpeechComponent::GetPrefetchStats();
+                TestEqual("One prefetch is wasted", StatsAfter.NumWasted - StatsBefore.NumWasted, 1);
+                TestEqual("One miss is counted", StatsAfter.NumMisses - StatsBefore.NumMisses, 1);
+            });
+        });
+
+        Describe("Speech cache", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            AfterEach([this]() {
+                USpeechComponent::SetSpeechCacheBudget(32 * 1024);
+                USpeechComponent::SetSpeechDiskCacheBudget(256);
+            });
+
+            It("should generate a repeated line without calling Polly again", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a line that was generated once
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                const FSpeechCacheStats StatsBefore = USpeechComponent::GetSpeechCacheStats();
+                // when the same line is generated again, with different whitespace
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync(" Hello   there. ", EVoiceId::Joanna);
+                // then the cached results are used
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Polly is only called once", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+                TestEqual("The cached audio is used", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+                TestEqual("The cached visemes are used", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+                const FSpeechCacheStats StatsAfter = USpeechComponent::GetSpeechCacheStats();
+                TestEqual("One hit is counted", StatsAfter.NumHits - StatsBefore.NumHits, 1);
+                TestEqual("One entry is stored", StatsAfter.NumEntries, 1);
+            });
+
+            It("should synthesize the same line again for another voice", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 RequestIndex = 0; RequestIndex < 2; RequestIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // given a line that was generated once
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                // when the same line is generated for another voice
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Matthew);
+                // then it is synthesized again
+                TestEqual("Polly is called for each voice", MockPollyClient->GetRequestedAudioTexts().Num(), 2);
+                TestEqual("One entry is stored per voice", USpeechComponent::GetSpeechCacheStats().NumEntries, 2);
+            });
+
+            It("should evict the least recently used lines beyond the budget", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 RequestIndex = 0; RequestIndex < 4; RequestIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // given a budget of two lines, and no disk cache to reload evicted lines from
+                USpeechComponent::SetSpeechCacheBudget(8);
+                USpeechComponent::SetSpeechDiskCacheBudget(0);
+                TestableSpeechComponent->GenerateSpeechSync("One.", EVoiceId::Joanna);
+                TestableSpeechComponent->GenerateSpeechSync("Two.", EVoiceId::Joanna);
+                // when the oldest line is used again and a third line is generated
+                TestableSpeechComponent->GenerateSpeechSync("One.", EVoiceId::Joanna);
+                TestableSpeechComponent->GenerateSpeechSync("Three.", EVoiceId::Joanna);
+                // then the least recently used line is evicted
+                const FSpeechCacheStats Stats = USpeechComponent::GetSpeechCacheStats();
+                TestEqual("One entry is evicted", Stats.NumEvictions, 1);
+                TestEqual("Two entries are stored", Stats.NumEntries, 2);
+                TestTrue("The recently used line is kept", TestableSpeechComponent->IsSpeechCached("One.", EVoiceId::Joanna));
+                TestFalse("The least recently used line is evicted", TestableSpeechComponent->IsSpeechCached("Two.", EVoiceId::Joanna));
+                // when the evicted line is generated again
+                TestableSpeechComponent->GenerateSpeechSync("Two.", EVoiceId::Joanna);
+                // then it is synthesized again
+                TestEqual("Polly is called for the evicted line", MockPollyClient->GetRequestedAudioTexts().Num(), 4);
+            });
+
+            It("should load a line from disk once it is no longer in memory", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a line that was generated and written to disk before a restart
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                FSpeechDiskCache::Get().Flush();
+                FSpeechCache::Get().Empty();
+                const FSpeechCacheStats StatsBefore = USpeechComponent::GetSpeechCacheStats();
+                TestEqual("The line is written to disk", StatsBefore.NumDiskEntries, 1);
+                // when the line is generated again
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                // then it is read from disk
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Polly is only called once", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+                TestEqual("The audio is read from disk", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+                TestEqual("The visemes are read from disk", TestableSpeechComponent->GetVisemeEventArray().Num(), 1);
+                const FSpeechCacheStats StatsAfter = USpeechComponent::GetSpeechCacheStats();
+                TestEqual("One disk hit is counted", StatsAfter.NumDiskHits - StatsBefore.NumDiskHits, 1);
+                // and where files can be mapped, the audio views the mapped entry instead of a copy of it
+                const TArray<FPollyAudioBuffer> SpeechAudio = TestableSpeechComponent->GetSpeechAudio();
+                if (SpeechAudio.Num() == 1 && SpeechAudio[0]->IsView()) {
+                    TestEqual("The mapped audio is not copied to the heap", SpeechAudio[0]->GetAllocatedSize(), (SIZE_T)0);
+                    TestEqual("The mapped audio is not counted against the cache budget", StatsAfter.SizeKB, 0);
+                }
+            });
+
+            It("should tell the lines in memory from the lines only on disk", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a line that was generated
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                const FString Key = FSpeechCache::MakeKey("Hello there.", EVoiceId::Joanna, FSpeechCache::OutputFormat);
+                TestTrue("The line is in memory", FSpeechCache::Get().ContainsInMemory(Key));
+                // when it is dropped from memory but kept on disk
+                FSpeechDiskCache::Get().Flush();
+                FSpeechCache::Get().Empty();
+                // then it is still cached, but no longer in memory
+                TestTrue("The line is cached", FSpeechCache::Get().Contains(Key));
+                TestFalse("The line is no longer in memory", FSpeechCache::Get().ContainsInMemory(Key));
+            });
+
+            It("should discard a corrupt entry on disk and synthesize the line again", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 RequestIndex = 0; RequestIndex < 2; RequestIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // given a line whose entry on disk was damaged
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                FSpeechDiskCache::Get().Flush();
+                FSpeechCache::Get().Empty();
+                TArray<FString> EntryFiles;
+                IFileManager::Get().FindFiles(EntryFiles, *FPaths::Combine(FSpeechDiskCache::Get().GetDirectory(), TEXT("*.pspeech")), true, false);
+                for (const FString& EntryFile : EntryFiles) {
+                    FFileHelper::SaveStringToFile(TEXT("NOT A SPEECH"), *FPaths::Combine(FSpeechDiskCache::Get().GetDirectory(), EntryFile));
+                }
+                AddExpectedError(TEXT("Discarding corrupt speech cache entry"), EAutomationExpectedErrorFlags::Contains, 1);
+                // when the line is generated again
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                // then the entry is discarded and the line is synthesized again
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Polly is called again", MockPollyClient->GetRequestedAudioTexts().Num(), 2);
+                TestEqual("The audio is synthesized again", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+            });
+
+            It("should always call Polly when bUseSpeechCache is false", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                for (int32 RequestIndex = 0; RequestIndex < 2; RequestIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                }
+                // given a SpeechComponent that does not cache speech
+                TestableSpeechComponent->bUseSpeechCache = false;
+                // when the same line is generated twice
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                TestableSpeechComponent->GenerateSpeechSync("Hello there.", EVoiceId::Joanna);
+                // then Polly is called each time and nothing is stored
+                TestEqual("Polly is called twice", MockPollyClient->GetRequestedAudioTexts().Num(), 2);
+                TestEqual("No entry is stored", USpeechComponent::GetSpeechCacheStats().NumEntries, 0);
+            });
+        });
+
+        Describe("Speech cache warmup", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should rank the recorded lines by how often they are spoken", [this]() {
+                // given a manifest of lines spoken 1, 3 and 2 times
+                FSpeechWarmupManifest Manifest(FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("SpeechWarmupRank.json")), 0);
+                Manifest.Record(TEXT("Welcome!"), EVoiceId::Joanna);
+                for (int32 RecordIndex = 0; RecordIndex < 3; RecordIndex++) {
+                    Manifest.Record(TEXT("Hello there."), EVoiceId::Joanna);
+                }
+                Manifest.Record(TEXT("Hello there."), EVoiceId::Matthew);
+                Manifest.Record(TEXT("Hello there."), EVoiceId::Matthew);
+                // when the most frequent lines are requested
+                TArray<FSpeechWarmupLine> Lines = Manifest.GetMostFrequentLines(2);
+                // then they are ranked by count, counting each voice separately
+                TestEqual("The number of lines is bounded", Lines.Num(), 2);
+                if (Lines.Num() == 2) {
+                    TestEqual("The most frequent line comes first", Lines[0].Count, 3);
+                    TestEqual("The most frequent line keeps its voice", Lines[0].VoiceId, EVoiceId::Joanna);
+                    TestEqual("The same text in another voice is a separate line", Lines[1].VoiceId, EVoiceId::Matthew);
+                }
+            });
+
+            It("should keep the counts of a manifest across runs", [this]() {
+                const FString ManifestPath = FPaths::Combine(FPaths::AutomationTransientDir(), TEXT("SpeechWarmupSave.json"));
+                IFileManager::Get().Delete(*ManifestPath, false, false, true);
+                // given a manifest saved by a previous run
+                {
+                    FSpeechWarmupManifest Manifest(ManifestPath, 0);
+                    Manifest.Record(TEXT("Hello there."), EVoiceId::Joanna);
+                    Manifest.Record(TEXT("Hello there."), EVoiceId::Joanna);
+                    TestTrue("The manifest is saved", Manifest.Save());
+                }
+                // when it is loaded and the line is spoken again
+                FSpeechWarmupManifest Manifest(ManifestPath, 0);
+                TestTrue("The manifest is loaded", Manifest.Load());
+                Manifest.Record(TEXT("Hello there."), EVoiceId::Joanna);
+                // then the counts add up
+                TArray<FSpeechWarmupLine> Lines = Manifest.GetMostFrequentLines(8);
+                TestEqual("The line is loaded", Lines.Num(), 1);
+                if (Lines.Num() == 1) {
+                    TestEqual("The text is loaded", Lines[0].Text, FString(TEXT("Hello there.")));
+                    TestEqual("The counts of both runs add up", Lines[0].Count, 3);
+                }
+            });
+
+            It("should synthesize a warmed line into the cache without changing the speech", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a warmed up line
+                const bool bWarmed = TestableSpeechComponent->WarmSpeechCache(TEXT("Hello there."), EVoiceId::Joanna, MakePollyCancellationFlag());
+                TestTrue("The line is warmed up", bWarmed);
+                TestEqual("The speech of the component is unchanged", TestableSpeechComponent->GetVisemeEventArray().Num(), 0);
+                // when the line is generated
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync(TEXT("Hello there."), EVoiceId::Joanna);
+                // then it is taken from the cache
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("Polly is only called by the warmup", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+                TestEqual("The warmed up audio is used", TestableSpeechComponent->GetAudiobuffer().Num(), 3200);
+            });
+        });
+
+        Describe("Baked speech (UPollySpeechAsset)", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should play a baked line without calling Polly", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given an asset holding 100ms of audio and 2 visemes
+                UPollySpeechAsset* SpeechAsset = NewObject<UPollySpeechAsset>();
+                TArray<uint8> Audio;
+                Audio.SetNumZeroed(3200);
+                TArray<VisemeEvent> Visemes = { { EViseme::P, 0 }, { EViseme::Sil, 80 } };
+                SpeechAsset->SetSpeech(TEXT("Hi!"), EVoiceId::Joanna, Audio, Visemes);
+                // when its speech is generated and started
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechFromAsset(SpeechAsset);
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                // then the baked speech plays
+                TestTrue("The speech is generated", bGenerated);
+                TestNotNull("StartSpeech returns a sound", PollyAudio);
+                TestEqual("Polly is not called", MockPollyClient->GetRequestedAudioTexts().Num(), 0);
+                TestNotNull("The baked audio is streamed", Cast<UPollyBakedSoundWave>(PollyAudio));
+                TestEqual("The baked audio is not copied", TestableSpeechComponent->GetAudiobuffer().Num(), 0);
+                TArray<VisemeEvent> VisemeEventArray = TestableSpeechComponent->GetVisemeEventArray();
+                TestEqual("The baked visemes are used", VisemeEventArray.Num(), 2);
+                if (VisemeEventArray.Num() == 2) {
+                    TestEqual("The baked viseme times are kept", VisemeEventArray[1].TimeMilliseconds, 80);
+                }
+            });
+
+            It("should only be up to date for the text and voice it was baked from", [this]() {
+                // given a baked line
+                UPollySpeechAsset* SpeechAsset = NewObject<UPollySpeechAsset>();
+                TArray<VisemeEvent> Visemes = { { EViseme::Sil, 0 } };
+                TArray<uint8> Audio;
+                Audio.SetNumZeroed(3200);
+                SpeechAsset->SetSpeech(TEXT("Hello there."), EVoiceId::Joanna, Audio, Visemes);
+                // then it only needs to be baked again when the line changes
+                TestTrue("The same line is up to date", SpeechAsset->IsUpToDate(TEXT("Hello there."), EVoiceId::Joanna));
+                TestTrue("Whitespace does not change the speech", SpeechAsset->IsUpToDate(TEXT("Hello  there. "), EVoiceId::Joanna));
+                TestFalse("A changed text is baked again", SpeechAsset->IsUpToDate(TEXT("Hello there!"), EVoiceId::Joanna));
+                TestFalse("A changed voice is baked again", SpeechAsset->IsUpToDate(TEXT("Hello there."), EVoiceId::JoannaNeural));
+            });
+
+            It("should stream the audio within the read-ahead window and seek it", [this]() {
+                // given an asset holding 5s of audio, read 3 chunks of 1024ms ahead
+                UPollySpeechAsset* SpeechAsset = NewObject<UPollySpeechAsset>();
+                TArray<uint8> Audio;
+                Audio.SetNumUninitialized(160000);
+                for (int32 ByteIndex = 0; ByteIndex < Audio.Num(); ByteIndex++) {
+                    Audio[ByteIndex] = static_cast<uint8>(ByteIndex % 251);
+                }
+                TArray<VisemeEvent> Visemes = { { EViseme::P, 0 }, { EViseme::S, 2000 }, { EViseme::T, 4500 } };
+                SpeechAsset->SetSpeech(TEXT("A long line."), EVoiceId::Joanna, Audio, Visemes);
+                TestableSpeechComponent->BakedSpeechReadAheadChunks = 3;
+                TestableSpeechComponent->GenerateSpeechFromAsset(SpeechAsset);
+                UPollyBakedSoundWave* PollyAudio = Cast<UPollyBakedSoundWave>(TestableSpeechComponent->StartSpeech());
+                if (!TestNotNull("StartSpeech returns a baked sound", PollyAudio)) {
+                    return;
+                }
+                // when the first 100ms are played
+                TArray<uint8> PlayedAudio;
+                const int32 NumSamples = PollyAudio->OnGeneratePCMAudio(PlayedAudio, 1600);
+                // then they are the start of the audio, and only the read-ahead window is in memory
+                TestEqual("A full callback is played", NumSamples, 1600);
+                TestTrue("The start of the audio is played", PlayedAudio.Num() == 3200 && FMemory::Memcmp(PlayedAudio.GetData(), Audio.GetData(), 3200) == 0);
+                TestTrue("The resident audio is bounded", PollyAudio->GetResidentAudioBytes() <= 3 * UPollySpeechAsset::AudioChunkBytes);
+                // when the speech is seeked to 4s
+                TestTrue("The speech is seeked", TestableSpeechComponent->SeekSpeech(4.0f));
+                PollyAudio->OnGeneratePCMAudio(PlayedAudio, 1600);
+                // then the audio and the visemes continue from there
+                TestTrue("The audio continues from the seek", PlayedAudio.Num() == 3200 && FMemory::Memcmp(PlayedAudio.GetData(), Audio.GetData() + 128000, 3200) == 0);
+                TestEqual("The visemes continue from the seek", TestableSpeechComponent->GetCurrentViseme(), EViseme::T);
+                // when the rest of the audio is played
+                int32 PlayedBytes = 3200;
+                while (PollyAudio->OnGeneratePCMAudio(PlayedAudio, 1600) > 0) {
+                    PlayedBytes += PlayedAudio.Num();
+                }
+                // then the sound ends with the audio
+                TestEqual("The sound ends with the audio", 128000 + PlayedBytes, Audio.Num());
+                TestEqual("No chunk arrived late", PollyAudio->GetUnderflowCount(), 0);
+            });
+
+            It("should bake every line without exceeding the request rate", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                TArray<FPollySpeechBakeLine> Lines;
+                for (int32 LineIndex = 0; LineIndex < 4; LineIndex++) {
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(3200));
+                    MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                    Lines.Add({ FName(*FString::Printf(TEXT("Line%d"), LineIndex)), FString::Printf(TEXT("Line number %d."), LineIndex), EVoiceId::Joanna });
+                }
+                // given a baker of 2 lines at a time and 40 requests, or 20 lines, per second
+                FPollySpeechBaker Baker(TestableSpeechComponent, 2, 40.0f);
+                // when 4 lines are baked
+                const double StartSeconds = FPlatformTime::Seconds();
+                TArray<FPollySpeechBakeResult> Results = Baker.Bake(Lines);
+                const double BakeSeconds = FPlatformTime::Seconds() - StartSeconds;
+                // then every line is synthesized, the last one no earlier than 150ms after the first
+                TestEqual("Every line has a result", Results.Num(), 4);
+                for (const FPollySpeechBakeResult& Result : Results) {
+                    TestTrue("The line is baked", Result.bSucceeded);
+                    TestEqual("The audio of the line is baked", Result.Audio.Num(), 3200);
+                }
+                TestEqual("Every line is synthesized once", MockPollyClient->GetRequestedAudioTexts().Num(), 4);
+                TestTrue("The request rate is respected", BakeSeconds >= 0.14);
+            });
+        });
+
+        Describe("Speech replication", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should encode a sentence of visemes in under 200 bytes", [this]() {
+                // given the visemes of a sentence of about 3s, with a pause
+                TArray<VisemeEvent> Visemes;
+                for (int32 VisemeIndex = 0; VisemeIndex < 60; VisemeIndex++) {
+                    const int32 PauseMilliseconds = VisemeIndex >= 30 ? 400 : 0;
+                    Visemes.Add({ static_cast<EViseme>(VisemeIndex % 17), VisemeIndex * 50 + PauseMilliseconds });
+                }
+                // when they are encoded and decoded
+                TArray<uint8> Track;
+                VisemeTrackCodec::Encode(Visemes, Track);
+                TArray<VisemeEvent> DecodedVisemes;
+                const bool bDecoded = VisemeTrackCodec::Decode(Track, DecodedVisemes);
+                // then the track is compact and the visemes are unchanged
+                TestTrue("The track is under 200 bytes", Track.Num() < 200);
+                TestTrue("The track is decoded", bDecoded);
+                TestEqual("Every viseme is decoded", DecodedVisemes.Num(), Visemes.Num());
+                for (int32 VisemeIndex = 0; VisemeIndex < DecodedVisemes.Num() && VisemeIndex < Visemes.Num(); VisemeIndex++) {
+                    TestEqual("The viseme is decoded", DecodedVisemes[VisemeIndex].Viseme, Visemes[VisemeIndex].Viseme);
+                    TestEqual("The viseme time is decoded", DecodedVisemes[VisemeIndex].TimeMilliseconds, Visemes[VisemeIndex].TimeMilliseconds);
+                }
+            });
+
+            It("should reject a truncated viseme track", [this]() {
+                // given a track whose last varint was cut
+                TArray<VisemeEvent> Visemes = { { EViseme::P, 0 }, { EViseme::A, 2000 } };
+                TArray<uint8> Track;
+                VisemeTrackCodec::Encode(Visemes, Track);
+                Track.RemoveAt(Track.Num() - 1);
+                // then it is not decoded
+                TArray<VisemeEvent> DecodedVisemes;
+                TestFalse("The track is rejected", VisemeTrackCodec::Decode(Track, DecodedVisemes));
+            });
+
+            It("should start a replicated speech where the server is", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a baked speech of 4s that started on the server 2s ago
+                UPollySpeechAsset* SpeechAsset = NewObject<UPollySpeechAsset>();
+                TArray<uint8> Audio;
+                Audio.SetNumUninitialized(128000);
+                for (int32 ByteIndex = 0; ByteIndex < Audio.Num(); ByteIndex++) {
+                    Audio[ByteIndex] = static_cast<uint8>(ByteIndex % 251);
+                }
+                TArray<VisemeEvent> Visemes = { { EViseme::P, 0 }, { EViseme::S, 1000 }, { EViseme::T, 2500 }, { EViseme::Sil, 4000 } };
+                SpeechAsset->SetSpeech(TEXT("Joining late."), EVoiceId::Joanna, Audio, Visemes);
+                FReplicatedSpeech ReplicatedSpeech;
+                ReplicatedSpeech.SpeechId = 1;
+                ReplicatedSpeech.bPlaying = true;
+                ReplicatedSpeech.Text = SpeechAsset->Text;
+                ReplicatedSpeech.SpeechAsset = SpeechAsset;
+                VisemeTrackCodec::Encode(Visemes, ReplicatedSpeech.VisemeTrack);
+                // The component has no world, so its server time is 0
+                ReplicatedSpeech.ServerStartSeconds = -2.0f;
+                // when a client receives it
+                TestableSpeechComponent->ApplyReplicatedSpeech(ReplicatedSpeech);
+                // then the speech plays from 2s without calling Polly
+                TestTrue("The speech plays", TestableSpeechComponent->IsSpeaking());
+                TestEqual("Polly is not called", MockPollyClient->GetRequestedAudioTexts().Num(), 0);
+                TestEqual("The visemes start from 2s", TestableSpeechComponent->GetCurrentViseme(), EViseme::T);
+                UPollyBakedSoundWave* PollyAudio = Cast<UPollyBakedSoundWave>(TestableSpeechComponent->GetActivePollyAudio());
+                if (!TestNotNull("The baked audio is streamed", PollyAudio)) {
+                    return;
+                }
+                TArray<uint8> PlayedAudio;
+                PollyAudio->OnGeneratePCMAudio(PlayedAudio, 1600);
+                TestTrue("The audio starts from 2s", PlayedAudio.Num() == 3200 && FMemory::Memcmp(PlayedAudio.GetData(), Audio.GetData() + 64000, 3200) == 0);
+            });
+        });
+
+        Describe("Synthesis modes", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+                // Cached segments would make the requests issued depend on earlier tests
+                TestableSpeechComponent->bUseSpeechCache = false;
+            });
+
+            It("should only request the visemes of a speaker out of earshot", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a component in the VisemesOnly mode
+                TestableSpeechComponent->SynthesisMode = ESpeechSynthesisMode::VisemesOnly;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":300,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":800,\"type\":\"viseme\",\"value\":\"sil\"}"));
+                // when a speech is generated and started
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Too far away to hear.", EVoiceId::Joanna);
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                // then only the visemes are requested, and they play without a sound
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("No audio is requested", MockPollyClient->GetRequestedAudioTexts().Num(), 0);
+                TestEqual("The visemes are requested", MockPollyClient->GetRequestedVisemeTexts().Num(), 1);
+                TestNull("No sound is returned", PollyAudio);
+                TestTrue("The visemes play", TestableSpeechComponent->IsSpeaking());
+                TestEqual("The speech starts with the first viseme", TestableSpeechComponent->GetCurrentViseme(), EViseme::P);
+                TestEqual("The speech lasts until the last viseme", TestableSpeechComponent->GetSpeechDurationSeconds(), 0.8f);
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should keep the synthesis mode of the speech when the next one fails", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a speech generated in the VisemesOnly mode
+                TestableSpeechComponent->SynthesisMode = ESpeechSynthesisMode::VisemesOnly;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"p\"}"));
+                TestableSpeechComponent->GenerateSpeechSync("Too far away to hear.", EVoiceId::Joanna);
+                // when a speech in the Full mode fails to be generated
+                TestableSpeechComponent->SynthesisMode = ESpeechSynthesisMode::Full;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome());
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyErrorOutcome());
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Come closer.", EVoiceId::Joanna);
+                // then the previous speech still plays without a sound
+                TestFalse("The speech is not generated", bGenerated);
+                TestNull("No sound is returned", TestableSpeechComponent->StartSpeech());
+                TestTrue("The visemes play", TestableSpeechComponent->IsSpeaking());
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should only request the audio of a speaker out of sight", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a component in the AudioOnly mode, and 500ms of audio
+                TestableSpeechComponent->SynthesisMode = ESpeechSynthesisMode::AudioOnly;
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(16000));
+                // when a speech is generated and started
+                const bool bGenerated = TestableSpeechComponent->GenerateSpeechSync("Behind the wall.", EVoiceId::Joanna);
+                USoundWaveProcedural* PollyAudio = TestableSpeechComponent->StartSpeech();
+                // then only the audio is requested, and it plays with a closed mouth
+                TestTrue("The speech is generated", bGenerated);
+                TestEqual("The audio is requested", MockPollyClient->GetRequestedAudioTexts().Num(), 1);
+                TestEqual("No visemes are requested", MockPollyClient->GetRequestedVisemeTexts().Num(), 0);
+                TestNotNull("A sound is returned", PollyAudio);
+                TestEqual("The mouth is closed", TestableSpeechComponent->GetCurrentViseme(), EViseme::Sil);
+                TestEqual("The speech lasts as long as its audio", TestableSpeechComponent->GetSpeechDurationSeconds(), 0.5f);
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should estimate the duration of a speech without calling Polly", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a component in the DurationOnly mode
+                TestableSpeechComponent->SynthesisMode = ESpeechSynthesisMode::DurationOnly;
+                // when a short and a long speech are generated
+                const bool bShortGenerated = TestableSpeechComponent->GenerateSpeechSync("Hi.", EVoiceId::Joanna);
+                const float ShortSeconds = TestableSpeechComponent->GetSpeechDurationSeconds();
+                const bool bLongGenerated = TestableSpeechComponent->GenerateSpeechSync("Hello there, it has been a long time. How have you been?", EVoiceId::Joanna);
+                const float LongSeconds = TestableSpeechComponent->GetSpeechDurationSeconds();
+                // then Polly is not called, and the longer speech lasts longer
+                TestTrue("The speeches are generated", bShortGenerated && bLongGenerated);
+                TestEqual("No audio is requested", MockPollyClient->GetRequestedAudioTexts().Num(), 0);
+                TestEqual("No visemes are requested", MockPollyClient->GetRequestedVisemeTexts().Num(), 0);
+                TestTrue("The short speech has a duration", ShortSeconds > 0.0f);
+                TestTrue("The long speech lasts longer", LongSeconds > ShortSeconds);
+                TestNull("No sound is returned", TestableSpeechComponent->StartSpeech());
+                TestTrue("The speech plays", TestableSpeechComponent->IsSpeaking());
+                TestableSpeechComponent->StopSpeech();
+            });
+        });
+
+        Describe("Intensity envelope", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+                TestableSpeechComponent->bUseSpeechCache = false;
+            });
+
+            It("should summarize every 10ms of audio by its level", [this]() {
+                // given 100ms of silence, 100ms at full scale and 105ms at a tenth of full scale
+                TArray<uint8> Audio;
+                Audio.SetNumZeroed(3200);
+                Audio.Append(CreateSquareWaveAudio(1600, 32767));
+                Audio.Append(CreateSquareWaveAudio(1680, 3277));
+                // when its envelope is computed
+                TArray<uint8> Envelope;
+                SpeechEnvelope::Compute(Audio, Envelope);
+                // then there is a value per frame, including the partial last one, on a decibel scale
+                if (!TestEqual("There is a value per frame", Envelope.Num(), 31)) {
+                    return;
+                }
+                TestEqual("Silence is 0", Envelope[0], static_cast<uint8>(0));
+                TestEqual("Full scale is 255", Envelope[15], static_cast<uint8>(255));
+                TestEqual("-20 dB is two thirds of the scale", Envelope[25], static_cast<uint8>(170));
+                TestEqual("The partial frame has the level of its samples", Envelope[30], static_cast<uint8>(170));
+            });
+
+            It("should return the intensity of the speech where it plays", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a speech whose audio starts at full scale
+                const FPollyAudioBuffer Audio = PollyAudioBuffer::Make(CreateSquareWaveAudio(16000, 32767));
+                MockPollyClient->AddSynthesizeSpeechBehavior([Audio]() {
+                    PollyOutcome Outcome;
+                    Outcome.IsSuccess = true;
+                    Outcome.StreamBuffer = Audio;
+                    return Outcome;
+                });
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":1000,\"type\":\"viseme\",\"value\":\"sil\"}"));
+                TestableSpeechComponent->GenerateSpeechSync("As loud as it gets.", EVoiceId::Joanna);
+                // then it is silent until it starts
+                TestEqual("A speech that does not play is silent", TestableSpeechComponent->GetCurrentIntensity(), 0.0f);
+                // when it starts
+                TestableSpeechComponent->StartSpeech();
+                // then its intensity is the one of its audio
+                TestEqual("The speech is at full intensity", TestableSpeechComponent->GetCurrentIntensity(), 1.0f);
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should bake the envelope with the audio", [this]() {
+                // given a line baked into an asset
+                UPollySpeechAsset* SpeechAsset = NewObject<UPollySpeechAsset>();
+                TArray<VisemeEvent> Visemes = { { EViseme::A, 0 }, { EViseme::Sil, 500 } };
+                SpeechAsset->SetSpeech(TEXT("Baked loudly."), EVoiceId::Joanna, CreateSquareWaveAudio(8000, 32767), Visemes);
+                // then the asset holds its envelope, and a speech generated from it is as loud
+                TestEqual("The envelope covers the audio", SpeechAsset->IntensityEnvelope.Num(), 50);
+                TestTrue("The speech is generated", TestableSpeechComponent->GenerateSpeechFromAsset(SpeechAsset));
+                TestableSpeechComponent->StartSpeech();
+                TestEqual("The speech is at full intensity", TestableSpeechComponent->GetCurrentIntensity(), 1.0f);
+                TestableSpeechComponent->StopSpeech();
+            });
+        });
+
+        Describe("Speech memory", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+                TestableSpeechComponent->bUseSpeechCache = false;
+            });
+
+            AfterEach([this]() {
+                USpeechComponent::SetSpeechMemoryBudget(0);
+                USpeechComponent::SetSpeechDiskCacheBudget(256);
+            });
+
+            It("should account for the speech of a component", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(64000));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                const FSpeechMemoryStats StatsBefore = USpeechComponent::GetSpeechMemoryStats();
+                // when a speech is generated
+                TestableSpeechComponent->GenerateSpeechSync("Count me in.", EVoiceId::Joanna);
+                // then its audio is accounted for
+                TestTrue("The component holds its audio", TestableSpeechComponent->GetSpeechMemoryBytes() >= 64000);
+                const FSpeechMemoryStats StatsAfter = USpeechComponent::GetSpeechMemoryStats();
+                TestTrue("The component is tracked", StatsAfter.NumComponents >= 1);
+                TestTrue("The speech buffers grow by the audio", StatsAfter.SpeechBuffersKB - StatsBefore.SpeechBuffersKB >= 62);
+            });
+
+            It("should release a speech that has been played once over budget", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(2 * 1024 * 1024));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a speech of 2 MB that has been played
+                TestableSpeechComponent->GenerateSpeechSync("A rather long line.", EVoiceId::Joanna);
+                TestableSpeechComponent->StartSpeech();
+                TestableSpeechComponent->StopSpeech();
+                const int32 NumReleasedBefore = USpeechComponent::GetSpeechMemoryStats().NumReleasedSpeeches;
+                // when the budget is 1 MB
+                USpeechComponent::SetSpeechMemoryBudget(1);
+                FSpeechMemoryTracker::Get().EnforceBudget();
+                // then the speech is released
+                TestEqual("The audio is released", TestableSpeechComponent->GetAudiobuffer().Num(), 0);
+                TestEqual("The visemes are released", TestableSpeechComponent->GetVisemeEventArray().Num(), 0);
+                TestEqual("The release is counted", USpeechComponent::GetSpeechMemoryStats().NumReleasedSpeeches - NumReleasedBefore, 1);
+                TestNull("The released speech cannot be started", TestableSpeechComponent->StartSpeech());
+            });
+
+            It("should not release a speech that is playing", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(2 * 1024 * 1024));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a speech of 2 MB that is playing
+                TestableSpeechComponent->GenerateSpeechSync("A rather long line.", EVoiceId::Joanna);
+                TestableSpeechComponent->StartSpeech();
+                // when the budget is 1 MB
+                USpeechComponent::SetSpeechMemoryBudget(1);
+                AddExpectedError(TEXT("exceeds its budget"), EAutomationExpectedErrorFlags::Contains);
+                FSpeechMemoryTracker::Get().EnforceBudget();
+                // then the speech is kept
+                TestEqual("The audio is kept", TestableSpeechComponent->GetAudiobuffer().Num(), 2 * 1024 * 1024);
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should evict cached texts once the idle speeches are released", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(2 * 1024 * 1024));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                // given a cached speech of 2 MB that has been played, and no disk cache to reload it from
+                USpeechComponent::SetSpeechDiskCacheBudget(0);
+                TestableSpeechComponent->bUseSpeechCache = true;
+                TestableSpeechComponent->GenerateSpeechSync("A rather long line.", EVoiceId::Joanna);
+                TestableSpeechComponent->StartSpeech();
+                TestableSpeechComponent->StopSpeech();
+                // when the budget is 1 MB
+                USpeechComponent::SetSpeechMemoryBudget(1);
+                FSpeechMemoryTracker::Get().EnforceBudget();
+                // then both the speech and the cached text are released
+                TestEqual("The audio is released", TestableSpeechComponent->GetAudiobuffer().Num(), 0);
+                TestFalse("The text is evicted from the cache", TestableSpeechComponent->IsSpeechCached("A rather long line.", EVoiceId::Joanna));
+                TestTrue("The cache fits the budget", USpeechComponent::GetSpeechMemoryStats().SpeechCacheKB <= 1024);
+            });
+        });
+
+        Describe("Speech metrics", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+                TestableSpeechComponent->bUseSpeechCache = false;
+            });
+
+            It("should count the requests of a speech", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                const Aws::String VisemeJson = "{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}";
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(32000));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome(VisemeJson));
+                const FSpeechMetricsSnapshot Before = FSpeechMetrics::Get().GetSnapshot();
+                // when a speech is generated
+                TestableSpeechComponent->GenerateSpeechSync("Count me in.", EVoiceId::Joanna);
+                // then its requests, their responses and their latency are counted
+                const FSpeechMetricsSnapshot After = FSpeechMetrics::Get().GetSnapshot();
+                TestEqual("Both requests are counted", After.NumRequests - Before.NumRequests, (int64)2);
+                TestEqual("No request failed", After.NumFailedRequests - Before.NumFailedRequests, (int64)0);
+                TestEqual("The responses are counted", After.BytesReceived - Before.BytesReceived, (int64)(32000 + VisemeJson.length()));
+                TestEqual("The latency of both requests is recorded", After.RequestLatency.Count - Before.RequestLatency.Count, (uint64)2);
+                TestTrue("The parse time is recorded", After.ParseTime.Count > Before.ParseTime.Count);
+                TestTrue("The queue wait is recorded", After.QueueWait.Count - Before.QueueWait.Count >= 2);
+                const FSpeechVoiceLatency* VoiceLatency = After.VoiceLatencies.FindByPredicate([](const FSpeechVoiceLatency& Latency) {
+                    return Latency.Voice == TEXT("Joanna");
+                });
+                TestNotNull("The latency of the voice is recorded", VoiceLatency);
+            });
+
+            It("should count throttled requests and the requests they cancel", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given the audio request being throttled while the viseme request is still in flight
+                MockPollyClient->AddSynthesizeSpeechBehavior([]() {
+                    PollyOutcome Outcome;
+                    Outcome.IsSuccess = false;
+                    Outcome.IsThrottled = true;
+                    Outcome.PollyErrorMsg = "Rate exceeded";
+                    return Outcome;
+                });
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"), 1.0f);
+                AddExpectedError(TEXT("Polly failed to generate audio file"), EAutomationExpectedErrorFlags::Contains);
+                const FSpeechMetricsSnapshot Before = FSpeechMetrics::Get().GetSnapshot();
+                // when a speech is generated
+                TestableSpeechComponent->GenerateSpeechSync("Slow down.", EVoiceId::Joanna);
+                // then the throttled request is counted as failed, and the viseme request as cancelled
+                const FSpeechMetricsSnapshot After = FSpeechMetrics::Get().GetSnapshot();
+                TestEqual("The failure is counted", After.NumFailedRequests - Before.NumFailedRequests, (int64)1);
+                TestEqual("The throttling is counted", After.NumThrottledRequests - Before.NumThrottledRequests, (int64)1);
+                TestEqual("The aborted request is counted", After.NumCancelledRequests - Before.NumCancelledRequests, (int64)1);
+                TestEqual("Failures are left out of the latency", After.RequestLatency.Count, Before.RequestLatency.Count);
+            });
+
+            It("should place every value in a bucket within an eighth of it", [this]() {
+                for (uint64 Value : { 0ull, 1ull, 7ull, 8ull, 15ull, 16ull, 17ull, 1000ull, 123456ull, 1ull << 40, MAX_uint64 }) {
+                    // when a value is placed in a bucket
+                    const int32 BucketIndex = FSpeechMetricHistogram::GetBucketIndex(Value);
+                    const uint64 LowerBound = FSpeechMetricHistogram::GetBucketLowerBound(BucketIndex);
+                    // then the bucket holds it and is no wider than an eighth of its lower bound
+                    TestTrue(FString::Printf(TEXT("%llu is in a bucket"), Value), BucketIndex >= 0 && BucketIndex < FSpeechMetricHistogram::NumBuckets);
+                    TestTrue(FString::Printf(TEXT("%llu is above its lower bound"), Value), LowerBound <= Value);
+                    if (BucketIndex + 1 < FSpeechMetricHistogram::NumBuckets) {
+                        const uint64 UpperBound = FSpeechMetricHistogram::GetBucketLowerBound(BucketIndex + 1);
+                        TestTrue(FString::Printf(TEXT("%llu is below its upper bound"), Value), Value < UpperBound);
+                        TestTrue(FString::Printf(TEXT("The bucket of %llu is narrow"), Value), UpperBound - LowerBound <= FMath::Max<uint64>(LowerBound / 8, 1));
+                    }
+                }
+            });
+
+            It("should estimate percentiles within an eighth", [this]() {
+                // given the values 1 to 1000
+                FSpeechMetricHistogram Histogram;
+                for (uint64 Value = 1; Value <= 1000; Value++) {
+                    Histogram.Record(Value);
+                }
+                // when the percentiles are estimated
+                const FSpeechHistogramSnapshot Snapshot = Histogram.GetSnapshot();
+                // then they are within an eighth of the exact ones
+                TestEqual("The values are counted", Snapshot.Count, (uint64)1000);
+                TestEqual("The maximum is exact", Snapshot.Max, (uint64)1000);
+                TestEqual("The mean is exact", Snapshot.GetMean(), 500.5);
+                TestTrue("The median is close", FMath::Abs(Snapshot.GetPercentile(0.5) - 500.0) <= 500.0 / 8);
+                TestTrue("The 99th percentile is close", FMath::Abs(Snapshot.GetPercentile(0.99) - 990.0) <= 990.0 / 8);
+                TestTrue("The percentiles do not exceed the maximum", Snapshot.GetPercentile(1.0) <= 1000.0);
+            });
+
+            It("should not lose values recorded from several threads at once", [this]() {
+                // given 8 threads each recording 10000 values at the same time
+                FSpeechMetricHistogram Histogram;
+                TArray<TFuture<void>> Recorders;
+                for (int32 ThreadIndex = 0; ThreadIndex < 8; ThreadIndex++) {
+                    Recorders.Add(Async(EAsyncExecution::Thread, [&Histogram, ThreadIndex]() {
+                        for (uint64 Value = 1; Value <= 10000; Value++) {
+                            Histogram.Record(Value + ThreadIndex);
+                        }
+                    }));
+                }
+                for (TFuture<void>& Recorder : Recorders) {
+                    Recorder.Wait();
+                }
+                // then every value is counted
+                const FSpeechHistogramSnapshot Snapshot = Histogram.GetSnapshot();
+                uint64 NumInBuckets = 0;
+                for (uint64 BucketCount : Snapshot.Buckets) {
+                    NumInBuckets += BucketCount;
+                }
+                TestEqual("Every value is counted", Snapshot.Count, (uint64)80000);
+                TestEqual("Every value is in a bucket", NumInBuckets, (uint64)80000);
+                TestEqual("Every value is summed", Snapshot.Sum, (uint64)(8 * 50005000 + 10000 * 28));
+                TestEqual("The maximum is the largest value", Snapshot.Max, (uint64)10007);
+            });
+
+            It("should write the metrics as JSON", [this]() {
+                // given some requests
+                FSpeechMetricsSnapshot Snapshot;
+                Snapshot.NumRequests = 3;
+                Snapshot.NumThrottledRequests = 1;
+                Snapshot.NumCacheHits = 1;
+                Snapshot.NumCacheMisses = 3;
+                FSpeechMetricHistogram Latency;
+                Latency.Record(200000);
+                Snapshot.RequestLatency = Latency.GetSnapshot();
+                // when the metrics are written as JSON
+                TSharedPtr<FJsonObject> Json;
+                TSharedRef<TJsonReader<TCHAR>> JsonReader = TJsonReaderFactory<TCHAR>::Create(FSpeechMetrics::ToJson(Snapshot));
+                if (!TestTrue("The JSON is valid", FJsonSerializer::Deserialize(JsonReader, Json) && Json.IsValid())) {
+                    return;
+                }
+                // then the counters and the latency in milliseconds are in it
+                TestEqual("The requests are written", Json->GetIntegerField(TEXT("requests")), 3);
+                TestEqual("The throttled requests are written", Json->GetIntegerField(TEXT("throttled_requests")), 1);
+                TestEqual("The cache hit rate is written", Json->GetNumberField(TEXT("cache_hit_rate")), 0.25);
+                TestEqual("The latency is in milliseconds", Json->GetObjectField(TEXT("request_latency_ms"))->GetNumberField(TEXT("max")), 200.0);
+                TestEqual("The buckets in use are written", Json->GetObjectField(TEXT("request_latency_ms"))->GetArrayField(TEXT("buckets")).Num(), 1);
+            });
+        });
+
+        Describe("Shared audio buffers", [this]() {
+
+            BeforeEach([this]() {
+                TestableSpeechComponent = NewObject<UTestableSpeechComponent>();
+                TestableSpeechComponent->InitializePollyClient();
+            });
+
+            It("should play buffers from where the speech starts, across their boundaries", [this]() {
+                // given a sound playing two buffers from the second sample of the first one
+                UPollyBufferedSoundWave* PollyAudio = NewObject<UPollyBufferedSoundWave>();
+                const TArray<int16> FirstSamples = { 1, 2, 3 };
+                const TArray<int16> SecondSamples = { 4, 5 };
+                PollyAudio->SetAudio({
+                    PollyAudioBuffer::Make(TArray<uint8>(reinterpret_cast<const uint8*>(FirstSamples.GetData()), 6)),
+                    PollyAudioBuffer::Make(TArray<uint8>(reinterpret_cast<const uint8*>(SecondSamples.GetData()), 4))
+                }, 2);
+                TestEqual("The audio before the start is skipped", PollyAudio->GetRemainingAudioBytes(), (int64)8);
+                // when the audio thread asks for 3 samples
+                TArray<uint8> OutAudio;
+                const int32 NumSamples = PollyAudio->OnGeneratePCMAudio(OutAudio, 3);
+                // then they are read across both buffers
+                TestEqual("The samples are returned", NumSamples, 3);
+                const int16* Samples = reinterpret_cast<const int16*>(OutAudio.GetData());
+                TestTrue("The samples follow each other", Samples[0] == 2 && Samples[1] == 3 && Samples[2] == 4);
+                // and once the audio runs out, silence keeps the sound alive
+                PollyAudio->OnGeneratePCMAudio(OutAudio, 3);
+                Samples = reinterpret_cast<const int16*>(OutAudio.GetData());
+                TestTrue("The rest of the audio is followed by silence", Samples[0] == 5 && Samples[1] == 0 && Samples[2] == 0);
+                TestEqual("No audio is left", PollyAudio->GetRemainingAudioBytes(), (int64)0);
+            });
+
+            It("should share the audio of a response with the cache and the sound instead of copying it", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                // given a response holding the audio of a line
+                const FPollyAudioBuffer Audio = PollyAudioBuffer::Make(CreateSquareWaveAudio(1600, 1000));
+                MockPollyClient->AddSynthesizeSpeechBehavior([Audio]() {
+                    PollyOutcome Outcome;
+                    Outcome.IsSuccess = true;
+                    Outcome.StreamBuffer = Audio;
+                    return Outcome;
+                });
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":50,\"type\":\"viseme\",\"value\":\"p\"}"));
+                const FString Text = FString::Printf(TEXT("Shared line %s."), *FGuid::NewGuid().ToString());
+                // when the line is generated and started
+                TestableSpeechComponent->GenerateSpeechSync(Text, EVoiceId::Joanna);
+                UPollyBufferedSoundWave* PollyAudio = Cast<UPollyBufferedSoundWave>(TestableSpeechComponent->StartSpeech());
+                // then the speech and the cache hold the buffer of the response itself
+                const TArray<FPollyAudioBuffer> SpeechAudio = TestableSpeechComponent->GetSpeechAudio();
+                TestTrue("The speech holds the response", SpeechAudio.Num() == 1 && &SpeechAudio[0].Get() == &Audio.Get());
+                TestTrue("The cache holds the response", FSpeechCache::Get().HoldsAudio(Audio));
+                // and the sound plays it
+                TestNotNull("StartSpeech returns a sound playing the buffers", PollyAudio);
+                if (PollyAudio != nullptr) {
+                    TestEqual("The sound plays the whole response", PollyAudio->GetRemainingAudioBytes(), (int64)Audio->Num());
+                }
+                TestableSpeechComponent->StopSpeech();
+            });
+        });
+
         Describe("StartSpeech()", [this]() {
 
             BeforeEach([this]() {
@@ -642,6 +2572,43 @@ void::AmazonPollySpec::Define() {
                 TestTrue("CurrentVisemeIndex should be the size of the VisemeEventArray, 1", TestableSpeechComponent->GetCurrentVisemeIndex() == TestableSpeechComponent->GetVisemeEventArray().Num());
             });
 
+            It("should start the speech at a time into it", [this]() {
+                MockPollyClient* MockPollyClient = TestableSpeechComponent->GetPollyClient();
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollyAudioOutcome(32000));
+                MockPollyClient->AddSynthesizeSpeechBehavior(CreatePollySuccessfulOutcome("{\"time\":0,\"type\":\"viseme\",\"value\":\"p\"}\n{\"time\":400,\"type\":\"viseme\",\"value\":\"a\"}\n{\"time\":800,\"type\":\"viseme\",\"value\":\"k\"}\n{\"time\":1000,\"type\":\"viseme\",\"value\":\"sil\"}"));
+                // given a speech of 1s that was paused at 0.5s
+                TestableSpeechComponent->GenerateSpeechSync("Where was I?", EVoiceId::Joanna);
+                // when it is started from there
+                UPollyBufferedSoundWave* PollyAudio = Cast<UPollyBufferedSoundWave>(TestableSpeechComponent->StartSpeechAt(0.5f));
+                // then the audio and the visemes resume at 0.5s
+                if (!TestNotNull("StartSpeechAt returns a sound", PollyAudio)) {
+                    return;
+                }
+                TestEqual("The audio resumes at 0.5s", PollyAudio->GetRemainingAudioBytes(), (int64)16000);
+                TestEqual("The visemes resume at 0.5s", TestableSpeechComponent->GetCurrentViseme(), EViseme::K);
+                TestEqual("The current viseme is found in the track", TestableSpeechComponent->GetCurrentVisemeIndex(), 2);
+                TestEqual("The track can be sampled without the component", TestableSpeechComponent->GetVisemeTrack()->Evaluate(500), EViseme::K);
+                TestableSpeechComponent->StopSpeech();
+            });
+
+            It("should let the SDK read back an error response written to the response stream", [this]() {
+                // given an error returned by Polly, written to the response stream the way the SDK writes it
+                const std::string ErrorJson = "{\"__type\":\"ThrottlingException\",\"message\":\"Rate exceeded\"}";
+                TSharedRef<FPollyResponseBody, ESPMode::ThreadSafe> Body = MakeShared<FPollyResponseBody, ESPMode::ThreadSafe>(0);
+                FPollyResponseStream Stream(Body);
+                Stream.write(ErrorJson.data(), ErrorJson.size());
+                // when the SDK checks for a body and reads it
+                const std::streamoff WrittenBytes = Stream.tellp();
+                Stream.seekg(0);
+                const std::string ReadBack((std::istreambuf_iterator<char>(Stream)), std::istreambuf_iterator<char>());
+                // then the size of the body is reported and the whole error is read back
+                TestEqual("tellp reports the size of the body", static_cast<int64>(WrittenBytes), static_cast<int64>(ErrorJson.size()));
+                TestTrue("The error is read back", ReadBack == ErrorJson);
+                Stream.clear();
+                TestEqual("tellg reports the end of the body once read", static_cast<int64>(Stream.tellg()), static_cast<int64>(ErrorJson.size()));
+                TestTrue("The write position cannot be moved back", Stream.seekp(0).fail());
+            });
+
             It("should not StartSpeech before GenerateSpeechSync invoked (empty VisemeEventArray)", [this]() {
                 AddExpectedError(TEXT("Failed to start speech"), EAutomationExpectedErrorFlags::Contains);
                 auto result = TestableSpeechComponent->StartSpeech();
@@ -0,0 +1,214 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SpeechLoadTest.h"
+#include "Async/Async.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "PollySynthesisScheduler.h"
+#include "TestableSpeechComponent.h"
+
+namespace {
+    enum class ESpeakerState : uint8 {
+        Pausing,
+        Generating,
+        Speaking
+    };
+
+    /**
+    * A speech component and where it is in its cycle of lines
+    */
+    struct FVirtualSpeaker {
+        UTestableSpeechComponent* SpeechComponent = nullptr;
+        FaultInjectingPollyClient* PollyClient = nullptr;
+        ESpeakerState State = ESpeakerState::Pausing;
+        double NextLineSeconds = 0.0;
+        double LineRequestSeconds = 0.0;
+        double SpeechStartSeconds = 0.0;
+        TFuture<bool> Generated;
+    };
+
+    /**
+    * Returns a percentile of sorted values, or 0 if there are none
+    */
+    double Percentile(const TArray<double>& SortedValues, int32 Percent) {
+        return SortedValues.Num() > 0 ? SortedValues[FMath::Min(SortedValues.Num() * Percent / 100, SortedValues.Num() - 1)] : 0.0;
+    }
+
+    /**
+    * Creates a line of a random length, made of sentences the way dialogue is
+    */
+    FString CreateLine(FRandomStream& Random, const FSpeechLoadTestConfig& Config) {
+        const FString Sentence = TEXT("The quick brown fox jumps over the lazy dog. ");
+        const int32 NumChars = Random.RandRange(FMath::Max(Config.MinLineChars, 1), FMath::Max(Config.MinLineChars, Config.MaxLineChars));
+        FString Line;
+        while (Line.Len() < NumChars) {
+            Line += Sentence;
+        }
+        return Line.Left(NumChars);
+    }
+
+    /**
+    * Plays the visemes of a speaker that are due, standing in for the timers the testable component does not set
+    */
+    void PlayDueVisemes(FVirtualSpeaker& Speaker, double NowSeconds) {
+        UTestableSpeechComponent* SpeechComponent = Speaker.SpeechComponent;
+        const int64 PlaybackMilliseconds = (NowSeconds - Speaker.SpeechStartSeconds) * 1000.0;
+        while (SpeechComponent->IsSpeaking()) {
+            const FVisemeTrackRef VisemeTrack = SpeechComponent->GetVisemeTrack();
+            const int32 VisemeIndex = SpeechComponent->GetCurrentVisemeIndex();
+            const int64 DueMilliseconds = VisemeIndex + 1 < VisemeTrack->Num() ? VisemeTrack->GetTimeMilliseconds(VisemeIndex + 1) : FMath::RoundToInt(SpeechComponent->GetSpeechDurationSeconds() * 1000.0f);
+            if (DueMilliseconds > PlaybackMilliseconds) {
+                return;
+            }
+            SpeechComponent->PlayNextViseme();
+            if (SpeechComponent->GetCurrentVisemeIndex() == VisemeIndex) {
+                // The speech holds its last viseme until the next segment arrives
+                return;
+            }
+        }
+    }
+}
+
+FSpeechLoadTestResult SpeechLoadTest::Run(const FSpeechLoadTestConfig& Config) {
+    check(IsInGameThread());
+    FRandomStream Random(Config.Faults.Seed);
+    TArray<FVirtualSpeaker> Speakers;
+    Speakers.SetNum(FMath::Max(Config.NumSpeakers, 1));
+    const double StartSeconds = FPlatformTime::Seconds();
+    for (int32 SpeakerIndex = 0; SpeakerIndex < Speakers.Num(); SpeakerIndex++) {
+        FVirtualSpeaker& Speaker = Speakers[SpeakerIndex];
+        Speaker.SpeechComponent = NewObject<UTestableSpeechComponent>();
+        Speaker.SpeechComponent->AddToRoot();
+        Speaker.SpeechComponent->bUseSpeechCache = false;
+        Speaker.SpeechComponent->bPipelineSentences = Config.bPipelineSentences;
+        FPollyFaultConfig Faults = Config.Faults;
+        Faults.Seed += SpeakerIndex;
+        TUniquePtr<FaultInjectingPollyClient> PollyClient = MakeUnique<FaultInjectingPollyClient>(Faults);
+        Speaker.PollyClient = PollyClient.Get();
+        Speaker.SpeechComponent->SetPollyClient(MoveTemp(PollyClient));
+        // The first lines are spread over a pause rather than all requested on the first frame
+        Speaker.NextLineSeconds = StartSeconds + Random.FRandRange(0.0f, Config.MaxPauseSeconds);
+    }
+
+    FPollySynthesisScheduler& Scheduler = FPollySynthesisScheduler::Get();
+    const double EndSeconds = StartSeconds + Config.DurationSeconds;
+    TArray<double> TimesToFirstAudio;
+    TArray<double> FrameCosts;
+    double TotalOccupancy = 0.0;
+    FSpeechLoadTestResult Result;
+    Result.NumSpeakers = Speakers.Num();
+    int32 NumGenerating = 0;
+    for (double FrameStartSeconds = StartSeconds; FrameStartSeconds < EndSeconds || NumGenerating > 0; ) {
+        const double WorkStartSeconds = FPlatformTime::Seconds();
+        FTaskGraphInterface::Get().ProcessThreadUntilIdle(ENamedThreads::GameThread);
+        for (FVirtualSpeaker& Speaker : Speakers) {
+            const double NowSeconds = FPlatformTime::Seconds();
+            switch (Speaker.State) {
+            case ESpeakerState::Pausing:
+                if (NowSeconds >= Speaker.NextLineSeconds && NowSeconds < EndSeconds) {
+                    UTestableSpeechComponent* SpeechComponent = Speaker.SpeechComponent;
+                    const FString Line = CreateLine(Random, Config);
+                    Speaker.LineRequestSeconds = NowSeconds;
+                    Speaker.Generated = Async(EAsyncExecution::Thread, [SpeechComponent, Line]() {
+                        return SpeechComponent->GenerateSpeechSync(Line, EVoiceId::Joanna);
+                    });
+                    Speaker.State = ESpeakerState::Generating;
+                    NumGenerating++;
+                }
+                break;
+            case ESpeakerState::Generating:
+                if (Speaker.Generated.IsReady()) {
+                    NumGenerating--;
+                    if (Speaker.Generated.Get() && Speaker.SpeechComponent->StartSpeech() != nullptr) {
+                        Speaker.SpeechStartSeconds = FPlatformTime::Seconds();
+                        TimesToFirstAudio.Add((Speaker.SpeechStartSeconds - Speaker.LineRequestSeconds) * 1000.0);
+                        Speaker.State = ESpeakerState::Speaking;
+                        Result.NumSpoken++;
+                    }
+                    else {
+                        Speaker.NextLineSeconds = NowSeconds + Random.FRandRange(Config.MinPauseSeconds, Config.MaxPauseSeconds);
+                        Speaker.State = ESpeakerState::Pausing;
+                        Result.NumFailed++;
+                    }
+                }
+                break;
+            case ESpeakerState::Speaking:
+                PlayDueVisemes(Speaker, NowSeconds);
+                // What an animation blueprint reads every frame
+                Speaker.SpeechComponent->GetCurrentViseme();
+                Speaker.SpeechComponent->GetCurrentIntensity();
+                if (!Speaker.SpeechComponent->IsSpeaking()) {
+                    Speaker.NextLineSeconds = NowSeconds + Random.FRandRange(Config.MinPauseSeconds, Config.MaxPauseSeconds);
+                    Speaker.State = ESpeakerState::Pausing;
+                }
+                break;
+            }
+        }
+        FrameCosts.Add((FPlatformTime::Seconds() - WorkStartSeconds) * 1000.0);
+
+        const FPollySchedulerStats Stats = Scheduler.GetStats();
+        int32 InFlight = 0;
+        for (const FPollySchedulerPriorityStats& PriorityStats : Stats.Priorities) {
+            InFlight += PriorityStats.InFlight;
+        }
+        const double Occupancy = static_cast<double>(InFlight) / FMath::Max(Stats.NumWorkers, 1);
+        TotalOccupancy += Occupancy;
+        Result.PeakWorkerOccupancy = FMath::Max(Result.PeakWorkerOccupancy, Occupancy);
+
+        // A frame that ran long is not made up for, like a game thread that hitches
+        const double NextFrameSeconds = FrameStartSeconds + Config.FrameSeconds;
+        const double SleepSeconds = NextFrameSeconds - FPlatformTime::Seconds();
+        if (SleepSeconds > 0.0) {
+            FPlatformProcess::Sleep(SleepSeconds);
+        }
+        FrameStartSeconds = FMath::Max(NextFrameSeconds, FPlatformTime::Seconds());
+    }
+    Result.ElapsedSeconds = FPlatformTime::Seconds() - StartSeconds;
+
+    for (FVirtualSpeaker& Speaker : Speakers) {
+        if (Speaker.State == ESpeakerState::Speaking) {
+            Speaker.SpeechComponent->StopSpeech();
+        }
+        Result.NumRequests += Speaker.PollyClient->GetNumRequests();
+        Result.NumThrottled += Speaker.PollyClient->GetNumThrottled();
+        Speaker.SpeechComponent->RemoveFromRoot();
+    }
+    Result.LinesPerSecond = Result.NumSpoken / Result.ElapsedSeconds;
+    Result.RequestsPerSecond = Result.NumRequests / Result.ElapsedSeconds;
+    TimesToFirstAudio.Sort();
+    Result.TimeToFirstAudioP50Ms = Percentile(TimesToFirstAudio, 50);
+    Result.TimeToFirstAudioP95Ms = Percentile(TimesToFirstAudio, 95);
+    Result.TimeToFirstAudioP99Ms = Percentile(TimesToFirstAudio, 99);
+    Result.TimeToFirstAudioMaxMs = TimesToFirstAudio.Num() > 0 ? TimesToFirstAudio.Last() : 0.0;
+    Result.NumFrames = FrameCosts.Num();
+    Result.MeanWorkerOccupancy = TotalOccupancy / FMath::Max<int64>(Result.NumFrames, 1);
+    FrameCosts.Sort();
+    Result.GameThreadP50Ms = Percentile(FrameCosts, 50);
+    Result.GameThreadP99Ms = Percentile(FrameCosts, 99);
+    Result.GameThreadMaxMs = FrameCosts.Num() > 0 ? FrameCosts.Last() : 0.0;
+    return Result;
+}
+
+FString SpeechLoadTest::ToString(const FSpeechLoadTestResult& Result) {
+    return FString::Printf(TEXT("%d speakers over %.1f s: %lld lines spoken and %lld failed, %lld of %lld requests throttled, %.1f lines/s, %.1f requests/s. ")
+        TEXT("Time to first audio p50 %.0f ms, p95 %.0f ms, p99 %.0f ms, max %.0f ms. Scheduler workers %.0f%% busy on average, %.0f%% at peak. ")
+        TEXT("Game thread %.3f ms per frame at p50, %.3f ms at p99, %.3f ms at most over %lld frames."),
+        Result.NumSpeakers, Result.ElapsedSeconds, Result.NumSpoken, Result.NumFailed, Result.NumThrottled, Result.NumRequests, Result.LinesPerSecond, Result.RequestsPerSecond,
+        Result.TimeToFirstAudioP50Ms, Result.TimeToFirstAudioP95Ms, Result.TimeToFirstAudioP99Ms, Result.TimeToFirstAudioMaxMs, Result.MeanWorkerOccupancy * 100.0, Result.PeakWorkerOccupancy * 100.0,
+        Result.GameThreadP50Ms, Result.GameThreadP99Ms, Result.GameThreadMaxMs, Result.NumFrames);
+}
@@ -0,0 +1,116 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "FaultInjectingPollyClient.h"
+
+/**
+* Configuration of a load test, see SpeechLoadTest::Run
+*/
+struct FSpeechLoadTestConfig {
+    int32 NumSpeakers = 100;
+    /**
+    * How long the speakers request new lines for. The lines still being generated at the end are waited for.
+    */
+    float DurationSeconds = 30.0f;
+    /**
+    * Length of a frame of the simulated game thread
+    */
+    float FrameSeconds = 1.0f / 60.0f;
+    /**
+    * Shortest and longest line, in characters
+    */
+    int32 MinLineChars = 20;
+    int32 MaxLineChars = 200;
+    /**
+    * Shortest and longest pause of a speaker between the end of a line and the request of the next one
+    */
+    float MinPauseSeconds = 0.5f;
+    float MaxPauseSeconds = 3.0f;
+    /**
+    * See USpeechComponent::bPipelineSentences
+    */
+    bool bPipelineSentences = false;
+    /**
+    * Latencies and faults of the Polly clients of the speakers. The seed of each speaker is offset by its index.
+    */
+    FPollyFaultConfig Faults;
+};
+
+/**
+* Results of a load test
+*/
+struct FSpeechLoadTestResult {
+    int32 NumSpeakers = 0;
+    double ElapsedSeconds = 0.0;
+    /**
+    * Number of lines that started speaking
+    */
+    int64 NumSpoken = 0;
+    /**
+    * Number of lines whose generation failed
+    */
+    int64 NumFailed = 0;
+    int64 NumRequests = 0;
+    int64 NumThrottled = 0;
+    double LinesPerSecond = 0.0;
+    double RequestsPerSecond = 0.0;
+    /**
+    * Time from requesting a line until StartSpeech returned its sound, in milliseconds. The end of the generation
+    * is noticed on the next frame, as a latent GenerateSpeech call does.
+    */
+    double TimeToFirstAudioP50Ms = 0.0;
+    double TimeToFirstAudioP95Ms = 0.0;
+    double TimeToFirstAudioP99Ms = 0.0;
+    double TimeToFirstAudioMaxMs = 0.0;
+    /**
+    * Fraction of the workers of the FPollySynthesisScheduler with a request in flight, averaged over the frames
+    * and at its peak
+    */
+    double MeanWorkerOccupancy = 0.0;
+    double PeakWorkerOccupancy = 0.0;
+    /**
+    * Time the game thread spent on the speakers per frame, in milliseconds
+    */
+    double GameThreadP50Ms = 0.0;
+    double GameThreadP99Ms = 0.0;
+    double GameThreadMaxMs = 0.0;
+    int64 NumFrames = 0;
+};
+
+/**
+* Load test of many speech components speaking at once, without network access
+*/
+namespace SpeechLoadTest {
+    /**
+    * Simulates virtual speakers, each a speech component calling Polly through a FaultInjectingPollyClient. Every
+    * speaker repeatedly pauses, generates a line on a thread of its own the way a latent GenerateSpeech call does,
+    * starts it on the game thread once generated and plays its visemes to the end. Frames of the game thread are
+    * simulated on the calling thread, which must be the game thread: every frame runs the tasks queued for the
+    * game thread, updates the speakers and samples the FPollySynthesisScheduler.
+    * @param Config - the configuration of the test
+    * @return FSpeechLoadTestResult - the results
+    */
+    FSpeechLoadTestResult Run(const FSpeechLoadTestConfig& Config);
+    /**
+    * Formats the results of a load test for the log
+    */
+    FString ToString(const FSpeechLoadTestResult& Result);
+}
@@ -0,0 +1,212 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "CoreMinimal.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS && WITH_EDITOR
+
+#include "Editor.h"
+#include "Settings/LevelEditorPlaySettings.h"
+#include "Tests/AutomationCommon.h"
+#include "EngineUtils.h"
+#include "SpeechReplicationTestActor.h"
+
+namespace {
+    /**
+    * Number of clients besides the listen server
+    */
+    const int32 NumClients = 2;
+    /**
+    * How long each step waits for the worlds to replicate
+    */
+    const double StepTimeoutSeconds = 10.0;
+
+    /**
+    * Returns the PIE worlds of a net mode
+    */
+    TArray<UWorld*> GetPlayWorlds(ENetMode NetMode) {
+        TArray<UWorld*> Worlds;
+        for (const FWorldContext& Context : GEngine->GetWorldContexts()) {
+            UWorld* World = Context.World();
+            if (Context.WorldType == EWorldType::PIE && World != nullptr && World->HasBegunPlay() && World->GetNetMode() == NetMode) {
+                Worlds.Add(World);
+            }
+        }
+        return Worlds;
+    }
+
+    /**
+    * Returns the test actors replicated to the clients
+    */
+    TArray<ASpeechReplicationTestActor*> GetClientActors() {
+        TArray<ASpeechReplicationTestActor*> Actors;
+        for (UWorld* World : GetPlayWorlds(NM_Client)) {
+            for (TActorIterator<ASpeechReplicationTestActor> It(World); It; ++It) {
+                Actors.Add(*It);
+            }
+        }
+        return Actors;
+    }
+
+    /**
+    * Creates a lambda function that returns a successful PollyOutcome holding silent pcm audio
+    */
+    TFunction<PollyOutcome()> CreateReplicationAudioOutcome(int32 NumBytes) {
+        return [NumBytes]() {
+            PollyOutcome Outcome;
+            Outcome.IsSuccess = true;
+            TArray<uint8> Audio;
+            Audio.SetNumZeroed(NumBytes);
+            Outcome.StreamBuffer = PollyAudioBuffer::Make(MoveTemp(Audio));
+            return Outcome;
+        };
+    }
+
+    /**
+    * Creates a lambda function that returns the speech marks of a sentence of 2s
+    */
+    TFunction<PollyOutcome()> CreateReplicationVisemeOutcome() {
+        return []() {
+            FString VisemeJson;
+            for (int32 VisemeIndex = 0; VisemeIndex < 40; VisemeIndex++) {
+                VisemeJson += FString::Printf(TEXT("{\"time\":%d,\"type\":\"viseme\",\"value\":\"%s\"}\n"), VisemeIndex * 50, VisemeIndex % 2 ? TEXT("a") : TEXT("p"));
+            }
+            PollyOutcome Outcome;
+            Outcome.IsSuccess = true;
+            const FTCHARToUTF8 VisemeUtf8(*VisemeJson);
+            Outcome.StreamBuffer = PollyAudioBuffer::Make(TArray<uint8>(reinterpret_cast<const uint8*>(VisemeUtf8.Get()), VisemeUtf8.Length()));
+            return Outcome;
+        };
+    }
+
+    /**
+    * State shared by the latent steps of the test
+    */
+    struct FSpeechReplicationTestState {
+        TWeakObjectPtr<ASpeechReplicationTestActor> ServerActor;
+        double StepStartSeconds = 0.0;
+    };
+
+    /**
+    * Latent step polling a condition until it holds, failing the test after StepTimeoutSeconds
+    */
+    class FWaitForReplicationCommand : public IAutomationLatentCommand {
+    public:
+        FWaitForReplicationCommand(FAutomationTestBase* InTest, TSharedRef<FSpeechReplicationTestState> InState, const FString& InDescription, TFunction<bool()> InCondition) :
+            Test(InTest),
+            State(InState),
+            Description(InDescription),
+            Condition(InCondition) {
+        }
+
+        virtual bool Update() override {
+            if (State->StepStartSeconds == 0.0) {
+                State->StepStartSeconds = FPlatformTime::Seconds();
+            }
+            if (Condition()) {
+                State->StepStartSeconds = 0.0;
+                return true;
+            }
+            if (FPlatformTime::Seconds() - State->StepStartSeconds > StepTimeoutSeconds) {
+                Test->AddError(FString::Printf(TEXT("Timed out waiting for %s."), *Description));
+                State->StepStartSeconds = 0.0;
+                return true;
+            }
+            return false;
+        }
+
+    private:
+        FAutomationTestBase* Test;
+        TSharedRef<FSpeechReplicationTestState> State;
+        FString Description;
+        TFunction<bool()> Condition;
+    };
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FSpeechReplicationTest, "AmazonPolly.Replication Tests.Replicated speech plays in sync on every client", EAutomationTestFlags::EditorContext | EAutomationTestFlags::ProductFilter)
+
+bool FSpeechReplicationTest::RunTest(const FString& Parameters) {
+    // given a listen server and 2 clients in one process
+    ULevelEditorPlaySettings* PlaySettings = NewObject<ULevelEditorPlaySettings>();
+    PlaySettings->SetPlayNetMode(EPlayNetMode::PIE_ListenServer);
+    PlaySettings->SetPlayNumberOfClients(NumClients + 1);
+    PlaySettings->SetRunUnderOneProcess(true);
+    PlaySettings->bLaunchSeparateServer = false;
+    FRequestPlaySessionParams PlaySessionParams;
+    PlaySessionParams.EditorPlaySettings = PlaySettings;
+    GEditor->RequestPlaySession(PlaySessionParams);
+
+    TSharedRef<FSpeechReplicationTestState> State = MakeShared<FSpeechReplicationTestState>();
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitForReplicationCommand(this, State, TEXT("the clients to join"), []() {
+        return GetPlayWorlds(NM_ListenServer).Num() == 1 && GetPlayWorlds(NM_Client).Num() == NumClients;
+    }));
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([State]() {
+        State->ServerActor = GetPlayWorlds(NM_ListenServer)[0]->SpawnActor<ASpeechReplicationTestActor>();
+        return true;
+    }));
+    // Each client only synthesizes the audio of the line, the visemes come from the server
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitForReplicationCommand(this, State, TEXT("the speaker to replicate"), []() {
+        TArray<ASpeechReplicationTestActor*> ClientActors = GetClientActors();
+        if (ClientActors.Num() < NumClients) {
+            return false;
+        }
+        for (ASpeechReplicationTestActor* ClientActor : ClientActors) {
+            ClientActor->SpeechComponent->GetPollyClient()->AddSynthesizeSpeechBehavior(CreateReplicationAudioOutcome(64000));
+        }
+        return true;
+    }));
+    // when the server speaks a line
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]() {
+        UTestableSpeechComponent* ServerSpeech = State->ServerActor->SpeechComponent;
+        ServerSpeech->bUseSpeechCache = false;
+        ServerSpeech->GetPollyClient()->AddSynthesizeSpeechBehavior(CreateReplicationAudioOutcome(64000));
+        ServerSpeech->GetPollyClient()->AddSynthesizeSpeechBehavior(CreateReplicationVisemeOutcome());
+        TestTrue("The server generates the speech", ServerSpeech->GenerateSpeechSync(TEXT("Hello everyone."), EVoiceId::Joanna));
+        TestNotNull("The server starts the speech", ServerSpeech->StartSpeech());
+        return true;
+    }));
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitForReplicationCommand(this, State, TEXT("the clients to speak"), []() {
+        for (ASpeechReplicationTestActor* ClientActor : GetClientActors()) {
+            if (!ClientActor->SpeechComponent->IsSpeaking()) {
+                return false;
+            }
+        }
+        return true;
+    }));
+    ADD_LATENT_AUTOMATION_COMMAND(FWaitLatentCommand(0.5f));
+    // then every client plays it in sync with the server, from a compact viseme track
+    ADD_LATENT_AUTOMATION_COMMAND(FFunctionLatentCommand([this, State]() {
+        const int32 TrackBytes = State->ServerActor->SpeechComponent->GetReplicatedVisemeTrackBytes();
+        AddInfo(FString::Printf(TEXT("Replicated viseme track: %d bytes for 40 visemes."), TrackBytes));
+        TestTrue("The viseme track is under 200 bytes", TrackBytes > 0 && TrackBytes < 200);
+        for (ASpeechReplicationTestActor* ClientActor : GetClientActors()) {
+            UTestableSpeechComponent* ClientSpeech = ClientActor->SpeechComponent;
+            const float DriftMilliseconds = ClientSpeech->GetReplicationDriftMilliseconds();
+            AddInfo(FString::Printf(TEXT("Client drift: %.1f ms."), DriftMilliseconds));
+            TestTrue("The client is within 100ms of the server", FMath::Abs(DriftMilliseconds) < 100.0f);
+            TestEqual("The client synthesizes the audio once", ClientSpeech->GetPollyClient()->GetRequestedAudioTexts().Num(), 1);
+            TestEqual("The client has every viseme", ClientSpeech->GetVisemeEventArray().Num(), 40);
+        }
+        return true;
+    }));
+    ADD_LATENT_AUTOMATION_COMMAND(FEndPlayMapCommand());
+    return true;
+}
+
+#endif
@@ -22,8 +22,8 @@ void UTestableSpeechComponent::InitializePollyClient() {
     MyPollyClient = MakeUnique<MockPollyClient>();
 }
 
-void UTestableSpeechComponent::GenerateSpeechSync(const FString text, const EVoiceId VoiceId) {
-    Super::GenerateSpeechSync(text, VoiceId);
+bool UTestableSpeechComponent::GenerateSpeechSync(const FString text, const EVoiceId VoiceId) {
+    return Super::GenerateSpeechSync(text, VoiceId);
 }
 
 void UTestableSpeechComponent::SetTimer(float CurrentVisemeDurationSeconds) {
@@ -44,6 +44,10 @@ MockPollyClient* UTestableSpeechComponent::GetPollyClient() {
     return StaticCast<MockPollyClient*>(MyPollyClient.Get());
 }
 
+void UTestableSpeechComponent::SetPollyClient(TUniquePtr<MockPollyClient> PollyClient) {
+    MyPollyClient = MoveTemp(PollyClient);
+}
+
 void UTestableSpeechComponent::PlayNextViseme() {
     Super::PlayNextViseme();
 }
@@ -53,7 +57,9 @@ EViseme UTestableSpeechComponent::GetCurrentViseme() {
 }
 
 TArray<VisemeEvent> UTestableSpeechComponent::GetVisemeEventArray() {
-    return VisemeEventArray;
+    TArray<VisemeEvent> Visemes;
+    VisemeTrack->GetVisemeEvents(Visemes);
+    return Visemes;
 }
 
 int UTestableSpeechComponent::GetCurrentVisemeIndex() {
@@ -61,7 +67,23 @@ int UTestableSpeechComponent::GetCurrentVisemeIndex() {
 }
 
 TArray<uint8> UTestableSpeechComponent::GetAudiobuffer() {
-    return Audiobuffer;
+    TArray<uint8> Audio;
+    PollyAudioBuffer::Flatten(SpeechAudio, Audio);
+    return Audio;
+}
+
+TArray<FPollyAudioBuffer> UTestableSpeechComponent::GetSpeechAudio() {
+    return SpeechAudio;
+}
+
+int32 UTestableSpeechComponent::GetPendingSegmentCount() {
+    return PendingSegmentCount;
+}
+
+void UTestableSpeechComponent::WaitForSegmentPipeline() {
+    if (SegmentPipeline.IsValid()) {
+        SegmentPipeline.Wait();
+    }
 }
 
 bool UTestableSpeechComponent::IsSpeaking() {
@@ -71,3 +93,27 @@ bool UTestableSpeechComponent::IsSpeaking() {
 void UTestableSpeechComponent::SetSpeaking(bool boolean) {
     bIsSpeaking = boolean;
 }
+
+void UTestableSpeechComponent::ApplyReplicatedSpeech(const FReplicatedSpeech& InReplicatedSpeech) {
+    ReplicatedSpeech = InReplicatedSpeech;
+    OnRep_ReplicatedSpeech();
+}
+
+USoundWaveProcedural* UTestableSpeechComponent::GetActivePollyAudio() {
+    return ActivePollyAudio.Get();
+}
+
+void UTestableSpeechComponent::ApplyVisemeJson(TArrayView<const uint8> VisemeJson) {
+    FScopeLock lock(&Mutex);
+    GenerateVisemeEvents(VisemeJson);
+}
+
+void UTestableSpeechComponent::SetSpeechAudio(const TArray<FPollyAudioBuffer>& Audio) {
+    FScopeLock lock(&Mutex);
+    SpeechAudio = Audio;
+}
+
+USoundWaveProcedural* UTestableSpeechComponent::CreateSpeechSound(int64 StartMilliseconds) {
+    FScopeLock lock(&Mutex);
+    return QueuePollyAudio(StartMilliseconds);
+}
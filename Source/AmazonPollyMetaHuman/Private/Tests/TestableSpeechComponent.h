@@ -39,7 +39,7 @@ public:
     * Overrides GenerateSpeechSync to change accessibility to public so it can be invoked
     * from the spec tests. See USpeechComponent::GenerateSpeechSync for details.
     */
-    virtual void GenerateSpeechSync(const FString text, const EVoiceId VoiceId) override;
+    virtual bool GenerateSpeechSync(const FString text, const EVoiceId VoiceId) override;
     /**
     * Overrides PlayNextViseme to change accessibility to public so it can be invoked
     * from the spec tests. See USpeechComponent::GenerateSpeechSync for details.
@@ -58,11 +58,15 @@ public:
     */
     MockPollyClient* GetPollyClient();
     /**
+    * Replaces the MockPollyClient, e.g. by a FaultInjectingPollyClient
+    */
+    void SetPollyClient(TUniquePtr<MockPollyClient> PollyClient);
+    /**
     * Getter for CurrentViseme
     */
     EViseme GetCurrentViseme();
     /**
-    * Getter for VisemeEventArray
+    * Getter for the visemes of the VisemeTrack
     */
     TArray<VisemeEvent> GetVisemeEventArray();
     /**
@@ -70,10 +74,22 @@ public:
     */
     int GetCurrentVisemeIndex();
     /**
-    * Getter for Audiobuffer
+    * Returns the audio of the speech in one piece
     */
     TArray<uint8> GetAudiobuffer();
     /**
+    * Getter for SpeechAudio
+    */
+    TArray<FPollyAudioBuffer> GetSpeechAudio();
+    /**
+    * Getter for PendingSegmentCount
+    */
+    int32 GetPendingSegmentCount();
+    /**
+    * Blocks until the segments synthesized in the background have been appended
+    */
+    void WaitForSegmentPipeline();
+    /**
     * Getter for bIsSpeaking 
     */
     bool IsSpeaking();
@@ -81,4 +97,24 @@ public:
     * Setter for bIsSpeaking
     */
     void SetSpeaking(bool boolean);
+    /**
+    * Receives a replicated speech as if it came from the server
+    */
+    void ApplyReplicatedSpeech(const FReplicatedSpeech& InReplicatedSpeech);
+    /**
+    * Getter for ActivePollyAudio
+    */
+    USoundWaveProcedural* GetActivePollyAudio();
+    /**
+    * Fills the visemes from viseme data as if Polly returned it, see USpeechComponent::GenerateVisemeEvents
+    */
+    void ApplyVisemeJson(TArrayView<const uint8> VisemeJson);
+    /**
+    * Setter for SpeechAudio
+    */
+    void SetSpeechAudio(const TArray<FPollyAudioBuffer>& Audio);
+    /**
+    * Creates the sound playing the speech, see USpeechComponent::QueuePollyAudio
+    */
+    USoundWaveProcedural* CreateSpeechSound(int64 StartMilliseconds);
 };
\ No newline at end of file
@@ -17,6 +17,7 @@
  */
 
 #include "UnrealAWSUtils.h"
+#include "SpeechTrace.h"
 
 Aws::String UnrealAWSUtils::FStringToAwsString(const FString& UnrealString) {
     return Aws::String(TCHAR_TO_UTF8(UnrealString.GetCharArray().GetData()), UnrealString.Len());
@@ -39,6 +40,7 @@ long GetStreamSize(Aws::IOStream& PollyStream) {
 }
 
 TArray<uint8> UnrealAWSUtils::PreparePollyData(Aws::IOStream& PollyStream) {
+    POLLY_TRACE_SCOPE(UnrealAWSUtils::PreparePollyData);
     TArray<uint8> Buffer;
     long size = GetStreamSize(PollyStream);
     Buffer.AddUninitialized(size);
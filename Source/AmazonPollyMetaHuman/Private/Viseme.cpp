@@ -17,44 +17,76 @@
  */
 
 #include "Viseme.h"
-#include "CaseSensitiveKeyFunc.h"
 
 DEFINE_LOG_CATEGORY(LogAmazonPollyViseme);
 
+namespace {
+    /**
+    * Viseme of each single character symbol, indexed by the character. Symbols are case-sensitive, as visemes
+    * have both capital and lowercase versions.
+    */
+    struct FVisemeSymbolTable {
+        static constexpr uint8 NoViseme = 0xFF;
+        uint8 Visemes[128];
+    };
+
+    constexpr FVisemeSymbolTable MakeVisemeSymbolTable() {
+        FVisemeSymbolTable Table = {};
+        for (int32 Character = 0; Character < 128; Character++) {
+            Table.Visemes[Character] = FVisemeSymbolTable::NoViseme;
+        }
+        Table.Visemes['p'] = static_cast<uint8>(EViseme::P);
+        Table.Visemes['t'] = static_cast<uint8>(EViseme::LowerT);
+        Table.Visemes['S'] = static_cast<uint8>(EViseme::S);
+        Table.Visemes['T'] = static_cast<uint8>(EViseme::T);
+        Table.Visemes['f'] = static_cast<uint8>(EViseme::F);
+        Table.Visemes['k'] = static_cast<uint8>(EViseme::K);
+        Table.Visemes['i'] = static_cast<uint8>(EViseme::I);
+        Table.Visemes['r'] = static_cast<uint8>(EViseme::R);
+        Table.Visemes['s'] = static_cast<uint8>(EViseme::LowerS);
+        Table.Visemes['u'] = static_cast<uint8>(EViseme::U);
+        Table.Visemes['@'] = static_cast<uint8>(EViseme::At);
+        Table.Visemes['a'] = static_cast<uint8>(EViseme::A);
+        Table.Visemes['e'] = static_cast<uint8>(EViseme::LowerE);
+        Table.Visemes['E'] = static_cast<uint8>(EViseme::E);
+        Table.Visemes['o'] = static_cast<uint8>(EViseme::LowerO);
+        Table.Visemes['O'] = static_cast<uint8>(EViseme::O);
+        return Table;
+    }
+
+    constexpr FVisemeSymbolTable VisemeSymbols = MakeVisemeSymbolTable();
+    static_assert(VisemeSymbols.Visemes['p'] == static_cast<uint8>(EViseme::P), "The viseme symbol table is built at compile time");
+}
+
+bool TryGetVisemeFromSymbol(const ANSICHAR* Symbol, int32 Length, EViseme& OutViseme) {
+    if (Length == 1) {
+        const uint8 Character = static_cast<uint8>(Symbol[0]);
+        if (Character < 128 && VisemeSymbols.Visemes[Character] != FVisemeSymbolTable::NoViseme) {
+            OutViseme = static_cast<EViseme>(VisemeSymbols.Visemes[Character]);
+            return true;
+        }
+        return false;
+    }
+    if (Length == 3 && Symbol[0] == 's' && Symbol[1] == 'i' && Symbol[2] == 'l') {
+        OutViseme = EViseme::Sil;
+        return true;
+    }
+    return false;
+}
+
 /*
 * Maps the FString representation of a viseme to its corresponding EViseme enum 
-* NOTE: A custom case-sensitive key-func is implemented to compare FStrings, as Visemes 
-* have both capital and lowercase versions, and the default FString comparison 
-* (uses ==) is case-insensitive 
 * @param String - an FString of the viseme 
 * @return - the EViseme enum corresponding to the FString 
 */
 EViseme GetVisemeValueFromString(const FString& String)
 {
-    static TMap<FString, EViseme, FDefaultSetAllocator, CaseSensitiveKeyFunc<EViseme>> VisemeMap = {
-        {TEXT("p"),EViseme::P}, 
-        {TEXT("t"),EViseme::LowerT},
-        {TEXT("S"),EViseme::S},
-        {TEXT("T"),EViseme::T}, 
-        {TEXT("f"),EViseme::F},
-        {TEXT("k"),EViseme::K},
-        {TEXT("i"),EViseme::I},
-        {TEXT("r"),EViseme::R},
-        {TEXT("s"),EViseme::LowerS},
-        {TEXT("u"),EViseme::U},
-        {TEXT("@"),EViseme::At},
-        {TEXT("a"),EViseme::A}, 
-        {TEXT("e"),EViseme::LowerE}, 
-        {TEXT("E"),EViseme::E},
-        {TEXT("o"),EViseme::LowerO},
-        {TEXT("O"),EViseme::O},
-        {TEXT("sil"),EViseme::Sil} 
-    };
-    auto Viseme = VisemeMap.Find(String);
-    if (!Viseme)
+    EViseme Viseme;
+    const FTCHARToUTF8 Symbol(*String);
+    if (!TryGetVisemeFromSymbol(Symbol.Get(), Symbol.Length(), Viseme))
     {
         UE_LOG(LogAmazonPollyViseme, Error, TEXT("Tried to read an invalid viseme value. Returning Sil as default. Invalid value: %s"), *String);
         return EViseme::Sil;
     }
-    return *Viseme;
-};
\ No newline at end of file
+    return Viseme;
+};
@@ -0,0 +1,70 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "VisemeTrack.h"
+#include "Algo/BinarySearch.h"
+
+static_assert(sizeof(EViseme) == 1, "A viseme of a track takes a single byte");
+
+FVisemeTrackRef FVisemeTrack::Make(const TArray<VisemeEvent>& VisemeEvents) {
+    TSharedRef<FVisemeTrack, ESPMode::ThreadSafe> Track = MakeShared<FVisemeTrack, ESPMode::ThreadSafe>();
+    Track->AddVisemes(VisemeEvents, 0);
+    return Track;
+}
+
+const FVisemeTrackRef& FVisemeTrack::GetEmpty() {
+    static const FVisemeTrackRef Empty = MakeShared<const FVisemeTrack, ESPMode::ThreadSafe>();
+    return Empty;
+}
+
+FVisemeTrackRef FVisemeTrack::Append(const TArray<VisemeEvent>& VisemeEvents, int32 OffsetMilliseconds) const {
+    TSharedRef<FVisemeTrack, ESPMode::ThreadSafe> Track = MakeShared<FVisemeTrack, ESPMode::ThreadSafe>();
+    Track->TimesMilliseconds.Reserve(Num() + VisemeEvents.Num());
+    Track->Visemes.Reserve(Num() + VisemeEvents.Num());
+    Track->TimesMilliseconds.Append(TimesMilliseconds);
+    Track->Visemes.Append(Visemes);
+    Track->AddVisemes(VisemeEvents, OffsetMilliseconds);
+    return Track;
+}
+
+int32 FVisemeTrack::FindVisemeIndex(int64 PlaybackMilliseconds) const {
+    const int32 Milliseconds = static_cast<int32>(FMath::Clamp<int64>(PlaybackMilliseconds, MIN_int32, MAX_int32));
+    return Algo::LowerBound(TimesMilliseconds, Milliseconds);
+}
+
+EViseme FVisemeTrack::Evaluate(int64 PlaybackMilliseconds) const {
+    const int32 Index = FindVisemeIndex(PlaybackMilliseconds);
+    return Index < Num() ? Visemes[Index] : EViseme::Sil;
+}
+
+void FVisemeTrack::GetVisemeEvents(TArray<VisemeEvent>& OutVisemeEvents) const {
+    OutVisemeEvents.Reserve(OutVisemeEvents.Num() + Num());
+    for (int32 Index = 0; Index < Num(); Index++) {
+        OutVisemeEvents.Add({ Visemes[Index], TimesMilliseconds[Index] });
+    }
+}
+
+void FVisemeTrack::AddVisemes(const TArray<VisemeEvent>& VisemeEvents, int32 OffsetMilliseconds) {
+    TimesMilliseconds.Reserve(Num() + VisemeEvents.Num());
+    Visemes.Reserve(Num() + VisemeEvents.Num());
+    for (const VisemeEvent& Event : VisemeEvents) {
+        // Times out of order would break the binary search
+        TimesMilliseconds.Add(FMath::Max(Event.TimeMilliseconds + OffsetMilliseconds, GetEndMilliseconds()));
+        Visemes.Add(Event.Viseme);
+    }
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "VisemeTrackCodec.h"
+
+namespace {
+    const uint32 VisemeMask = (1 << VisemeTrackCodec::VisemeBits) - 1;
+    /**
+    * Largest delta that still fits a uint32 once shifted by VisemeBits
+    */
+    const int64 MaxDeltaMilliseconds = MAX_uint32 >> VisemeTrackCodec::VisemeBits;
+}
+
+namespace VisemeTrackCodec {
+    void Encode(const TArray<VisemeEvent>& VisemeEvents, TArray<uint8>& OutTrack) {
+        static_assert(static_cast<uint32>(EViseme::LowerO) <= VisemeMask, "EViseme does not fit in VisemeBits");
+        OutTrack.Reset(VisemeEvents.Num() * 2);
+        int64 PreviousMilliseconds = 0;
+        for (const VisemeEvent& Event : VisemeEvents) {
+            const int64 DeltaMilliseconds = FMath::Clamp<int64>(Event.TimeMilliseconds - PreviousMilliseconds, 0, MaxDeltaMilliseconds);
+            PreviousMilliseconds += DeltaMilliseconds;
+            uint32 Value = static_cast<uint32>(DeltaMilliseconds << VisemeBits) | static_cast<uint32>(Event.Viseme);
+            // 7 bits per byte, the high bit is set on every byte but the last
+            while (Value >= 0x80) {
+                OutTrack.Add(static_cast<uint8>(Value | 0x80));
+                Value >>= 7;
+            }
+            OutTrack.Add(static_cast<uint8>(Value));
+        }
+    }
+
+    bool Decode(const TArray<uint8>& Track, TArray<VisemeEvent>& OutVisemeEvents) {
+        OutVisemeEvents.Reset(Track.Num() / 2);
+        int64 TimeMilliseconds = 0;
+        int32 ByteIndex = 0;
+        while (ByteIndex < Track.Num()) {
+            uint32 Value = 0;
+            int32 Shift = 0;
+            uint8 Byte;
+            do {
+                if (ByteIndex == Track.Num() || Shift > 28) {
+                    return false;
+                }
+                Byte = Track[ByteIndex++];
+                Value |= static_cast<uint32>(Byte & 0x7F) << Shift;
+                Shift += 7;
+            } while (Byte & 0x80);
+            const uint32 Viseme = Value & VisemeMask;
+            if (Viseme > static_cast<uint32>(EViseme::LowerO)) {
+                return false;
+            }
+            TimeMilliseconds += Value >> VisemeBits;
+            VisemeEvent Event;
+            Event.Viseme = static_cast<EViseme>(Viseme);
+            Event.TimeMilliseconds = static_cast<int32>(TimeMilliseconds);
+            OutVisemeEvents.Add(Event);
+        }
+        return true;
+    }
+}
@@ -0,0 +1,47 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpeechComponent.h"
+
+/**
+* Compact encoding of a viseme track for replication. Every viseme is a single varint holding the milliseconds
+* since the previous viseme, shifted left by VisemeBits, and the viseme in the low VisemeBits bits. Visemes less
+* than 128ms apart, which is nearly all of them, take 2 bytes, so a sentence is typically well under 200 bytes.
+*/
+namespace VisemeTrackCodec {
+    /**
+    * Number of bits holding the viseme, enough for every EViseme
+    */
+    const int32 VisemeBits = 5;
+    /**
+    * Encodes visemes. A viseme timed before the previous one is moved to the time of the previous one.
+    * @param VisemeEvents - the visemes, in playback order
+    * @param OutTrack - receives the encoded track
+    */
+    void Encode(const TArray<VisemeEvent>& VisemeEvents, TArray<uint8>& OutTrack);
+    /**
+    * Decodes visemes encoded by Encode
+    * @param Track - the encoded track
+    * @param OutVisemeEvents - receives the visemes
+    * @return bool - false if the track is truncated or holds an unknown viseme
+    */
+    bool Decode(const TArray<uint8>& Track, TArray<VisemeEvent>& OutVisemeEvents);
+}
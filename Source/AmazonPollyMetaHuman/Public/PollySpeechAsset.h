@@ -0,0 +1,169 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Object.h"
+#include "Engine/DataTable.h"
+#include "Serialization/BulkData.h"
+#include "SpeechComponent.h"
+#include "PollySpeechAsset.generated.h"
+
+/**
+* Row of the data tables of lines baked by the PollySpeechBake commandlet. The row name names the asset.
+*/
+USTRUCT(BlueprintType)
+struct FPollySpeechLine : public FTableRowBase {
+    GENERATED_BODY()
+    /**
+    * The text to be synthesized by Polly
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly")
+    FString Text;
+    /**
+    * The voice to synthesize the text with
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly")
+    EVoiceId VoiceId = EVoiceId::Joanna;
+};
+
+/**
+* Speech synthesized ahead of time by the PollySpeechBake commandlet, which a speech component plays without
+* calling Polly. See USpeechComponent::GenerateSpeechFromAsset.
+* The audio is stored outside of the package export, so that a cooked asset only loads its visemes and the audio is
+* streamed in AudioChunkBytes chunks while it plays, see UPollyBakedSoundWave.
+*/
+UCLASS(BlueprintType)
+class AMAZONPOLLYMETAHUMAN_API UPollySpeechAsset : public UObject {
+    GENERATED_BODY()
+
+public:
+    /**
+    * Size of the chunks the audio is streamed in, 1024ms of audio
+    */
+    static constexpr int32 AudioChunkBytes = 32 * 1024;
+
+    /**
+    * Serializes the audio bulk data along with the properties
+    */
+    virtual void Serialize(FArchive& Ar) override;
+    /**
+    * Stores the synthesized speech of a text
+    * @param InText - the text that was synthesized
+    * @param InVoiceId - the voice the text was synthesized with
+    * @param InAudio - the pcm audio of the text
+    * @param InVisemeEvents - the visemes of the text
+    */
+    void SetSpeech(const FString& InText, const EVoiceId InVoiceId, const TArray<uint8>& InAudio, const TArray<VisemeEvent>& InVisemeEvents);
+    /**
+    * Returns true if the asset holds the speech of a text and voice, synthesized with the current output formats
+    * @param InText - the text of the line
+    * @param InVoiceId - the voice of the line
+    * @return bool - false if the line must be synthesized again
+    */
+    bool IsUpToDate(const FString& InText, const EVoiceId InVoiceId) const;
+    /**
+    * Returns the size of the audio in bytes
+    */
+    int32 GetNumAudioBytes() const;
+    /**
+    * Returns the number of AudioChunkBytes chunks of the audio, the last one may be shorter
+    */
+    int32 GetNumAudioChunks() const;
+    /**
+    * Returns the size of a chunk of the audio in bytes
+    */
+    int32 GetAudioChunkSize(int32 ChunkIndex) const;
+    /**
+    * Copies a chunk of the audio if the audio is in memory, which is the case for speech set by SetSpeech that
+    * has not been saved and loaded yet
+    * @param ChunkIndex - the index of the chunk
+    * @param Dest - receives the chunk, GetAudioChunkSize bytes
+    * @return bool - false if the chunk has to be read with ReadAudioChunkAsync
+    */
+    bool CopyResidentAudioChunk(int32 ChunkIndex, uint8* Dest) const;
+    /**
+    * Starts reading a chunk of the audio from the package, pak file or container it was loaded from
+    * @param ChunkIndex - the index of the chunk
+    * @param Dest - receives the chunk, GetAudioChunkSize bytes
+    * @param Callback - called on an IO thread once the read completes or is cancelled
+    * @return IBulkDataIORequest* - the read, owned by the caller, or nullptr if the read could not be started
+    */
+    IBulkDataIORequest* ReadAudioChunkAsync(int32 ChunkIndex, uint8* Dest, FBulkDataIORequestCallBack* Callback) const;
+    /**
+    * Copies the whole audio, loading it if needed. Playback streams the audio instead, this is meant for tools.
+    * @param OutAudio - the pcm audio of the speech
+    * @return bool - false if the audio could not be loaded
+    */
+    bool GetAudio(TArray<uint8>& OutAudio) const;
+    /**
+    * Expands the viseme track into viseme events
+    * @param OutVisemeEvents - the visemes of the speech
+    */
+    void GetVisemeEvents(TArray<VisemeEvent>& OutVisemeEvents) const;
+    /**
+    * Returns the duration of the audio
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    float GetDurationSeconds() const;
+    /**
+    * Returns the hash identifying the synthesis of a text and voice, which changes with the text, the voice, the
+    * engine of the voice and the output formats
+    */
+    static FString GetSourceHash(const FString& InText, const EVoiceId InVoiceId);
+
+    /**
+    * The text that was synthesized
+    */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Amazon Polly")
+    FString Text;
+    /**
+    * The voice the text was synthesized with
+    */
+    UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Amazon Polly")
+    EVoiceId VoiceId;
+    /**
+    * GetSourceHash of the text and voice at the time they were synthesized
+    */
+    UPROPERTY(VisibleAnywhere, Category = "Amazon Polly")
+    FString SourceHash;
+    /**
+    * Visemes of the speech, with their start times in VisemeTimesMs
+    */
+    UPROPERTY()
+    TArray<EViseme> Visemes;
+    UPROPERTY()
+    TArray<int32> VisemeTimesMs;
+    /**
+    * Amplitude envelope of the audio, see USpeechComponent::GetCurrentIntensity. Kept in the export, it is 1/320
+    * of the size of the audio.
+    */
+    UPROPERTY()
+    TArray<uint8> IntensityEnvelope;
+
+private:
+    /**
+    * Audio of the speech, 16 kHz 16 bit mono pcm, never stored inline in the package
+    */
+    FByteBulkData AudioBulkData;
+    /**
+    * Guards the locks of AudioBulkData, which may be read by the audio render thread and the game thread at once
+    */
+    mutable FCriticalSection AudioBulkDataMutex;
+};
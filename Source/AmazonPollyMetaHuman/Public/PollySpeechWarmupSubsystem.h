@@ -0,0 +1,110 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter.h"
+#include "SpeechWarmupManifest.h"
+#include "PollySpeechWarmupSubsystem.generated.h"
+
+class USpeechComponent;
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSpeechWarmupComplete);
+
+/**
+* Records the lines spoken in a map, with how often they are spoken, in Saved/PollySpeechWarmup/<map>.json. When the
+* map is loaded again, the first speech component to begin play synthesizes the most frequent of them into the
+* cache of synthesized speech in the background, so that they are spoken without waiting for Polly.
+*/
+UCLASS()
+class AMAZONPOLLYMETAHUMAN_API UPollySpeechWarmupSubsystem : public UWorldSubsystem {
+    GENERATED_BODY()
+
+public:
+    /**
+    * Only game and play in editor worlds record and warm up lines. See USubsystem::ShouldCreateSubsystem for details.
+    */
+    virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+    /**
+    * Loads the manifest of the map. See USubsystem::Initialize for details.
+    */
+    virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+    /**
+    * Aborts the warmup and saves the manifest. See USubsystem::Deinitialize for details.
+    */
+    virtual void Deinitialize() override;
+    /**
+    * Starts synthesizing the most frequent lines of the manifest in the background, unless a warmup was already
+    * started in this map. Lines are synthesized at Ambient priority, so that they do not delay other speech.
+    * @param SpeechComponent - the component whose Polly client and settings are used
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    void StartWarmup(USpeechComponent* SpeechComponent);
+    /**
+    * Returns the fraction of the lines to warm up that are cached, 1 once the warmup is complete
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    float GetWarmupProgress() const;
+    /**
+    * Returns true once every line to warm up has been synthesized, or failed to be
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    bool IsWarmupComplete() const;
+    /**
+    * Broadcast on the game thread once the warmup is complete, e.g. to end a loading screen
+    */
+    UPROPERTY(BlueprintAssignable, Category = "Amazon Polly")
+    FOnSpeechWarmupComplete OnWarmupComplete;
+    /**
+    * Returns the manifest the speech components of the map record their lines in
+    */
+    TSharedPtr<FSpeechWarmupManifest, ESPMode::ThreadSafe> GetManifest() const { return Manifest; }
+
+private:
+    /**
+    * Takes the next line to warm up
+    * @param OutLine - the line
+    * @return bool - false once there are no lines left
+    */
+    bool PopWarmupLine(FSpeechWarmupLine& OutLine);
+    /**
+    * Counts a line as warmed up, broadcasting OnWarmupComplete after the last one
+    */
+    void NoteLineWarmed();
+
+    TSharedPtr<FSpeechWarmupManifest, ESPMode::ThreadSafe> Manifest;
+    /**
+    * Lines left to warm up, most frequent last
+    */
+    TArray<FSpeechWarmupLine> PendingLines;
+    /**
+    * Cancellation flag of the warmup, raised when the map or the warming component goes away
+    */
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> WarmupCancellationFlag;
+    bool bWarmupStarted = false;
+    int32 NumLinesToWarm = 0;
+    FThreadSafeCounter NumLinesWarmed;
+    /**
+    * Number of background tasks warming up lines, which hold back Deinitialize
+    */
+    FThreadSafeCounter NumRunningWarmups;
+    FCriticalSection Mutex;
+};
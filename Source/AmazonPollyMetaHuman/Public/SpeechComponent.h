@@ -24,13 +24,27 @@
 #include <aws/core/Aws.h>
 #include "PollyClient.h"
 #include <chrono>
+#include <atomic>
+#include "HAL/Event.h"
 #include "Runtime/Engine/Public/LatentActions.h"
 #include "Viseme.h"
+#include "VisemeTrack.h"
 #include "VoiceId.h"
+#include "SpeechPriority.h"
+#include "SpeechSynthesisMode.h"
 #include "SpeechComponent.generated.h"
 
 DECLARE_LOG_CATEGORY_EXTERN(LogPollyMsg, Log, All);
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSpeechReady);
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnReplicatedSpeechStarted, USoundWaveProcedural*, PollyAudio);
+
+class FSpeechPhraseSegmenter;
+struct FPrefetchedSpeech;
+struct FCachedSpeechSegment;
+class FSpeechWarmupManifest;
+class UPollySpeechAsset;
+
 /**
 * Represents the multiple output pins that can be invoked
 * on completion of the latent GenerateSpeech function.
@@ -42,12 +56,316 @@ enum class EGenerateSpeechExecPins : uint8 {
 };
 
 /**
-* Struct containing a single viseme and its corresponding timestamp returned by Polly
-* to be used in setting CurrentViseme and CurrentVisemeDurationSeconds states 
+* Latency of interrupting a speech with StopSpeech or CancelSpeech
+*/
+struct FSpeechCancelMetrics {
+    /**
+    * Number of StopSpeech and CancelSpeech calls
+    */
+    int32 NumCancels = 0;
+    /**
+    * Milliseconds the last StopSpeech call took to drop the unplayed audio and reset the viseme. The sound
+    * is silent from the next audio callback on.
+    */
+    double LastCancelToSilenceMs = 0.0;
+    /**
+    * Milliseconds from the last StopSpeech or CancelSpeech call until the last Polly request it aborted returned
+    */
+    double LastCancelToIdleMs = 0.0;
+};
+
+/**
+* Counters of the texts synthesized ahead of time by PrefetchSpeech, shared by all speech components
+*/
+USTRUCT(BlueprintType)
+struct FSpeechPrefetchStats {
+    GENERATED_BODY()
+    /**
+    * Number of texts prefetched
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumPrefetches = 0;
+    /**
+    * Number of GenerateSpeech calls served by a prefetched text
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumHits = 0;
+    /**
+    * Number of GenerateSpeech calls that had to synthesize their text
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumMisses = 0;
+    /**
+    * Number of prefetched texts that were cancelled or dropped before a GenerateSpeech call used them
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumWasted = 0;
+};
+
+/**
+* Counters of the cache of synthesized speech shared by all speech components
+*/
+USTRUCT(BlueprintType)
+struct FSpeechCacheStats {
+    GENERATED_BODY()
+    /**
+    * Number of Polly requests served from the cache
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumHits = 0;
+    /**
+    * Number of Polly requests whose text was not cached
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumMisses = 0;
+    /**
+    * Number of texts evicted to stay within the byte budget
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumEvictions = 0;
+    /**
+    * Number of texts cached
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumEntries = 0;
+    /**
+    * Memory used by the cached audio and visemes
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 SizeKB = 0;
+    /**
+    * Number of hits served from the disk, counted in NumHits as well
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumDiskHits = 0;
+    /**
+    * Number of texts cached on disk
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumDiskEntries = 0;
+    /**
+    * Disk space used by the cached audio and visemes
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 DiskSizeKB = 0;
+};
+
+/**
+* Memory held by the speech of all speech components and by the cache of synthesized speech
+*/
+USTRUCT(BlueprintType)
+struct FSpeechMemoryStats {
+    GENERATED_BODY()
+    /**
+    * Number of speech components
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumComponents = 0;
+    /**
+    * Memory held by the speech components: audio, visemes and the audio queued in their sounds
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 SpeechBuffersKB = 0;
+    /**
+    * Memory held by the cache of synthesized speech
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 SpeechCacheKB = 0;
+    /**
+    * Budget of the speech memory, 0 if it is unbounded
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 BudgetKB = 0;
+    /**
+    * Number of speeches released to stay within the budget after they had been played
+    */
+    UPROPERTY(BlueprintReadOnly, Category = "Amazon Polly")
+    int32 NumReleasedSpeeches = 0;
+};
+
+/**
+* Wakes up a background task of a USpeechComponent waiting for more work. Each task gets its own, as a cancelled
+* task may still be waiting while the next one runs.
 */
-struct VisemeEvent {
-    EViseme Viseme;
-    int TimeMilliseconds;
+struct FSpeechWorkSignal {
+    FSpeechWorkSignal() :
+        Event(FPlatformProcess::GetSynchEventFromPool(false)) {
+    }
+    ~FSpeechWorkSignal() {
+        FPlatformProcess::ReturnSynchEventToPool(Event);
+    }
+    FSpeechWorkSignal(const FSpeechWorkSignal&) = delete;
+    FSpeechWorkSignal& operator=(const FSpeechWorkSignal&) = delete;
+    /**
+    * Wakes up the task, or lets its next Wait return at once if it is not waiting yet
+    */
+    void Trigger() {
+        Event->Trigger();
+    }
+    /**
+    * Waits until Trigger is called
+    * @param WaitMilliseconds - how long to wait at most
+    */
+    void Wait(uint32 WaitMilliseconds = MAX_uint32) {
+        Event->Wait(WaitMilliseconds);
+    }
+
+private:
+    FEvent* Event;
+};
+
+/**
+* The audio and viseme requests of one segment of the text, while they are in flight, or the cached results of
+* the segment
+*/
+struct FPendingSpeechSegment {
+    TFuture<PollyOutcome> AudioFuture;
+    TFuture<PollyOutcome> VisemeFuture;
+    /**
+    * Key of the segment in the FSpeechCache, empty if the results are not to be cached
+    */
+    FString CacheKey;
+    /**
+    * The cached results, in which case no request is in flight
+    */
+    TSharedPtr<const FCachedSpeechSegment, ESPMode::ThreadSafe> Cached;
+    /**
+    * Returns true once the results of the segment are available
+    */
+    bool IsReady() const {
+        return Cached.IsValid() || ((!AudioFuture.IsValid() || AudioFuture.IsReady()) && (!VisemeFuture.IsValid() || VisemeFuture.IsReady()));
+    }
+    /**
+    * Waits until the requests of the segment have returned. A segment started in a reduced synthesis mode
+    * lacks one or both of them.
+    */
+    void Wait() const {
+        if (!Cached.IsValid()) {
+            if (AudioFuture.IsValid()) {
+                AudioFuture.Wait();
+            }
+            if (VisemeFuture.IsValid()) {
+                VisemeFuture.Wait();
+            }
+        }
+    }
+};
+
+/**
+* A line waiting in the speech queue of a USpeechComponent
+*/
+struct FQueuedUtterance {
+    FQueuedUtterance(const FString& InText, EVoiceId InVoiceId) :
+        Text(InText),
+        VoiceId(InVoiceId),
+        CancellationFlag(MakePollyCancellationFlag()) {
+    }
+    FString Text;
+    EVoiceId VoiceId;
+    /**
+    * Aborts the requests of this line only
+    */
+    PollyCancellationFlag CancellationFlag;
+    /**
+    * Requests of the segments of the line, once it is being prefetched
+    */
+    TArray<FPendingSpeechSegment> Segments;
+    bool bPrefetched = false;
+    /**
+    * Results of the line, once all of its requests have returned
+    */
+    bool bFinished = false;
+    bool bSucceeded = false;
+    TArray<FPollyAudioBuffer> Audio;
+    TArray<VisemeEvent> Visemes;
+};
+
+/**
+* A speech of GenerateSpeechSync whose requests are in flight, between BeginGenerateSpeech and FinishGenerateSpeech
+*/
+struct FPendingGeneratedSpeech {
+    FPendingGeneratedSpeech(const FString& InText, EVoiceId InVoiceId, uint32 InUtteranceId) :
+        Text(InText),
+        VoiceId(InVoiceId),
+        UtteranceId(InUtteranceId) {
+    }
+    FString Text;
+    EVoiceId VoiceId;
+    uint32 UtteranceId;
+    /**
+    * False if the speech failed before any request was issued
+    */
+    bool bStarted = false;
+    /**
+    * Set by FinishGenerateSpeech once the speech is generated or failed
+    */
+    bool bFinished = false;
+    ESpeechSynthesisMode Mode = ESpeechSynthesisMode::Full;
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> CancellationFlag;
+    /**
+    * The prefetch whose requests became those of the speech, if there was one
+    */
+    TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe> Prefetched;
+    /**
+    * The segments of the text
+    */
+    TArray<FString> Segments;
+    /**
+    * Requests of the first segments, in order, unless the first segment is streamed
+    */
+    TArray<FPendingSpeechSegment> StartedSegments;
+    /**
+    * Streamed first segment: the audio streams into RingBuffer, of which JitterBufferBytes must arrive before playback
+    */
+    TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer;
+    TFuture<PollyOutcome> StreamedAudioFuture;
+    TFuture<PollyOutcome> StreamedVisemeFuture;
+    int32 JitterBufferBytes = 0;
+    /**
+    * Returns true once FinishGenerateSpeech would not wait for any request
+    */
+    bool IsReady() const;
+};
+
+/**
+* Speech started on the server, replicated to the clients so that they play it in sync without synthesizing its
+* visemes. See USpeechComponent::bReplicateSpeech.
+*/
+USTRUCT()
+struct FReplicatedSpeech {
+    GENERATED_BODY()
+    /**
+    * Incremented for every speech started on the server, so that a line started again is replicated again
+    */
+    UPROPERTY()
+    uint16 SpeechId = 0;
+    /**
+    * False once the speech was stopped on the server
+    */
+    UPROPERTY()
+    bool bPlaying = false;
+    /**
+    * The text of the speech, which the clients synthesize the audio of. Empty if only the visemes are replicated.
+    */
+    UPROPERTY()
+    FString Text;
+    UPROPERTY()
+    EVoiceId VoiceId = EVoiceId::Joanna;
+    /**
+    * The baked speech played, whose audio the clients stream instead of synthesizing it
+    */
+    UPROPERTY()
+    UPollySpeechAsset* SpeechAsset = nullptr;
+    /**
+    * The visemes of the speech, encoded by VisemeTrackCodec
+    */
+    UPROPERTY()
+    TArray<uint8> VisemeTrack;
+    /**
+    * Server world time at which the speech started, see AGameStateBase::GetServerWorldTimeSeconds
+    */
+    UPROPERTY()
+    float ServerStartSeconds = 0.0f;
 };
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
@@ -92,6 +410,14 @@ public:
         EGenerateSpeechExecPins& EGenerateSpeechExecPins
     );
     /**
+    * Variant of GenerateSpeech for speech synthesized ahead of time by the PollySpeechBake commandlet. Completes
+    * right away, without calling Polly. StartSpeech plays the speech afterwards, streaming its audio from the asset.
+    * @param SpeechAsset - the baked speech
+    * @return bool - false if the asset holds no speech or a speech is playing
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    bool GenerateSpeechFromAsset(UPollySpeechAsset* SpeechAsset);
+    /**
     * Starts the Animation playback and returns an Audio object to be played in Blueprints.
     * GenerateSpeech function must be called beforehand.
     * @return A USoundWaveProcedural object containing the audio synthesized from Polly
@@ -99,6 +425,14 @@ public:
     UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
     USoundWaveProcedural* StartSpeech();
     /**
+    * Variant of StartSpeech starting the speech at a time into it, e.g. to resume a paused speech. The audio and the
+    * visemes both start there. Speech streamed while it plays (see bStreamAudio) can only start at its beginning.
+    * @param Seconds - the time to start the speech from
+    * @return A USoundWaveProcedural object containing the audio from that time on
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    USoundWaveProcedural* StartSpeechAt(float Seconds);
+    /**
     * Returns the current viseme corresponding to the last invocation of StartSpeech. Assuming
     * the sound returned by StartSpeech began playback immediately following its creation, the
     * current viseme returned by this function should be synchronized to the current sound
@@ -109,21 +443,372 @@ public:
     UFUNCTION(BlueprintPure, Category = "Amazon Polly")
     EViseme GetCurrentViseme();
     /**
+    * Returns the visemes of the last generated speech. The track is immutable and may be kept and sampled with
+    * FVisemeTrack::Evaluate from any thread, e.g. by an animation worker thread, without locking the component.
+    * Segments appended to the speech later are in the track returned by the next call.
+    *
+    * @return the viseme track
+    */
+    FVisemeTrackRef GetVisemeTrack();
+    /**
+    * Returns the loudness of the speech at the current playback time, e.g. to drive how wide the jaw opens. The
+    * loudness is precomputed when the speech is synthesized, 100 times per second of audio, so this is a lookup.
+    * Audio streamed while it plays (see bStreamAudio) has no loudness until the segments appended after it.
+    *
+    * @return the intensity, from 0 for silence to 1 for full scale
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    float GetCurrentIntensity();
+    /**
     * Returns true if the speech component is still playing a viseme sequence
     * 
     * @return true if the speech component is still playing a viseme sequence
     */
     UFUNCTION(BlueprintPure, Category = "Amazon Polly")
     bool IsSpeaking();
+    /**
+    * Returns the duration of the last generated speech, as far as it has been synthesized. A speech generated
+    * in the DurationOnly synthesis mode has an estimated duration.
+    *
+    * @return the duration in seconds
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    float GetSpeechDurationSeconds();
+    /**
+    * Interrupts the speech within the current frame: aborts every Polly request still in flight, drops the
+    * audio of the sound returned by StartSpeech that has not been played yet, resets the current viseme to Sil
+    * and stops the viseme playback. GenerateSpeech can be called again right away.
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    void StopSpeech();
+    /**
+    * Moves the playback of speech generated by GenerateSpeechFromAsset to another time, along with its visemes
+    * @param Seconds - the time to continue the speech from
+    * @return bool - false if no speech generated from an asset is playing
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    bool SeekSpeech(float Seconds);
+    /**
+    * If true, speech started on the server is replicated to the clients: they receive its visemes and start time
+    * instead of calling Polly for them, and only synthesize its audio unless it was generated from a speech asset.
+    * A client joining while a line plays starts it from the current time.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Replication")
+    bool bReplicateSpeech = true;
+    /**
+    * Broadcast on the clients once a replicated speech starts, with the sound to play, which is null if only the
+    * visemes of the speech are replicated
+    */
+    UPROPERTY(BlueprintAssignable, Category = "Amazon Polly|Replication")
+    FOnReplicatedSpeechStarted OnReplicatedSpeechStarted;
+    /**
+    * Returns the size of the encoded viseme track of the last replicated speech
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly|Replication")
+    int32 GetReplicatedVisemeTrackBytes() const;
+    /**
+    * Returns how far ahead of the server the visemes of the replicated speech playing on this client are, in
+    * milliseconds. Negative if they are behind, 0 if no replicated speech plays.
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly|Replication")
+    float GetReplicationDriftMilliseconds();
+    /**
+    * Registers ReplicatedSpeech. See UObject::GetLifetimeReplicatedProps for details.
+    */
+    virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+    /**
+    * Adds a line to the speech queue. Queued lines play one after the other without a gap: the next
+    * SpeechQueuePrefetchDepth lines are synthesized in the background, and each line is appended to the playing
+    * speech shortly before the previous one ends. If no queued speech is playing, the first ready line becomes a
+    * new speech and OnSpeechReady is broadcast, so that it can be started with StartSpeech.
+    * GenerateSpeech, AppendText, StopSpeech and CancelSpeech clear the queue.
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @return true if the line was queued, false if the queue is full
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    bool EnqueueSpeech(const FString& Text, const EVoiceId VoiceId);
+    /**
+    * Returns the number of lines in the speech queue that have not been handed to a speech yet
+    * @return the number of queued lines
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    int32 GetQueuedSpeechCount();
+    /**
+    * Aborts every Polly request still in flight, including a GenerateSpeech call that has not completed yet
+    * (which then takes its Failure pin), without interrupting the speech that is playing. A speech that was still
+    * receiving segments ends after the ones it already has.
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    void CancelSpeech();
+    /**
+    * Returns the latency of the last StopSpeech or CancelSpeech call
+    * @return FSpeechCancelMetrics - the metrics
+    */
+    FSpeechCancelMetrics GetCancelMetrics();
+    /**
+    * Appends text to the speech being generated incrementally, e.g. token by token as a text generator produces
+    * it. The first call starts a new speech. Every phrase completed by the appended text is synthesized right
+    * away, and appended to the speech while it plays. OnSpeechReady is broadcast once the first phrase is ready
+    * for StartSpeech. FinishText must be called once all text has been appended.
+    * @param Text - the text following the text appended so far
+    * @param VoiceId - enum for VoiceId for use in calling Polly, taken from the call starting the speech
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    void AppendText(const FString& Text, const EVoiceId VoiceId);
+    /**
+    * Marks the end of the text of the speech generated by AppendText, and synthesizes the last phrase
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    void FinishText();
+    /**
+    * Synthesizes a line the speaker is likely to say next, e.g. one of the replies a dialogue tree may trigger. The
+    * result is stored for all speech components, and a later GenerateSpeech call for the same text and voice uses it
+    * instead of calling Polly, completing on the next tick once the prefetch has returned.
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param Priority - the priority of the Polly requests, ambient by default so that prefetching never delays speech
+    * @return true if the text is being prefetched or was prefetched already
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    bool PrefetchSpeech(const FString& Text, const EVoiceId VoiceId, const ESpeechPriority Priority = ESpeechPriority::Ambient);
+    /**
+    * Drops a prefetched line that is no longer likely to be said, aborting its Polly requests if still in flight
+    * @param Text - the text passed to PrefetchSpeech
+    * @param VoiceId - the voice passed to PrefetchSpeech
+    * @return true if the line was prefetched
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    bool CancelPrefetchSpeech(const FString& Text, const EVoiceId VoiceId);
+    /**
+    * Returns the hit, miss and waste counters of the lines prefetched by all speech components
+    * @return FSpeechPrefetchStats - the counters
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    static FSpeechPrefetchStats GetPrefetchStats();
+    /**
+    * Returns the hit, miss and eviction counters of the cache of synthesized speech shared by all speech components
+    * @return FSpeechCacheStats - the counters
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    static FSpeechCacheStats GetSpeechCacheStats();
+    /**
+    * Changes the memory the cache of synthesized speech may use, evicting the least recently used texts beyond it
+    * @param BudgetKB - the budget, 0 disables the cache
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    static void SetSpeechCacheBudget(int32 BudgetKB);
+    /**
+    * Changes the disk space the cache of synthesized speech may use under Saved/PollySpeechCache, deleting the least
+    * recently used texts beyond it
+    * @param BudgetMB - the budget, 0 disables the disk cache without deleting it
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    static void SetSpeechDiskCacheBudget(int32 BudgetMB);
+    /**
+    * Removes all texts from the cache of synthesized speech, in memory and on disk
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    static void ClearSpeechCache();
+    /**
+    * Returns the memory held by the speech of all speech components and by the cache of synthesized speech
+    * @return FSpeechMemoryStats - the counters
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    static FSpeechMemoryStats GetSpeechMemoryStats();
+    /**
+    * Changes the memory the speech of all speech components and the cache of synthesized speech may use together,
+    * same as the Polly.SpeechMemoryBudgetMB console variable. Beyond it, the speech of idle components is released
+    * and then cached texts are evicted.
+    * @param BudgetMB - the budget, 0 for no budget
+    */
+    UFUNCTION(BlueprintCallable, Category = "Amazon Polly")
+    static void SetSpeechMemoryBudget(int32 BudgetMB);
+    /**
+    * Returns the memory held by the speech of this component: its audio, visemes and envelope, and the audio still
+    * queued in the sound returned by StartSpeech
+    * @return int64 - the memory in bytes
+    */
+    int64 GetSpeechMemoryBytes();
+    /**
+    * Releases the speech of this component if it has been played and is neither playing nor being synthesized.
+    * StartSpeech fails afterwards until a new speech is generated.
+    * @return int64 - the memory released in bytes, 0 if the speech is in use
+    */
+    int64 ReleaseIdleSpeech();
+    /**
+    * Returns true if every segment GenerateSpeechSync would synthesize for a text is cached
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @return bool - true if GenerateSpeechSync completes without calling Polly
+    */
+    UFUNCTION(BlueprintPure, Category = "Amazon Polly")
+    bool IsSpeechCached(const FString& Text, const EVoiceId VoiceId) const;
+    /**
+    * Broadcast on the game thread once the first phrase of a speech generated by AppendText can be started
+    */
+    UPROPERTY(BlueprintAssignable, Category = "Amazon Polly")
+    FOnSpeechReady OnSpeechReady;
+    /**
+    * Synthesizes the lines most frequently spoken in the map into the cache of synthesized speech, if this is the
+    * first speech component to begin play in it. See UActorComponent::BeginPlay for details.
+    */
+    virtual void BeginPlay() override;
+    /**
+    * Stops any audio still being streamed or synthesized. See UActorComponent::EndPlay for details.
+    */
+    virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+    /**
+    * Aborts any background work. See UObject::BeginDestroy for details.
+    */
+    virtual void BeginDestroy() override;
+    /**
+    * Holds back destruction until no background work references this component anymore.
+    * See UObject::IsReadyForFinishDestroy for details.
+    */
+    virtual bool IsReadyForFinishDestroy() override;
+    /**
+    * If true, GenerateSpeech completes as soon as the visemes and the first StreamingJitterBufferMs of audio
+    * have been received, and the rest of the audio is streamed into the sound returned by StartSpeech while
+    * it plays. A streamed sound can only be played once.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Streaming")
+    bool bStreamAudio = false;
+    /**
+    * Which of the audio and the visemes GenerateSpeech requests from Polly, e.g. only the visemes of a speaker
+    * out of earshot. Speech generated in a mode other than Full is neither pipelined nor streamed.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Synthesis")
+    ESpeechSynthesisMode SynthesisMode = ESpeechSynthesisMode::Full;
+    /**
+    * Milliseconds of audio to buffer before a streamed sound starts playing
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Streaming", Meta = (ClampMin = "0"))
+    int32 StreamingJitterBufferMs = 200;
+    /**
+    * Size of the buffer holding streamed audio that has been received but not played yet. The download
+    * pauses while the buffer is full, so this bounds the memory used by a streamed sound.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Streaming", Meta = (ClampMin = "16"))
+    int32 StreamingBufferKB = 256;
+    /**
+    * Number of chunks of 1024ms of audio read ahead of the playback of speech generated by GenerateSpeechFromAsset.
+    * Only these chunks are kept in memory, whatever the length of the speech.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Streaming", Meta = (ClampMin = "1"))
+    int32 BakedSpeechReadAheadChunks = 3;
+    /**
+    * If true, text made of several sentences is synthesized sentence by sentence. GenerateSpeech completes as
+    * soon as the first sentence is ready, and the remaining sentences are synthesized in the background and
+    * appended to the speech while it plays. Text longer than the 3000 characters Polly accepts in a single
+    * request is always split, but without this flag GenerateSpeech waits for all of it.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Pipelining")
+    bool bPipelineSentences = false;
+    /**
+    * Maximum number of segments whose Polly requests are in flight at the same time while the rest of the text
+    * is synthesized
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Pipelining", Meta = (ClampMin = "1"))
+    int32 MaxConcurrentSegmentRequests = 2;
+    /**
+    * Minimum length of a phrase passed to AppendText before a comma, colon or semicolon ends it. Shorter phrases
+    * start speaking sooner, longer phrases sound more natural.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Pipelining", Meta = (ClampMin = "1"))
+    int32 IncrementalMinClauseLength = 80;
+    /**
+    * Maximum number of lines waiting in the speech queue
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Queue", Meta = (ClampMin = "1"))
+    int32 MaxQueuedUtterances = 16;
+    /**
+    * Number of lines at the front of the speech queue that are synthesized ahead of time
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Queue", Meta = (ClampMin = "1"))
+    int32 SpeechQueuePrefetchDepth = 2;
+    /**
+    * Prefetching of further lines pauses while the audio of the lines synthesized ahead of time exceeds this size
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Queue", Meta = (ClampMin = "0"))
+    int32 SpeechQueueMaxPrefetchKB = 4096;
+    /**
+    * A queued line is appended to the playing speech once less than this many milliseconds of it remain
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Queue", Meta = (ClampMin = "0"))
+    int32 SpeechQueueAppendLeadMs = 1000;
+    /**
+    * Priority of the Polly requests of this component. All speech components share a fixed number of connections
+    * to Polly, and the requests of a higher priority are sent first.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Scheduling")
+    ESpeechPriority SpeechPriority = ESpeechPriority::Normal;
+    /**
+    * A Polly request of this component that has waited this many milliseconds for a connection fails instead of
+    * being sent, e.g. for ambient speech that is pointless once late. 0 waits as long as it takes.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Scheduling", Meta = (ClampMin = "0"))
+    int32 SynthesisDeadlineMs = 0;
+    /**
+    * If true, texts synthesized before by any speech component are taken from the cache of synthesized speech
+    * instead of calling Polly, and GenerateSpeech completes right away. Streamed audio is not cached.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Cache")
+    bool bUseSpeechCache = true;
+    /**
+    * If true, the lines spoken by this component are counted in the warmup manifest of the map, and when it is the
+    * first speech component to begin play in a map, it synthesizes the lines most frequently spoken in previous
+    * runs in the background. See UPollySpeechWarmupSubsystem for the progress of the warmup.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Cache")
+    bool bWarmUpSpeechCache = true;
+    /**
+    * Maximum number of lines synthesized by the warmup
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Cache", Meta = (ClampMin = "0"))
+    int32 MaxWarmupLines = 64;
+    /**
+    * Maximum number of lines synthesized by the warmup at the same time
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Cache", Meta = (ClampMin = "1"))
+    int32 MaxConcurrentWarmups = 2;
+    /**
+    * Synthesizes a text into the cache of synthesized speech at Ambient priority, without changing the speech of
+    * this component. Blocks until the text is cached.
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - raised to abort the requests
+    * @return bool - true if the text is cached
+    */
+    bool WarmSpeechCache(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag);
+    /**
+    * Synthesizes a text without changing the speech of this component, e.g. to bake it. Blocks until the text is
+    * synthesized.
+    * @param Text - the text to be synthesized by Polly (longer text is split into several requests)
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - raised to abort the requests
+    * @param Scheduling - the priority and deadline of the requests
+    * @param OutAudio - the audio of the text, in the buffers of its segments
+    * @param OutVisemeEvents - the visemes of the text
+    * @return bool - false if the text could not be synthesized
+    */
+    bool SynthesizeSpeechSync(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, const FPollyRequestScheduling& Scheduling, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents);
+    /**
+    * Endpoint the Polly requests of this component are sent to instead of Polly, e.g. a local stand-in for
+    * offline tests. Read when the component is initialized.
+    */
+    UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Amazon Polly|Connection")
+    FString PollyEndpointOverride;
 
 protected:
     /**
     * Blueprint function for calling Polly API to generate Viseme/Audio data.
     * One of the GenerateSpeech* functions must be called before StartSpeech() function.
-    * @param text - the text to be synthesized by Polly (the maximum length of input text can be up to 3000 characters)
+    * @param text - the text to be synthesized by Polly (longer text is split into several requests)
     * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @return bool - false if the speech could not be generated or was cancelled
     */
-    virtual void GenerateSpeechSync(const FString text, const EVoiceId VoiceId);
+    virtual bool GenerateSpeechSync(const FString text, const EVoiceId VoiceId);
     /**
     * Each time this method is called it plays back the next viseme in the speech.
     */
@@ -141,37 +826,390 @@ protected:
     */
     bool bIsSpeaking = false;
     /**
-    * Index variable used to iterate through VisemeDataArray in UpdateVisemeAndDurationStates function
+    * Index of the current viseme in the VisemeTrack
     */
     int CurrentVisemeIndex;
     /**
-    * Buffer containing audio data from Polly stream
+    * Audio of the speech in the buffers of its segments, in playback order. The buffers are shared with the
+    * FSpeechCache and the sound playing the speech rather than copied.
     */
-    TArray<uint8> Audiobuffer;
+    TArray<FPollyAudioBuffer> SpeechAudio;
     /**
     * PollyClient state for calling Polly SDK 
     */
     TUniquePtr<PollyClient> MyPollyClient;
     /**
-    * Array containing custom data structure that holds viseme and time data for each Viseme from Polly
+    * Visemes of the speech. Replaced rather than modified, so that a track returned by GetVisemeTrack stays valid.
+    */
+    FVisemeTrackRef VisemeTrack = FVisemeTrack::GetEmpty();
+    /**
+    * Amplitude envelope of the audio of the speech, a SpeechEnvelope value per SpeechEnvelope::FrameMilliseconds
+    * of playback
+    */
+    TArray<uint8> IntensityEnvelope;
+    /**
+    * Ring buffer receiving the streamed audio when bStreamAudio is set, until it is handed to a sound by StartSpeech
+    */
+    TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> StreamingAudio;
+    /**
+    * Speech asset passed to GenerateSpeechFromAsset, whose audio is streamed by the sounds returned by StartSpeech
+    */
+    UPROPERTY()
+    UPollySpeechAsset* BakedSpeechAsset = nullptr;
+    /**
+    * Text and voice of the last generated speech that clients can synthesize again, empty if there is none
+    */
+    FString SpeechText;
+    EVoiceId SpeechVoiceId = EVoiceId::Joanna;
+    /**
+    * Speech replicated by the server
+    */
+    UPROPERTY(ReplicatedUsing = OnRep_ReplicatedSpeech)
+    FReplicatedSpeech ReplicatedSpeech;
+    /**
+    * Number of visemes in the VisemeTrack of ReplicatedSpeech, on the server
+    */
+    int32 NumReplicatedVisemes = 0;
+    /**
+    * SpeechId of the replicated speech played by this client
+    */
+    uint16 PlayedReplicatedSpeechId = 0;
+    /**
+    * Plays the speech replicated by the server on a client
+    */
+    UFUNCTION()
+    void OnRep_ReplicatedSpeech();
+    /**
+    * Cancellation flag shared by every request of the last generated speech that may still be in flight
+    */
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> UtteranceCancellationFlag;
+    /**
+    * Number of segments of the last generated speech that have not been appended to it yet
+    */
+    int32 PendingSegmentCount = 0;
+    /**
+    * Playback time at which the audio appended to the last generated speech so far ends
+    */
+    int64 UtteranceEndMilliseconds = 0;
+    /**
+    * Synthesis mode the last speech was generated in, StartSpeech returns no sound if it has no audio
+    */
+    ESpeechSynthesisMode UtteranceSynthesisMode = ESpeechSynthesisMode::Full;
+    /**
+    * True between the first AppendText call of a speech and its FinishText call
+    */
+    bool bIncrementalTextOpen = false;
+    /**
+    * Phrases completed by AppendText that have not been picked up by the SegmentPipeline yet
+    */
+    TArray<FString> PendingPhrases;
+    /**
+    * Cuts the text passed to AppendText into phrases
+    */
+    TSharedPtr<FSpeechPhraseSegmenter> IncrementalTextSegmenter;
+    /**
+    * Wakes up the SegmentPipeline of the open incremental speech when phrases are completed or the text is finished
+    */
+    TSharedPtr<FSpeechWorkSignal, ESPMode::ThreadSafe> IncrementalTextSignal;
+    /**
+    * True once StartSpeech was called for the last generated speech
+    */
+    bool bSpeechStarted = false;
+    /**
+    * Cancellation flag of the speech StartSpeech was last called for, which tells a speech that played from one that
+    * is still being generated
+    */
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> StartedUtteranceFlag;
+    /**
+    * Lines added by EnqueueSpeech that have not been handed to a speech yet
+    */
+    TArray<TSharedPtr<FQueuedUtterance, ESPMode::ThreadSafe>> SpeechQueue;
+    /**
+    * Cancellation flag of the speech started by the speech queue, which later lines are appended to
+    */
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> SpeechQueueSpeechFlag;
+    /**
+    * True while the SpeechQueueWorker runs
+    */
+    bool bSpeechQueueRunning = false;
+    /**
+    * Background task prefetching the lines of the speech queue and handing them to the speech
+    */
+    TFuture<void> SpeechQueueWorker;
+    /**
+    * Wakes up the SpeechQueueWorker, valid while it runs
+    */
+    TSharedPtr<FSpeechWorkSignal, ESPMode::ThreadSafe> SpeechQueueSignal;
+    /**
+    * Sound returned by the last StartSpeech call, which receives the audio of segments appended while it plays
+    */
+    TWeakObjectPtr<USoundWaveProcedural> ActivePollyAudio;
+    /**
+    * Background task synthesizing the remaining segments of the last generated speech
+    */
+    TFuture<void> SegmentPipeline;
+    /**
+    * Background tasks of cancelled speeches that have not returned yet
+    */
+    TArray<TFuture<void>> CancelledWork;
+    /**
+    * Prefetches issued by this component, whose requests must return before it is destroyed
     */
-    TArray<VisemeEvent> VisemeEventArray;
+    TArray<TSharedPtr<FPrefetchedSpeech, ESPMode::ThreadSafe>> OwnPrefetches;
+    /*
+    * Mutex for thread-safe mutation of internal state.
+    */
+    FCriticalSection Mutex;
+    /**
+    * Fills the VisemeTrack with the visemes and corresponding timestamps of Polly viseme data
+    * @param VisemeJson - UTF-8 Polly json viseme data ( example: {"time":125,"type":"viseme","value":"k"} )
+    */
+    void GenerateVisemeEvents(TArrayView<const uint8> VisemeJson);
+    /**
+    * Returns a USoundWave object containing the Polly Audio for playback in Blueprints
+    * @param StartMilliseconds - the playback time the sound starts from, ignored for streamed audio
+    * @return USoundWaveProcedural - Sound wave object containing Polly Audio 
+    */
+    USoundWaveProcedural* QueuePollyAudio(int64 StartMilliseconds = 0);
 
 private:
     /**
-    * Calls the PollyClient to generate Polly Audio data 
-    * @param text - the text synthesized by Polly
-    * @param VoiceId - the voice of the synthesized audio 
-    * @return bool - boolean indicating success/failure of Polly call
+    * First half of GenerateSpeechSync: checks the text and puts the requests of the speech in flight, without waiting
+    * for any of them. Only reads the disk cache, so it belongs on a background thread all the same.
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param UtteranceId - the utterance the speech is traced as, or 0 to begin a new one
+    * @return TSharedRef<FPendingGeneratedSpeech> - the speech, to be passed to FinishGenerateSpeech
+    */
+    TSharedRef<FPendingGeneratedSpeech, ESPMode::ThreadSafe> BeginGenerateSpeech(const FString& Text, const EVoiceId VoiceId, uint32 UtteranceId);
+    /**
+    * Second half of GenerateSpeechSync: waits for the requests of the speech, unless they are ready, and makes it
+    * the speech of this component. Synthesizes the speech again if it was prefetched and the prefetch failed.
+    * @param Speech - the speech returned by BeginGenerateSpeech
+    * @param bWaitForRetry - false to return with the speech unfinished once the requests of a failed prefetch were
+    * issued again, so that the caller can finish it again after they returned
+    * @return bool - false if the speech could not be generated, was cancelled, or is not finished yet
     */
-    bool SynthesizeAudio(const FString& text, const EVoiceId VoiceId);
+    bool FinishGenerateSpeech(FPendingGeneratedSpeech& Speech, bool bWaitForRetry = true);
     /**
-    * Calls the PollyClient to generate Polly Viseme data
-    * @param text - the text synthesized by Polly
-    * @param VoiceId - the voice of the synthesized data 
+    * Splits the text of a speech in the Full synthesis mode and puts its first requests in flight: the streamed
+    * first segment, the first segment only if sentences are pipelined, or else every segment
+    * @param Speech - the speech
+    * @return bool - false if the speech has nothing to say or this component is shutting down
+    */
+    bool StartSpeechRequests(FPendingGeneratedSpeech& Speech);
+    /**
+    * Puts the requests of a speech in a synthesis mode other than Full in flight. Only the requests the mode needs
+    * are issued, and their results are not cached.
+    * @param Speech - the speech
+    * @param Mode - the synthesis mode
+    * @return bool - false if this component is shutting down
+    */
+    bool StartReducedSpeechRequests(FPendingGeneratedSpeech& Speech, const ESpeechSynthesisMode Mode);
+    /**
+    * Finishes a speech started by StartSpeechRequests. Pipelined segments after the first one are synthesized in
+    * the background, other segments are appended before returning.
+    * @param Speech - the speech
+    * @return bool - false if the speech could not be generated or was cancelled
+    */
+    bool FinishSpeechRequests(FPendingGeneratedSpeech& Speech);
+    /**
+    * Finishes a speech whose first segment is streamed. Waits for the visemes and the jitter buffer of the audio,
+    * while the rest of the audio keeps streaming into StreamingAudio.
+    * Segments after the first one are appended to the stream in the background.
+    * @param Speech - the speech
+    * @return bool - false if the speech could not be generated or was cancelled
+    */
+    bool FinishStreamingSpeech(FPendingGeneratedSpeech& Speech);
+    /**
+    * Finishes a speech using the results of PrefetchSpeech, waiting for them if they are still in flight.
+    * The requests of the prefetch became the requests of the speech in BeginGenerateSpeech, so that CancelSpeech
+    * aborts them.
+    * @param Prefetched - the prefetch, taken from the FSpeechPrefetchStore
+    * @param bOutCancelled - set to true if the speech was cancelled, rather than the prefetch having failed
+    * @return bool - false if the speech was cancelled or the prefetch failed
+    */
+    bool FinishPrefetchedSpeech(const FPrefetchedSpeech& Prefetched, bool& bOutCancelled);
+    /**
+    * Finishes a speech started by StartReducedSpeechRequests
+    * @param Speech - the speech
+    * @return bool - false if the speech could not be generated or was cancelled
+    */
+    bool FinishReducedSpeech(FPendingGeneratedSpeech& Speech);
+    /**
+    * Returns the priority and deadline of a Polly request issued now
+    * @return FPollyRequestScheduling - the scheduling of the request
+    */
+    FPollyRequestScheduling GetRequestScheduling() const;
+    /**
+    * Returns the key of a segment in the FSpeechCache, or an empty key if this component does not use the cache
+    * @param Text - the text of the segment
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @return FString - the key
+    */
+    FString GetSpeechCacheKey(const FString& Text, const EVoiceId VoiceId) const;
+    /**
+    * Returns true if every segment GenerateSpeechSync would synthesize for a text is cached
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param bInMemoryOnly - true to ignore the segments cached on disk only
+    * @return bool - true if all segments are cached
+    */
+    bool AreSegmentsCached(const FString& Text, const EVoiceId VoiceId, bool bInMemoryOnly) const;
+    /**
+    * Counts a line in the warmup manifest of the map
+    * @param Text - the text of the line
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    */
+    void RecordSpokenLine(const FString& Text, const EVoiceId VoiceId);
+    /**
+    * Puts the audio and viseme requests of a segment in flight
+    * @param Text - the text of the segment
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - the cancellation flag of the speech the segment belongs to
+    * @param Scheduling - the priority and deadline of the requests
+    * @param Mode - which of the requests to issue
+    * @return FPendingSpeechSegment - the requests in flight
+    */
+    FPendingSpeechSegment StartSegment(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, const FPollyRequestScheduling& Scheduling, const ESpeechSynthesisMode Mode = ESpeechSynthesisMode::Full);
+    /**
+    * Waits for the requests of a segment and parses their results
+    * @param Segment - the requests in flight
+    * @param OutAudio - receives the buffer holding the pcm audio of the segment
+    * @param OutVisemeEvents - receives the visemes of the segment, timed from the start of the segment
+    * @return bool - boolean indicating success/failure of the requests
+    */
+    bool FinishSegment(const FPendingSpeechSegment& Segment, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents) const;
+    /**
+    * Variant of FinishSegment for a segment started in a synthesis mode other than Full
+    * @param Segment - the requests in flight
+    * @param Text - the text of the segment
+    * @param Mode - the synthesis mode the segment was started in
+    * @param OutAudio - receives the pcm audio of the segment in the AudioOnly mode
+    * @param OutVisemeEvents - receives the visemes of the segment in the VisemesOnly mode
+    * @param OutDurationMilliseconds - receives the duration of the segment, estimated in the DurationOnly mode
+    * @return bool - boolean indicating success/failure of the requests
+    */
+    bool FinishSegmentInMode(const FPendingSpeechSegment& Segment, const FString& Text, const ESpeechSynthesisMode Mode, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents, int64& OutDurationMilliseconds) const;
+    /**
+    * Synthesizes the remaining segments of a speech in order, keeping up to MaxConcurrentSegmentRequests
+    * of them in flight, and appends each one to the speech as soon as it and all segments before it are ready.
+    * Finishes the ring buffer of a streamed speech once all of its audio has been written.
+    * @param Segments - the remaining segments of the text
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - the cancellation flag of the speech, raised if any segment fails
+    * @param RingBuffer - the ring buffer of a streamed speech, or nullptr
+    * @param StartedSegments - requests already in flight for the first of the remaining segments, in order
+    * @return bool - false if a segment failed or the speech was cancelled
+    */
+    bool RunSegmentPipeline(const TArray<FString>& Segments, const EVoiceId VoiceId, PollyCancellationFlag CancellationFlag, TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer, TArray<FPendingSpeechSegment> StartedSegments = TArray<FPendingSpeechSegment>());
+    /**
+    * Synthesizes the phrases completed by AppendText in order, keeping up to MaxConcurrentSegmentRequests of them
+    * in flight, and appends each one to the speech. Runs until FinishText was called and all phrases are appended.
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - the cancellation flag of the speech, raised if any phrase fails
+    * @param TextSignal - triggered whenever there are new phrases, the text is finished or the speech is aborted
+    */
+    void RunIncrementalPipeline(const EVoiceId VoiceId, PollyCancellationFlag CancellationFlag, TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> TextSignal);
+    /**
+    * Prefetches the lines of the speech queue and hands each one to the speech once it is ready, until the queue is empty
+    * @param QueueSignal - triggered whenever a line is queued, a request of a line returns, or the playing speech
+    * changes in a way that may let the next line through
+    */
+    void RunSpeechQueue(TSharedRef<FSpeechWorkSignal, ESPMode::ThreadSafe> QueueSignal);
+    /**
+    * Triggers the SpeechQueueSignal, if the worker runs. Must be called with the Mutex held.
+    */
+    void WakeSpeechQueue();
+    /**
+    * Waits for the requests of the segments of a text and stitches their results together
+    * @param Segments - the requests of the segments, in text order
+    * @param OutAudio - receives the buffers holding the pcm audio of the text
+    * @param OutVisemeEvents - receives the visemes of the text, timed from the start of the text
+    * @return bool - boolean indicating success/failure of the requests
+    */
+    bool FinishSegments(const TArray<FPendingSpeechSegment>& Segments, TArray<FPollyAudioBuffer>& OutAudio, TArray<VisemeEvent>& OutVisemeEvents) const;
+    /**
+    * Appends a synthesized segment to the end of the speech
+    * @param Audio - the buffers holding the pcm audio of the segment
+    * @param Visemes - the visemes of the segment, timed from the start of the segment
+    * @param CancellationFlag - the cancellation flag of the speech
+    * @param RingBuffer - the ring buffer of a streamed speech, or nullptr
+    */
+    void AppendSegment(const TArray<FPollyAudioBuffer>& Audio, const TArray<VisemeEvent>& Visemes, const PollyCancellationFlag& CancellationFlag, TSharedPtr<FPollyAudioRingBuffer, ESPMode::ThreadSafe> RingBuffer);
+    /**
+    * Aborts the requests of the last generated speech that may still be in flight and releases StreamingAudio.
+    * Must be called with the Mutex held, and does not wait for the aborted requests.
+    */
+    void AbortUtterance();
+    /**
+    * Records the time it took aborted work to return, if it was aborted by StopSpeech or CancelSpeech.
+    * Takes the Mutex, which may already be held.
+    * @param CancellationFlag - the cancellation flag of the aborted work
+    */
+    void NoteAbortedWorkFinished(const PollyCancellationFlag& CancellationFlag);
+    /**
+    * Aborts the requests of the last generated speech without waiting for them. Its background tasks are kept in
+    * CancelledWork until they return, which holds back the destruction of this component.
+    */
+    void CancelUtteranceRequests();
+    /**
+    * Returns true if the speech queue may replace the speech with its next line: no other speech is being generated,
+    * waits to be started or plays. Must be called with the Mutex held.
+    */
+    bool CanSpeechQueueStartSpeech() const;
+    /**
+    * Moves the viseme playback to a playback time and schedules the next viseme. Must be called with the Mutex held.
+    * @param PlaybackMilliseconds - the playback time of the speech
+    */
+    void SyncVisemesToPlayback(int64 PlaybackMilliseconds);
+    /**
+    * Traces the start of the speech: ends the span of its utterance and begins its Speaking span. Must be called
+    * with the Mutex held, before bIsSpeaking is set.
+    */
+    void BeginTraceSpeaking();
+    /**
+    * Computes the envelope of audio playing from a playback time into IntensityEnvelope, replacing the envelope
+    * from that time on. Must be called with the Mutex held.
+    * @param StartMilliseconds - the playback time the audio starts at
+    * @param Audio - the buffers holding the pcm audio, in playback order
+    */
+    void SetIntensityEnvelope(int64 StartMilliseconds, const TArray<FPollyAudioBuffer>& Audio);
+    /**
+    * Returns true if speech started by this component is replicated to the clients
+    */
+    bool IsReplicatingSpeech() const;
+    /**
+    * Returns the world time of the server, as synchronized by the game state
+    */
+    double GetServerWorldSeconds() const;
+    /**
+    * Replicates the playing speech, or the visemes appended to it since it was last replicated. Must be called on
+    * the game thread with the Mutex held.
+    * @param bNewSpeech - true if the speech just started
+    */
+    void UpdateReplicatedSpeech(bool bNewSpeech);
+    /**
+    * Starts the replicated speech on a client from the current server time, once its audio is available
+    */
+    void StartReplicatedSpeech();
+    /**
+    * Synthesizes the audio of a text without its visemes, for a replicated speech
+    * @param Text - the text to be synthesized by Polly
+    * @param VoiceId - enum for VoiceId for use in calling Polly
+    * @param CancellationFlag - raised to abort the requests
+    * @param OutAudio - the audio of the text, in the buffers of its segments
+    * @return bool - false if the audio could not be synthesized
+    */
+    bool SynthesizeAudioSync(const FString& Text, const EVoiceId VoiceId, const PollyCancellationFlag& CancellationFlag, TArray<FPollyAudioBuffer>& OutAudio) const;
+    /**
+    * Logs the error of a failed Polly call. Calls aborted because a sibling request failed are not
+    * reported as errors, since the sibling already reported the cause.
+    * @param Outcome - the outcome of the Polly call
+    * @param Description - what the call was meant to generate
     * @return bool - boolean indicating success/failure of Polly call
     */
-    bool SynthesizeVisemes(const FString& text, const EVoiceId VoiceId);
+    bool CheckPollyOutcome(const PollyOutcome& Outcome, const TCHAR* Description) const;
     /**
     * Returns a PollyRequest that is configured to return pcm audio data with a given text and VoiceId 
     * @param text - the text to be synthesized (SetText)
@@ -187,15 +1225,12 @@ private:
     */
     Aws::Polly::Model::SynthesizeSpeechRequest CreatePollyVisemeRequest(const FString& text, const EVoiceId VoiceId) const;
     /**
-    * Fills the VisemeEventArray with VisemeEvent objects containing visemes and corresponding timestamps
-    * @param VisemeJson - FString containing Polly json viseme data ( example: {"time":125,"type":"viseme","value":"k"} )
+    * Parses Polly json viseme data into VisemeEvent objects
+    * @param VisemeJson - UTF-8 Polly json viseme data, as returned by Polly
+    * @param OutVisemeEvents - receives the parsed VisemeEvent objects
+    * @return bool - false if the data could not be parsed
     */
-    void GenerateVisemeEvents(FString VisemeJson);
-    /**
-    * Returns a USoundWave object containing the Polly Audio for playback in Blueprints
-    * @return USoundWaveProcedural - Sound wave object containing Polly Audio 
-    */
-    USoundWaveProcedural* QueuePollyAudio();
+    static bool ParseVisemeEvents(TArrayView<const uint8> VisemeJson, TArray<VisemeEvent>& OutVisemeEvents);
     /**
     * Timer handle for use in creating/clearing timers 
     */
@@ -218,11 +1253,48 @@ private:
     */
     virtual void InitializePollyClient();
     /*
-    * Mutex for thread-safe mutation of internal state.
+    * Number of GenerateSpeech calls running in the background, which hold back destruction
     */
-    FCriticalSection Mutex;
+    FThreadSafeCounter PendingGenerateSpeechCalls;
+    /*
+    * Set by BeginDestroy to reject new speech
+    */
+    bool bIsShuttingDown = false;
+    /*
+    * Latency of the last StopSpeech or CancelSpeech call
+    */
+    FSpeechCancelMetrics CancelMetrics;
+    /*
+    * Time of the last StopSpeech or CancelSpeech call, in FPlatformTime::Seconds
+    */
+    double LastCancelSeconds = 0.0;
+    /*
+    * Cancellation flag of the speech aborted by the last StopSpeech or CancelSpeech call
+    */
+    TSharedPtr<FThreadSafeBool, ESPMode::ThreadSafe> LastCancelledFlag;
+    /*
+    * Utterance of the speech in traces, see SpeechTrace. Read without the Mutex when the requests of the speech are issued.
+    */
+    std::atomic<uint32> TraceUtteranceId{ 0 };
+    /*
+    * Utterance whose speech was generated but has not started yet, so its Utterance span is still open
+    */
+    uint32 OpenTraceUtteranceId = 0;
+    /*
+    * Warmup manifest of the map, set by BeginPlay
+    */
+    TSharedPtr<FSpeechWarmupManifest, ESPMode::ThreadSafe> WarmupManifest;
+    /*
+    * Cancellation flag of the warmup started by this component, raised by EndPlay and BeginDestroy
+    */
+    PollyCancellationFlag WarmupCancellationFlag = MakePollyCancellationFlag();
     // FGenerateSpeechAction is a friend class so that it can invoke the
-    // protected GenerateSpeechSync function in a separate thread, which
-    // is required to make GenerateSpeech a non-blocking latent function.
+    // private BeginGenerateSpeech and FinishGenerateSpeech functions in a
+    // separate thread, which is required to make GenerateSpeech a
+    // non-blocking latent function.
     friend class FGenerateSpeechAction;
+    // The warmup runs on behalf of a component, whose destruction it holds back
+    friend class UPollySpeechWarmupSubsystem;
+    // The baker creates the Polly client of the components it uses outside of a world
+    friend class FPollySpeechBaker;
 };
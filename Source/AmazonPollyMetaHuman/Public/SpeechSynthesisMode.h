@@ -0,0 +1,38 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SpeechSynthesisMode.generated.h"
+
+/**
+* What GenerateSpeech synthesizes. Speakers that cannot be heard or cannot be seen only need part of their speech,
+* and every part that is skipped saves a Polly request.
+*/
+UENUM(BlueprintType)
+enum class ESpeechSynthesisMode : uint8 {
+    /** Audio and visemes */
+    Full UMETA(DisplayName = "Full"),
+    /** Visemes only, e.g. for speakers out of earshot. StartSpeech returns no sound. */
+    VisemesOnly UMETA(DisplayName = "Visemes Only"),
+    /** Audio only, e.g. for off-screen voices. The viseme is Sil while the speech plays. */
+    AudioOnly UMETA(DisplayName = "Audio Only"),
+    /** Nothing is synthesized, the speech lasts as long as the text is estimated to take. StartSpeech returns no sound. */
+    DurationOnly UMETA(DisplayName = "Duration Only")
+};
@@ -56,4 +56,15 @@ enum class EViseme : uint8
  * @param String the string representation of the viseme 
  * @return EViseme the enum represetnation of the viseme
  */
-EViseme GetVisemeValueFromString(const FString& String);
\ No newline at end of file
+EViseme GetVisemeValueFromString(const FString& String);
+
+/**
+ * Looks up the viseme of the symbol returned by Amazon Polly,
+ * without allocating and without logging unknown symbols.
+ * 
+ * @param Symbol the symbol, e.g. "p" or "sil"
+ * @param Length the number of characters of the symbol
+ * @param OutViseme receives the viseme
+ * @return bool false if the symbol is not a viseme
+ */
+bool TryGetVisemeFromSymbol(const ANSICHAR* Symbol, int32 Length, EViseme& OutViseme);
\ No newline at end of file
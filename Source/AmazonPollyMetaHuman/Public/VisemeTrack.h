@@ -0,0 +1,123 @@
+/*
+ * Copyright Amazon.com, Inc. or its affiliates. All Rights Reserved.
+ * SPDX-License-Identifier: MIT-0
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of this
+ * software and associated documentation files (the "Software"), to deal in the Software
+ * without restriction, including without limitation the rights to use, copy, modify,
+ * merge, publish, distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+ * INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A
+ * PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION
+ * OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/SharedPointer.h"
+#include "Viseme.h"
+
+/**
+* Struct containing a single viseme and its corresponding timestamp returned by Polly
+* to be used in setting CurrentViseme and CurrentVisemeDurationSeconds states 
+*/
+struct VisemeEvent {
+    EViseme Viseme;
+    int TimeMilliseconds;
+};
+
+class FVisemeTrack;
+
+/**
+* Viseme track shared by the speech component and any thread sampling it
+*/
+using FVisemeTrackRef = TSharedRef<const FVisemeTrack, ESPMode::ThreadSafe>;
+
+/**
+* Visemes of a speech, stored as an array of times and an array of visemes, so a viseme takes 5 bytes rather
+* than the 8 of a VisemeEvent. A track is immutable once made, so it can be sampled from any thread; appending
+* visemes makes a new track. The viseme played at a time is the first one whose time has not passed yet.
+*/
+class AMAZONPOLLYMETAHUMAN_API FVisemeTrack {
+public:
+    /**
+    * Makes a track. A viseme timed before the previous one is moved to the time of the previous one.
+    * @param VisemeEvents - the visemes, in playback order
+    * @return FVisemeTrackRef - the track
+    */
+    static FVisemeTrackRef Make(const TArray<VisemeEvent>& VisemeEvents);
+    /**
+    * Returns the empty track shared by the speech components without a speech
+    */
+    static const FVisemeTrackRef& GetEmpty();
+    /**
+    * Makes a track holding the visemes of this one followed by more visemes
+    * @param VisemeEvents - the visemes to append, timed from OffsetMilliseconds
+    * @param OffsetMilliseconds - the time the appended visemes start at
+    * @return FVisemeTrackRef - the new track
+    */
+    FVisemeTrackRef Append(const TArray<VisemeEvent>& VisemeEvents, int32 OffsetMilliseconds) const;
+    /**
+    * Returns the number of visemes
+    */
+    int32 Num() const {
+        return TimesMilliseconds.Num();
+    }
+    /**
+    * Returns a viseme
+    * @param Index - the index of the viseme
+    */
+    EViseme GetViseme(int32 Index) const {
+        return Visemes[Index];
+    }
+    /**
+    * Returns the time of a viseme
+    * @param Index - the index of the viseme
+    */
+    int32 GetTimeMilliseconds(int32 Index) const {
+        return TimesMilliseconds[Index];
+    }
+    /**
+    * Returns the time of the last viseme, where the visemes end, or 0 for an empty track
+    */
+    int32 GetEndMilliseconds() const {
+        return TimesMilliseconds.Num() > 0 ? TimesMilliseconds.Last() : 0;
+    }
+    /**
+    * Finds the viseme played at a time, by binary search
+    * @param PlaybackMilliseconds - the time since the start of the speech
+    * @return int32 - the index of the viseme, or Num() once the visemes ended
+    */
+    int32 FindVisemeIndex(int64 PlaybackMilliseconds) const;
+    /**
+    * Returns the viseme played at a time
+    * @param PlaybackMilliseconds - the time since the start of the speech
+    * @return EViseme - the viseme, or Sil once the visemes ended
+    */
+    EViseme Evaluate(int64 PlaybackMilliseconds) const;
+    /**
+    * Copies the visemes out of the track, e.g. to store or encode them
+    * @param OutVisemeEvents - receives the visemes
+    */
+    void GetVisemeEvents(TArray<VisemeEvent>& OutVisemeEvents) const;
+    /**
+    * Returns the memory held by the track
+    */
+    SIZE_T GetAllocatedSize() const {
+        return TimesMilliseconds.GetAllocatedSize() + Visemes.GetAllocatedSize();
+    }
+
+private:
+    /**
+    * Appends visemes, keeping the times in order
+    */
+    void AddVisemes(const TArray<VisemeEvent>& VisemeEvents, int32 OffsetMilliseconds);
+
+    TArray<int32> TimesMilliseconds;
+    TArray<EViseme> Visemes;
+};
@@ -0,0 +1,60 @@
+#!/bin/bash
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" &> /dev/null && pwd )"
+SDK_REPO_DIR="$SCRIPT_DIR/aws-sdk-cpp"
+SDK_BUILD_DIR="$SDK_REPO_DIR/_build"
+SDK_INSTALL_DIR="$SDK_REPO_DIR/_install"
+MODULE_LINUX_DIR="$SCRIPT_DIR/Linux"
+AWS_SDK_VERSION="1.9.0"
+
+# Unreal Engine links against its own libc++ on Linux, so the SDK has to be built with the engine's clang toolchain
+# and libc++ for the C++ types of its API to be compatible. UE_ENGINE_DIR is the root of the engine, the folder
+# containing Engine/. LINUX_MULTIARCH_ROOT, if set, selects the toolchain as it does for the engine.
+if [ -z "$UE_ENGINE_DIR" ] || [ ! -d "$UE_ENGINE_DIR/Engine" ]; then
+    echo "Set UE_ENGINE_DIR to the root of the Unreal Engine install (the folder containing Engine/). Installation FAILED."
+    exit 1
+fi
+if [ -z "$LINUX_MULTIARCH_ROOT" ]; then
+    LINUX_MULTIARCH_ROOT="$( ls -d "$UE_ENGINE_DIR"/Engine/Extras/ThirdPartyNotUE/SDKs/HostLinux/Linux_x64/*/ 2> /dev/null | sort | tail -n 1 )"
+fi
+TOOLCHAIN_DIR="${LINUX_MULTIARCH_ROOT%/}/x86_64-unknown-linux-gnu"
+LIBCXX_DIR="$UE_ENGINE_DIR/Engine/Source/ThirdParty/Linux/LibCxx"
+if [ ! -x "$TOOLCHAIN_DIR/bin/clang++" ] || [ ! -d "$LIBCXX_DIR" ]; then
+    echo "The clang toolchain of the engine was not found. Run Setup.sh of the engine, or set LINUX_MULTIARCH_ROOT. Installation FAILED."
+    exit 1
+fi
+LIBCXX_FLAGS="-nostdinc++ -I$LIBCXX_DIR/include -I$LIBCXX_DIR/include/c++/v1"
+LIBCXX_LINKER_FLAGS="-nodefaultlibs -L$LIBCXX_DIR/lib/Linux/x86_64-unknown-linux-gnu -lc++ -lc++abi -lm -lc -lpthread -lgcc_s -lgcc"
+
+# Clone the repo
+cd "$SCRIPT_DIR"
+git clone --branch $AWS_SDK_VERSION --recurse-submodules https://github.com/aws/aws-sdk-cpp.git || exit 1
+
+# Create build and install directories where we will build and install the SDK to
+cd "$SDK_REPO_DIR"
+mkdir "$SDK_BUILD_DIR"
+mkdir "$SDK_INSTALL_DIR"
+
+# Build the SDK. libcurl and OpenSSL are the ones of the system, their development packages have to be installed.
+cd "$SDK_BUILD_DIR"
+cmake "$SDK_REPO_DIR" -DCMAKE_INSTALL_PREFIX="$SDK_INSTALL_DIR" -DCMAKE_INSTALL_LIBDIR=lib -DCMAKE_BUILD_TYPE=Release \
+    -DBUILD_ONLY="polly" -DCUSTOM_MEMORY_MANAGEMENT=ON -DBUILD_SHARED_LIBS=ON -DENABLE_TESTING=OFF \
+    -DCMAKE_C_COMPILER="$TOOLCHAIN_DIR/bin/clang" -DCMAKE_CXX_COMPILER="$TOOLCHAIN_DIR/bin/clang++" \
+    -DCMAKE_CXX_FLAGS="$LIBCXX_FLAGS -fPIC" -DCMAKE_SHARED_LINKER_FLAGS="$LIBCXX_LINKER_FLAGS" || exit 1
+make -j"$(nproc)" || exit 1
+
+# Install the SDK
+make install || exit 1
+
+# Remove any previous builds from the platform specific directory
+mkdir "$MODULE_LINUX_DIR"
+rm -rf "$MODULE_LINUX_DIR"/*
+
+# Copy the new build to the platform specific directory. The libraries are loaded by the name they were linked
+# with, which may carry a version suffix, so every name is copied as a file of its own.
+cp -R "$SDK_INSTALL_DIR"/include "$MODULE_LINUX_DIR"/include
+mkdir "$MODULE_LINUX_DIR"/lib
+ls -1 "$SDK_INSTALL_DIR"/lib/*.so* | xargs -L1 -I{} cp -L {} "$MODULE_LINUX_DIR"/lib/
+
+# Remove the cloned repo, build, and install directory.
+rm -rf "$SDK_REPO_DIR"